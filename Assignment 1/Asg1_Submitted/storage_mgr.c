@@ -355,18 +355,31 @@ RC writeCurrentBlock (SM_FileHandle *fHandle, SM_PageHandle memPage)
 */
 RC appendEmptyBlock (SM_FileHandle *fHandle)
 {
-	int i;
-	char emptyblock[PAGE_SIZE];
-	for(i=0;i<PAGE_SIZE;i++)
-		emptyblock[i]=0;
+	return(ensureCapacity (fHandle->totalNumPages+1, fHandle));
+}
 
-	printf("\nLength of emptyblock that will be written:%d", strlen(emptyblock));
+/*
+ * Function ensureCapacity()
+ * Checks if the number of the pages in the file is equal to the specified Page Number
+ * Grows the file with a single ftruncate if it is less than specified capacity,
+ * new pages read back as zero bytes without being written.
+*/
+RC ensureCapacity (int numberOfPages, SM_FileHandle *fHandle)
+{
+	FILE *fd=fHandle->mgmtInfo;
 
 	if (checkinit() == RC_OK)
 		{
 			if (exists(fHandle->fileName))
 			{
-				writeBlock (fHandle->totalNumPages, fHandle, emptyblock);
+				if (numberOfPages <= fHandle->totalNumPages)
+					return RC_OK;
+
+				fflush(fd);
+				if (ftruncate(fileno(fd), (off_t) numberOfPages*PAGE_SIZE) < 0)
+					return RC_WRITE_FAILED;
+				fHandle->totalNumPages=numberOfPages;
+				fHandle->curPagePos=numberOfPages-1;
 				return RC_OK;
 			}
 			else
@@ -379,33 +392,3 @@ RC appendEmptyBlock (SM_FileHandle *fHandle)
 			return RC_STORAGE_MGR_NOT_INIT;
 		}
 }
-
-/*
- * Function ensureCapacity()
- * Checks if the number of the pages in the file is equal to the specified Page Number
- * Appends new blocks to the file if it is less than specified capacity.
-*/
-RC ensureCapacity (int numberOfPages, SM_FileHandle *fHandle)
-{
-	int i;
-		char emptyblock[PAGE_SIZE];
-		for(i=0;i<PAGE_SIZE;i++)
-			emptyblock[i]=0;
-
-		if (checkinit() == RC_OK)
-			{
-				if (exists(fHandle->fileName))
-				{
-					writeBlock (numberOfPages-1, fHandle, emptyblock);
-					return RC_OK;
-				}
-				else
-				{
-					return RC_FILE_NOT_FOUND;
-				}
-			}
-			else
-			{
-				return RC_STORAGE_MGR_NOT_INIT;
-			}
-}
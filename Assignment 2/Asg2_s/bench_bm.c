@@ -0,0 +1,385 @@
+/*
+ * Buffer manager benchmark over synthetic workloads.
+ *
+ * Every combination of workload, page file size, pool size, thread
+ * count and replacement strategy is one run. Threads share one pool
+ * and each does numOps pin/unpin pairs on pages picked by the
+ * workload, writing to the page and marking it dirty on a share of
+ * them. One result line is printed per run, as CSV or JSON lines, so
+ * runs can be collected and compared between versions.
+ *
+ * Workloads
+ *   uniform  every page equally likely
+ *   zipf     page ranks Zipf distributed with skew theta, ranks are
+ *            scattered over the file so hot pages are not neighbours
+ *   hotcold  80% of accesses to 20% of pages
+ *   scan     each thread reads the file sequentially from its own
+ *            starting point
+ *   mix      zipf point accesses, one in SCAN_SHARE continues a
+ *            sequential scan of the thread
+ *
+ * usage: bench_bm [-w workloads] [-f filePages] [-p poolPages]
+ *                 [-t threads] [-s strategies] [-n opsPerThread]
+ *                 [-d dirtyPercent] [-z theta] [-l] [-j]
+ *   Lists are comma separated, e.g. -p 64,256,1024 -s FIFO,LRU,CLOCK.
+ *   -l records pin latencies, -j prints JSON lines instead of CSV.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <math.h>
+#include <time.h>
+#include <pthread.h>
+
+#include "dberror.h"
+#include "storage_mgr.h"
+#include "buffer_mgr.h"
+#include "latency_hist.h"
+
+#define BENCH_FILE "bench_bm.bin"
+#define MAX_LIST 16
+#define SCAN_SHARE 10
+
+#define CHECK_RC(code)                                                  \
+  do {                                                                  \
+    RC _rc= (code);                                                     \
+    if (_rc != RC_OK)                                                   \
+    {                                                                   \
+      char *_msg= errorMessage(_rc);                                    \
+      fprintf(stderr, "%s:%d: %s\n", __FILE__, __LINE__, _msg);         \
+      free(_msg);                                                       \
+      exit(1);                                                          \
+    }                                                                   \
+  } while (0)
+
+typedef enum Workload {
+  WL_UNIFORM,
+  WL_ZIPF,
+  WL_HOTCOLD,
+  WL_SCAN,
+  WL_MIX
+} Workload;
+
+static const char *workloadNames[]= { "uniform", "zipf", "hotcold", "scan",
+                                      "mix" };
+static const char *strategyNames[]= { "FIFO", "LRU", "CLOCK" };
+
+// Zipf over ranks 0 .. n-1 (Gray et al., "Quickly generating
+// billion-record synthetic databases"), constants shared by threads
+typedef struct ZipfGen {
+  int n;
+  double theta, alpha, zetan, eta;
+} ZipfGen;
+
+// One run of the benchmark
+typedef struct BenchRun {
+  BM_BufferPool bm;
+  Workload workload;
+  ZipfGen zipf;
+  int filePages;
+  int numOps;
+  int dirtyPercent;
+} BenchRun;
+
+// Work of one thread
+typedef struct BenchThread {
+  pthread_t thread;
+  BenchRun *run;
+  unsigned long long rng;
+  int cursor;
+  long long failedPins;
+} BenchThread;
+
+static double now(void)
+{
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+// xorshift64*, one state per thread
+static unsigned long long nextRand(unsigned long long *s)
+{
+  *s^= *s >> 12;
+  *s^= *s << 25;
+  *s^= *s >> 27;
+  return *s * 2685821657736338717ULL;
+}
+
+static double nextDouble(unsigned long long *s)
+{
+  return (nextRand(s) >> 11) * (1.0 / 9007199254740992.0);
+}
+
+static void initZipf(ZipfGen *z, int n, double theta)
+{
+  double zeta2= 1.0 + pow(0.5, theta);
+  int i;
+
+  z->n= n;
+  z->theta= theta;
+  z->zetan= 0;
+  for (i=1; i <= n; i++)
+    z->zetan+= 1.0 / pow(i, theta);
+  z->alpha= 1.0 / (1.0 - theta);
+  z->eta= (1.0 - pow(2.0 / n, 1.0 - theta)) / (1.0 - zeta2 / z->zetan);
+}
+
+static int nextZipf(ZipfGen *z, unsigned long long *s)
+{
+  double u= nextDouble(s), uz= u * z->zetan;
+  int rank;
+
+  if (uz < 1.0)
+    return 0;
+  if (uz < 1.0 + pow(0.5, z->theta))
+    return 1;
+  rank= (int) (z->n * pow(z->eta * u - z->eta + 1.0, z->alpha));
+  return rank < z->n ? rank : z->n - 1;
+}
+
+// Spread ranks over the file, a prime above any file size is coprime
+static int scatter(int rank, int n)
+{
+  return (int) (((unsigned long long) rank * 2654435761ULL) % n);
+}
+
+static int nextPage(BenchThread *t)
+{
+  BenchRun *run= t->run;
+  int n= run->filePages;
+
+  switch (run->workload)
+  {
+    case WL_UNIFORM:
+      return (int) (nextRand(&t->rng) % n);
+    case WL_ZIPF:
+      return scatter(nextZipf(&run->zipf, &t->rng), n);
+    case WL_HOTCOLD:
+      if (nextRand(&t->rng) % 100 < 80)
+        return (int) (nextRand(&t->rng) % (n / 5 > 0 ? n / 5 : 1));
+      return (int) (nextRand(&t->rng) % n);
+    case WL_SCAN:
+      t->cursor= (t->cursor + 1) % n;
+      return t->cursor;
+    case WL_MIX:
+      if (nextRand(&t->rng) % SCAN_SHARE == 0)
+      {
+        t->cursor= (t->cursor + 1) % n;
+        return t->cursor;
+      }
+      return scatter(nextZipf(&run->zipf, &t->rng), n);
+  }
+  return 0;
+}
+
+static void *benchThread(void *arg)
+{
+  BenchThread *t= (BenchThread*) arg;
+  BenchRun *run= t->run;
+  BM_PageHandle h;
+  int i;
+
+  for (i=0; i < run->numOps; i++)
+  {
+    if (pinPage(&run->bm, &h, nextPage(t)) != RC_OK)
+    {
+      // Every frame pinned by other threads
+      t->failedPins++;
+      continue;
+    }
+    if (nextRand(&t->rng) % 100 < (unsigned) run->dirtyPercent)
+    {
+      h.data[0]++;
+      markDirty(&run->bm, &h);
+    }
+    unpinPage(&run->bm, &h);
+  }
+  return NULL;
+}
+
+static void makeFile(int filePages)
+{
+  SM_FileHandle fh;
+
+  destroyPageFile(BENCH_FILE);
+  CHECK_RC(createPageFile(BENCH_FILE));
+  CHECK_RC(openPageFile(BENCH_FILE, &fh));
+  CHECK_RC(ensureCapacity(filePages, &fh));
+  CHECK_RC(closePageFile(&fh));
+}
+
+static void runOne(BenchRun *run, int poolPages, int numThreads,
+                   ReplacementStrategy strategy, bool json)
+{
+  BenchThread *threads= (BenchThread*) calloc(numThreads, sizeof(BenchThread));
+  BM_PoolStats stats;
+  LH_Snapshot *hit= (LH_Snapshot*) malloc(sizeof(LH_Snapshot));
+  LH_Snapshot *miss= (LH_Snapshot*) malloc(sizeof(LH_Snapshot));
+  long long failed= 0, ops, accesses;
+  double start, secs, hitRatio;
+  int i;
+
+  CHECK_RC(initBufferPool(&run->bm, BENCH_FILE, poolPages, strategy, NULL));
+  for (i=0; i < numThreads; i++)
+  {
+    threads[i].run= run;
+    threads[i].rng= 0x9E3779B97F4A7C15ULL * (i + 1);
+    threads[i].cursor= (int) ((long long) run->filePages * i / numThreads);
+  }
+
+  start= now();
+  for (i=0; i < numThreads; i++)
+    pthread_create(&threads[i].thread, NULL, benchThread, &threads[i]);
+  for (i=0; i < numThreads; i++)
+  {
+    pthread_join(threads[i].thread, NULL);
+    failed+= threads[i].failedPins;
+  }
+  secs= now() - start;
+
+  CHECK_RC(getPoolStats(&run->bm, &stats));
+  CHECK_RC(getPinLatency(&run->bm, hit, miss));
+  CHECK_RC(shutdownBufferPool(&run->bm));
+
+  ops= (long long) run->numOps * numThreads;
+  accesses= stats.hits + stats.misses;
+  hitRatio= accesses ? (double) stats.hits / accesses : 0.0;
+  if (json)
+    printf("{\"workload\":\"%s\",\"strategy\":\"%s\",\"file_pages\":%d,"
+           "\"pool_pages\":%d,\"threads\":%d,\"ops\":%lld,\"seconds\":%.6f,"
+           "\"ops_per_sec\":%.0f,\"hit_ratio\":%.6f,\"reads\":%lld,"
+           "\"writes\":%lld,\"dirty_evictions\":%lld,\"pin_waits\":%lld,"
+           "\"failed_pins\":%lld,\"hit_p50_ns\":%lld,\"hit_p99_ns\":%lld,"
+           "\"miss_p50_ns\":%lld,\"miss_p99_ns\":%lld}\n",
+           workloadNames[run->workload], strategyNames[strategy],
+           run->filePages, poolPages, numThreads, ops, secs, ops / secs,
+           hitRatio, stats.numReadIO, stats.numWriteIO, stats.dirtyEvictions,
+           stats.pinWaits, failed, hit->p50, hit->p99, miss->p50, miss->p99);
+  else
+    printf("%s,%s,%d,%d,%d,%lld,%.6f,%.0f,%.6f,%lld,%lld,%lld,%lld,%lld,"
+           "%lld,%lld,%lld,%lld\n",
+           workloadNames[run->workload], strategyNames[strategy],
+           run->filePages, poolPages, numThreads, ops, secs, ops / secs,
+           hitRatio, stats.numReadIO, stats.numWriteIO, stats.dirtyEvictions,
+           stats.pinWaits, failed, hit->p50, hit->p99, miss->p50, miss->p99);
+  fflush(stdout);
+
+  free(hit);
+  free(miss);
+  free(threads);
+}
+
+// Comma separated list of names, index in names is stored
+static int parseNames(char *arg, const char **names, int numNames, int *out)
+{
+  char *tok, *save;
+  int n= 0, i;
+
+  for (tok= strtok_r(arg, ",", &save); tok; tok= strtok_r(NULL, ",", &save))
+  {
+    for (i=0; i < numNames && strcmp(tok, names[i]) != 0; i++)
+      ;
+    if (i == numNames || n == MAX_LIST)
+    {
+      fprintf(stderr, "bad or too many values: %s\n", tok);
+      exit(1);
+    }
+    out[n++]= i;
+  }
+  return n;
+}
+
+static int parseInts(char *arg, int *out)
+{
+  char *tok, *save;
+  int n= 0;
+
+  for (tok= strtok_r(arg, ",", &save); tok; tok= strtok_r(NULL, ",", &save))
+  {
+    if (atoi(tok) <= 0 || n == MAX_LIST)
+    {
+      fprintf(stderr, "bad or too many values: %s\n", tok);
+      exit(1);
+    }
+    out[n++]= atoi(tok);
+  }
+  return n;
+}
+
+int main(int argc, char **argv)
+{
+  int workloads[MAX_LIST], files[MAX_LIST], pools[MAX_LIST];
+  int threads[MAX_LIST], strategies[MAX_LIST];
+  int numWorkloads= 5, numFiles= 1, numPools= 3, numThreads= 1;
+  int numStrategies= 3;
+  int w, f, p, t, s, opt;
+  double theta= 0.99;
+  bool json= FALSE;
+  BenchRun run;
+
+  for (w=0; w < numWorkloads; w++)
+    workloads[w]= w;
+  files[0]= 10000;
+  pools[0]= 100;
+  pools[1]= 1000;
+  pools[2]= 5000;
+  threads[0]= 1;
+  for (s=0; s < numStrategies; s++)
+    strategies[s]= s;
+  run.numOps= 200000;
+  run.dirtyPercent= 10;
+
+  while ((opt= getopt(argc, argv, "w:f:p:t:s:n:d:z:lj")) != -1)
+  {
+    switch (opt)
+    {
+      case 'w': numWorkloads= parseNames(optarg, workloadNames, 5, workloads); break;
+      case 'f': numFiles= parseInts(optarg, files); break;
+      case 'p': numPools= parseInts(optarg, pools); break;
+      case 't': numThreads= parseInts(optarg, threads); break;
+      case 's': numStrategies= parseNames(optarg, strategyNames, 3, strategies); break;
+      case 'n': run.numOps= atoi(optarg); break;
+      case 'd': run.dirtyPercent= atoi(optarg); break;
+      case 'z': theta= atof(optarg); break;
+      case 'l': setLatencyTracking(TRUE); break;
+      case 'j': json= TRUE; break;
+      default:
+        fprintf(stderr, "usage: %s [-w workloads] [-f filePages] "
+                "[-p poolPages] [-t threads] [-s strategies] "
+                "[-n opsPerThread] [-d dirtyPercent] [-z theta] [-l] [-j]\n",
+                argv[0]);
+        return 1;
+    }
+  }
+  if (theta <= 0 || theta >= 1)
+  {
+    fprintf(stderr, "theta must be between 0 and 1\n");
+    return 1;
+  }
+
+  initStorageManager();
+  if (!json)
+    printf("workload,strategy,file_pages,pool_pages,threads,ops,seconds,"
+           "ops_per_sec,hit_ratio,reads,writes,dirty_evictions,pin_waits,"
+           "failed_pins,hit_p50_ns,hit_p99_ns,miss_p50_ns,miss_p99_ns\n");
+
+  for (f=0; f < numFiles; f++)
+  {
+    run.filePages= files[f];
+    makeFile(run.filePages);
+    initZipf(&run.zipf, run.filePages, theta);
+    for (w=0; w < numWorkloads; w++)
+      for (p=0; p < numPools; p++)
+        for (t=0; t < numThreads; t++)
+          for (s=0; s < numStrategies; s++)
+          {
+            run.workload= (Workload) workloads[w];
+            runOne(&run, pools[p], threads[t],
+                   (ReplacementStrategy) strategies[s], json);
+          }
+  }
+  destroyPageFile(BENCH_FILE);
+  return 0;
+}
@@ -0,0 +1,319 @@
+/*
+ * Point lookup benchmark, B+-tree index against a linear table scan.
+ *
+ * Loads numKeys records with unique int keys in random order into a
+ * table and an index on the key. Then looks up random keys, once
+ * through findKey + getRecord and once with a scan on key = k.
+ *
+ * Same keys are bulk loaded into a second index for comparison.
+ *
+ * Then measures index alone with 1, 2, 4, ... maxThreads threads.
+ * Threads insert disjoint shares of numKeys keys into an empty index,
+ * then all of them look up random keys. Pins per lookup tell how
+ * often a lookup went through the buffer pool mutex.
+ *
+ * Built by make bench, or
+ * gcc -O2 -I. -o bench_btree bench_btree.c btree_mgr.c record_mgr.c \
+ *     rm_serializer.c expr.c vector_eval.c free_space_mgr.c sort_mgr.c \
+ *     buffer_mgr.c buffer_mgr_stat.c buffer_trace.c mrc.c latency_hist.c \
+ *     storage_mgr.c page_compress.c page_table.c lru_linked_list.c \
+ *     page_latch.c frame_arena.c dberror.c -lpthread
+ *
+ * usage: bench_btree [numKeys] [numLookups] [numScans] [maxThreads]
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <pthread.h>
+
+#include "dberror.h"
+#include "btree_mgr.h"
+#include "record_mgr.h"
+#include "expr.h"
+#include "tables.h"
+
+#define TABLE_NAME "bench_btree_tbl"
+#define INDEX_NAME "bench_btree_idx"
+#define MT_INDEX_NAME "bench_btree_mt_idx"
+#define BULK_INDEX_NAME "bench_btree_bulk_idx"
+
+#define CHECK_RC(code)                                                  \
+  do {                                                                  \
+    RC _rc= (code);                                                     \
+    if (_rc != RC_OK)                                                   \
+    {                                                                   \
+      char *_msg= errorMessage(_rc);                                    \
+      fprintf(stderr, "%s:%d: %s\n", __FILE__, __LINE__, _msg);         \
+      free(_msg);                                                       \
+      exit(1);                                                          \
+    }                                                                   \
+  } while (0)
+
+static double now(void)
+{
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static Schema *benchSchema(void)
+{
+  char **names= (char**) malloc(2 * sizeof(char*));
+  DataType *dt= (DataType*) malloc(2 * sizeof(DataType));
+  int *sizes= (int*) calloc(2, sizeof(int));
+  int *keys= (int*) malloc(sizeof(int));
+
+  names[0]= strdup("key");
+  names[1]= strdup("payload");
+  dt[0]= DT_INT;
+  dt[1]= DT_INT;
+  keys[0]= 0;
+  return createSchema(2, names, dt, sizes, 1, keys);
+}
+
+static void report(const char *what, int ops, double secs)
+{
+  printf("%-16s %10d ops %10.3f s %12.2f us/op\n", what, ops, secs,
+         secs * 1e6 / ops);
+}
+
+// Work of one thread in the threaded phase
+typedef struct BenchThread {
+  pthread_t thread;
+  BTreeHandle *tree;
+  int *keys;
+  int numKeys;     // Inserts keys[0..numKeys-1]
+  int keyRange;    // Looks up keys below keyRange
+  int numLookups;
+  unsigned int seed;
+} BenchThread;
+
+static void *insertThread(void *arg)
+{
+  BenchThread *bt= (BenchThread*) arg;
+  Value val;
+  RID rid;
+  int i;
+
+  val.dt= DT_INT;
+  for (i=0; i < bt->numKeys; i++)
+  {
+    val.v.intV= bt->keys[i];
+    rid.page= bt->keys[i];
+    rid.slot= 0;
+    CHECK_RC(insertKey(bt->tree, &val, rid));
+  }
+  return NULL;
+}
+
+static void *lookupThread(void *arg)
+{
+  BenchThread *bt= (BenchThread*) arg;
+  Value val;
+  RID rid;
+  int i;
+
+  val.dt= DT_INT;
+  for (i=0; i < bt->numLookups; i++)
+  {
+    val.v.intV= rand_r(&bt->seed) % bt->keyRange;
+    CHECK_RC(findKey(bt->tree, &val, &rid));
+    if (rid.page != val.v.intV)
+    {
+      fprintf(stderr, "index returned wrong entry\n");
+      exit(1);
+    }
+  }
+  return NULL;
+}
+
+// Run fn on numThreads threads, returns seconds taken.
+static double runThreads(BenchThread *bt, int numThreads,
+                         void *(*fn)(void *))
+{
+  double t0= now();
+  int i;
+
+  for (i=0; i < numThreads; i++)
+    pthread_create(&bt[i].thread, NULL, fn, &bt[i]);
+  for (i=0; i < numThreads; i++)
+    pthread_join(bt[i].thread, NULL);
+  return now() - t0;
+}
+
+static void benchThreads(int *perm, int numKeys, int numLookups,
+                         int maxThreads)
+{
+  BenchThread *bt= (BenchThread*) malloc(maxThreads * sizeof(BenchThread));
+  BTreeHandle *tree;
+  BM_BufferPool *bm;
+  BM_PoolStats stats;
+  int numThreads, i, share;
+  double secs;
+
+  printf("%-8s %14s %14s %12s\n", "threads", "insert Mops/s", "lookup Mops/s",
+         "pins/lookup");
+  for (numThreads= 1; numThreads <= maxThreads; numThreads*= 2)
+  {
+    destroyPageFile(MT_INDEX_NAME);
+    CHECK_RC(createBtree(MT_INDEX_NAME, DT_INT, BT_MAX_N));
+    CHECK_RC(openBtree(&tree, MT_INDEX_NAME));
+
+    share= numKeys / numThreads;
+    for (i=0; i < numThreads; i++)
+    {
+      bt[i].tree= tree;
+      bt[i].keys= perm + i * share;
+      bt[i].numKeys= (i == numThreads - 1) ? numKeys - i * share : share;
+      bt[i].keyRange= numKeys;
+      bt[i].numLookups= numLookups / numThreads;
+      bt[i].seed= 42 + i;
+    }
+
+    secs= runThreads(bt, numThreads, insertThread);
+    printf("%-8d %14.3f", numThreads, numKeys / secs / 1e6);
+
+    // Every pin takes the pool mutex twice, with unpin
+    bm= &((BT_TreeMgmtData*) tree->mgmtData)->bm;
+    CHECK_RC(resetPoolStats(bm));
+    secs= runThreads(bt, numThreads, lookupThread);
+    CHECK_RC(getPoolStats(bm, &stats));
+    printf(" %14.3f %12.2f\n", bt[0].numLookups * numThreads / secs / 1e6,
+           (double) (stats.hits + stats.misses)
+           / (bt[0].numLookups * numThreads));
+
+    CHECK_RC(closeBtree(tree));
+    CHECK_RC(deleteBtree(MT_INDEX_NAME));
+  }
+  free(bt);
+}
+
+int main(int argc, char **argv)
+{
+  int numKeys= (argc > 1) ? atoi(argv[1]) : 1000000;
+  int numLookups= (argc > 2) ? atoi(argv[2]) : 100000;
+  int numScans= (argc > 3) ? atoi(argv[3]) : 10;
+  int maxThreads= (argc > 4) ? atoi(argv[4]) : 4;
+  RM_TableData table;
+  RM_ScanHandle scan;
+  BTreeHandle *tree;
+  BT_BulkLoad *load;
+  Schema *schema;
+  Record *rec;
+  Value *val;
+  Expr *cond, *attr, *cons;
+  RID rid;
+  int *perm, i, j, tmp, found;
+  double t0, indexSecs, scanSecs;
+
+  srand(42);
+  perm= (int*) malloc(numKeys * sizeof(int));
+  for (i=0; i < numKeys; i++)
+    perm[i]= i;
+  for (i=numKeys - 1; i > 0; i--)
+  {
+    j= rand() % (i + 1);
+    tmp= perm[i];
+    perm[i]= perm[j];
+    perm[j]= tmp;
+  }
+
+  initRecordManager(NULL);
+  initIndexManager(NULL);
+  destroyPageFile(TABLE_NAME);
+  destroyPageFile(INDEX_NAME);
+
+  schema= benchSchema();
+  CHECK_RC(createTable(TABLE_NAME, schema));
+  CHECK_RC(openTable(&table, TABLE_NAME));
+  CHECK_RC(createBtree(INDEX_NAME, DT_INT, BT_MAX_N));
+  CHECK_RC(openBtree(&tree, INDEX_NAME));
+  CHECK_RC(createRecord(&rec, table.schema));
+
+  // Load
+  t0= now();
+  for (i=0; i < numKeys; i++)
+  {
+    memcpy(rec->data, &perm[i], sizeof(int));
+    memcpy(rec->data + sizeof(int), &i, sizeof(int));
+    CHECK_RC(insertRecord(&table, rec));
+    MAKE_VALUE(val, DT_INT, perm[i]);
+    CHECK_RC(insertKey(tree, val, rec->id));
+    freeVal(val);
+  }
+  report("load", numKeys, now() - t0);
+
+  // Same keys through bulk load
+  destroyPageFile(BULK_INDEX_NAME);
+  t0= now();
+  CHECK_RC(startBtreeLoad(&load, BULK_INDEX_NAME, DT_INT, BT_MAX_N, 1.0));
+  val= (Value*) malloc(sizeof(Value));
+  val->dt= DT_INT;
+  for (i=0; i < numKeys; i++)
+  {
+    val->v.intV= perm[i];
+    rid.page= perm[i];
+    rid.slot= 0;
+    CHECK_RC(loadKey(load, val, rid));
+  }
+  free(val);
+  CHECK_RC(finishBtreeLoad(load));
+  report("bulk load index", numKeys, now() - t0);
+  CHECK_RC(deleteBtree(BULK_INDEX_NAME));
+
+  // Point lookups through index
+  t0= now();
+  for (i=0; i < numLookups; i++)
+  {
+    MAKE_VALUE(val, DT_INT, rand() % numKeys);
+    CHECK_RC(findKey(tree, val, &rid));
+    CHECK_RC(getRecord(&table, rid, rec));
+    if (memcmp(rec->data, &val->v.intV, sizeof(int)) != 0)
+    {
+      fprintf(stderr, "index returned wrong record\n");
+      return 1;
+    }
+    freeVal(val);
+  }
+  indexSecs= now() - t0;
+  report("index lookup", numLookups, indexSecs);
+
+  // Point lookups by scanning table, key = k
+  t0= now();
+  for (i=0; i < numScans; i++)
+  {
+    MAKE_ATTRREF(attr, 0);
+    MAKE_VALUE(val, DT_INT, rand() % numKeys);
+    MAKE_CONS(cons, val);
+    MAKE_BINOP_EXPR(cond, attr, cons, OP_COMP_EQUAL);
+
+    found= 0;
+    CHECK_RC(startScan(&table, &scan, cond));
+    while (next(&scan, rec) == RC_OK)
+      found++;
+    CHECK_RC(closeScan(&scan));
+    freeExpr(cond);
+    if (found != 1)
+    {
+      fprintf(stderr, "scan found %d records\n", found);
+      return 1;
+    }
+  }
+  scanSecs= now() - t0;
+  report("scan lookup", numScans, scanSecs);
+
+  printf("index lookup is %.0fx faster than scan\n",
+         (scanSecs / numScans) / (indexSecs / numLookups));
+
+  freeRecord(rec);
+  CHECK_RC(closeBtree(tree));
+  CHECK_RC(closeTable(&table));
+  CHECK_RC(deleteBtree(INDEX_NAME));
+  CHECK_RC(deleteTable(TABLE_NAME));
+
+  benchThreads(perm, numKeys, numLookups, maxThreads);
+  freeSchema(schema);
+  free(perm);
+  return 0;
+}
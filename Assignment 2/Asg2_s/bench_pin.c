@@ -0,0 +1,184 @@
+/*
+ * Cost of buffer manager calls that do no I/O.
+ *
+ * All pages fit in the pool and are read before timing starts, so
+ * every pin is a hit. Each thread loops over its own pages, and each
+ * operation is timed for every given strategy. Prints ns per call,
+ * as CSV, so the fixed cost of the hit path can be compared between
+ * versions.
+ *
+ * Operations
+ *   pin_unpin   pinPage + unpinPage
+ *   pin_dirty   pinPage + markDirty + unpinPage
+ *   mark_dirty  markDirty of a pinned page
+ *   force_clean forcePage of a pinned clean page, writes nothing
+ *
+ * usage: bench_pin [-p poolPages] [-t threads] [-n callsPerThread]
+ *                  [-s strategies]
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <time.h>
+#include <pthread.h>
+
+#include "dberror.h"
+#include "storage_mgr.h"
+#include "buffer_mgr.h"
+
+#define BENCH_FILE "bench_pin.bin"
+#define MAX_THREADS 64
+
+#define CHECK_RC(code)                                                  \
+  do {                                                                  \
+    RC _rc= (code);                                                     \
+    if (_rc != RC_OK)                                                   \
+    {                                                                   \
+      char *_msg= errorMessage(_rc);                                    \
+      fprintf(stderr, "%s:%d: %s\n", __FILE__, __LINE__, _msg);         \
+      free(_msg);                                                       \
+      exit(1);                                                          \
+    }                                                                   \
+  } while (0)
+
+typedef enum PinOp {
+  OP_PIN_UNPIN,
+  OP_PIN_DIRTY,
+  OP_MARK_DIRTY,
+  OP_FORCE_CLEAN
+} PinOp;
+
+static const char *opNames[]= { "pin_unpin", "pin_dirty", "mark_dirty",
+                                "force_clean" };
+static const char *strategyNames[]= { "FIFO", "LRU", "CLOCK" };
+
+// Work of one thread, pages first .. first+numPages-1
+typedef struct PinThread {
+  pthread_t thread;
+  BM_BufferPool *bm;
+  PinOp op;
+  int first;
+  int numPages;
+  long long calls;
+} PinThread;
+
+static double now(void)
+{
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static void *pinThread(void *arg)
+{
+  PinThread *t= (PinThread*) arg;
+  BM_PageHandle h;
+  long long i;
+  int page= 0;
+
+  if (t->op == OP_MARK_DIRTY || t->op == OP_FORCE_CLEAN)
+  {
+    CHECK_RC(pinPage(t->bm, &h, t->first));
+    for (i=0; i < t->calls; i++)
+      if (t->op == OP_MARK_DIRTY)
+        markDirty(t->bm, &h);
+      else
+        forcePage(t->bm, &h);
+    CHECK_RC(unpinPage(t->bm, &h));
+    return NULL;
+  }
+
+  for (i=0; i < t->calls; i++)
+  {
+    pinPage(t->bm, &h, t->first + page);
+    if (t->op == OP_PIN_DIRTY)
+      markDirty(t->bm, &h);
+    unpinPage(t->bm, &h);
+    if (++page == t->numPages)
+      page= 0;
+  }
+  return NULL;
+}
+
+static void runOne(ReplacementStrategy strategy, PinOp op, int poolPages,
+                   int numThreads, long long calls)
+{
+  PinThread threads[MAX_THREADS];
+  BM_BufferPool bm;
+  BM_PageHandle h;
+  double start, secs;
+  int i, perThread= poolPages / numThreads;
+
+  CHECK_RC(initBufferPool(&bm, BENCH_FILE, poolPages, strategy, NULL));
+  for (i=0; i < poolPages; i++)
+  {
+    CHECK_RC(pinPage(&bm, &h, i));
+    CHECK_RC(unpinPage(&bm, &h));
+  }
+
+  for (i=0; i < numThreads; i++)
+  {
+    threads[i].bm= &bm;
+    threads[i].op= op;
+    threads[i].first= i * perThread;
+    threads[i].numPages= perThread;
+    threads[i].calls= calls;
+  }
+  start= now();
+  for (i=0; i < numThreads; i++)
+    pthread_create(&threads[i].thread, NULL, pinThread, &threads[i]);
+  for (i=0; i < numThreads; i++)
+    pthread_join(threads[i].thread, NULL);
+  secs= now() - start;
+
+  printf("%s,%s,%d,%d,%lld,%.1f\n", opNames[op], strategyNames[strategy],
+         poolPages, numThreads, calls, secs * 1e9 / (calls * numThreads));
+  CHECK_RC(shutdownBufferPool(&bm));
+}
+
+int main(int argc, char **argv)
+{
+  int poolPages= 64, numThreads= 1, opt, i, op;
+  int strategies[3]= { RS_FIFO, RS_LRU, RS_CLOCK }, numStrategies= 3;
+  long long calls= 2000000;
+  char *tok, *save;
+
+  while ((opt= getopt(argc, argv, "p:t:n:s:")) != -1)
+  {
+    switch (opt)
+    {
+      case 'p': poolPages= atoi(optarg); break;
+      case 't': numThreads= atoi(optarg); break;
+      case 'n': calls= atoll(optarg); break;
+      case 's':
+        numStrategies= 0;
+        for (tok= strtok_r(optarg, ",", &save); tok && numStrategies < 3;
+             tok= strtok_r(NULL, ",", &save))
+          for (i=0; i < 3; i++)
+            if (strcmp(tok, strategyNames[i]) == 0)
+              strategies[numStrategies++]= i;
+        break;
+      default:
+        fprintf(stderr, "usage: %s [-p poolPages] [-t threads] "
+                "[-n callsPerThread] [-s strategies]\n", argv[0]);
+        return 1;
+    }
+  }
+  if (numThreads < 1 || numThreads > MAX_THREADS || poolPages < numThreads
+      || calls <= 0 || numStrategies == 0)
+  {
+    fprintf(stderr, "bad arguments\n");
+    return 1;
+  }
+
+  initStorageManager();
+  CHECK_RC(createPageFile(BENCH_FILE));
+  printf("op,strategy,pool_pages,threads,calls,ns_per_call\n");
+  for (op= OP_PIN_UNPIN; op <= OP_FORCE_CLEAN; op++)
+    for (i=0; i < numStrategies; i++)
+      runOne((ReplacementStrategy) strategies[i], (PinOp) op, poolPages,
+             numThreads, calls);
+  CHECK_RC(destroyPageFile(BENCH_FILE));
+  return 0;
+}
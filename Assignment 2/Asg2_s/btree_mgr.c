@@ -0,0 +1,1837 @@
+#define _GNU_SOURCE // pthread_rwlockattr_setkind_np
+#include "btree_mgr.h"
+#include "storage_mgr.h"
+#include <string.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <sched.h>
+
+/*
+ * B+-tree index
+ *
+ * Nodes are pages of the index file, accessed only through the
+ * buffer pool. They are allocated and freed with the free space map.
+ *
+ * Nodes do not keep parent pointers. Insert and delete remember
+ * the path from root to leaf, and walk it back up to split
+ * or rebalance parents.
+ *
+ * Insert splits a node that overflowed to n+1 keys in two halves.
+ * Delete first borrows an entry from a sibling of an underflowed
+ * node, if siblings are at minimum it merges them.
+ *
+ * Concurrency, optimistic lock coupling
+ *
+ * Readers never latch. Going down they note version of a node,
+ * read the child pointer, pin child, note its version and then check
+ * that version of parent did not change. Data read from a node is
+ * only used after its version is checked again, so a reader restarts
+ * from root when it raced with a writer.
+ *
+ * Inner nodes met on the way down stay pinned until the index is
+ * closed, see BT_KeptNodes, so a descent only goes through the buffer
+ * pool, and its mutex, to pin the leaf. Inner nodes past BT_KEEP_MAX
+ * are pinned and unpinned on every visit as before.
+ *
+ * Insert and delete first go down the same way and latch the leaf
+ * by upgrading its version. When the change fits in the leaf they
+ * are done, holding structLock shared against splits and merges.
+ * Otherwise they retry with structLock exclusive: then no other
+ * writer runs, and every node changed is latched until the whole
+ * split or merge is done, so readers never see half of it.
+ * structLock prefers writers, so a steady stream of inserts that fit
+ * their leaf can not starve a split.
+ *
+ * A split first latches every node it will change and allocates
+ * every new node, a merge latches every node it will change. Only
+ * then the leaf is changed, so running out of pages or frames leaves
+ * the tree as it was.
+ */
+
+// On disk tree header
+typedef struct BT_TreeHeader {
+  int magic;
+  int keyType;
+  int n;
+  PageNumber root;
+  int height;
+  int numNodes;
+  int numEntries;
+} BT_TreeHeader;
+
+// Root to leaf path, childIdx[i] is child taken at pages[i].
+typedef struct BT_Path {
+  int depth;
+  PageNumber pages[BT_MAX_HEIGHT];
+  int childIdx[BT_MAX_HEIGHT];
+} BT_Path;
+
+// Nodes latched by a split or merge, released when it is done.
+// A level needs at most node and sibling, parent is next level.
+#define BT_MAX_HELD (2 * BT_MAX_HEIGHT + 1)
+typedef struct BT_Held {
+  int count;
+  BM_PageHandle ph[BT_MAX_HELD];
+  bool obsolete[BT_MAX_HELD];
+} BT_Held;
+
+// New nodes of a split, allocated before any node is changed.
+// Every level may split and the root gets a new parent.
+typedef struct BT_Spare {
+  int count;
+  BM_PageHandle ph[BT_MAX_HEIGHT + 1];
+} BT_Spare;
+
+#define HEADER_PAGE (FSM_MAP_PAGE(0) + 1)
+#define TREE_MGMT(tree) ((BT_TreeMgmtData*) (tree)->mgmtData)
+#define SPINS_BEFORE_YIELD 64
+
+// Minimum keys of a node which is not root
+#define MIN_LEAF_KEYS(n)  (((n) + 1) / 2)
+#define MIN_INNER_KEYS(n) ((n) / 2)
+#define MIN_KEYS(page,n)  (BT_HEADER(page)->isLeaf ? MIN_LEAF_KEYS(n) \
+                                                   : MIN_INNER_KEYS(n))
+
+// Bulk loading, sort workspace holds BT_LOAD_RUN_ENTRIES and a page
+#define ENTRIES_PER_PAGE ((int) (PAGE_SIZE / sizeof(BT_Entry)))
+#define LOAD_SORT_FRAMES (BT_LOAD_RUN_ENTRIES / ENTRIES_PER_PAGE + 1)
+
+#define LOAD_ROOT(t)      __atomic_load_n(&(t)->root, __ATOMIC_ACQUIRE)
+#define STORE_ROOT(t,pn)  __atomic_store_n(&(t)->root, (pn), __ATOMIC_RELEASE)
+
+// Not a interface
+static RC keyFromValue(DataType keyType, Value *val, BT_Key *key);
+static int keyCmp(DataType keyType, BT_Key a, BT_Key b);
+static int numKeysOf(char *page);
+static int lowerBound(DataType keyType, char *page, BT_Key key);
+static int upperBound(DataType keyType, char *page, BT_Key key);
+static bool readLockOrRestart(char *page, unsigned long long *version);
+static bool checkOrRestart(char *page, unsigned long long version);
+static bool upgradeToWriteLock(char *page, unsigned long long version);
+static void writeLock(char *page);
+static void writeUnlock(char *page, bool obsolete);
+static char *keptNode(BT_TreeMgmtData *t, PageNumber pn);
+static bool keepNode(BT_TreeMgmtData *t, BM_PageHandle *ph);
+static void releaseKeptNodes(BT_TreeMgmtData *t);
+static RC visitNode(BT_TreeMgmtData *t, PageNumber pn, BM_PageHandle *ph,
+                    bool *pinned);
+static void leaveNode(BT_TreeMgmtData *t, BM_PageHandle *ph, bool pinned);
+static bool tryOptimisticLeaf(BTreeHandle *tree, BT_Key *key,
+                              BM_PageHandle *ph,
+                              unsigned long long *version, RC *rc);
+static RC optimisticLeaf(BTreeHandle *tree, BT_Key *key, BM_PageHandle *ph,
+                         unsigned long long *version);
+static RC pinHeld(BT_TreeMgmtData *t, BT_Held *held, PageNumber pn,
+                  BM_PageHandle *ph);
+static void releaseHeld(BT_TreeMgmtData *t, BT_Held *held);
+static RC newNode(BT_TreeMgmtData *t, bool isLeaf, BM_PageHandle *ph);
+static RC reserveNodes(BT_TreeMgmtData *t, BT_Spare *spare, int count);
+static void returnNodes(BT_TreeMgmtData *t, BT_Spare *spare);
+static RC dropNode(BT_TreeMgmtData *t, BT_Held *held, BM_PageHandle *ph);
+static RC findLeaf(BTreeHandle *tree, BT_Key key, BT_Path *path);
+static void splitNode(BT_TreeMgmtData *t, BM_PageHandle *ph,
+                      BT_Spare *spare, BT_Key *sep, PageNumber *right);
+static RC insertIntoParents(BT_TreeMgmtData *t, BT_Held *held, BT_Path *path,
+                            BT_Spare *spare, BT_Key sep, PageNumber right);
+static RC insertWithSplits(BTreeHandle *tree, BT_Key key, RID rid);
+static void mergeNodes(BT_TreeMgmtData *t, char *left, char *right,
+                       char *parent, int sepIdx);
+static RC rebalance(BT_TreeMgmtData *t, BT_Held *held, BM_PageHandle *parent,
+                    int idx, BM_PageHandle *node);
+static RC deleteWithMerges(BTreeHandle *tree, BT_Key key);
+static void leafInsert(BT_TreeMgmtData *t, char *page, int pos, BT_Key key,
+                       RID rid);
+static void leafRemove(BT_TreeMgmtData *t, char *page, int pos);
+static RC writeTreeHeader(BT_TreeMgmtData *t, DataType keyType);
+static int entryCmp(const void *a, const void *b, void *keyType);
+static int nodeFill(int remaining, int per, int min, int max);
+static RC buildLeaves(BT_BulkLoad *load, FSM_BulkWriter *w,
+                      BT_Key *firstKeys, PageNumber *pages, int *count);
+static RC buildInnerLevel(BT_BulkLoad *load, FSM_BulkWriter *w,
+                          BT_Key *firstKeys, PageNumber *pages, int *count);
+
+/**************************************************
+ * Keys and node search
+ */
+static RC keyFromValue(DataType keyType, Value *val, BT_Key *key)
+{
+  if (val->dt != keyType)
+    RETURN(RC_RM_COMPARE_VALUE_OF_DIFFERENT_DATATYPE);
+
+  switch (val->dt)
+  {
+    case DT_INT:
+      key->intV= val->v.intV;
+      break;
+    case DT_BOOL:
+      key->intV= val->v.boolV;
+      break;
+    case DT_FLOAT:
+      key->floatV= val->v.floatV;
+      break;
+    default:
+      RETURN(RC_RM_UNKOWN_DATATYPE);
+  }
+  RETURN(RC_OK);
+}
+
+static int keyCmp(DataType keyType, BT_Key a, BT_Key b)
+{
+  if (keyType == DT_FLOAT)
+    return (a.floatV > b.floatV) - (a.floatV < b.floatV);
+  return (a.intV > b.intV) - (a.intV < b.intV);
+}
+
+// Key count of node read without latch can be garbage. Clamped
+// value keeps all reads inside the page, version check rejects them.
+static int numKeysOf(char *page)
+{
+  int numKeys= BT_HEADER(page)->numKeys;
+  if (numKeys < 0)
+    return 0;
+  return numKeys > BT_MAX_N + 1 ? BT_MAX_N + 1 : numKeys;
+}
+
+// First position with keys[pos] >= key
+static int lowerBound(DataType keyType, char *page, BT_Key key)
+{
+  BT_Key *keys= BT_KEYS(page);
+  int lo= 0, hi= numKeysOf(page), mid;
+
+  while (lo < hi)
+  {
+    mid= (lo + hi) / 2;
+    if (keyCmp(keyType, keys[mid], key) < 0)
+      lo= mid + 1;
+    else
+      hi= mid;
+  }
+  return lo;
+}
+
+// First position with keys[pos] > key. In inner node it is the child
+// whose subtree holds key.
+static int upperBound(DataType keyType, char *page, BT_Key key)
+{
+  BT_Key *keys= BT_KEYS(page);
+  int lo= 0, hi= numKeysOf(page), mid;
+
+  while (lo < hi)
+  {
+    mid= (lo + hi) / 2;
+    if (keyCmp(keyType, keys[mid], key) <= 0)
+      lo= mid + 1;
+    else
+      hi= mid;
+  }
+  return lo;
+}
+
+/**************************************************
+ * Node version latches
+ */
+
+// Wait until node is not latched, FALSE if node is obsolete.
+static bool readLockOrRestart(char *page, unsigned long long *version)
+{
+  unsigned long long *word= &BT_HEADER(page)->version;
+  unsigned long long v;
+  int spins= 0;
+
+  v= __atomic_load_n(word, __ATOMIC_ACQUIRE);
+  while (v & BT_VERSION_LOCKED)
+  {
+    if (++spins % SPINS_BEFORE_YIELD == 0)
+      sched_yield();
+    v= __atomic_load_n(word, __ATOMIC_ACQUIRE);
+  }
+
+  *version= v;
+  return !(v & BT_VERSION_OBSOLETE);
+}
+
+// TRUE if node did not change since version was read
+static bool checkOrRestart(char *page, unsigned long long version)
+{
+  __atomic_thread_fence(__ATOMIC_ACQUIRE);
+  return __atomic_load_n(&BT_HEADER(page)->version, __ATOMIC_RELAXED)
+         == version;
+}
+
+static bool upgradeToWriteLock(char *page, unsigned long long version)
+{
+  return __atomic_compare_exchange_n(&BT_HEADER(page)->version, &version,
+                                     version + BT_VERSION_LOCKED, FALSE,
+                                     __ATOMIC_ACQUIRE, __ATOMIC_RELAXED);
+}
+
+static void writeLock(char *page)
+{
+  unsigned long long v;
+
+  while (TRUE)
+  {
+    readLockOrRestart(page, &v);
+    if (upgradeToWriteLock(page, v))
+      return;
+  }
+}
+
+// Adding locked bit again clears it and counts up the version.
+static void writeUnlock(char *page, bool obsolete)
+{
+  __atomic_fetch_add(&BT_HEADER(page)->version,
+                     BT_VERSION_LOCKED + (obsolete ? BT_VERSION_OBSOLETE : 0),
+                     __ATOMIC_RELEASE);
+}
+
+/**************************************************
+ * Kept inner nodes
+ */
+
+// Data of kept node pn, NULL if it is not kept
+static char *keptNode(BT_TreeMgmtData *t, PageNumber pn)
+{
+  char **chunk;
+
+  if (pn < 0 || pn >= BT_KEEP_CHUNK * BT_KEEP_CHUNKS)
+    return NULL;
+  chunk= __atomic_load_n(&t->kept.chunks[pn / BT_KEEP_CHUNK],
+                         __ATOMIC_ACQUIRE);
+  if (!chunk)
+    return NULL;
+  return __atomic_load_n(&chunk[pn % BT_KEEP_CHUNK], __ATOMIC_ACQUIRE);
+}
+
+// Keep pinned node until index is closed. TRUE if pin of ph now
+// belongs to kept nodes, FALSE if caller still has to unpin it.
+static bool keepNode(BT_TreeMgmtData *t, BM_PageHandle *ph)
+{
+  BT_KeptNodes *k= &t->kept;
+  PageNumber pn= ph->pageNum;
+  char **chunk;
+  bool kept= FALSE;
+
+  if (pn < 0 || pn >= BT_KEEP_CHUNK * BT_KEEP_CHUNKS
+      || __atomic_load_n(&k->count, __ATOMIC_RELAXED) == BT_KEEP_MAX)
+    return FALSE;
+
+  pthread_mutex_lock(&k->mutex);
+  chunk= k->chunks[pn / BT_KEEP_CHUNK];
+  if (!chunk)
+  {
+    chunk= (char**) calloc(BT_KEEP_CHUNK, sizeof(char*));
+    if (chunk)
+      __atomic_store_n(&k->chunks[pn / BT_KEEP_CHUNK], chunk,
+                       __ATOMIC_RELEASE);
+  }
+  if (chunk && !chunk[pn % BT_KEEP_CHUNK] && k->count < BT_KEEP_MAX)
+  {
+    k->handles[k->count]= *ph;
+    __atomic_store_n(&k->count, k->count + 1, __ATOMIC_RELAXED);
+    __atomic_store_n(&chunk[pn % BT_KEEP_CHUNK], ph->data, __ATOMIC_RELEASE);
+    kept= TRUE;
+  }
+  pthread_mutex_unlock(&k->mutex);
+  return kept;
+}
+
+// Only when no other thread uses the index
+static void releaseKeptNodes(BT_TreeMgmtData *t)
+{
+  BT_KeptNodes *k= &t->kept;
+  int i;
+
+  for (i=0; i < k->count; i++)
+    unpinPage(&t->bm, &k->handles[i]);
+  for (i=0; i < BT_KEEP_CHUNKS; i++)
+    free(k->chunks[i]);
+  memset(k->chunks, 0, sizeof(k->chunks));
+  k->count= 0;
+}
+
+// Node pn for a descent. Kept node is used without a pin, then
+// *pinned is FALSE and leaveNode has nothing to unpin.
+static RC visitNode(BT_TreeMgmtData *t, PageNumber pn, BM_PageHandle *ph,
+                    bool *pinned)
+{
+  char *data= keptNode(t, pn);
+
+  if (data)
+  {
+    ph->pageNum= pn;
+    ph->data= data;
+    *pinned= FALSE;
+    return RC_OK;
+  }
+  *pinned= TRUE;
+  return pinPage(&t->bm, ph, pn);
+}
+
+static void leaveNode(BT_TreeMgmtData *t, BM_PageHandle *ph, bool pinned)
+{
+  if (pinned)
+    unpinPage(&t->bm, ph);
+}
+
+// One optimistic descent to the leaf of key, or leftmost leaf for
+// NULL key. FALSE if it has to be restarted. Leaf stays pinned.
+static bool tryOptimisticLeaf(BTreeHandle *tree, BT_Key *key,
+                              BM_PageHandle *ph,
+                              unsigned long long *version, RC *rc)
+{
+  BT_TreeMgmtData *t= TREE_MGMT(tree);
+  BM_PageHandle child;
+  unsigned long long v, cv;
+  PageNumber pn= LOAD_ROOT(t);
+  bool pinned, childPinned;
+
+  *rc= visitNode(t, pn, ph, &pinned);
+  if (*rc != RC_OK)
+    return TRUE;
+
+  // Root may have been split before we noted its version
+  if (!readLockOrRestart(ph->data, &v) || pn != LOAD_ROOT(t))
+  {
+    leaveNode(t, ph, pinned);
+    return FALSE;
+  }
+
+  while (!BT_HEADER(ph->data)->isLeaf)
+  {
+    pn= BT_CHILDREN(ph->data, t->n)[key == NULL ? 0
+                                    : upperBound(tree->keyType, ph->data, *key)];
+    if (!checkOrRestart(ph->data, v))
+    {
+      leaveNode(t, ph, pinned);
+      return FALSE;
+    }
+
+    *rc= visitNode(t, pn, &child, &childPinned);
+    if (*rc != RC_OK)
+    {
+      leaveNode(t, ph, pinned);
+      return TRUE;
+    }
+    if (!readLockOrRestart(child.data, &cv) || !checkOrRestart(ph->data, v))
+    {
+      leaveNode(t, &child, childPinned);
+      leaveNode(t, ph, pinned);
+      return FALSE;
+    }
+
+    // Node was checked to be inner, later descents skip the pool
+    if (pinned && keepNode(t, ph))
+      pinned= FALSE;
+    leaveNode(t, ph, pinned);
+    *ph= child;
+    pinned= childPinned;
+    v= cv;
+  }
+
+  // Leaf goes to caller pinned. A kept node that became a leaf is
+  // pinned in the frame it is kept in, so version v still holds.
+  if (!pinned)
+  {
+    *rc= pinPage(&t->bm, ph, ph->pageNum);
+    if (*rc != RC_OK)
+      return TRUE;
+  }
+
+  *version= v;
+  return TRUE;
+}
+
+static RC optimisticLeaf(BTreeHandle *tree, BT_Key *key, BM_PageHandle *ph,
+                         unsigned long long *version)
+{
+  RC rc;
+  while (!tryOptimisticLeaf(tree, key, ph, version, &rc))
+    ;
+  return rc;
+}
+
+/**************************************************
+ * Node allocation and latching of splits and merges
+ */
+
+// Pin and latch node for a split or merge, nodes already held are
+// returned as they are.
+static RC pinHeld(BT_TreeMgmtData *t, BT_Held *held, PageNumber pn,
+                  BM_PageHandle *ph)
+{
+  int i;
+  RC rc;
+
+  for (i=0; i < held->count; i++)
+  {
+    if (held->ph[i].pageNum == pn)
+    {
+      *ph= held->ph[i];
+      RETURN(RC_OK);
+    }
+  }
+
+  rc= pinPage(&t->bm, ph, pn);
+  if (rc != RC_OK)
+    RETURN(rc);
+  writeLock(ph->data);
+
+  held->ph[held->count]= *ph;
+  held->obsolete[held->count]= FALSE;
+  held->count++;
+  RETURN(RC_OK);
+}
+
+static void releaseHeld(BT_TreeMgmtData *t, BT_Held *held)
+{
+  int i;
+  for (i=0; i < held->count; i++)
+  {
+    writeUnlock(held->ph[i].data, held->obsolete[i]);
+    unpinPage(&t->bm, &held->ph[i]);
+  }
+  held->count= 0;
+}
+
+// Allocate and pin an empty node. It is not reachable yet, so it
+// is not latched. Version counts on from its previous use.
+static RC newNode(BT_TreeMgmtData *t, bool isLeaf, BM_PageHandle *ph)
+{
+  BT_NodeHeader *hdr;
+  unsigned long long version;
+  PageNumber pn;
+  RC rc;
+
+  rc= allocatePage(&t->fsm, &pn);
+  if (rc != RC_OK)
+    RETURN(rc);
+  rc= pinPage(&t->bm, ph, pn);
+  if (rc != RC_OK)
+  {
+    freePage(&t->fsm, pn);
+    RETURN(rc);
+  }
+
+  hdr= BT_HEADER(ph->data);
+  version= (hdr->magic == BT_NODE_MAGIC) ? hdr->version : 0;
+  memset(ph->data, 0, PAGE_SIZE);
+  hdr->version= (version | BT_VERSION_OBSOLETE | BT_VERSION_LOCKED) + 1;
+  hdr->magic= BT_NODE_MAGIC;
+  hdr->isLeaf= isLeaf;
+  hdr->numKeys= 0;
+  hdr->next= NO_PAGE;
+  markDirty(&t->bm, ph);
+
+  t->numNodes++;
+  RETURN(RC_OK);
+}
+
+// Allocate count new nodes for a split, all or none.
+static RC reserveNodes(BT_TreeMgmtData *t, BT_Spare *spare, int count)
+{
+  RC rc;
+
+  spare->count= 0;
+  while (spare->count < count)
+  {
+    rc= newNode(t, FALSE, &spare->ph[spare->count]);
+    if (rc != RC_OK)
+    {
+      returnNodes(t, spare);
+      RETURN(rc);
+    }
+    spare->count++;
+  }
+  RETURN(RC_OK);
+}
+
+// Free new nodes a split did not take, they were never reachable.
+static void returnNodes(BT_TreeMgmtData *t, BT_Spare *spare)
+{
+  while (spare->count > 0)
+  {
+    spare->count--;
+    freePage(&t->fsm, spare->ph[spare->count].pageNum);
+    unpinPage(&t->bm, &spare->ph[spare->count]);
+    t->numNodes--;
+  }
+}
+
+// Give back held node, it becomes obsolete when released.
+static RC dropNode(BT_TreeMgmtData *t, BT_Held *held, BM_PageHandle *ph)
+{
+  int i;
+
+  for (i=0; i < held->count; i++)
+    if (held->ph[i].pageNum == ph->pageNum)
+      held->obsolete[i]= TRUE;
+  markDirty(&t->bm, ph);
+  t->numNodes--;
+  return freePage(&t->fsm, ph->pageNum);
+}
+
+// Path to leaf of key, only used while structLock is held exclusive.
+static RC findLeaf(BTreeHandle *tree, BT_Key key, BT_Path *path)
+{
+  BT_TreeMgmtData *t= TREE_MGMT(tree);
+  BM_PageHandle ph;
+  PageNumber pn= t->root;
+  int idx;
+  RC rc;
+
+  path->depth= 0;
+  while (TRUE)
+  {
+    rc= pinPage(&t->bm, &ph, pn);
+    if (rc != RC_OK)
+      RETURN(rc);
+
+    path->pages[path->depth]= pn;
+    if (BT_HEADER(ph.data)->isLeaf)
+    {
+      path->childIdx[path->depth++]= -1;
+      unpinPage(&t->bm, &ph);
+      RETURN(RC_OK);
+    }
+
+    idx= upperBound(tree->keyType, ph.data, key);
+    path->childIdx[path->depth++]= idx;
+    pn= BT_CHILDREN(ph.data, t->n)[idx];
+    unpinPage(&t->bm, &ph);
+  }
+}
+
+/**************************************************
+ * Leaf changes, leaf is latched
+ */
+static void leafInsert(BT_TreeMgmtData *t, char *page, int pos, BT_Key key,
+                       RID rid)
+{
+  BT_NodeHeader *hdr= BT_HEADER(page);
+  int n= t->n;
+
+  memmove(&BT_KEYS(page)[pos + 1], &BT_KEYS(page)[pos],
+          (hdr->numKeys - pos) * sizeof(BT_Key));
+  memmove(&BT_RIDS(page, n)[pos + 1], &BT_RIDS(page, n)[pos],
+          (hdr->numKeys - pos) * sizeof(RID));
+  BT_KEYS(page)[pos]= key;
+  BT_RIDS(page, n)[pos]= rid;
+  hdr->numKeys++;
+  __atomic_fetch_add(&t->numEntries, 1, __ATOMIC_RELAXED);
+}
+
+static void leafRemove(BT_TreeMgmtData *t, char *page, int pos)
+{
+  BT_NodeHeader *hdr= BT_HEADER(page);
+  int n= t->n;
+
+  memmove(&BT_KEYS(page)[pos], &BT_KEYS(page)[pos + 1],
+          (hdr->numKeys - pos - 1) * sizeof(BT_Key));
+  memmove(&BT_RIDS(page, n)[pos], &BT_RIDS(page, n)[pos + 1],
+          (hdr->numKeys - pos - 1) * sizeof(RID));
+  hdr->numKeys--;
+  __atomic_fetch_sub(&t->numEntries, 1, __ATOMIC_RELAXED);
+}
+
+/**************************************************
+ * Insert
+ */
+
+// Split latched node holding n+1 keys. Right half goes to a spare
+// node, sep is the key parent gets for it.
+static void splitNode(BT_TreeMgmtData *t, BM_PageHandle *ph,
+                      BT_Spare *spare, BT_Key *sep, PageNumber *right)
+{
+  BM_PageHandle rph= spare->ph[--spare->count];
+  BT_NodeHeader *lhdr= BT_HEADER(ph->data);
+  BT_NodeHeader *rhdr= BT_HEADER(rph.data);
+  int n= t->n, total= lhdr->numKeys, mid;
+
+  rhdr->isLeaf= lhdr->isLeaf;
+
+  if (lhdr->isLeaf)
+  {
+    // Left keeps bigger half, separator is copied up.
+    mid= (total + 1) / 2;
+    rhdr->numKeys= total - mid;
+    memcpy(BT_KEYS(rph.data), &BT_KEYS(ph->data)[mid],
+           rhdr->numKeys * sizeof(BT_Key));
+    memcpy(BT_RIDS(rph.data, n), &BT_RIDS(ph->data, n)[mid],
+           rhdr->numKeys * sizeof(RID));
+    rhdr->next= lhdr->next;
+    lhdr->next= rph.pageNum;
+    *sep= BT_KEYS(rph.data)[0];
+  }
+  else
+  {
+    // Middle key moves up.
+    mid= total / 2;
+    rhdr->numKeys= total - mid - 1;
+    memcpy(BT_KEYS(rph.data), &BT_KEYS(ph->data)[mid + 1],
+           rhdr->numKeys * sizeof(BT_Key));
+    memcpy(BT_CHILDREN(rph.data, n), &BT_CHILDREN(ph->data, n)[mid + 1],
+           (rhdr->numKeys + 1) * sizeof(PageNumber));
+    *sep= BT_KEYS(ph->data)[mid];
+  }
+  lhdr->numKeys= mid;
+
+  *right= rph.pageNum;
+  markDirty(&t->bm, ph);
+  markDirty(&t->bm, &rph);
+  unpinPage(&t->bm, &rph);
+}
+
+// Add separator of split node at path->depth-1 to its parents,
+// splitting them as long as they overflow. Parents are held already.
+static RC insertIntoParents(BT_TreeMgmtData *t, BT_Held *held, BT_Path *path,
+                            BT_Spare *spare, BT_Key sep, PageNumber right)
+{
+  BM_PageHandle ph;
+  BT_NodeHeader *hdr;
+  BT_Key *keys;
+  PageNumber *children;
+  int level, idx, n= t->n;
+  RC rc;
+
+  for (level= path->depth - 2; level >= 0; level--)
+  {
+    rc= pinHeld(t, held, path->pages[level], &ph);
+    if (rc != RC_OK)
+      RETURN(rc);
+
+    hdr= BT_HEADER(ph.data);
+    keys= BT_KEYS(ph.data);
+    children= BT_CHILDREN(ph.data, n);
+    idx= path->childIdx[level];
+
+    memmove(&keys[idx + 1], &keys[idx], (hdr->numKeys - idx) * sizeof(BT_Key));
+    memmove(&children[idx + 2], &children[idx + 1],
+            (hdr->numKeys - idx) * sizeof(PageNumber));
+    keys[idx]= sep;
+    children[idx + 1]= right;
+    hdr->numKeys++;
+    markDirty(&t->bm, &ph);
+
+    if (hdr->numKeys <= n)
+      RETURN(RC_OK);
+
+    splitNode(t, &ph, spare, &sep, &right);
+  }
+
+  // Root was split, tree grows by one level.
+  ph= spare->ph[--spare->count];
+  hdr= BT_HEADER(ph.data);
+  hdr->numKeys= 1;
+  BT_KEYS(ph.data)[0]= sep;
+  BT_CHILDREN(ph.data, n)[0]= path->pages[0];
+  BT_CHILDREN(ph.data, n)[1]= right;
+  unpinPage(&t->bm, &ph);
+
+  // Old root is still latched, readers that started at it restart.
+  STORE_ROOT(t, ph.pageNum);
+  t->height++;
+  RETURN(RC_OK);
+}
+
+// Insert which may split nodes, no other writer runs meanwhile.
+static RC insertWithSplits(BTreeHandle *tree, BT_Key key, RID rid)
+{
+  BT_TreeMgmtData *t= TREE_MGMT(tree);
+  BM_PageHandle ph, parent;
+  BT_Held held;
+  BT_Spare spare;
+  BT_Path path;
+  BT_Key sep;
+  PageNumber right;
+  int pos, level, need= 0;
+  RC rc;
+
+  held.count= 0;
+  spare.count= 0;
+  rc= findLeaf(tree, key, &path);
+  if (rc == RC_OK)
+    rc= pinHeld(t, &held, path.pages[path.depth - 1], &ph);
+  if (rc != RC_OK)
+    RETURN(rc);
+
+  pos= lowerBound(tree->keyType, ph.data, key);
+  if (pos < BT_HEADER(ph.data)->numKeys
+      && keyCmp(tree->keyType, BT_KEYS(ph.data)[pos], key) == 0)
+  {
+    releaseHeld(t, &held);
+    RETURN(RC_IM_KEY_ALREADY_EXISTS);
+  }
+
+  // Full nodes up from leaf split, then the root gets a new parent.
+  if (BT_HEADER(ph.data)->numKeys >= t->n)
+  {
+    need= 1;
+    for (level= path.depth - 2; level >= 0; level--)
+    {
+      rc= pinHeld(t, &held, path.pages[level], &parent);
+      if (rc != RC_OK || BT_HEADER(parent.data)->numKeys < t->n)
+        break;
+      need++;
+    }
+    if (level < 0)
+      need++;
+    if (rc == RC_OK)
+      rc= reserveNodes(t, &spare, need);
+    if (rc != RC_OK)
+    {
+      releaseHeld(t, &held);
+      RETURN(rc);
+    }
+  }
+
+  leafInsert(t, ph.data, pos, key, rid);
+  markDirty(&t->bm, &ph);
+
+  if (BT_HEADER(ph.data)->numKeys > t->n)
+  {
+    splitNode(t, &ph, &spare, &sep, &right);
+    rc= insertIntoParents(t, &held, &path, &spare, sep, right);
+  }
+  returnNodes(t, &spare);
+  releaseHeld(t, &held);
+
+  RETURN(rc);
+}
+
+/**************************************************
+ * Delete
+ */
+
+// Append right node to left one and remove it from parent.
+static void mergeNodes(BT_TreeMgmtData *t, char *left, char *right,
+                       char *parent, int sepIdx)
+{
+  BT_NodeHeader *lhdr= BT_HEADER(left);
+  BT_NodeHeader *rhdr= BT_HEADER(right);
+  BT_NodeHeader *phdr= BT_HEADER(parent);
+  BT_Key *pkeys= BT_KEYS(parent);
+  PageNumber *pchildren= BT_CHILDREN(parent, t->n);
+  int n= t->n, lk= lhdr->numKeys;
+
+  if (lhdr->isLeaf)
+  {
+    memcpy(&BT_KEYS(left)[lk], BT_KEYS(right), rhdr->numKeys * sizeof(BT_Key));
+    memcpy(&BT_RIDS(left, n)[lk], BT_RIDS(right, n),
+           rhdr->numKeys * sizeof(RID));
+    lhdr->numKeys+= rhdr->numKeys;
+    lhdr->next= rhdr->next;
+  }
+  else
+  {
+    // Separator comes down between both key sets
+    BT_KEYS(left)[lk]= pkeys[sepIdx];
+    memcpy(&BT_KEYS(left)[lk + 1], BT_KEYS(right),
+           rhdr->numKeys * sizeof(BT_Key));
+    memcpy(&BT_CHILDREN(left, n)[lk + 1], BT_CHILDREN(right, n),
+           (rhdr->numKeys + 1) * sizeof(PageNumber));
+    lhdr->numKeys+= rhdr->numKeys + 1;
+  }
+
+  memmove(&pkeys[sepIdx], &pkeys[sepIdx + 1],
+          (phdr->numKeys - sepIdx - 1) * sizeof(BT_Key));
+  memmove(&pchildren[sepIdx + 1], &pchildren[sepIdx + 2],
+          (phdr->numKeys - sepIdx - 1) * sizeof(PageNumber));
+  phdr->numKeys--;
+}
+
+// Fix underflow of held node, child idx of held parent. Borrows from
+// a sibling or merges with it.
+static RC rebalance(BT_TreeMgmtData *t, BT_Held *held, BM_PageHandle *parent,
+                    int idx, BM_PageHandle *node)
+{
+  BM_PageHandle sph;
+  BT_NodeHeader *nhdr= BT_HEADER(node->data);
+  BT_NodeHeader *shdr;
+  BT_Key *pkeys= BT_KEYS(parent->data);
+  BT_Key *nkeys= BT_KEYS(node->data);
+  BT_Key *skeys;
+  PageNumber *pchildren= BT_CHILDREN(parent->data, t->n);
+  int n= t->n, last;
+  bool fromLeft= (idx > 0);
+  RC rc;
+
+  rc= pinHeld(t, held, pchildren[fromLeft ? idx - 1 : idx + 1], &sph);
+  if (rc != RC_OK)
+    RETURN(rc);
+  shdr= BT_HEADER(sph.data);
+  skeys= BT_KEYS(sph.data);
+
+  markDirty(&t->bm, parent);
+  markDirty(&t->bm, node);
+  markDirty(&t->bm, &sph);
+
+  if (shdr->numKeys > MIN_KEYS(sph.data, n) && fromLeft)
+  {
+    // Last entry of left sibling becomes first of node
+    last= shdr->numKeys - 1;
+    memmove(&nkeys[1], nkeys, nhdr->numKeys * sizeof(BT_Key));
+    if (nhdr->isLeaf)
+    {
+      memmove(&BT_RIDS(node->data, n)[1], BT_RIDS(node->data, n),
+              nhdr->numKeys * sizeof(RID));
+      nkeys[0]= skeys[last];
+      BT_RIDS(node->data, n)[0]= BT_RIDS(sph.data, n)[last];
+      pkeys[idx - 1]= nkeys[0];
+    }
+    else
+    {
+      memmove(&BT_CHILDREN(node->data, n)[1], BT_CHILDREN(node->data, n),
+              (nhdr->numKeys + 1) * sizeof(PageNumber));
+      nkeys[0]= pkeys[idx - 1];
+      BT_CHILDREN(node->data, n)[0]= BT_CHILDREN(sph.data, n)[last + 1];
+      pkeys[idx - 1]= skeys[last];
+    }
+    nhdr->numKeys++;
+    shdr->numKeys--;
+  }
+  else if (shdr->numKeys > MIN_KEYS(sph.data, n))
+  {
+    // First entry of right sibling becomes last of node
+    if (nhdr->isLeaf)
+    {
+      nkeys[nhdr->numKeys]= skeys[0];
+      BT_RIDS(node->data, n)[nhdr->numKeys]= BT_RIDS(sph.data, n)[0];
+      memmove(BT_RIDS(sph.data, n), &BT_RIDS(sph.data, n)[1],
+              (shdr->numKeys - 1) * sizeof(RID));
+      memmove(skeys, &skeys[1], (shdr->numKeys - 1) * sizeof(BT_Key));
+      pkeys[idx]= skeys[0];
+    }
+    else
+    {
+      nkeys[nhdr->numKeys]= pkeys[idx];
+      BT_CHILDREN(node->data, n)[nhdr->numKeys + 1]= BT_CHILDREN(sph.data, n)[0];
+      pkeys[idx]= skeys[0];
+      memmove(skeys, &skeys[1], (shdr->numKeys - 1) * sizeof(BT_Key));
+      memmove(BT_CHILDREN(sph.data, n), &BT_CHILDREN(sph.data, n)[1],
+              shdr->numKeys * sizeof(PageNumber));
+    }
+    nhdr->numKeys++;
+    shdr->numKeys--;
+  }
+  else if (fromLeft)
+  {
+    mergeNodes(t, sph.data, node->data, parent->data, idx - 1);
+    rc= dropNode(t, held, node);
+  }
+  else
+  {
+    mergeNodes(t, node->data, sph.data, parent->data, idx);
+    rc= dropNode(t, held, &sph);
+  }
+
+  RETURN(rc);
+}
+
+// Delete which may merge nodes, no other writer runs meanwhile.
+static RC deleteWithMerges(BTreeHandle *tree, BT_Key key)
+{
+  BT_TreeMgmtData *t= TREE_MGMT(tree);
+  BM_PageHandle ph, parent, sibling;
+  BT_NodeHeader *hdr;
+  BT_Held held;
+  BT_Path path;
+  int pos, level, idx, numKeys, n= t->n;
+  RC rc, freeRc;
+
+  held.count= 0;
+  rc= findLeaf(tree, key, &path);
+  if (rc == RC_OK)
+    rc= pinHeld(t, &held, path.pages[path.depth - 1], &ph);
+  if (rc != RC_OK)
+    RETURN(rc);
+
+  pos= lowerBound(tree->keyType, ph.data, key);
+  if (pos == BT_HEADER(ph.data)->numKeys
+      || keyCmp(tree->keyType, BT_KEYS(ph.data)[pos], key) != 0)
+  {
+    releaseHeld(t, &held);
+    RETURN(RC_IM_KEY_NOT_FOUND);
+  }
+
+  // Hold parent and sibling of every node that will underflow. A
+  // borrow ends it, a merge takes a key from the parent.
+  parent= ph;
+  numKeys= BT_HEADER(ph.data)->numKeys - 1;
+  for (level= path.depth - 1;
+       level > 0 && numKeys < MIN_KEYS(parent.data, n); level--)
+  {
+    idx= path.childIdx[level - 1];
+    rc= pinHeld(t, &held, path.pages[level - 1], &parent);
+    if (rc == RC_OK)
+      rc= pinHeld(t, &held,
+                  BT_CHILDREN(parent.data, n)[idx > 0 ? idx - 1 : idx + 1],
+                  &sibling);
+    if (rc != RC_OK)
+    {
+      releaseHeld(t, &held);
+      RETURN(rc);
+    }
+    if (BT_HEADER(sibling.data)->numKeys > MIN_KEYS(sibling.data, n))
+      break;
+    numKeys= BT_HEADER(parent.data)->numKeys - 1;
+  }
+
+  leafRemove(t, ph.data, pos);
+  markDirty(&t->bm, &ph);
+
+  // Rebalance underflowed nodes bottom up. Nodes are held, only a
+  // freed page can fail to go back to the free space map, which
+  // loses the page but not the tree.
+  for (level= path.depth - 1; level > 0; level--)
+  {
+    if (BT_HEADER(ph.data)->numKeys >= MIN_KEYS(ph.data, n))
+      break;
+
+    pinHeld(t, &held, path.pages[level - 1], &parent);
+    freeRc= rebalance(t, &held, &parent, path.childIdx[level - 1], &ph);
+    if (rc == RC_OK)
+      rc= freeRc;
+    ph= parent;
+  }
+
+  // Root without keys left gives its place to its only child
+  hdr= BT_HEADER(ph.data);
+  if (level == 0 && !hdr->isLeaf && hdr->numKeys == 0)
+  {
+    STORE_ROOT(t, BT_CHILDREN(ph.data, n)[0]);
+    t->height--;
+    freeRc= dropNode(t, &held, &ph);
+    if (rc == RC_OK)
+      rc= freeRc;
+  }
+  releaseHeld(t, &held);
+
+  RETURN(rc);
+}
+
+/**************************************************
+ * init and shutdown index manager
+ */
+RC initIndexManager (void *mgmtData)
+{
+  initStorageManager();
+  RETURN(RC_OK);
+}
+
+RC shutdownIndexManager ()
+{
+  RETURN(RC_OK);
+}
+
+/**************************************************
+ * create, destroy, open, and close an btree index
+ */
+static RC writeTreeHeader(BT_TreeMgmtData *t, DataType keyType)
+{
+  BM_PageHandle ph;
+  BT_TreeHeader *hdr;
+  RC rc;
+
+  rc= pinPage(&t->bm, &ph, HEADER_PAGE);
+  if (rc != RC_OK)
+    RETURN(rc);
+
+  hdr= (BT_TreeHeader*) ph.data;
+  hdr->magic= BT_TREE_MAGIC;
+  hdr->keyType= keyType;
+  hdr->n= t->n;
+  hdr->root= t->root;
+  hdr->height= t->height;
+  hdr->numNodes= t->numNodes;
+  hdr->numEntries= t->numEntries;
+
+  markDirty(&t->bm, &ph);
+  unpinPage(&t->bm, &ph);
+  RETURN(RC_OK);
+}
+
+RC createBtree (char *idxId, DataType keyType, int n)
+{
+  BT_TreeMgmtData t;
+  BM_PageHandle ph;
+  PageNumber headerPage;
+  RC rc;
+
+  if (n < 2 || n > BT_MAX_N)
+    RETURN(RC_IM_N_TO_LAGE);
+  if (keyType == DT_STRING)
+    RETURN(RC_RM_UNKOWN_DATATYPE);
+
+  rc= createPageFile(idxId);
+  if (rc != RC_OK)
+    RETURN(rc);
+  rc= initBufferPool(&t.bm, idxId, BT_POOL_PAGES, RS_LRU, NULL);
+  if (rc != RC_OK)
+    RETURN(rc);
+  rc= initFreeSpaceMap(&t.fsm, &t.bm);
+  if (rc != RC_OK)
+  {
+    shutdownBufferPool(&t.bm);
+    RETURN(rc);
+  }
+
+  t.n= n;
+  t.height= 1;
+  t.numNodes= 0;
+  t.numEntries= 0;
+
+  // Header is first page allocated, root is an empty leaf.
+  rc= allocatePage(&t.fsm, &headerPage);
+  if (rc == RC_OK)
+    rc= newNode(&t, TRUE, &ph);
+  if (rc == RC_OK)
+  {
+    t.root= ph.pageNum;
+    unpinPage(&t.bm, &ph);
+    rc= writeTreeHeader(&t, keyType);
+  }
+
+  shutdownFreeSpaceMap(&t.fsm);
+  if (rc != RC_OK)
+  {
+    shutdownBufferPool(&t.bm);
+    RETURN(rc);
+  }
+  return shutdownBufferPool(&t.bm);
+}
+
+RC openBtree (BTreeHandle **tree, char *idxId)
+{
+  BT_TreeMgmtData *t;
+  BT_TreeHeader *hdr;
+  BM_PageHandle ph;
+  pthread_rwlockattr_t lockAttr;
+  RC rc;
+
+  t= (BT_TreeMgmtData*) malloc(sizeof(BT_TreeMgmtData));
+  rc= initBufferPool(&t->bm, idxId, BT_POOL_PAGES, RS_LRU, NULL);
+  if (rc != RC_OK)
+  {
+    free(t);
+    RETURN(rc);
+  }
+  rc= initFreeSpaceMap(&t->fsm, &t->bm);
+  if (rc == RC_OK)
+    rc= pinPage(&t->bm, &ph, HEADER_PAGE);
+  if (rc != RC_OK || ((BT_TreeHeader*) ph.data)->magic != BT_TREE_MAGIC)
+  {
+    if (rc == RC_OK)
+      unpinPage(&t->bm, &ph);
+    shutdownFreeSpaceMap(&t->fsm);
+    shutdownBufferPool(&t->bm);
+    free(t);
+    RETURN(rc != RC_OK ? rc : RC_FILE_NOT_FOUND);
+  }
+
+  hdr= (BT_TreeHeader*) ph.data;
+  t->n= hdr->n;
+  t->root= hdr->root;
+  t->height= hdr->height;
+  t->numNodes= hdr->numNodes;
+  t->numEntries= hdr->numEntries;
+  pthread_rwlockattr_init(&lockAttr);
+  pthread_rwlockattr_setkind_np(&lockAttr,
+                                PTHREAD_RWLOCK_PREFER_WRITER_NONRECURSIVE_NP);
+  pthread_rwlock_init(&t->structLock, &lockAttr);
+  pthread_rwlockattr_destroy(&lockAttr);
+  memset(&t->kept, 0, sizeof(BT_KeptNodes));
+  pthread_mutex_init(&t->kept.mutex, NULL);
+
+  *tree= (BTreeHandle*) malloc(sizeof(BTreeHandle));
+  (*tree)->keyType= (DataType) hdr->keyType;
+  (*tree)->idxId= strdup(idxId);
+  (*tree)->mgmtData= t;
+  unpinPage(&t->bm, &ph);
+
+  RETURN(RC_OK);
+}
+
+RC closeBtree (BTreeHandle *tree)
+{
+  BT_TreeMgmtData *t= TREE_MGMT(tree);
+  RC rc;
+
+  rc= writeTreeHeader(t, tree->keyType);
+  if (rc != RC_OK)
+    RETURN(rc);
+  releaseKeptNodes(t);
+  shutdownFreeSpaceMap(&t->fsm);
+  rc= shutdownBufferPool(&t->bm);
+  if (rc != RC_OK)
+    RETURN(rc);
+
+  pthread_rwlock_destroy(&t->structLock);
+  pthread_mutex_destroy(&t->kept.mutex);
+  free(tree->idxId);
+  free(t);
+  free(tree);
+  RETURN(RC_OK);
+}
+
+RC deleteBtree (char *idxId)
+{
+  return destroyPageFile(idxId);
+}
+
+/**************************************************
+ * access information about a b-tree
+ */
+RC getNumNodes (BTreeHandle *tree, int *result)
+{
+  *result= TREE_MGMT(tree)->numNodes;
+  RETURN(RC_OK);
+}
+
+RC getNumEntries (BTreeHandle *tree, int *result)
+{
+  *result= __atomic_load_n(&TREE_MGMT(tree)->numEntries, __ATOMIC_RELAXED);
+  RETURN(RC_OK);
+}
+
+RC getKeyType (BTreeHandle *tree, DataType *result)
+{
+  *result= tree->keyType;
+  RETURN(RC_OK);
+}
+
+/**************************************************
+ * index access
+ */
+RC findKey (BTreeHandle *tree, Value *key, RID *result)
+{
+  BT_TreeMgmtData *t= TREE_MGMT(tree);
+  BM_PageHandle ph;
+  unsigned long long v;
+  BT_Key k;
+  RID rid;
+  bool found;
+  int pos;
+  RC rc;
+
+  rc= keyFromValue(tree->keyType, key, &k);
+  if (rc != RC_OK)
+    RETURN(rc);
+
+  while (TRUE)
+  {
+    rc= optimisticLeaf(tree, &k, &ph, &v);
+    if (rc != RC_OK)
+      RETURN(rc);
+
+    pos= lowerBound(tree->keyType, ph.data, k);
+    found= (pos < numKeysOf(ph.data)
+            && keyCmp(tree->keyType, BT_KEYS(ph.data)[pos], k) == 0);
+    if (found)
+      rid= BT_RIDS(ph.data, t->n)[pos];
+
+    if (checkOrRestart(ph.data, v))
+      break;
+    unpinPage(&t->bm, &ph);
+  }
+  unpinPage(&t->bm, &ph);
+
+  if (!found)
+    RETURN(RC_IM_KEY_NOT_FOUND);
+  *result= rid;
+  RETURN(RC_OK);
+}
+
+RC insertKey (BTreeHandle *tree, Value *key, RID rid)
+{
+  BT_TreeMgmtData *t= TREE_MGMT(tree);
+  BM_PageHandle ph;
+  unsigned long long v;
+  BT_Key k;
+  int pos;
+  RC rc;
+
+  rc= keyFromValue(tree->keyType, key, &k);
+  if (rc != RC_OK)
+    RETURN(rc);
+
+  // Try to insert in leaf without split
+  pthread_rwlock_rdlock(&t->structLock);
+  while (TRUE)
+  {
+    rc= optimisticLeaf(tree, &k, &ph, &v);
+    if (rc != RC_OK)
+    {
+      pthread_rwlock_unlock(&t->structLock);
+      RETURN(rc);
+    }
+    if (upgradeToWriteLock(ph.data, v))
+      break;
+    unpinPage(&t->bm, &ph);
+  }
+
+  pos= lowerBound(tree->keyType, ph.data, k);
+  if (pos < BT_HEADER(ph.data)->numKeys
+      && keyCmp(tree->keyType, BT_KEYS(ph.data)[pos], k) == 0)
+    rc= RC_IM_KEY_ALREADY_EXISTS;
+  else if (BT_HEADER(ph.data)->numKeys < t->n)
+  {
+    leafInsert(t, ph.data, pos, k, rid);
+    markDirty(&t->bm, &ph);
+  }
+  else
+    rc= RC_IM_N_TO_LAGE;  // Leaf is full
+  writeUnlock(ph.data, FALSE);
+  unpinPage(&t->bm, &ph);
+  pthread_rwlock_unlock(&t->structLock);
+
+  if (rc != RC_IM_N_TO_LAGE)
+    RETURN(rc);
+
+  pthread_rwlock_wrlock(&t->structLock);
+  rc= insertWithSplits(tree, k, rid);
+  pthread_rwlock_unlock(&t->structLock);
+  RETURN(rc);
+}
+
+RC deleteKey (BTreeHandle *tree, Value *key)
+{
+  BT_TreeMgmtData *t= TREE_MGMT(tree);
+  BM_PageHandle ph;
+  unsigned long long v;
+  BT_Key k;
+  int pos;
+  RC rc;
+
+  rc= keyFromValue(tree->keyType, key, &k);
+  if (rc != RC_OK)
+    RETURN(rc);
+
+  // Try to delete from leaf without rebalancing
+  pthread_rwlock_rdlock(&t->structLock);
+  while (TRUE)
+  {
+    rc= optimisticLeaf(tree, &k, &ph, &v);
+    if (rc != RC_OK)
+    {
+      pthread_rwlock_unlock(&t->structLock);
+      RETURN(rc);
+    }
+    if (upgradeToWriteLock(ph.data, v))
+      break;
+    unpinPage(&t->bm, &ph);
+  }
+
+  pos= lowerBound(tree->keyType, ph.data, k);
+  if (pos == BT_HEADER(ph.data)->numKeys
+      || keyCmp(tree->keyType, BT_KEYS(ph.data)[pos], k) != 0)
+    rc= RC_IM_KEY_NOT_FOUND;
+  else if (BT_HEADER(ph.data)->numKeys > MIN_LEAF_KEYS(t->n)
+           || ph.pageNum == LOAD_ROOT(t))
+  {
+    leafRemove(t, ph.data, pos);
+    markDirty(&t->bm, &ph);
+  }
+  else
+    rc= RC_IM_N_TO_LAGE;  // Leaf would underflow
+  writeUnlock(ph.data, FALSE);
+  unpinPage(&t->bm, &ph);
+  pthread_rwlock_unlock(&t->structLock);
+
+  if (rc != RC_IM_N_TO_LAGE)
+    RETURN(rc);
+
+  pthread_rwlock_wrlock(&t->structLock);
+  rc= deleteWithMerges(tree, k);
+  pthread_rwlock_unlock(&t->structLock);
+  RETURN(rc);
+}
+
+RC openTreeScan (BTreeHandle *tree, BT_ScanHandle **handle)
+{
+  return openTreeRangeScan(tree, NULL, NULL, handle);
+}
+
+RC openTreeRangeScan (BTreeHandle *tree, Value *low, Value *high,
+                      BT_ScanHandle **handle)
+{
+  BT_ScanMgmtData *sm;
+  BT_Key lowKey, highKey;
+  RC rc;
+
+  lowKey.intV= 0;
+  highKey.intV= 0;
+  if (low != NULL && (rc= keyFromValue(tree->keyType, low, &lowKey)) != RC_OK)
+    RETURN(rc);
+  if (high != NULL && (rc= keyFromValue(tree->keyType, high, &highKey)) != RC_OK)
+    RETURN(rc);
+
+  sm= (BT_ScanMgmtData*) malloc(sizeof(BT_ScanMgmtData));
+  sm->leaf= NO_PAGE;
+  sm->leafVersion= 0;
+  sm->done= FALSE;
+  sm->hasLast= FALSE;
+  sm->hasLow= (low != NULL);
+  sm->low= lowKey;
+  sm->hasHigh= (high != NULL);
+  sm->high= highKey;
+
+  *handle= (BT_ScanHandle*) malloc(sizeof(BT_ScanHandle));
+  (*handle)->tree= tree;
+  (*handle)->mgmtData= sm;
+  RETURN(RC_OK);
+}
+
+// Returns entry following last one returned. Leaves are read
+// optimistically. Scan goes right from leaf to leaf the way readers go
+// down, and searches last key from root when a leaf changed.
+RC nextEntry (BT_ScanHandle *handle, RID *result)
+{
+  BTreeHandle *tree= handle->tree;
+  BT_TreeMgmtData *t= TREE_MGMT(tree);
+  BT_ScanMgmtData *sm= (BT_ScanMgmtData*) handle->mgmtData;
+  BM_PageHandle ph, nph;
+  unsigned long long v, nv;
+  BT_Key *from, key;
+  PageNumber next;
+  RID rid;
+  bool ok;
+  int pos, numKeys;
+  RC rc;
+
+  from= sm->hasLast ? &sm->last : (sm->hasLow ? &sm->low : NULL);
+  while (!sm->done)
+  {
+    if (sm->leaf == NO_PAGE)
+    {
+      rc= optimisticLeaf(tree, from, &ph, &v);
+      if (rc != RC_OK)
+        RETURN(rc);
+    }
+    else
+    {
+      rc= pinPage(&t->bm, &ph, sm->leaf);
+      if (rc != RC_OK)
+        RETURN(rc);
+      v= sm->leafVersion;
+      if (!checkOrRestart(ph.data, v))
+      {
+        unpinPage(&t->bm, &ph);
+        sm->leaf= NO_PAGE;
+        continue;
+      }
+    }
+
+    while (TRUE)
+    {
+      if (from == NULL)
+        pos= 0;
+      else if (sm->hasLast)
+        pos= upperBound(tree->keyType, ph.data, *from);
+      else
+        pos= lowerBound(tree->keyType, ph.data, *from);
+
+      numKeys= numKeysOf(ph.data);
+      if (pos < numKeys)
+      {
+        key= BT_KEYS(ph.data)[pos];
+        rid= BT_RIDS(ph.data, t->n)[pos];
+      }
+      next= BT_HEADER(ph.data)->next;
+
+      if (!checkOrRestart(ph.data, v))
+      {
+        unpinPage(&t->bm, &ph);
+        sm->leaf= NO_PAGE;
+        break;
+      }
+
+      if (pos < numKeys)
+      {
+        sm->leaf= ph.pageNum;
+        sm->leafVersion= v;
+        unpinPage(&t->bm, &ph);
+        if (sm->hasHigh && keyCmp(tree->keyType, key, sm->high) > 0)
+        {
+          sm->done= TRUE;
+          break;
+        }
+        sm->last= key;
+        sm->hasLast= TRUE;
+        *result= rid;
+        RETURN(RC_OK);
+      }
+
+      if (next == NO_PAGE)
+      {
+        unpinPage(&t->bm, &ph);
+        sm->done= TRUE;
+        break;
+      }
+
+      // Leaf has no more keys for us, go right while it is unchanged
+      rc= pinPage(&t->bm, &nph, next);
+      if (rc != RC_OK)
+      {
+        unpinPage(&t->bm, &ph);
+        RETURN(rc);
+      }
+      ok= readLockOrRestart(nph.data, &nv) && checkOrRestart(ph.data, v);
+      unpinPage(&t->bm, &ph);
+      if (!ok)
+      {
+        unpinPage(&t->bm, &nph);
+        sm->leaf= NO_PAGE;
+        break;
+      }
+      ph= nph;
+      v= nv;
+    }
+  }
+
+  RETURN(RC_IM_NO_MORE_ENTRIES);
+}
+
+RC closeTreeScan (BT_ScanHandle *handle)
+{
+  free(handle->mgmtData);
+  free(handle);
+  RETURN(RC_OK);
+}
+
+/**************************************************
+ * bulk loading
+ *
+ * Entries go through an external sort with a workspace of
+ * BT_LOAD_RUN_ENTRIES, larger loads are sorted in runs on disk.
+ * Leaves are filled from the sorted entries left to right. The
+ * first key and page of every node is kept, and inner levels are
+ * built from them bottom up until one node, the root, is left.
+ *
+ * Nodes are written in page number order by a bulk writer, only the
+ * tree header on page 1 is written again at the end.
+ */
+static int entryCmp(const void *a, const void *b, void *keyType)
+{
+  return keyCmp(*(DataType*) keyType, ((BT_Entry*) a)->key,
+                ((BT_Entry*) b)->key);
+}
+
+RC startBtreeLoad (BT_BulkLoad **load, char *idxId, DataType keyType,
+                   int n, float fillFactor)
+{
+  BT_BulkLoad *l;
+  RC rc;
+
+  if (n < 2 || n > BT_MAX_N)
+    RETURN(RC_IM_N_TO_LAGE);
+  if (keyType == DT_STRING)
+    RETURN(RC_RM_UNKOWN_DATATYPE);
+  if (fillFactor <= 0 || fillFactor > 1)
+    fillFactor= 1;
+
+  l= (BT_BulkLoad*) malloc(sizeof(BT_BulkLoad));
+  l->keyType= keyType;
+  rc= openSort(&l->sort, NULL, LOAD_SORT_FRAMES, sizeof(BT_Entry), entryCmp,
+               &l->keyType, idxId);
+  if (rc != RC_OK)
+  {
+    free(l);
+    RETURN(rc);
+  }
+  l->idxId= strdup(idxId);
+  l->n= n;
+  l->fillFactor= fillFactor;
+  l->numEntries= 0;
+
+  *load= l;
+  RETURN(RC_OK);
+}
+
+RC loadKey (BT_BulkLoad *load, Value *key, RID rid)
+{
+  BT_Entry e;
+  RC rc;
+
+  rc= keyFromValue(load->keyType, key, &e.key);
+  if (rc != RC_OK)
+    RETURN(rc);
+  e.rid= rid;
+  rc= putSortRecord(load->sort, &e);
+  if (rc != RC_OK)
+    RETURN(rc);
+  load->numEntries++;
+  RETURN(RC_OK);
+}
+
+// Entries of next node, when remaining entries are spread over nodes
+// of per entries. Last two nodes share the rest so that none of them
+// gets less than min.
+static int nodeFill(int remaining, int per, int min, int max)
+{
+  if (remaining <= per)
+    return remaining;
+  if (remaining - per >= min)
+    return per;
+  if (remaining <= max)
+    return remaining;
+  return (remaining + 1) / 2;
+}
+
+// Fill leaves with all entries in order. First key and page number
+// of leaves are returned for the level above.
+static RC buildLeaves(BT_BulkLoad *load, FSM_BulkWriter *w,
+                      BT_Key *firstKeys, PageNumber *pages, int *count)
+{
+  BT_NodeHeader *hdr;
+  BT_Entry e, prev;
+  PageNumber pn;
+  char *page;
+  int n= load->n, per, remaining= load->numEntries, cnt, i;
+  RC rc;
+
+  per= (int) (n * load->fillFactor + 0.5);
+  per= per < MIN_LEAF_KEYS(n) ? MIN_LEAF_KEYS(n) : (per > n ? n : per);
+
+  memset(&prev, 0, sizeof(BT_Entry));
+  *count= 0;
+  do
+  {
+    cnt= nodeFill(remaining, per, MIN_LEAF_KEYS(n), n);
+    rc= bulkAllocatePage(w, &pn, &page);
+    if (rc != RC_OK)
+      RETURN(rc);
+
+    for (i=0; i < cnt; i++)
+    {
+      rc= getSortRecord(load->sort, &e);
+      if (rc != RC_OK)
+        RETURN(rc);
+      if ((i > 0 || *count > 0) && keyCmp(load->keyType, prev.key, e.key) == 0)
+        RETURN(RC_IM_KEY_ALREADY_EXISTS);
+      BT_KEYS(page)[i]= e.key;
+      BT_RIDS(page, n)[i]= e.rid;
+      prev= e;
+    }
+    remaining-= cnt;
+
+    hdr= BT_HEADER(page);
+    hdr->magic= BT_NODE_MAGIC;
+    hdr->isLeaf= TRUE;
+    hdr->numKeys= cnt;
+    hdr->next= remaining > 0 ? bulkNextPageNumber(w) : NO_PAGE;
+
+    firstKeys[*count]= BT_KEYS(page)[0];
+    pages[*count]= pn;
+    (*count)++;
+  } while (remaining > 0);
+
+  RETURN(RC_OK);
+}
+
+// Build parents of count nodes, arrays are replaced by the parents.
+static RC buildInnerLevel(BT_BulkLoad *load, FSM_BulkWriter *w,
+                          BT_Key *firstKeys, PageNumber *pages, int *count)
+{
+  BT_NodeHeader *hdr;
+  PageNumber pn;
+  char *page;
+  int n= load->n, per, remaining= *count, in= 0, out= 0, cnt, i;
+  RC rc;
+
+  // Counted in children
+  per= (int) (n * load->fillFactor + 0.5) + 1;
+  per= per < MIN_INNER_KEYS(n) + 1 ? MIN_INNER_KEYS(n) + 1
+                                   : (per > n + 1 ? n + 1 : per);
+
+  while (remaining > 0)
+  {
+    cnt= nodeFill(remaining, per, MIN_INNER_KEYS(n) + 1, n + 1);
+    rc= bulkAllocatePage(w, &pn, &page);
+    if (rc != RC_OK)
+      RETURN(rc);
+
+    hdr= BT_HEADER(page);
+    hdr->magic= BT_NODE_MAGIC;
+    hdr->isLeaf= FALSE;
+    hdr->numKeys= cnt - 1;
+    hdr->next= NO_PAGE;
+    for (i=0; i < cnt; i++)
+    {
+      BT_CHILDREN(page, n)[i]= pages[in + i];
+      if (i > 0)
+        BT_KEYS(page)[i - 1]= firstKeys[in + i];
+    }
+
+    // Parents never overtake their children in the arrays
+    firstKeys[out]= firstKeys[in];
+    pages[out]= pn;
+    out++;
+    in+= cnt;
+    remaining-= cnt;
+  }
+
+  *count= out;
+  RETURN(RC_OK);
+}
+
+RC finishBtreeLoad (BT_BulkLoad *load)
+{
+  FSM_BulkWriter w;
+  BT_TreeHeader *hdr;
+  BT_Key *firstKeys;
+  PageNumber *pages, headerPage;
+  char header[PAGE_SIZE], *page;
+  int count, height= 1, numNodes;
+  RC rc;
+
+  // Every leaf but the root is at least half full
+  count= load->numEntries / MIN_LEAF_KEYS(load->n) + 1;
+  firstKeys= (BT_Key*) malloc(count * sizeof(BT_Key));
+  pages= (PageNumber*) malloc(count * sizeof(PageNumber));
+
+  rc= finishSortInput(load->sort);
+  if (rc == RC_OK)
+  {
+    rc= startBulkWrite(&w, load->idxId);
+    if (rc == RC_OK)
+    {
+      // Header is first page allocated, like in createBtree
+      rc= bulkAllocatePage(&w, &headerPage, &page);
+      if (rc == RC_OK)
+        rc= buildLeaves(load, &w, firstKeys, pages, &count);
+      numNodes= count;
+      while (rc == RC_OK && count > 1)
+      {
+        rc= buildInnerLevel(load, &w, firstKeys, pages, &count);
+        numNodes+= count;
+        height++;
+      }
+
+      if (rc == RC_OK)
+      {
+        memset(header, 0, PAGE_SIZE);
+        hdr= (BT_TreeHeader*) header;
+        hdr->magic= BT_TREE_MAGIC;
+        hdr->keyType= load->keyType;
+        hdr->n= load->n;
+        hdr->root= pages[0];
+        hdr->height= height;
+        hdr->numNodes= numNodes;
+        hdr->numEntries= load->numEntries;
+        rc= bulkWritePage(&w, headerPage, header);
+      }
+      if (rc == RC_OK)
+        rc= finishBulkWrite(&w);
+      else
+        abortBulkWrite(&w);
+    }
+  }
+
+  closeSort(load->sort);
+  free(firstKeys);
+  free(pages);
+  free(load->idxId);
+  free(load);
+  RETURN(rc);
+}
+
+/**************************************************
+ * debug and test functions
+ */
+
+// Nodes in depth first order, position in list is node number.
+static int collectNodes(BT_TreeMgmtData *t, PageNumber pn, PageNumber *nodes,
+                        int count)
+{
+  BM_PageHandle ph;
+  PageNumber children[BT_MAX_N + 2];
+  int i, numChildren= 0;
+
+  nodes[count++]= pn;
+  if (pinPage(&t->bm, &ph, pn) != RC_OK)
+    return count;
+  if (!BT_HEADER(ph.data)->isLeaf)
+  {
+    numChildren= BT_HEADER(ph.data)->numKeys + 1;
+    memcpy(children, BT_CHILDREN(ph.data, t->n),
+           numChildren * sizeof(PageNumber));
+  }
+  unpinPage(&t->bm, &ph);
+
+  for (i=0; i < numChildren; i++)
+    count= collectNodes(t, children[i], nodes, count);
+  return count;
+}
+
+static int nodePosition(PageNumber *nodes, int count, PageNumber pn)
+{
+  int i;
+  for (i=0; i < count; i++)
+    if (nodes[i] == pn)
+      return i;
+  return -1;
+}
+
+static int printKey(char *out, DataType keyType, BT_Key key)
+{
+  if (keyType == DT_FLOAT)
+    return sprintf(out, "%f", key.floatV);
+  return sprintf(out, "%d", key.intV);
+}
+
+// One line per node in depth first order, not thread safe.
+// Inner node: (pos)[child,key,child,...,child]
+// Leaf: (pos)[page.slot,key,...,next leaf]
+char *printTree (BTreeHandle *tree)
+{
+  BT_TreeMgmtData *t= TREE_MGMT(tree);
+  BM_PageHandle ph;
+  BT_NodeHeader *hdr;
+  PageNumber *nodes;
+  char *result;
+  int count, i, j, len= 0, n= t->n;
+
+  nodes= (PageNumber*) malloc(t->numNodes * sizeof(PageNumber));
+  count= collectNodes(t, t->root, nodes, 0);
+
+  // Key or RID take at most 48 characters
+  result= (char*) malloc(count * (16 + (2 * n + 2) * 48) + 1);
+  result[0]= '\0';
+  for (i=0; i < count; i++)
+  {
+    if (pinPage(&t->bm, &ph, nodes[i]) != RC_OK)
+      break;
+    hdr= BT_HEADER(ph.data);
+
+    len+= sprintf(result + len, "(%d)[", i);
+    for (j=0; j < hdr->numKeys; j++)
+    {
+      if (hdr->isLeaf)
+        len+= sprintf(result + len, "%d.%d,", BT_RIDS(ph.data, n)[j].page,
+                      BT_RIDS(ph.data, n)[j].slot);
+      else
+        len+= sprintf(result + len, "%d,",
+                      nodePosition(nodes, count, BT_CHILDREN(ph.data, n)[j]));
+      len+= printKey(result + len, tree->keyType, BT_KEYS(ph.data)[j]);
+      len+= sprintf(result + len, ",");
+    }
+    if (hdr->isLeaf)
+    {
+      if (hdr->next != NO_PAGE)
+        len+= sprintf(result + len, "%d",
+                      nodePosition(nodes, count, hdr->next));
+      else if (len > 0 && result[len - 1] == ',')
+        len--;
+    }
+    else
+      len+= sprintf(result + len, "%d",
+                    nodePosition(nodes, count,
+                                 BT_CHILDREN(ph.data, n)[hdr->numKeys]));
+    len+= sprintf(result + len, "]\n");
+    unpinPage(&t->bm, &ph);
+  }
+
+  free(nodes);
+  return result;
+}
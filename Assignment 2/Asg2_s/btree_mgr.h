@@ -0,0 +1,176 @@
+#ifndef BTREE_MGR_H
+#define BTREE_MGR_H
+
+#include <pthread.h>
+
+#include "dberror.h"
+#include "buffer_mgr.h"
+#include "free_space_mgr.h"
+#include "sort_mgr.h"
+#include "tables.h"
+
+// Buffer pool used by every open index
+#define BT_POOL_PAGES 256
+
+/*
+ * Index file layout
+ * | FSM map 0 | Tree header 1 | Nodes ... |
+ *
+ * Every node is a page. Node holds up to n keys, one more slot
+ * is kept so that a node can overflow before it is split.
+ * | BT_NodeHeader | BT_Key[n+1] | RID[n+1] (leaf) or PageNumber[n+2] |
+ *
+ * Keys of the subtree of children[i] are >= keys[i-1] and < keys[i].
+ * Leaves are linked left to right through next.
+ */
+#define BT_NODE_MAGIC 0x42544E44 // "BTND"
+#define BT_TREE_MAGIC 0x42545245 // "BTRE"
+
+// Deepest tree, every inner node has at least 2 children.
+#define BT_MAX_HEIGHT 40
+
+typedef union BT_Key {
+  int intV;     // DT_INT and DT_BOOL
+  float floatV; // DT_FLOAT
+} BT_Key;
+
+/*
+ * Node version latch, first word of every node.
+ * | counter ... | locked (bit 1) | obsolete (bit 0) |
+ * Writers set locked bit, unlock adds to counter. Readers do not
+ * latch, they note version before reading a node and restart when
+ * it changed after. Freed nodes stay obsolete until reused.
+ */
+#define BT_VERSION_OBSOLETE 1ULL
+#define BT_VERSION_LOCKED   2ULL
+
+typedef struct BT_NodeHeader {
+  unsigned long long version;
+  int magic;
+  int isLeaf;
+  int numKeys;
+  PageNumber next;  // Right sibling of leaf, NO_PAGE for last leaf
+} BT_NodeHeader;
+
+// Largest n, leaf entries are bigger than inner ones.
+#define BT_MAX_N ((int) ((PAGE_SIZE - sizeof(BT_NodeHeader))             \
+                         / (sizeof(BT_Key) + sizeof(RID))) - 1)
+
+#define BT_HEADER(page)       ((BT_NodeHeader*) (page))
+#define BT_KEYS(page)         ((BT_Key*) ((page) + sizeof(BT_NodeHeader)))
+#define BT_RIDS(page,n)       ((RID*) (BT_KEYS(page) + (n) + 1))
+#define BT_CHILDREN(page,n)   ((PageNumber*) (BT_KEYS(page) + (n) + 1))
+
+// Inner nodes kept pinned while index is open, up to half of the
+// pool. Descents find them by page number without the buffer pool.
+// Chunks are added, never removed, until the index is closed.
+#define BT_KEEP_CHUNK  1024   // Page numbers per chunk
+#define BT_KEEP_CHUNKS 1024   // Only pages below this many chunks
+#define BT_KEEP_MAX    (BT_POOL_PAGES / 2)
+
+typedef struct BT_KeptNodes {
+  pthread_mutex_t mutex;              // Adding nodes
+  char **chunks[BT_KEEP_CHUNKS];      // Data of kept page, NULL if not
+  BM_PageHandle handles[BT_KEEP_MAX]; // Pins given back on close
+  int count;
+} BT_KeptNodes;
+
+// Management data of open index
+//
+// Inserts and deletes that stay within one leaf hold structLock
+// shared and latch only that leaf. Splits and merges hold it
+// exclusive, they are the only users of the free space map.
+typedef struct BT_TreeMgmtData {
+  BM_BufferPool bm;
+  FSM_Handle fsm;
+  BT_KeptNodes kept;
+  pthread_rwlock_t structLock;
+  int n;
+  PageNumber root;  // Read and written atomically
+  int height;       // Levels including leaves
+  int numNodes;
+  int numEntries;   // Updated atomically
+} BT_TreeMgmtData;
+
+// structure for accessing btrees
+typedef struct BTreeHandle {
+  DataType keyType;
+  char *idxId;
+  void *mgmtData;
+} BTreeHandle;
+
+typedef struct BT_ScanHandle {
+  BTreeHandle *tree;
+  void *mgmtData;
+} BT_ScanHandle;
+
+// Scan remembers last key returned instead of a position, so
+// that it continues correctly after concurrent changes of the leaf.
+typedef struct BT_ScanMgmtData {
+  PageNumber leaf;  // Leaf to continue at, NO_PAGE to search from root
+  unsigned long long leafVersion;  // Version leaf had when it was read
+  bool done;
+  bool hasLast;
+  BT_Key last;      // Last key returned
+  bool hasLow;
+  BT_Key low;
+  bool hasHigh;
+  BT_Key high;
+} BT_ScanMgmtData;
+
+// Index entry, also the unit sorted when bulk loading
+typedef struct BT_Entry {
+  BT_Key key;
+  RID rid;
+} BT_Entry;
+
+// Entries sorted in memory, more are sorted in runs on disk.
+#define BT_LOAD_RUN_ENTRIES 65536
+
+// State of an index being bulk loaded
+typedef struct BT_BulkLoad {
+  char *idxId;
+  DataType keyType;
+  int n;
+  float fillFactor;
+  int numEntries;
+  ES_SortHandle *sort;    // Entries, run files are <idxId>.sort<N>
+} BT_BulkLoad;
+
+// init and shutdown index manager
+extern RC initIndexManager (void *mgmtData);
+extern RC shutdownIndexManager ();
+
+// create, destroy, open, and close an btree index
+extern RC createBtree (char *idxId, DataType keyType, int n);
+extern RC openBtree (BTreeHandle **tree, char *idxId);
+extern RC closeBtree (BTreeHandle *tree);
+extern RC deleteBtree (char *idxId);
+
+// access information about a b-tree
+extern RC getNumNodes (BTreeHandle *tree, int *result);
+extern RC getNumEntries (BTreeHandle *tree, int *result);
+extern RC getKeyType (BTreeHandle *tree, DataType *result);
+
+// index access, thread safe
+extern RC findKey (BTreeHandle *tree, Value *key, RID *result);
+extern RC insertKey (BTreeHandle *tree, Value *key, RID rid);
+extern RC deleteKey (BTreeHandle *tree, Value *key);
+extern RC openTreeScan (BTreeHandle *tree, BT_ScanHandle **handle);
+// Entries with low <= key <= high, NULL bound is open.
+extern RC openTreeRangeScan (BTreeHandle *tree, Value *low, Value *high,
+                             BT_ScanHandle **handle);
+extern RC nextEntry (BT_ScanHandle *handle, RID *result);
+extern RC closeTreeScan (BT_ScanHandle *handle);
+
+// bulk loading of a new index, entries can come in any order.
+// Nodes are filled to fillFactor of n, but not below half full.
+extern RC startBtreeLoad (BT_BulkLoad **load, char *idxId, DataType keyType,
+                          int n, float fillFactor);
+extern RC loadKey (BT_BulkLoad *load, Value *key, RID rid);
+extern RC finishBtreeLoad (BT_BulkLoad *load);
+
+// debug and test functions
+extern char *printTree (BTreeHandle *tree);
+
+#endif // BTREE_MGR_H
@@ -1,8 +1,11 @@
 #include "buffer_mgr.h"
 #include <string.h>
+#include <stddef.h>
 #include "storage_mgr.h"
 #include "lru_linked_list.h"
 #include "page_table.h"
+#include "buffer_trace.h"
+#include "mrc.h"
 #include "assert.h"
 
 // Some non-interface static functions
@@ -11,11 +14,37 @@ static BM_PageFrame* findFreeFrameLRU(BM_BufferPool *bm);
 static BM_PageFrame* findFreeFrameCLOCK(BM_BufferPool *bm);
 static BM_PageFrame* findFreeFrame(BM_BufferPool *bm);
 static RC writeIfDirty(BM_BufferPool *const bm, BM_PageFrame *pf);
+static RC flushFrame(BM_BufferPool *const bm, BM_PageFrame *pf);
+static RC evictFrame(BM_BufferPool *const bm, BM_PageFrame *pf);
+static BM_PageFrame* newFrame(BM_BufferPool *const bm, int frameNo);
+static void dropNewFrames(BM_BufferPool *const bm, int first, int end);
+static BM_PageFrame* handleFrame(BM_BufferPool *const bm,
+                                 BM_PageHandle *const page);
+static void dropPin(BM_BufferPool *const bm, BM_PageFrame *pf);
+static BM_PageFrame* copyOnWrite(BM_BufferPool *const bm, BM_PageFrame *pf);
+static int comparePageFrames(const void *a, const void *b);
+static void undoPins(BM_BufferPool *const bm, BM_PageHandle *const pages,
+                     int numPinned, BM_PageFrame **missed, int numMissed);
 
 // Handy lock macros to make BM thread safe.
 #define BM_LOCK()   pthread_mutex_lock(&mgmtData->bm_mutex);
 #define BM_UNLOCK() pthread_mutex_unlock(&mgmtData->bm_mutex);
 
+// Statistics are bumped without ordering, readers only want counts.
+#define STAT_ADD(field, n) \
+  __atomic_fetch_add(&mgmtData->stats.field, (n), __ATOMIC_RELAXED)
+#define STAT_GET(field) \
+  __atomic_load_n(&mgmtData->stats.field, __ATOMIC_RELAXED)
+
+// Note change of frame for getPoolChanges, under bm_mutex
+#define FRAME_CHANGED(pf)  ((pf)->changeEpoch= ++mgmtData->epoch)
+
+// LRU frames looked at for one on node of thread, on NUMA hosts
+#define NUMA_LOOKAHEAD 8
+
+// Batches of pinPages up to this size keep their arrays on stack
+#define PIN_BATCH_STACK 64
+
 
 // Buffer Manager Interface Pool Handling
 // ***************************************
@@ -24,6 +53,7 @@ RC initBufferPool(BM_BufferPool *const bm, const char *const pageFileName,
 		  void *stratData)
 {
   BM_Pool_MgmtData *mgmtData;
+  RC rc;
   int i;
 
   // Initialize Pool
@@ -33,30 +63,51 @@ RC initBufferPool(BM_BufferPool *const bm, const char *const pageFileName,
 
   // Initialize Pool Mgmt Data
   mgmtData= MAKE_POOL_MGMTDATA();
-  mgmtData->io_reads= 0;
-  mgmtData->io_writes= 0;
+  if (mgmtData == NULL)
+  {
+    free(bm->pageFile);
+    RETURN(RC_WRITE_FAILED);
+  }
+  // Nothing else is set up for a file that can not be opened
+  rc= openPageFile(bm->pageFile, &mgmtData->fh);
+  if (rc != RC_OK)
+  {
+    free(bm->pageFile);
+    free(mgmtData);
+    bm->mgmtData= NULL;
+    RETURN(rc);
+  }
+  memset(&mgmtData->stats, 0, sizeof(BM_PoolStats));
+  mgmtData->epoch= 0;
+  mgmtData->trace= NULL;
+  mgmtData->mrc= NULL;
+  initLatencyHistogram(&mgmtData->pinHitLatency);
+  initLatencyHistogram(&mgmtData->pinMissLatency);
   mgmtData->stratData.fifoLastFreeFrame= -1;
   mgmtData->stratData.lru_head= NULL;
   mgmtData->stratData.lru_tail= NULL;
   mgmtData->stratData.clockCurrentFrame= -1;
-  openPageFile(bm->pageFile, &mgmtData->fh);
   initPageTable(&mgmtData->pt_head);
 
   // Create Pool pages and initialize them
+  bm->mgmtData= mgmtData;
+  initFrameArena(&mgmtData->arena, sizeof(BM_PageFrame), 0);
   mgmtData->pool = MAKE_BUFFER_POOL(numPages);
-  for (i=0; i<numPages; i++)
+  for (i=0; mgmtData->pool && i<numPages; i++)
+    if ((mgmtData->pool[i]= newFrame(bm, i)) == NULL)
+      break;
+  if (mgmtData->pool == NULL || i < numPages)
   {
-    mgmtData->pool[i].dirty= FALSE;
-    mgmtData->pool[i].fixCount= 0;
-    mgmtData->pool[i].pn= NO_PAGE;
-    
-    // Add all frames in LRU list
-    // representing free frame to use.
-    appendMRUFrame(&mgmtData->stratData, &mgmtData->pool[i]);
-
-    mgmtData->pool[i].clockReplaceFlag= TRUE;
+    if (mgmtData->pool)
+      dropNewFrames(bm, 0, i);
+    destroyFrameArena(&mgmtData->arena);
+    free(mgmtData->pool);
+    closePageFile(&mgmtData->fh);
+    free(bm->pageFile);
+    free(mgmtData);
+    bm->mgmtData= NULL;
+    RETURN(RC_WRITE_FAILED);
   }
-  bm->mgmtData= mgmtData;
 
   // Initialize thread lock
   pthread_mutex_init(&mgmtData->bm_mutex, NULL);
@@ -79,9 +130,9 @@ RC shutdownBufferPool(BM_BufferPool *const bm)
 
   BM_LOCK();
   // Check if we have pinned pages,
-  pf= &mgmtData->pool[0];
   for (frmNo=0; frmNo < bm->numPages; frmNo++)
   {
+    pf= mgmtData->pool[frmNo];
     if (pf->fixCount)
     {
       BM_UNLOCK();
@@ -91,7 +142,6 @@ RC shutdownBufferPool(BM_BufferPool *const bm)
     // Also reset page table
     if (pf->pn != NO_PAGE)
       resetPageFrame(&mgmtData->pt_head, pf->pn);
-    pf++;
   }
   
   rc= closePageFile(&mgmtData->fh);
@@ -100,8 +150,18 @@ RC shutdownBufferPool(BM_BufferPool *const bm)
     BM_UNLOCK();
     RETURN(rc);
   }
+  if (mgmtData->trace)
+    closeTraceWriter(mgmtData->trace);
+  if (mgmtData->mrc)
+  {
+    freeMRCEstimator(mgmtData->mrc);
+    free(mgmtData->mrc);
+  }
 
   cleanLRUlist(&mgmtData->stratData);
+  for (frmNo=0; frmNo < bm->numPages; frmNo++)
+    destroyLatch(&mgmtData->pool[frmNo]->latch);
+  destroyFrameArena(&mgmtData->arena);
   free(mgmtData->pool);
   free(bm->pageFile);
   BM_UNLOCK();
@@ -123,13 +183,12 @@ RC forceFlushPool(BM_BufferPool *const bm)
 
   BM_LOCK();
 
-  pf= &mgmtData->pool[0];
   for (frmNo=0; frmNo < bm->numPages; frmNo++)
   {
-    rc= writeIfDirty(bm, pf);
+    pf= mgmtData->pool[frmNo];
+    rc= flushFrame(bm, pf);
     if (rc!=RC_OK)
       break;
-    pf++;
   }
 
   BM_UNLOCK();
@@ -149,30 +208,50 @@ static RC writeIfDirty(BM_BufferPool *const bm, BM_PageFrame *pf)
     rc= writeBlock(pf->pn, &mgmtData->fh, (SM_PageHandle) &pf->data);
     if (rc!=RC_OK)
       RETURN(rc);
-    mgmtData->io_writes++;
+    STAT_ADD(numWriteIO, 1);
+    STAT_ADD(bytesWritten, PAGE_SIZE);
     pf->dirty= FALSE;
-    resetPageFrame(&mgmtData->pt_head, pf->pn);
+    FRAME_CHANGED(pf);
   }
 
   RETURN(RC_OK);
 }
 
+// Write back on request of client, not to free the frame
+static RC flushFrame(BM_BufferPool *const bm, BM_PageFrame *pf)
+{
+  RC rc;
+  BM_Pool_MgmtData *mgmtData= bm->mgmtData;
+  bool written= pf->dirty && pf->fixCount==0;
+
+  rc= writeIfDirty(bm, pf);
+  if (rc==RC_OK && written)
+    STAT_ADD(flushes, 1);
+  RETURN(rc);
+}
+
 // Mark page as dirty
 RC markDirty (BM_BufferPool *const bm, BM_PageHandle *const page)
 {
   BM_PageFrame *pf;
   BM_Pool_MgmtData *mgmtData= bm->mgmtData;
   BM_LOCK();
+  if (mgmtData->trace)
+    traceAccess(mgmtData->trace, TR_DIRTY, page->pageNum);
 
   // Check if we already have a frame assigned to this page
-  pf= findPageFrame(&mgmtData->pt_head, page->pageNum);
+  pf= handleFrame(bm, page);
   if (!pf)
   {
     BM_UNLOCK();
     RETURN(RC_PAGE_NOT_PINNED);
   }
 
-  pf->dirty= TRUE;
+  if (!pf->dirty)
+  {
+    pf->dirty= TRUE;
+    FRAME_CHANGED(pf);
+  }
 
   BM_UNLOCK();
   RETURN(RC_OK);
@@ -184,22 +263,19 @@ RC unpinPage (BM_BufferPool *const bm, BM_PageHandle *const page)
   BM_PageFrame *pf;
   BM_Pool_MgmtData *mgmtData= bm->mgmtData;
   BM_LOCK();
+  if (mgmtData->trace)
+    traceAccess(mgmtData->trace, TR_UNPIN, page->pageNum);
 
   // Check if we already have a frame assigned to this page
-  pf= findPageFrame(&mgmtData->pt_head, page->pageNum);
-  if (!pf)
+  pf= handleFrame(bm, page);
+  if (!pf || pf->fixCount == 0)
   {
     BM_UNLOCK();
     RETURN(RC_PAGE_NOT_PINNED);
   }
 
   // Mark that page frame is not used by client now.
-  pf->fixCount--;
-
-  // Add frame back to the list as MRU frame, 
-  // so that this can be used, in next pinPage.
-  if(pf->fixCount == 0 && bm->strategy == RS_LRU)
-	appendMRUFrame(&mgmtData->stratData, pf);
+  dropPin(bm, pf);
 
   BM_UNLOCK();
   RETURN(RC_OK);
@@ -214,9 +290,9 @@ RC forcePage (BM_BufferPool *const bm, BM_PageHandle *const page)
   BM_LOCK();
 
   // Check if we already have a frame assigned to this page
-  pf= findPageFrame(&mgmtData->pt_head, page->pageNum);
+  pf= handleFrame(bm, page);
   if (pf)
-    rc= writeIfDirty(bm, pf);
+    rc= flushFrame(bm, pf);
 
   // We force to write dirty block, even if fixCount>0. Last arg=true.
   BM_UNLOCK();
@@ -230,29 +306,44 @@ RC pinPage (BM_BufferPool *const bm, BM_PageHandle *const page,
   RC rc;
   BM_PageFrame *pf;
   BM_Pool_MgmtData *mgmtData= bm->mgmtData;
-  BM_LOCK();
+  long long start= latencyStart();
+  if (pthread_mutex_trylock(&mgmtData->bm_mutex) != 0)
+  {
+    STAT_ADD(pinWaits, 1);
+    BM_LOCK();
+  }
+  if (mgmtData->trace)
+    traceAccess(mgmtData->trace, TR_PIN, pageNum);
+  if (mgmtData->mrc)
+    recordMRCAccess(mgmtData->mrc, pageNum);
 
   // Check if we already have a frame assigned to this page
   pf= findPageFrame(&mgmtData->pt_head, pageNum);
   if (pf)
   {
+    STAT_ADD(hits, 1);
     // If fixCount==0, then remove it from LRU
     // Representing that frame is no more free
     if(pf->fixCount==0 && bm->strategy == RS_LRU)
       reuseLRUFrame(&mgmtData->stratData, pf);
 
     pf->fixCount++;
+    FRAME_CHANGED(pf);
     page->pageNum= pageNum;
     page->data= (char*)&pf->data;
+    page->frameNo= pf->frameNo;
+    page->frameGen= pf->gen;
     if (bm->strategy == RS_CLOCK)
     {
        pf->clockReplaceFlag = FALSE;
     }
     BM_UNLOCK();
+    recordLatencySince(&mgmtData->pinHitLatency, start);
     RETURN(RC_OK);
   }
 
   // Get free frame from pool
+  STAT_ADD(misses, 1);
   pf= findFreeFrame(bm);
   if (pf==NULL)
   {
@@ -276,12 +367,17 @@ RC pinPage (BM_BufferPool *const bm, BM_PageHandle *const page,
     BM_UNLOCK();
     return rc;
   }
-  mgmtData->io_reads++;
+  STAT_ADD(numReadIO, 1);
+  STAT_ADD(bytesRead, PAGE_SIZE);
 
   // Mark page frame as used
   pf->fixCount++;
   pf->pn= page->pageNum= pageNum;
+  pf->gen++;
+  FRAME_CHANGED(pf);
   page->data= &pf->data[0];
+  page->frameNo= pf->frameNo;
+  page->frameGen= pf->gen;
 
   // Map page number to frame;
   setPageFrame(&mgmtData->pt_head, pageNum, pf);
@@ -291,9 +387,632 @@ RC pinPage (BM_BufferPool *const bm, BM_PageHandle *const page,
      pf->clockReplaceFlag = FALSE;
 
   BM_UNLOCK();
+  recordLatencySince(&mgmtData->pinMissLatency, start);
+  RETURN(RC_OK);
+}
+
+// Take frames out of the pool to be used as plain memory, e.g. as
+// workspace of a sort. Their pages are written back and evicted like
+// for pinPage. Reserved frames count as pinned until released.
+RC reserveFrames (BM_BufferPool *const bm, const int numFrames,
+                  char **frames)
+{
+  BM_PageFrame *pf;
+  BM_Pool_MgmtData *mgmtData= bm->mgmtData;
+  int i;
+  BM_LOCK();
+
+  for (i=0; i < numFrames; i++)
+  {
+    pf= findFreeFrame(bm);
+    if (pf==NULL)
+      break;
+    pf->fixCount= 1;
+    pf->pn= NO_PAGE;
+    pf->dirty= FALSE;
+    pf->gen++;
+    FRAME_CHANGED(pf);
+    if (bm->strategy == RS_CLOCK)
+      pf->clockReplaceFlag= FALSE;
+    frames[i]= &pf->data[0];
+  }
+
+  BM_UNLOCK();
+  if (i < numFrames)
+  {
+    releaseFrames(bm, i, frames);
+    RETURN(RC_BUFFER_POOL_FULL);
+  }
+  RETURN(RC_OK);
+}
+
+// Give reserved frames back to the pool as free frames
+RC releaseFrames (BM_BufferPool *const bm, const int numFrames,
+                  char **frames)
+{
+  BM_PageFrame *pf;
+  BM_Pool_MgmtData *mgmtData= bm->mgmtData;
+  int i;
+  BM_LOCK();
+
+  for (i=0; i < numFrames; i++)
+  {
+    pf= (BM_PageFrame*) (frames[i] - offsetof(BM_PageFrame, data));
+    if (pf->frameNo < 0 || pf->frameNo >= bm->numPages
+        || mgmtData->pool[pf->frameNo] != pf
+        || pf->pn != NO_PAGE || pf->fixCount != 1)
+    {
+      BM_UNLOCK();
+      RETURN(RC_PAGE_NOT_PINNED);
+    }
+    pf->fixCount= 0;
+    FRAME_CHANGED(pf);
+    if (bm->strategy == RS_LRU)
+      appendMRUFrame(&mgmtData->stratData, pf);
+    if (bm->strategy == RS_CLOCK)
+      pf->clockReplaceFlag= TRUE;
+  }
+
+  BM_UNLOCK();
+  RETURN(RC_OK);
+}
+
+// Frame of page, straight from handle if it still refers to the frame
+// holding the page. Otherwise page table is searched.
+static BM_PageFrame* handleFrame(BM_BufferPool *const bm,
+                                 BM_PageHandle *const page)
+{
+  BM_Pool_MgmtData *mgmtData= bm->mgmtData;
+  BM_PageFrame *pf;
+
+  if (page->frameNo >= 0 && page->frameNo < bm->numPages)
+  {
+    pf= mgmtData->pool[page->frameNo];
+    if (pf->gen == page->frameGen && pf->pn == page->pageNum
+        && pf->pn != NO_PAGE)
+      return pf;
+  }
+  return findPageFrame(&mgmtData->pt_head, page->pageNum);
+}
+
+/**************************************************
+ * Latched access
+ */
+
+// Latch is taken after pin without bm_mutex, waiting for it does not
+// hold up the pool. Frame of a pinned page is neither reused nor
+// freed, so it stays valid meanwhile.
+//
+// A writer looks for snapshot pins once it holds the latch, a
+// snapshot reader coming later waits for the latch before it reads.
+RC pinPageLatched (BM_BufferPool *const bm, BM_PageHandle *const page,
+                   const PageNumber pageNum, PL_Mode mode)
+{
+  BM_Pool_MgmtData *mgmtData= bm->mgmtData;
+  BM_PageFrame *pf, *copy;
+  RC rc;
+
+  if (mode != PL_SHARED && mode != PL_EXCLUSIVE)
+    RETURN(RC_LATCH_INVALID_MODE);
+
+  for (;;)
+  {
+    rc= pinPage(bm, page, pageNum);
+    if (rc != RC_OK)
+      return rc;
+    pf= (BM_PageFrame*) (page->data - offsetof(BM_PageFrame, data));
+    acquireLatch(&pf->latch, mode);
+    if (mode == PL_SHARED)
+      RETURN(RC_OK);
+
+    BM_LOCK();
+    if (pf->shadow)
+    {
+      // Page moved to a copy while we waited, pin that one
+      BM_UNLOCK();
+      releaseLatch(&pf->latch, mode);
+      unpinPage(bm, page);
+      continue;
+    }
+    if (pf->snapshotPins == 0)
+    {
+      BM_UNLOCK();
+      RETURN(RC_OK);
+    }
+
+    copy= copyOnWrite(bm, pf);
+    if (copy)
+    {
+      page->data= &copy->data[0];
+      page->frameNo= copy->frameNo;
+      page->frameGen= copy->gen;
+    }
+    BM_UNLOCK();
+    releaseLatch(&pf->latch, mode);
+    if (copy == NULL)
+    {
+      unpinPage(bm, page);
+      RETURN(RC_BUFFER_POOL_FULL);
+    }
+    RETURN(RC_OK);
+  }
+}
+
+RC unpinPageLatched (BM_BufferPool *const bm, BM_PageHandle *const page,
+                     PL_Mode mode)
+{
+  BM_PageFrame *pf;
+  BM_Pool_MgmtData *mgmtData= bm->mgmtData;
+
+  if (mode != PL_SHARED && mode != PL_EXCLUSIVE)
+    RETURN(RC_LATCH_INVALID_MODE);
+
+  BM_LOCK();
+  pf= handleFrame(bm, page);
+  if (!pf || pf->fixCount == 0)
+  {
+    BM_UNLOCK();
+    RETURN(RC_PAGE_NOT_PINNED);
+  }
+  BM_UNLOCK();
+
+  // Still pinned by us, frame can not go away before unpinPage
+  releaseLatch(&pf->latch, mode);
+  return unpinPage(bm, page);
+}
+
+// Pinned frame is only read by snapshot readers from now on. The
+// shared latch waits out a writer that came before them.
+RC pinPageSnapshot (BM_BufferPool *const bm, BM_PageHandle *const page,
+                    const PageNumber pageNum)
+{
+  BM_Pool_MgmtData *mgmtData= bm->mgmtData;
+  BM_PageFrame *pf;
+  RC rc;
+
+  rc= pinPage(bm, page, pageNum);
+  if (rc != RC_OK)
+    return rc;
+  pf= (BM_PageFrame*) (page->data - offsetof(BM_PageFrame, data));
+
+  BM_LOCK();
+  pf->snapshotPins++;
+  BM_UNLOCK();
+  acquireLatch(&pf->latch, PL_SHARED);
+  releaseLatch(&pf->latch, PL_SHARED);
+  RETURN(RC_OK);
+}
+
+RC unpinPageSnapshot (BM_BufferPool *const bm, BM_PageHandle *const page)
+{
+  BM_Pool_MgmtData *mgmtData= bm->mgmtData;
+  BM_PageFrame *pf;
+  BM_LOCK();
+  if (mgmtData->trace)
+    traceAccess(mgmtData->trace, TR_UNPIN, page->pageNum);
+
+  pf= handleFrame(bm, page);
+  if (!pf || pf->snapshotPins == 0)
+  {
+    BM_UNLOCK();
+    RETURN(RC_PAGE_NOT_PINNED);
+  }
+  pf->snapshotPins--;
+  dropPin(bm, pf);
+
+  BM_UNLOCK();
+  RETURN(RC_OK);
+}
+
+// Move page of pf to a free frame, pf becomes a shadow holding the
+// old image. Caller holds bm_mutex, a pin and the exclusive latch of
+// pf, and gets pin and latch of the copy instead.
+static BM_PageFrame* copyOnWrite(BM_BufferPool *const bm, BM_PageFrame *pf)
+{
+  BM_Pool_MgmtData *mgmtData= bm->mgmtData;
+  BM_PageFrame *copy;
+
+  copy= findFreeFrame(bm);
+  if (copy == NULL)
+    return NULL;
+
+  memcpy(copy->data, pf->data, PAGE_SIZE);
+  copy->pn= pf->pn;
+  copy->dirty= pf->dirty;
+  copy->fixCount= 1;
+  copy->gen++;
+  if (bm->strategy == RS_CLOCK)
+    copy->clockReplaceFlag= FALSE;
+  // Unpinned frame, nobody holds its latch
+  tryAcquireLatch(&copy->latch, PL_EXCLUSIVE);
+  FRAME_CHANGED(copy);
+
+  resetPageFrame(&mgmtData->pt_head, pf->pn);
+  setPageFrame(&mgmtData->pt_head, copy->pn, copy);
+  pf->shadow= TRUE;
+  pf->dirty= FALSE;
+  pf->fixCount--;   // Snapshot pins are left
+  FRAME_CHANGED(pf);
+  return copy;
+}
+
+// Pin of caller keeps frame, so neither bm_mutex nor the latch is
+// written on the way. Readers only fall back to latch when writers
+// keep getting in.
+RC readPageOptimistic (BM_BufferPool *const bm, BM_PageHandle *const page,
+                       BM_PageReader read, void *arg)
+{
+  BM_PageFrame *pf;
+  unsigned int version;
+  int i;
+
+  pf= (BM_PageFrame*) (page->data - offsetof(BM_PageFrame, data));
+  for (i=0; i < BM_OPTIMISTIC_TRIES; i++)
+  {
+    version= startLatchRead(&pf->latch);
+    if (version & 1)
+      continue;
+    read(&pf->data[0], arg);
+    if (validateLatchRead(&pf->latch, version))
+      RETURN(RC_OK);
+  }
+
+  acquireLatch(&pf->latch, PL_SHARED);
+  read(&pf->data[0], arg);
+  releaseLatch(&pf->latch, PL_SHARED);
   RETURN(RC_OK);
 }
 
+/**************************************************
+ * Batch pinning
+ */
+
+// Pin pageNums[i] into pages[i], like numPages calls of pinPage but
+// under one lock. Pages not in pool all get their frame first, then
+// are read with one vectored read per run of consecutive pages. On
+// error no page of the batch stays pinned. A batch is timed as one
+// pin, a miss if any page had to be read.
+RC pinPages (BM_BufferPool *const bm, BM_PageHandle *const pages,
+             const PageNumber *const pageNums, const int numPages)
+{
+  BM_Pool_MgmtData *mgmtData= bm->mgmtData;
+  BM_PageFrame *pf, **missed, *missedBuf[PIN_BATCH_STACK];
+  SM_PageHandle *data, dataBuf[PIN_BATCH_STACK];
+  PageNumber maxMissed= 0;
+  int i, j, numPinned, numMissed= 0;
+  RC rc= RC_OK;
+  long long start= latencyStart();
+
+  for (i=0; i < numPages; i++)
+    if (pageNums[i] < 0)
+      RETURN(RC_READ_NON_EXISTING_PAGE);
+  if (numPages <= 0)
+    RETURN(RC_OK);
+
+  missed= missedBuf;
+  data= dataBuf;
+  if (numPages > PIN_BATCH_STACK)
+  {
+    missed= (BM_PageFrame**) malloc(numPages * sizeof(BM_PageFrame*));
+    data= (SM_PageHandle*) malloc(numPages * sizeof(SM_PageHandle));
+    if (missed == NULL || data == NULL)
+    {
+      free(missed);
+      free(data);
+      RETURN(RC_WRITE_FAILED);
+    }
+  }
+  if (pthread_mutex_trylock(&mgmtData->bm_mutex) != 0)
+  {
+    STAT_ADD(pinWaits, 1);
+    BM_LOCK();
+  }
+
+  for (i=0; i < numPages; i++)
+  {
+    if (mgmtData->trace)
+      traceAccess(mgmtData->trace, TR_PIN, pageNums[i]);
+    if (mgmtData->mrc)
+      recordMRCAccess(mgmtData->mrc, pageNums[i]);
+
+    pf= findPageFrame(&mgmtData->pt_head, pageNums[i]);
+    if (pf)
+    {
+      STAT_ADD(hits, 1);
+      if (pf->fixCount==0 && bm->strategy == RS_LRU)
+        reuseLRUFrame(&mgmtData->stratData, pf);
+    }
+    else
+    {
+      // Page is mapped now, so a repeat in batch is a hit. It is
+      // read before anyone else can take the lock.
+      STAT_ADD(misses, 1);
+      pf= findFreeFrame(bm);
+      if (pf==NULL)
+      {
+        rc= RC_BUFFER_POOL_FULL;
+        break;
+      }
+      pf->pn= pageNums[i];
+      pf->gen++;
+      setPageFrame(&mgmtData->pt_head, pf->pn, pf);
+      missed[numMissed++]= pf;
+      if (pf->pn > maxMissed)
+        maxMissed= pf->pn;
+    }
+
+    pf->fixCount++;
+    FRAME_CHANGED(pf);
+    if (bm->strategy == RS_CLOCK)
+      pf->clockReplaceFlag= FALSE;
+    pages[i].pageNum= pageNums[i];
+    pages[i].data= &pf->data[0];
+    pages[i].frameNo= pf->frameNo;
+    pages[i].frameGen= pf->gen;
+  }
+  numPinned= i;
+
+  if (rc==RC_OK && numMissed > 0)
+  {
+    qsort(missed, numMissed, sizeof(BM_PageFrame*), comparePageFrames);
+    if (maxMissed >= mgmtData->fh.totalNumPages)
+      rc= ensureCapacity(maxMissed+1, &mgmtData->fh);
+
+    for (i=0; i < numMissed; i++)
+      data[i]= &missed[i]->data[0];
+    for (i=0; i < numMissed && rc==RC_OK; i= j)
+    {
+      for (j=i+1; j < numMissed && missed[j]->pn == missed[j-1]->pn + 1; j++)
+        ;
+      rc= readBlocks(missed[i]->pn, j - i, &mgmtData->fh, &data[i]);
+    }
+    if (rc==RC_OK)
+    {
+      STAT_ADD(numReadIO, numMissed);
+      STAT_ADD(bytesRead, (long long) numMissed * PAGE_SIZE);
+    }
+  }
+
+  if (rc!=RC_OK)
+    undoPins(bm, pages, numPinned, missed, numMissed);
+  BM_UNLOCK();
+  if (missed != missedBuf)
+  {
+    free(missed);
+    free(data);
+  }
+  if (rc==RC_OK)
+    recordLatencySince(numMissed > 0 ? &mgmtData->pinMissLatency
+                       : &mgmtData->pinHitLatency, start);
+  RETURN(rc);
+}
+
+// Unpin pages[i] of numPages handles under one lock. Handles of pages
+// not pinned are skipped, RC_PAGE_NOT_PINNED then tells after the
+// others are unpinned.
+RC unpinPages (BM_BufferPool *const bm, BM_PageHandle *const pages,
+               const int numPages)
+{
+  BM_Pool_MgmtData *mgmtData= bm->mgmtData;
+  BM_PageFrame *pf;
+  RC rc= RC_OK;
+  int i;
+  BM_LOCK();
+
+  for (i=0; i < numPages; i++)
+  {
+    if (mgmtData->trace)
+      traceAccess(mgmtData->trace, TR_UNPIN, pages[i].pageNum);
+
+    pf= handleFrame(bm, &pages[i]);
+    if (!pf || pf->fixCount == 0)
+    {
+      rc= RC_PAGE_NOT_PINNED;
+      continue;
+    }
+
+    dropPin(bm, pf);
+  }
+
+  BM_UNLOCK();
+  RETURN(rc);
+}
+
+// Drop a pin of frame, under bm_mutex. Unpinned frames go back to
+// the replacement strategy, a shadow is emptied first.
+static void dropPin(BM_BufferPool *const bm, BM_PageFrame *pf)
+{
+  BM_Pool_MgmtData *mgmtData= bm->mgmtData;
+
+  pf->fixCount--;
+  FRAME_CHANGED(pf);
+  if (pf->fixCount > 0)
+    return;
+
+  if (pf->shadow)
+  {
+    pf->shadow= FALSE;
+    pf->pn= NO_PAGE;
+    pf->dirty= FALSE;
+    pf->gen++;
+    if (bm->strategy == RS_CLOCK)
+      pf->clockReplaceFlag= TRUE;
+    if (bm->strategy == RS_LRU)
+      prependLRUFrame(&mgmtData->stratData, pf);
+  }
+  // Add frame back to the list as MRU frame,
+  // so that this can be used, in next pinPage.
+  else if (bm->strategy == RS_LRU)
+    appendMRUFrame(&mgmtData->stratData, pf);
+}
+
+static int comparePageFrames(const void *a, const void *b)
+{
+  PageNumber pa= (*(BM_PageFrame* const *) a)->pn;
+  PageNumber pb= (*(BM_PageFrame* const *) b)->pn;
+
+  return pa < pb ? -1 : pa > pb;
+}
+
+// Drop pins of first numPinned handles of a failed pinPages. Frames
+// the batch took lose their page, it was never read.
+static void undoPins(BM_BufferPool *const bm, BM_PageHandle *const pages,
+                     int numPinned, BM_PageFrame **missed, int numMissed)
+{
+  BM_Pool_MgmtData *mgmtData= bm->mgmtData;
+  BM_PageFrame *pf;
+  int i;
+
+  for (i=0; i < numMissed; i++)
+  {
+    resetPageFrame(&mgmtData->pt_head, missed[i]->pn);
+    missed[i]->pn= NO_PAGE;
+    missed[i]->gen++;
+  }
+
+  for (i=0; i < numPinned; i++)
+  {
+    pf= mgmtData->pool[pages[i].frameNo];
+    pf->fixCount--;
+    FRAME_CHANGED(pf);
+    if (pf->fixCount > 0)
+      continue;
+    if (bm->strategy == RS_CLOCK)
+      pf->clockReplaceFlag= TRUE;
+    if (bm->strategy == RS_LRU)
+    {
+      // Emptied frames are reused first
+      if (pf->pn == NO_PAGE)
+        prependLRUFrame(&mgmtData->stratData, pf);
+      else
+        appendMRUFrame(&mgmtData->stratData, pf);
+    }
+  }
+}
+
+/**************************************************
+ * Pool resizing
+ */
+static BM_PageFrame* newFrame(BM_BufferPool *const bm, int frameNo)
+{
+  BM_Pool_MgmtData *mgmtData= bm->mgmtData;
+  int node= frameNo % mgmtData->arena.numNodes;
+  BM_PageFrame *pf= (BM_PageFrame*) allocFrame(&mgmtData->arena, node);
+
+  if (pf == NULL)
+    return NULL;
+  pf->node= node;
+  pf->dirty= FALSE;
+  pf->fixCount= 0;
+  pf->pn= NO_PAGE;
+  pf->changeEpoch= 0;
+  pf->frameNo= frameNo;
+  pf->gen= 0;
+  pf->clockReplaceFlag= TRUE;
+  initLatch(&pf->latch);
+  pf->snapshotPins= 0;
+  pf->shadow= FALSE;
+
+  // Add frame in LRU list representing free frame to use. New
+  // frames of a grown pool go first, ahead of cached pages.
+  if (frameNo < bm->numPages)
+    appendMRUFrame(&mgmtData->stratData, pf);
+  else
+    prependLRUFrame(&mgmtData->stratData, pf);
+  return pf;
+}
+
+// Give back frames first .. end-1 made by newFrame, none holds a page
+static void dropNewFrames(BM_BufferPool *const bm, int first, int end)
+{
+  BM_Pool_MgmtData *mgmtData= bm->mgmtData;
+  BM_PageFrame *pf;
+  int i;
+
+  for (i=first; i < end; i++)
+  {
+    pf= mgmtData->pool[i];
+    if (pf->lru_node)
+      reuseLRUFrame(&mgmtData->stratData, pf);
+    destroyLatch(&pf->latch);
+    freeFrame(&mgmtData->arena, pf, pf->node);
+  }
+}
+
+// Grow or shrink pool to numPages frames. Frames to drop are picked
+// by the replacement strategy like for pinPage, dirty pages are
+// written back. Frames of pinned pages never move, the last frame
+// takes the place of a dropped one. If too many pages are pinned,
+// pool shrinks as far as it can and RC_FRAME_IN_USE is returned.
+// If memory for new frames can not be had, pool keeps its size and
+// RC_WRITE_FAILED is returned.
+RC resizeBufferPool(BM_BufferPool *const bm, const int numPages)
+{
+  BM_Pool_MgmtData *mgmtData= bm->mgmtData;
+  BM_PageFrame *pf, *last, **pool;
+  RC rc= RC_OK;
+  int i;
+
+  if (numPages <= 0)
+    RETURN(RC_POOL_INVALID_SIZE);
+  BM_LOCK();
+
+  if (numPages > bm->numPages)
+  {
+    pool= (BM_PageFrame**) realloc(mgmtData->pool,
+                                   numPages * sizeof(BM_PageFrame*));
+    if (pool == NULL)
+    {
+      BM_UNLOCK();
+      RETURN(RC_WRITE_FAILED);
+    }
+    mgmtData->pool= pool;
+    for (i=bm->numPages; i < numPages; i++)
+    {
+      mgmtData->pool[i]= newFrame(bm, i);
+      if (mgmtData->pool[i] == NULL)
+      {
+        dropNewFrames(bm, bm->numPages, i);
+        BM_UNLOCK();
+        RETURN(RC_WRITE_FAILED);
+      }
+      FRAME_CHANGED(mgmtData->pool[i]);
+    }
+    bm->numPages= numPages;
+  }
+
+  while (bm->numPages > numPages)
+  {
+    // Handles of a shadow only find it at its index
+    if (mgmtData->pool[bm->numPages - 1]->shadow)
+    {
+      rc= RC_FRAME_IN_USE;
+      break;
+    }
+    pf= findFreeFrame(bm);
+    if (pf == NULL)
+    {
+      rc= RC_FRAME_IN_USE;
+      break;
+    }
+    // FIFO and CLOCK frames still have their node from initBufferPool
+    if (pf->lru_node)
+      reuseLRUFrame(&mgmtData->stratData, pf);
+
+    last= mgmtData->pool[bm->numPages - 1];
+    mgmtData->pool[pf->frameNo]= last;
+    last->frameNo= pf->frameNo;
+    last->gen++;
+    FRAME_CHANGED(last);
+    bm->numPages--;
+    destroyLatch(&pf->latch);
+    freeFrame(&mgmtData->arena, pf, pf->node);
+  }
+
+  BM_UNLOCK();
+  RETURN(rc);
+}
+
 /**************************************************
  * Strategy management functions
  */
@@ -316,12 +1035,35 @@ static BM_PageFrame* findFreeFrame(BM_BufferPool *bm)
   }
 }
 
+// Drop page of an unpinned frame, writing it back if dirty
+static RC evictFrame(BM_BufferPool *const bm, BM_PageFrame *pf)
+{
+  RC rc;
+  BM_Pool_MgmtData *mgmtData= bm->mgmtData;
+
+  if (pf->pn == NO_PAGE)
+    RETURN(RC_OK);
+
+  if (pf->dirty)
+  {
+    rc= writeIfDirty(bm, pf);
+    if (rc!=RC_OK)
+      RETURN(rc);
+    STAT_ADD(dirtyEvictions, 1);
+  }
+  else
+    STAT_ADD(cleanEvictions, 1);
+
+  // Reset Map, as we give this frame to different pn.
+  resetPageFrame(&mgmtData->pt_head, pf->pn);
+  RETURN(RC_OK);
+}
+
 /*
  * FIFO free page find strategy
  */
 static BM_PageFrame* findFreeFrameFIFO(BM_BufferPool *bm)
 {
-  RC rc;
   int frmNo, curFrame;
   BM_Pool_MgmtData *mgmtData= mgmtData= bm->mgmtData;
 
@@ -329,20 +1071,11 @@ static BM_PageFrame* findFreeFrameFIFO(BM_BufferPool *bm)
   for (frmNo=0; frmNo < bm->numPages; frmNo++)
   {
     curFrame= curFrame % bm->numPages;
-    BM_PageFrame *pf= &mgmtData->pool[curFrame];
+    BM_PageFrame *pf= mgmtData->pool[curFrame];
     if (pf->fixCount==0)
     {
-        if (pf->dirty)
-        {
-          rc= writeIfDirty(bm, pf);
-          if (rc!=RC_OK)
-            return NULL;
-        }
-        else if (pf->pn != NO_PAGE)
-        {
-          // Reset Map, as we give this frame to different pn.
-          resetPageFrame(&mgmtData->pt_head, pf->pn);
-        }
+        if (evictFrame(bm, pf) != RC_OK)
+          return NULL;
 
         mgmtData->stratData.fifoLastFreeFrame= curFrame;
         return pf;
@@ -358,25 +1091,20 @@ static BM_PageFrame* findFreeFrameFIFO(BM_BufferPool *bm)
  */
 static BM_PageFrame* findFreeFrameLRU(BM_BufferPool *bm)
 {
-  RC rc;
   BM_PageFrame *pf;
   BM_Pool_MgmtData *mgmtData= mgmtData= bm->mgmtData;
 
-  pf= retriveLRUFrame(&mgmtData->stratData);
+  // Frame local to thread, if one is about as old as the LRU one
+  if (mgmtData->arena.numNodes > 1)
+    pf= retriveLRUFrameOnNode(&mgmtData->stratData, getCurrentNumaNode(),
+                              NUMA_LOOKAHEAD);
+  else
+    pf= retriveLRUFrame(&mgmtData->stratData);
   if (!pf)
     return NULL; // All frames pinned
   
-  if (pf->dirty)
-  {
-     rc= writeIfDirty(bm, pf);
-     if (rc!=RC_OK)
-        return NULL;
-  }
-  else if (pf->pn != NO_PAGE)
-  {
-    // Reset Map, as we give this frame to different pn.
-    resetPageFrame(&mgmtData->pt_head, pf->pn);
-  }
+  if (evictFrame(bm, pf) != RC_OK)
+    return NULL;
 
   return pf;
 }
@@ -386,7 +1114,6 @@ static BM_PageFrame* findFreeFrameLRU(BM_BufferPool *bm)
  */
 static BM_PageFrame* findFreeFrameCLOCK(BM_BufferPool *bm)
 {
-  RC rc;
   int frmNo, curFrame;
   BM_Pool_MgmtData *mgmtData= mgmtData= bm->mgmtData;
 
@@ -396,22 +1123,13 @@ static BM_PageFrame* findFreeFrameCLOCK(BM_BufferPool *bm)
   for (frmNo=0; frmNo < bm->numPages * 2 ; frmNo++)
   {
     curFrame= curFrame % bm->numPages;
-    BM_PageFrame *pf= &mgmtData->pool[curFrame];
+    BM_PageFrame *pf= mgmtData->pool[curFrame];
     if (pf->clockReplaceFlag == TRUE)
     {
       if (pf->fixCount==0)
       {
-        if (pf->dirty)
-        {
-          rc= writeIfDirty(bm, pf);
-          if (rc!=RC_OK)
-            return NULL;
-        }
-        else if (pf->pn != NO_PAGE)
-        {
-          // Reset Map, as we give this frame to different pn.
-          resetPageFrame(&mgmtData->pt_head, pf->pn);
-        }
+        if (evictFrame(bm, pf) != RC_OK)
+          return NULL;
 
         mgmtData->stratData.clockCurrentFrame= curFrame;
         return pf;
@@ -433,7 +1151,6 @@ static BM_PageFrame* findFreeFrameCLOCK(BM_BufferPool *bm)
 PageNumber *getFrameContents (BM_BufferPool *const bm)
 {
   BM_Pool_MgmtData *mgmtData= bm->mgmtData;
-  BM_PageFrame *pf= &mgmtData->pool[0];
   PageNumber *pn;
   int frmNo;
   BM_LOCK();
@@ -441,29 +1158,25 @@ PageNumber *getFrameContents (BM_BufferPool *const bm)
   pn= (PageNumber*) malloc(bm->numPages*sizeof(PageNumber));
 
   for (frmNo=0; frmNo < bm->numPages; frmNo++)
-  {
-    pn[frmNo]= pf->pn;
-    pf++;
-  }
+    pn[frmNo]= mgmtData->pool[frmNo]->pn;
 
   BM_UNLOCK();
   return pn;
 }
 bool *getDirtyFlags (BM_BufferPool *const bm)
 {
-  bool *dirty_array= (bool*) malloc(bm->numPages*sizeof(bool));
+  bool *dirty_array;
   BM_Pool_MgmtData *mgmtData= bm->mgmtData;
   int frmNo;
-  BM_PageFrame *pf= &mgmtData->pool[0];
   BM_LOCK();
 
+  dirty_array= (bool*) malloc(bm->numPages*sizeof(bool));
   for (frmNo=0; frmNo < bm->numPages; frmNo++)
   {
-    if (pf->dirty)
+    if (mgmtData->pool[frmNo]->dirty)
       dirty_array[frmNo]= TRUE;
     else
       dirty_array[frmNo]= FALSE;
-    pf++;
   }
 
   BM_UNLOCK();
@@ -471,17 +1184,14 @@ bool *getDirtyFlags (BM_BufferPool *const bm)
 }
 int *getFixCounts (BM_BufferPool *const bm)
 {
-  int *fixCounts= (int*) malloc(bm->numPages*sizeof(int));
+  int *fixCounts;
   BM_Pool_MgmtData *mgmtData= bm->mgmtData;
   int frmNo;
   BM_LOCK();
 
-  BM_PageFrame *pf= &mgmtData->pool[0];
+  fixCounts= (int*) malloc(bm->numPages*sizeof(int));
   for (frmNo=0; frmNo < bm->numPages; frmNo++)
-  {
-    fixCounts[frmNo]= pf->fixCount;
-    pf++;
-  }
+    fixCounts[frmNo]= mgmtData->pool[frmNo]->fixCount;
 
   BM_UNLOCK();
   return fixCounts;
@@ -489,10 +1199,236 @@ int *getFixCounts (BM_BufferPool *const bm)
 int getNumReadIO (BM_BufferPool *const bm)
 {
   BM_Pool_MgmtData *mgmtData= bm->mgmtData;
-  return mgmtData->io_reads;
+  return (int) STAT_GET(numReadIO);
 }
 int getNumWriteIO (BM_BufferPool *const bm)
 {
   BM_Pool_MgmtData *mgmtData= bm->mgmtData;
-  return mgmtData->io_writes;
-}
\ No newline at end of file
+  return (int) STAT_GET(numWriteIO);
+}
+
+// Copy of counters, taken without bm_mutex. Every counter is read
+// atomically, but they are not from one instant when pool is busy.
+RC getPoolStats (BM_BufferPool *const bm, BM_PoolStats *stats)
+{
+  BM_Pool_MgmtData *mgmtData= bm->mgmtData;
+
+  stats->hits= STAT_GET(hits);
+  stats->misses= STAT_GET(misses);
+  stats->cleanEvictions= STAT_GET(cleanEvictions);
+  stats->dirtyEvictions= STAT_GET(dirtyEvictions);
+  stats->pinWaits= STAT_GET(pinWaits);
+  stats->flushes= STAT_GET(flushes);
+  stats->numReadIO= STAT_GET(numReadIO);
+  stats->numWriteIO= STAT_GET(numWriteIO);
+  stats->bytesRead= STAT_GET(bytesRead);
+  stats->bytesWritten= STAT_GET(bytesWritten);
+  RETURN(RC_OK);
+}
+
+RC resetPoolStats (BM_BufferPool *const bm)
+{
+  BM_Pool_MgmtData *mgmtData= bm->mgmtData;
+  long long *counter= (long long*) &mgmtData->stats;
+  int i;
+
+  for (i=0; i < (int) (sizeof(BM_PoolStats) / sizeof(long long)); i++)
+    __atomic_store_n(&counter[i], 0, __ATOMIC_RELAXED);
+  initLatencyHistogram(&mgmtData->pinHitLatency);
+  initLatencyHistogram(&mgmtData->pinMissLatency);
+  BM_LOCK();
+  if (mgmtData->mrc)
+    resetMRCEstimator(mgmtData->mrc);
+  BM_UNLOCK();
+  RETURN(RC_OK);
+}
+
+// Latency of pinPage calls that found page in pool and that read it
+RC getPinLatency (BM_BufferPool *const bm, LH_Snapshot *hit,
+                  LH_Snapshot *miss)
+{
+  BM_Pool_MgmtData *mgmtData= bm->mgmtData;
+
+  getLatencySnapshot(&mgmtData->pinHitLatency, hit);
+  getLatencySnapshot(&mgmtData->pinMissLatency, miss);
+  RETURN(RC_OK);
+}
+
+// Snapshot Interface
+// ***************************************
+RC initPoolSnapshot (BM_PoolSnapshot *snap, int capacity)
+{
+  snap->capacity= capacity;
+  snap->count= 0;
+  snap->epoch= 0;
+  snap->frameIds= (int*) malloc(capacity * sizeof(int));
+  snap->pageNums= (PageNumber*) malloc(capacity * sizeof(PageNumber));
+  snap->dirty= (bool*) malloc(capacity * sizeof(bool));
+  snap->fixCounts= (int*) malloc(capacity * sizeof(int));
+  RETURN(RC_OK);
+}
+
+void freePoolSnapshot (BM_PoolSnapshot *snap)
+{
+  free(snap->frameIds);
+  free(snap->pageNums);
+  free(snap->dirty);
+  free(snap->fixCounts);
+  snap->capacity= snap->count= 0;
+}
+
+// All frames
+RC getPoolSnapshot (BM_BufferPool *const bm, BM_PoolSnapshot *snap)
+{
+  return getPoolChanges(bm, 0, snap);
+}
+
+// Frames changed after epoch, epoch 0 gives all frames
+RC getPoolChanges (BM_BufferPool *const bm, unsigned long long epoch,
+                   BM_PoolSnapshot *snap)
+{
+  BM_Pool_MgmtData *mgmtData= bm->mgmtData;
+  BM_PageFrame *pf;
+  int frmNo, n= 0;
+
+  BM_LOCK();
+  if (epoch == 0 && snap->capacity < bm->numPages)
+  {
+    BM_UNLOCK();
+    RETURN(RC_SNAPSHOT_TOO_SMALL);
+  }
+
+  for (frmNo=0; frmNo < bm->numPages; frmNo++)
+  {
+    pf= mgmtData->pool[frmNo];
+    if (epoch != 0 && pf->changeEpoch <= epoch)
+      continue;
+    if (n == snap->capacity)
+    {
+      BM_UNLOCK();
+      RETURN(RC_SNAPSHOT_TOO_SMALL);
+    }
+    snap->frameIds[n]= frmNo;
+    snap->pageNums[n]= pf->pn;
+    snap->dirty[n]= pf->dirty;
+    snap->fixCounts[n]= pf->fixCount;
+    n++;
+  }
+  snap->count= n;
+  snap->epoch= mgmtData->epoch;
+
+  BM_UNLOCK();
+  RETURN(RC_OK);
+}
+
+// Trace Interface
+// ***************************************
+// Log pins, unpins and dirty marks to fileName until stopPoolTrace
+RC startPoolTrace (BM_BufferPool *const bm, const char *fileName)
+{
+  BM_TraceWriter *writer;
+  BM_Pool_MgmtData *mgmtData= bm->mgmtData;
+  RC rc;
+
+  // File is opened outside the lock, check first to not clobber it
+  if (__atomic_load_n(&mgmtData->trace, __ATOMIC_RELAXED))
+    RETURN(RC_FILE_HANDLE_IN_USE);
+  rc= openTraceWriter(&writer, fileName);
+  if (rc != RC_OK)
+    RETURN(rc);
+
+  BM_LOCK();
+  if (mgmtData->trace)
+  {
+    BM_UNLOCK();
+    closeTraceWriter(writer);
+    RETURN(RC_FILE_HANDLE_IN_USE);
+  }
+  mgmtData->trace= writer;
+  BM_UNLOCK();
+  RETURN(RC_OK);
+}
+
+RC stopPoolTrace (BM_BufferPool *const bm)
+{
+  BM_TraceWriter *writer;
+  BM_Pool_MgmtData *mgmtData= bm->mgmtData;
+
+  BM_LOCK();
+  writer= mgmtData->trace;
+  mgmtData->trace= NULL;
+  BM_UNLOCK();
+
+  if (writer == NULL)
+    RETURN(RC_FILE_HANDLE_NOT_INIT);
+  return closeTraceWriter(writer);
+}
+
+// Miss Ratio Interface
+// ***************************************
+// Pins from now on feed a sampled LRU reuse distance estimator,
+// enabling again starts over with the new parameters.
+RC enableMissRatioTracking (BM_BufferPool *const bm, int maxSize,
+                            double sampleRate)
+{
+  BM_Pool_MgmtData *mgmtData= bm->mgmtData;
+  MRC_Estimator *e, *old;
+  RC rc;
+
+  e= (MRC_Estimator*) malloc(sizeof(MRC_Estimator));
+  if (e == NULL)
+    RETURN(RC_WRITE_FAILED);
+  rc= initMRCEstimator(e, maxSize, sampleRate);
+  if (rc != RC_OK)
+  {
+    free(e);
+    RETURN(rc);
+  }
+
+  BM_LOCK();
+  old= mgmtData->mrc;
+  mgmtData->mrc= e;
+  BM_UNLOCK();
+
+  if (old)
+  {
+    freeMRCEstimator(old);
+    free(old);
+  }
+  RETURN(RC_OK);
+}
+
+RC disableMissRatioTracking (BM_BufferPool *const bm)
+{
+  BM_Pool_MgmtData *mgmtData= bm->mgmtData;
+  MRC_Estimator *old;
+
+  BM_LOCK();
+  old= mgmtData->mrc;
+  mgmtData->mrc= NULL;
+  BM_UNLOCK();
+
+  if (old == NULL)
+    RETURN(RC_MRC_NOT_ENABLED);
+  freeMRCEstimator(old);
+  free(old);
+  RETURN(RC_OK);
+}
+
+// LRU hit ratio with numPages frames over pins since tracking began
+// or stats were reset. Other strategies come close to it, see mrc_sim.
+RC getPredictedHitRatio (BM_BufferPool *const bm, int numPages,
+                         double *hitRatio)
+{
+  BM_Pool_MgmtData *mgmtData= bm->mgmtData;
+
+  BM_LOCK();
+  if (mgmtData->mrc == NULL)
+  {
+    BM_UNLOCK();
+    RETURN(RC_MRC_NOT_ENABLED);
+  }
+  *hitRatio= getEstimatedHitRatio(mgmtData->mrc, numPages);
+  BM_UNLOCK();
+  RETURN(RC_OK);
+}
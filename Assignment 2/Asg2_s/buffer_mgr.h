@@ -4,6 +4,10 @@
 // Include return codes and methods for logging errors
 #include "dberror.h"
 #include "storage_mgr.h"
+#include "dt.h"
+#include "latency_hist.h"
+#include "page_latch.h"
+#include "frame_arena.h"
 #include "stdlib.h"
 #include <pthread.h>
 
@@ -20,10 +24,6 @@ typedef enum ReplacementStrategy {
 typedef int PageNumber;
 #define NO_PAGE -1
 
-typedef short bool;
-#define TRUE 1
-#define FALSE 0
-
 typedef struct BM_BufferPool {
   char *pageFile;
   int numPages;
@@ -35,11 +35,27 @@ typedef struct BM_BufferPool {
 typedef struct BM_PageHandle {
   PageNumber pageNum;
   char *data;
+  // Set by pinPage, lets unpinPage, markDirty and forcePage find the
+  // frame without a page table walk. Checked before use, so a handle
+  // only holding pageNum still works.
+  int frameNo;
+  unsigned int frameGen;
 } BM_PageHandle;
 
+// Strategy Related data structures
+typedef struct LRU_Node {
+  struct BM_PageFrame *frame;
+  
+  // List organized in a way that HEAD points to LRU frame
+  // and TAIL points to MRU
+  struct LRU_Node *next;
+  struct LRU_Node *prev;
+} LRU_Node;
+
 // Per Buffer Pool frame details
 typedef struct BM_PageFrame {
     bool dirty;
+    bool clockReplaceFlag;
     int fixCount;
     PageNumber pn;  // Owner of the frame.
 
@@ -48,9 +64,33 @@ typedef struct BM_PageFrame {
     // found in pagetable, it is better to use same
     // page so as to avoid disk read. This need removal
     // of node from LRU, may be from mid of list.
+    // Points to lru_link while frame is in list, NULL otherwise.
+    // Node is part of frame, so LRU moves allocate nothing.
     struct LRU_Node *lru_node;
-    bool clockReplaceFlag;
+    LRU_Node lru_link;
+
+    // Pool epoch of last change of pn, dirty or fixCount
+    unsigned long long changeEpoch;
+
+    // Index in pool, changes when pool shrinks
+    int frameNo;
+    // Bumped when frame gets another page or index, handles of
+    // the old page then no longer match
+    unsigned int gen;
+    // NUMA node frame memory is on, see frame_arena.h
+    int node;
 
+    // Pins of pinPageSnapshot. A writer then moves page to a copy
+    // and this frame becomes a shadow: it keeps the old image for
+    // its pins, is out of page table and is never written back.
+    int snapshotPins;
+    bool shadow;
+
+    // Taken by pinPageLatched, guards data between threads that
+    // pin the same page. Pin count alone only keeps page in frame.
+    PL_Latch latch;
+
+    // Keep data 8 byte aligned, pages are read as structs.
     char data[PAGE_SIZE];
 } BM_PageFrame;
 
@@ -67,16 +107,6 @@ typedef struct BM_PageTable {
     void* entry[MAX_PT_ENTRIES];
 } BM_PageTable;
 
-// Strategy Related data structures
-typedef struct LRU_Node {
-  BM_PageFrame *frame;
-  
-  // List organized in a way that HEAD points to LRU frame
-  // and TAIL points to MRU
-  struct LRU_Node *next;
-  struct LRU_Node *prev;
-} LRU_Node;
-
 typedef struct BM_StrategyInfo {
     // For FIFO
     int fifoLastFreeFrame;
@@ -86,19 +116,52 @@ typedef struct BM_StrategyInfo {
     int clockCurrentFrame;
 } BM_StrategyInfo;
 
+// Pool statistics. Counters are updated atomically, so they can
+// be read any time without taking bm_mutex.
+typedef struct BM_PoolStats {
+  long long hits;           // pinPage found page in pool
+  long long misses;         // pinPage had to read page
+  long long cleanEvictions; // Page dropped from frame to reuse it
+  long long dirtyEvictions; // Page written back before reuse
+  long long pinWaits;       // pinPage or pinPages blocked on bm_mutex
+  long long flushes;        // Pages written by forcePage, forceFlushPool
+  long long numReadIO;
+  long long numWriteIO;
+  long long bytesRead;
+  long long bytesWritten;
+} BM_PoolStats;
+
 // Additional per BM details
 typedef struct BM_Pool_MgmtData {
   SM_FileHandle fh;
-  BM_PageFrame *pool;   // Heap mem = [numPages * sizeof(BM_PageFrame)] bytes
+  BM_PageFrame **pool;  // numPages frames, allocated one by one so
+                        // resizing does not move pinned pages
+  FA_Arena arena;       // Memory of frames, interleaved over nodes
   BM_PageTable pt_head; // Keeps mapping of page number to page frame.
-  int io_reads;
-  int io_writes;
+  BM_PoolStats stats;
+  unsigned long long epoch;     // Bumped on every frame change
+  struct BM_TraceWriter *trace; // Accesses are logged, NULL when off
+  struct MRC_Estimator *mrc;    // Reuse distances of pins, NULL when off
+  LH_Histogram pinHitLatency;   // Recorded while latency tracking is on
+  LH_Histogram pinMissLatency;
   BM_StrategyInfo stratData;
 
   // Gaurd's complete buffer manager
   pthread_mutex_t bm_mutex;
 } BM_Pool_MgmtData;
 
+// Frame states of a pool, arrays are owned by caller and hold
+// capacity entries. Entry i describes frame frameIds[i].
+typedef struct BM_PoolSnapshot {
+  int capacity;
+  int count;                  // Entries filled
+  unsigned long long epoch;   // Pass to getPoolChanges for next changes
+  int *frameIds;
+  PageNumber *pageNums;
+  bool *dirty;
+  int *fixCounts;
+} BM_PoolSnapshot;
+
 // convenience macros
 #define MAKE_POOL()				\
   ((BM_BufferPool *) malloc (sizeof(BM_BufferPool)))
@@ -109,11 +172,8 @@ typedef struct BM_Pool_MgmtData {
 #define MAKE_POOL_MGMTDATA()	\
   ((BM_Pool_MgmtData*) malloc (sizeof(BM_Pool_MgmtData)))
 
-#define MAKE_LRU_NODE()         \
-    ((LRU_Node*) malloc (sizeof(LRU_Node)))
-
 #define MAKE_BUFFER_POOL(n)     \
-    ((BM_PageFrame*) malloc (sizeof(BM_PageFrame) * n))
+    ((BM_PageFrame**) malloc (sizeof(BM_PageFrame*) * n))
 
 // Buffer Manager Interface - Pool Handling
 RC initBufferPool(BM_BufferPool *const bm, const char *const pageFileName, 
@@ -121,6 +181,7 @@ RC initBufferPool(BM_BufferPool *const bm, const char *const pageFileName,
 		  void *stratData);
 RC shutdownBufferPool(BM_BufferPool *const bm);
 RC forceFlushPool(BM_BufferPool *const bm);
+RC resizeBufferPool(BM_BufferPool *const bm, const int numPages);
 
 // Buffer Manager Interface - Access Pages
 RC markDirty (BM_BufferPool *const bm, BM_PageHandle *const page);
@@ -129,11 +190,74 @@ RC forcePage (BM_BufferPool *const bm, BM_PageHandle *const page);
 RC pinPage (BM_BufferPool *const bm, BM_PageHandle *const page, 
 	    const PageNumber pageNum);
 
+// Buffer Manager Interface - Batch Access, one lock for all pages
+RC pinPages (BM_BufferPool *const bm, BM_PageHandle *const pages,
+             const PageNumber *const pageNums, const int numPages);
+RC unpinPages (BM_BufferPool *const bm, BM_PageHandle *const pages,
+               const int numPages);
+
+// Buffer Manager Interface - Latched Access. Page is pinned, then
+// latched in mode, see page_latch.h. unpinPageLatched takes the same
+// mode, releases latch and unpins.
+RC pinPageLatched (BM_BufferPool *const bm, BM_PageHandle *const page,
+                   const PageNumber pageNum, PL_Mode mode);
+RC unpinPageLatched (BM_BufferPool *const bm, BM_PageHandle *const page,
+                     PL_Mode mode);
+
+// Buffer Manager Interface - Snapshot Reads. Page stays as it was
+// when pinned: a writer that latches it exclusive while snapshot pins
+// are on its frame gets a copy of the frame to write to. Writers that
+// do not latch the page are not noticed.
+RC pinPageSnapshot (BM_BufferPool *const bm, BM_PageHandle *const page,
+                    const PageNumber pageNum);
+RC unpinPageSnapshot (BM_BufferPool *const bm, BM_PageHandle *const page);
+
+// Optimistic read of a page the caller has pinned. read is called on
+// page data without latch and may see a half written page, so it
+// should only copy what it needs to arg. It is called again when an
+// exclusive latch holder came in between, after BM_OPTIMISTIC_TRIES
+// tries the page is read under shared latch. Writers that do not
+// latch the page are not noticed.
+#define BM_OPTIMISTIC_TRIES 3
+typedef void (*BM_PageReader) (const char *data, void *arg);
+RC readPageOptimistic (BM_BufferPool *const bm, BM_PageHandle *const page,
+                       BM_PageReader read, void *arg);
+
+// Buffer Manager Interface - Workspace Frames
+RC reserveFrames (BM_BufferPool *const bm, const int numFrames,
+                  char **frames);
+RC releaseFrames (BM_BufferPool *const bm, const int numFrames,
+                  char **frames);
+
 // Statistics Interface
 PageNumber *getFrameContents (BM_BufferPool *const bm);
 bool *getDirtyFlags (BM_BufferPool *const bm);
 int *getFixCounts (BM_BufferPool *const bm);
 int getNumReadIO (BM_BufferPool *const bm);
 int getNumWriteIO (BM_BufferPool *const bm);
+RC getPoolStats (BM_BufferPool *const bm, BM_PoolStats *stats);
+RC resetPoolStats (BM_BufferPool *const bm);
+RC getPinLatency (BM_BufferPool *const bm, LH_Snapshot *hit,
+                  LH_Snapshot *miss);
+
+// Snapshot Interface, frames are read under one lock and nothing
+// is allocated. Changes are frames changed after epoch was taken.
+RC initPoolSnapshot (BM_PoolSnapshot *snap, int capacity);
+void freePoolSnapshot (BM_PoolSnapshot *snap);
+RC getPoolSnapshot (BM_BufferPool *const bm, BM_PoolSnapshot *snap);
+RC getPoolChanges (BM_BufferPool *const bm, unsigned long long epoch,
+                   BM_PoolSnapshot *snap);
+
+// Trace Interface, see buffer_trace.h
+RC startPoolTrace (BM_BufferPool *const bm, const char *fileName);
+RC stopPoolTrace (BM_BufferPool *const bm);
+
+// Miss Ratio Interface, see mrc.h. Predicts hit ratio the pool
+// would have had with numPages frames, for sizes up to maxSize.
+RC enableMissRatioTracking (BM_BufferPool *const bm, int maxSize,
+                            double sampleRate);
+RC disableMissRatioTracking (BM_BufferPool *const bm);
+RC getPredictedHitRatio (BM_BufferPool *const bm, int numPages,
+                         double *hitRatio);
 
 #endif
\ No newline at end of file
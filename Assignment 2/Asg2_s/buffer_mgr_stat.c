@@ -1,109 +1,141 @@
-#include "buffer_mgr_stat.h"
-#include "buffer_mgr.h"
-
-#include <stdio.h>
-#include <stdlib.h>
-
-// local functions
-static void printStrat (BM_BufferPool *const bm);
-
-// external functions
-void 
-printPoolContent (BM_BufferPool *const bm)
-{
-  PageNumber *frameContent;
-  bool *dirty;
-  int *fixCount;
-  int i;
-
-  frameContent = getFrameContents(bm);
-  dirty = getDirtyFlags(bm);
-  fixCount = getFixCounts(bm);
-
-  printf("{");
-  printStrat(bm);
-  printf(" %i}: ", bm->numPages); 
-  
-  for (i = 0; i < bm->numPages; i++)
-      printf("%s[%i%s%i]", ((i == 0) ? "" : ",") , frameContent[i], (dirty[i] ? "x": " "), fixCount[i]);
-  printf("\n");
-}
-
-char *
-sprintPoolContent (BM_BufferPool *const bm)
-{
-  PageNumber *frameContent;
-  bool *dirty;
-  int *fixCount;
-  int i;
-  char *message;
-  int pos = 0;
-
-  message = (char *) malloc(256 + (22 * bm->numPages));
-  frameContent = getFrameContents(bm);
-  dirty = getDirtyFlags(bm);
-  fixCount = getFixCounts(bm);
-
-  for (i = 0; i < bm->numPages; i++)
-    pos += sprintf(message + pos, "%s[%i%s%i]", ((i == 0) ? "" : ",") , frameContent[i], (dirty[i] ? "x": " "), fixCount[i]);
-
-  free(frameContent);
-  free(dirty);
-  free(fixCount);
-  
-  return message;
-}
-
-
-void
-printPageContent (BM_PageHandle *const page)
-{
-  int i;
-
-  printf("[Page %i]\n", page->pageNum);
-
-  for (i = 1; i <= PAGE_SIZE; i++)
-    printf("%02X%s%s", page->data[i], (i % 8) ? "" : " ", (i % 64) ? "" : "\n"); 
-}
-
-char *
-sprintPageContent (BM_PageHandle *const page)
-{
-  int i;
-  char *message;
-  int pos = 0;
-
-  message = (char *) malloc(30 + (2 * PAGE_SIZE) + (PAGE_SIZE % 64) + (PAGE_SIZE % 8));
-  pos += sprintf(message + pos, "[Page %i]\n", page->pageNum);
-
-  for (i = 1; i <= PAGE_SIZE; i++)
-    pos += sprintf(message + pos, "%02X%s%s", page->data[i], (i % 8) ? "" : " ", (i % 64) ? "" : "\n"); 
-  
-  return message;
-}
-
-void
-printStrat (BM_BufferPool *const bm)
-{
-  switch (bm->strategy)
-    {
-    case RS_FIFO:
-      printf("FIFO");
-      break;
-    case RS_LRU:
-      printf("LRU");
-      break;
-    case RS_CLOCK:
-      printf("CLOCK");
-      break;
-    case RS_LFU:
-      printf("LFU");
-      break;
-    case RS_LRU_K:
-      printf("LRU-K");
-      break;
-    default:
-      printf("%i", bm->strategy);
-      break;
-    }
+#include "buffer_mgr_stat.h"
+#include "buffer_mgr.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+
+// local functions
+static void printStrat (BM_BufferPool *const bm);
+
+// external functions
+void 
+printPoolContent (BM_BufferPool *const bm)
+{
+  char *content;
+
+  content = sprintPoolContent(bm);
+  printf("{");
+  printStrat(bm);
+  printf(" %i}: %s\n", bm->numPages, content);
+  free(content);
+}
+
+// frames are taken in one snapshot, so they are consistent
+char *
+sprintPoolContent (BM_BufferPool *const bm)
+{
+  BM_PoolSnapshot snap;
+  int i;
+  char *message;
+  int pos = 0;
+
+  message = (char *) malloc(256 + (22 * bm->numPages));
+  initPoolSnapshot(&snap, bm->numPages);
+  getPoolSnapshot(bm, &snap);
+
+  for (i = 0; i < snap.count; i++)
+    pos += sprintf(message + pos, "%s[%i%s%i]", ((i == 0) ? "" : ",") , snap.pageNums[i], (snap.dirty[i] ? "x": " "), snap.fixCounts[i]);
+  message[pos] = '\0';
+
+  freePoolSnapshot(&snap);
+  return message;
+}
+
+
+void
+printPoolStats (BM_BufferPool *const bm)
+{
+  BM_PoolStats stats;
+  long long pins, evictions;
+  double ratio;
+  int size;
+
+  getPoolStats(bm, &stats);
+  pins = stats.hits + stats.misses;
+  evictions = stats.cleanEvictions + stats.dirtyEvictions;
+
+  printf("hits %lld misses %lld hit ratio %.1f%% pin waits %lld\n",
+         stats.hits, stats.misses,
+         pins ? 100.0 * stats.hits / pins : 0.0, stats.pinWaits);
+  printf("evictions %lld dirty %.1f%% flushes %lld\n", evictions,
+         evictions ? 100.0 * stats.dirtyEvictions / evictions : 0.0,
+         stats.flushes);
+  printf("read %lld pages %lld bytes, written %lld pages %lld bytes\n",
+         stats.numReadIO, stats.bytesRead, stats.numWriteIO,
+         stats.bytesWritten);
+
+  if (getPredictedHitRatio(bm, bm->numPages, &ratio) == RC_OK)
+    {
+      printf("predicted hit ratio");
+      for (size = (bm->numPages + 1) / 2; size <= 4 * bm->numPages; size *= 2)
+        {
+          getPredictedHitRatio(bm, size, &ratio);
+          printf(" %d frames %.1f%%", size, 100.0 * ratio);
+        }
+      printf("\n");
+    }
+
+  if (latencyTrackingOn())
+    {
+      LH_Snapshot hit, miss;
+
+      getPinLatency(bm, &hit, &miss);
+      printf("pin hit ns p50 %lld p99 %lld p999 %lld max %lld\n",
+             hit.p50, hit.p99, hit.p999, hit.max);
+      printf("pin miss ns p50 %lld p99 %lld p999 %lld max %lld\n",
+             miss.p50, miss.p99, miss.p999, miss.max);
+    }
+}
+
+void
+printPageContent (BM_PageHandle *const page)
+{
+  int i;
+
+  printf("[Page %i]\n", page->pageNum);
+
+  for (i = 1; i <= PAGE_SIZE; i++)
+    printf("%02X%s%s", page->data[i], (i % 8) ? "" : " ", (i % 64) ? "" : "\n"); 
+}
+
+char *
+sprintPageContent (BM_PageHandle *const page)
+{
+  int i;
+  char *message;
+  int pos = 0;
+
+  message = (char *) malloc(30 + (2 * PAGE_SIZE) + (PAGE_SIZE % 64) + (PAGE_SIZE % 8));
+  pos += sprintf(message + pos, "[Page %i]\n", page->pageNum);
+
+  for (i = 1; i <= PAGE_SIZE; i++)
+    pos += sprintf(message + pos, "%02X%s%s", page->data[i], (i % 8) ? "" : " ", (i % 64) ? "" : "\n"); 
+  
+  return message;
+}
+
+void
+printStrat (BM_BufferPool *const bm)
+{
+  switch (bm->strategy)
+    {
+    case RS_FIFO:
+      printf("FIFO");
+      break;
+    case RS_LRU:
+      printf("LRU");
+      break;
+    case RS_CLOCK:
+      printf("CLOCK");
+      break;
+    case RS_LFU:
+      printf("LFU");
+      break;
+    case RS_LRU_K:
+      printf("LRU-K");
+      break;
+    default:
+      printf("%i", bm->strategy);
+      break;
+    }
 }
\ No newline at end of file
@@ -0,0 +1,215 @@
+#include "buffer_trace.h"
+#include "storage_mgr.h"
+#include <string.h>
+#include <stdlib.h>
+#include <time.h>
+
+/*
+ * Buffer pool access traces
+ *
+ * A pool started with startPoolTrace logs every pinPage, unpinPage
+ * and markDirty while it holds bm_mutex, so records are in the order
+ * the pool saw them. Records are buffered and written in blocks.
+ *
+ * Replay runs the same calls against a new pool. Unpins of pages not
+ * pinned in the replay, because tracing started while they were
+ * pinned, are skipped.
+ */
+
+// Not a interface
+static RC flushTrace(BM_TraceWriter *writer);
+static RC fillTrace(BM_TraceReader *reader);
+static void unpinAll(BM_BufferPool *bm);
+
+static RC flushTrace(BM_TraceWriter *writer)
+{
+  if (writer->count == 0)
+    RETURN(RC_OK);
+  if (fwrite(writer->buf, sizeof(unsigned int), writer->count, writer->file)
+      != (size_t) writer->count)
+    RETURN(RC_WRITE_FAILED);
+  writer->count= 0;
+  RETURN(RC_OK);
+}
+
+RC openTraceWriter (BM_TraceWriter **writer, const char *fileName)
+{
+  BM_TraceWriter *w;
+  FILE *file;
+
+  file= fopen(fileName, "wb");
+  if (file == NULL)
+    RETURN(RC_FILE_CREATE_FAILED);
+  if (fwrite(TR_MAGIC, 1, TR_MAGIC_LEN, file) != TR_MAGIC_LEN)
+  {
+    fclose(file);
+    RETURN(RC_WRITE_FAILED);
+  }
+
+  w= (BM_TraceWriter*) malloc(sizeof(BM_TraceWriter));
+  w->file= file;
+  w->count= 0;
+  w->numRecords= 0;
+  *writer= w;
+  RETURN(RC_OK);
+}
+
+RC traceAccess (BM_TraceWriter *writer, TR_Op op, PageNumber pageNum)
+{
+  writer->buf[writer->count++]= ((unsigned int) op << TR_OP_SHIFT)
+                                | ((unsigned int) pageNum & TR_PAGE_MASK);
+  writer->numRecords++;
+  if (writer->count == TR_BUF_RECORDS)
+    return flushTrace(writer);
+  RETURN(RC_OK);
+}
+
+RC closeTraceWriter (BM_TraceWriter *writer)
+{
+  RC rc;
+
+  rc= flushTrace(writer);
+  if (fclose(writer->file) != 0 && rc == RC_OK)
+    rc= RC_FILE_CLOSE_FAILED;
+  free(writer);
+  RETURN(rc);
+}
+
+static RC fillTrace(BM_TraceReader *reader)
+{
+  reader->count= (int) fread(reader->buf, sizeof(unsigned int),
+                             TR_BUF_RECORDS, reader->file);
+  reader->pos= 0;
+  if (reader->count == 0)
+    RETURN(ferror(reader->file) ? RC_READ_FAILED : RC_TRACE_END);
+  RETURN(RC_OK);
+}
+
+RC openTraceReader (BM_TraceReader **reader, const char *fileName)
+{
+  BM_TraceReader *r;
+  char magic[TR_MAGIC_LEN];
+  FILE *file;
+
+  file= fopen(fileName, "rb");
+  if (file == NULL)
+    RETURN(RC_FILE_NOT_FOUND);
+  if (fread(magic, 1, TR_MAGIC_LEN, file) != TR_MAGIC_LEN
+      || memcmp(magic, TR_MAGIC, TR_MAGIC_LEN) != 0)
+  {
+    fclose(file);
+    RETURN(RC_TRACE_INVALID);
+  }
+
+  r= (BM_TraceReader*) malloc(sizeof(BM_TraceReader));
+  r->file= file;
+  r->count= 0;
+  r->pos= 0;
+  *reader= r;
+  RETURN(RC_OK);
+}
+
+RC nextTraceRecord (BM_TraceReader *reader, TR_Op *op, PageNumber *pageNum)
+{
+  unsigned int rec;
+  RC rc;
+
+  if (reader->pos == reader->count)
+  {
+    rc= fillTrace(reader);
+    if (rc != RC_OK)
+      RETURN(rc);
+  }
+
+  rec= reader->buf[reader->pos++];
+  *op= (TR_Op) (rec >> TR_OP_SHIFT);
+  *pageNum= (PageNumber) (rec & TR_PAGE_MASK);
+  RETURN(RC_OK);
+}
+
+RC closeTraceReader (BM_TraceReader *reader)
+{
+  fclose(reader->file);
+  free(reader);
+  RETURN(RC_OK);
+}
+
+// Let go pages left pinned at end of trace
+static void unpinAll(BM_BufferPool *bm)
+{
+  BM_PoolSnapshot snap;
+  BM_PageHandle h;
+  int i, j;
+
+  initPoolSnapshot(&snap, bm->numPages);
+  getPoolSnapshot(bm, &snap);
+  for (i=0; i < snap.count; i++)
+    for (j=0; j < snap.fixCounts[i]; j++)
+    {
+      h.pageNum= snap.pageNums[i];
+      unpinPage(bm, &h);
+    }
+  freePoolSnapshot(&snap);
+}
+
+RC replayTrace (const char *traceFile, const char *pageFile,
+                ReplacementStrategy strategy, int numPages,
+                BM_ReplayResult *result)
+{
+  BM_TraceReader *reader;
+  BM_BufferPool bm;
+  BM_PageHandle h;
+  struct timespec start, end;
+  TR_Op op;
+  RC rc;
+
+  memset(result, 0, sizeof(BM_ReplayResult));
+  rc= openTraceReader(&reader, traceFile);
+  if (rc != RC_OK)
+    RETURN(rc);
+
+  destroyPageFile((char*) pageFile);
+  rc= createPageFile((char*) pageFile);
+  if (rc == RC_OK)
+    rc= initBufferPool(&bm, pageFile, numPages, strategy, NULL);
+  if (rc != RC_OK)
+  {
+    closeTraceReader(reader);
+    RETURN(rc);
+  }
+
+  clock_gettime(CLOCK_MONOTONIC, &start);
+  while ((rc= nextTraceRecord(reader, &op, &h.pageNum)) == RC_OK)
+  {
+    result->numRecords++;
+    switch (op)
+    {
+      case TR_PIN:
+        result->numPins++;
+        if (pinPage(&bm, &h, h.pageNum) != RC_OK)
+          result->failedPins++;
+        break;
+      case TR_UNPIN:
+        unpinPage(&bm, &h);
+        break;
+      case TR_DIRTY:
+        markDirty(&bm, &h);
+        break;
+      default:
+        break;
+    }
+  }
+  clock_gettime(CLOCK_MONOTONIC, &end);
+  result->seconds= (end.tv_sec - start.tv_sec)
+                   + (end.tv_nsec - start.tv_nsec) / 1e9;
+  if (rc == RC_TRACE_END)
+    rc= RC_OK;
+
+  // Only I/O of the trace is counted, not writes at shutdown
+  getPoolStats(&bm, &result->stats);
+  closeTraceReader(reader);
+  unpinAll(&bm);
+  shutdownBufferPool(&bm);
+  destroyPageFile((char*) pageFile);
+  RETURN(rc);
+}
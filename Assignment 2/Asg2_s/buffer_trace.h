@@ -0,0 +1,68 @@
+#ifndef BUFFER_TRACE_H
+#define BUFFER_TRACE_H
+
+#include <stdio.h>
+
+#include "dberror.h"
+#include "buffer_mgr.h"
+
+/*
+ * Buffer pool access trace
+ * | "BMTRACE1" | record ... |
+ *
+ * Record is 4 bytes in host byte order, operation in top two bits
+ * and page number in the rest.
+ */
+#define TR_MAGIC        "BMTRACE1"
+#define TR_MAGIC_LEN    8
+#define TR_OP_SHIFT     30
+#define TR_PAGE_MASK    ((1U << TR_OP_SHIFT) - 1)
+#define TR_BUF_RECORDS  4096
+
+typedef enum TR_Op {
+  TR_PIN = 0,
+  TR_UNPIN = 1,
+  TR_DIRTY = 2
+} TR_Op;
+
+typedef struct BM_TraceWriter {
+  FILE *file;
+  unsigned int buf[TR_BUF_RECORDS];
+  int count;
+  long long numRecords;
+} BM_TraceWriter;
+
+typedef struct BM_TraceReader {
+  FILE *file;
+  unsigned int buf[TR_BUF_RECORDS];
+  int count;
+  int pos;
+} BM_TraceReader;
+
+// Outcome of replaying a trace
+typedef struct BM_ReplayResult {
+  long long numRecords;
+  long long numPins;
+  long long failedPins;   // Pool was full of pinned pages
+  double seconds;
+  BM_PoolStats stats;
+} BM_ReplayResult;
+
+// writing, caller serializes calls of traceAccess
+extern RC openTraceWriter (BM_TraceWriter **writer, const char *fileName);
+extern RC traceAccess (BM_TraceWriter *writer, TR_Op op, PageNumber pageNum);
+extern RC closeTraceWriter (BM_TraceWriter *writer);
+
+// reading, RC_TRACE_END after last record
+extern RC openTraceReader (BM_TraceReader **reader, const char *fileName);
+extern RC nextTraceRecord (BM_TraceReader *reader, TR_Op *op,
+                           PageNumber *pageNum);
+extern RC closeTraceReader (BM_TraceReader *reader);
+
+// Run trace against a new pool on scratch page file pageFile,
+// which is created and destroyed.
+extern RC replayTrace (const char *traceFile, const char *pageFile,
+                       ReplacementStrategy strategy, int numPages,
+                       BM_ReplayResult *result);
+
+#endif // BUFFER_TRACE_H
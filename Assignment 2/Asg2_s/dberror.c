@@ -4,7 +4,7 @@
 #include <stdlib.h>
 #include <stdio.h>
 
-char *RC_message;
+__thread char *RC_message;
 
 /* print a message to standard out describing the error */
 void 
@@ -54,11 +54,74 @@ static char* errMsgs[]= {
     "Buffer pool is full", // RC_BUFFER_POOL_FULL
     "Page not pinned", // RC_BUFFER_POOL_FULL
     "Cannot shutdown, page is pinned", // RC_HAVE_PINNED_PAGE
+
+    "Page is not allocated", // RC_PAGE_NOT_ALLOCATED
+    "No page with enough free space", // RC_NO_PAGE_WITH_FREE_SPACE
+
+    "Snapshot has less entries than pool frames", // RC_SNAPSHOT_TOO_SMALL
+
+    "Not an access trace file", // RC_TRACE_INVALID
+    "End of access trace", // RC_TRACE_END
+    "Cache size or sample rate out of range", // RC_MRC_INVALID_PARAM
+    "Miss ratio tracking is off", // RC_MRC_NOT_ENABLED
+
+    "Pool size out of range", // RC_POOL_INVALID_SIZE
+    "Not enough frames left in budget", // RC_POOL_BUDGET_EXCEEDED
+    "Pool is not managed by pool manager", // RC_POOL_NOT_MANAGED
+
+    "Latch mode must be shared or exclusive", // RC_LATCH_INVALID_MODE
+
+    "Rebalancing thread could not be started", // RC_POOL_THREAD_FAILED
+    ""
+};
+
+// Record manager codes start at RC_RM_COMPARE_VALUE_OF_DIFFERENT_DATATYPE
+static char* rmErrMsgs[]= {
+    "Compared values are of different datatype", // RC_RM_COMPARE_VALUE_OF_DIFFERENT_DATATYPE
+    "Expression result is not boolean", // RC_RM_EXPR_RESULT_IS_NOT_BOOLEAN
+    "Boolean expression argument is not boolean", // RC_RM_BOOLEAN_EXPR_ARG_IS_NOT_BOOLEAN
+    "No more tuples", // RC_RM_NO_MORE_TUPLES
+    "No print for datatype", // RC_RM_NO_PRINT_FOR_DATATYPE
+    "Unknown datatype", // RC_RM_UNKOWN_DATATYPE
+    "No such record", // RC_RM_NO_SUCH_RECORD
+    "Tuple does not fit in a page", // RC_RM_TUPLE_TOO_BIG
+    "Schema does not fit in a page", // RC_RM_SCHEMA_TOO_BIG
+    ""
+};
+
+// Index manager codes start at RC_IM_KEY_NOT_FOUND
+static char* imErrMsgs[]= {
+    "Key not found", // RC_IM_KEY_NOT_FOUND
+    "Key already exists", // RC_IM_KEY_ALREADY_EXISTS
+    "Too many keys per node", // RC_IM_N_TO_LAGE
+    "No more entries", // RC_IM_NO_MORE_ENTRIES
     ""
 };
 
+// External sort codes start at RC_ES_NO_MORE_RECORDS
+static char* esErrMsgs[]= {
+    "No more records", // RC_ES_NO_MORE_RECORDS
+    "Record does not fit in a page", // RC_ES_RECORD_TOO_BIG
+    "Too few frames for sort workspace", // RC_ES_TOO_FEW_FRAMES
+    ""
+};
+
+#define NUM_MSGS(msgs) ((int) (sizeof(msgs) / sizeof(char*)) - 1)
+
 RC set_errormsg(RC error)
 {
-    RC_message= errMsgs[error];
+    if (error >= RC_ES_NO_MORE_RECORDS
+        && error - RC_ES_NO_MORE_RECORDS < NUM_MSGS(esErrMsgs))
+        RC_message= esErrMsgs[error - RC_ES_NO_MORE_RECORDS];
+    else if (error >= RC_IM_KEY_NOT_FOUND
+        && error - RC_IM_KEY_NOT_FOUND < NUM_MSGS(imErrMsgs))
+        RC_message= imErrMsgs[error - RC_IM_KEY_NOT_FOUND];
+    else if (error >= RC_RM_COMPARE_VALUE_OF_DIFFERENT_DATATYPE
+        && error - RC_RM_COMPARE_VALUE_OF_DIFFERENT_DATATYPE < NUM_MSGS(rmErrMsgs))
+        RC_message= rmErrMsgs[error - RC_RM_COMPARE_VALUE_OF_DIFFERENT_DATATYPE];
+    else if (error >= 0 && error < NUM_MSGS(errMsgs))
+        RC_message= errMsgs[error];
+    else
+        RC_message= NULL;
     return error;
 }
\ No newline at end of file
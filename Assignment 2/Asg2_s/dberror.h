@@ -42,8 +42,43 @@ typedef int RC;
 #define RC_PAGE_NOT_PINNED 14
 #define RC_HAVE_PINNED_PAGE 15
 
-/* holder for error messages */
-extern char *RC_message;
+/* New error codes for free space map */
+#define RC_PAGE_NOT_ALLOCATED 16
+#define RC_NO_PAGE_WITH_FREE_SPACE 17
+
+/* New error codes for pool snapshots */
+#define RC_SNAPSHOT_TOO_SMALL 18
+
+/* New error codes for access traces */
+#define RC_TRACE_INVALID 19
+#define RC_TRACE_END 20
+#define RC_MRC_INVALID_PARAM 21
+#define RC_MRC_NOT_ENABLED 22
+
+/* New error codes for pool sizing */
+#define RC_POOL_INVALID_SIZE 23
+#define RC_POOL_BUDGET_EXCEEDED 24
+#define RC_POOL_NOT_MANAGED 25
+
+/* New error codes for page latches */
+#define RC_LATCH_INVALID_MODE 26
+
+/* New error codes for pool manager */
+#define RC_POOL_THREAD_FAILED 27
+
+/* New error codes for Record Manager */
+#define RC_RM_NO_SUCH_RECORD 206
+#define RC_RM_TUPLE_TOO_BIG 207
+#define RC_RM_SCHEMA_TOO_BIG 208
+
+/* New error codes for external sort */
+#define RC_ES_NO_MORE_RECORDS 400
+#define RC_ES_RECORD_TOO_BIG 401
+#define RC_ES_TOO_FEW_FRAMES 402
+
+/* holder for error messages, one per thread. Set by RETURN and THROW
+   on errors, it describes the last error returned on the thread. */
+extern __thread char *RC_message;
 
 /* print a message to standard out describing the error */
 extern void printError (RC error);
@@ -69,6 +104,12 @@ extern char *errorMessage (RC error);
   } while(0);
 
 extern RC set_errormsg(RC);
-#define RETURN(RC) { return set_errormsg(RC); }
+// RC_OK is returned right away, only errors look up their message
+#define RETURN(code) {                          \
+    RC rc_return= (code);                       \
+    if (rc_return == RC_OK)                     \
+      return RC_OK;                             \
+    return set_errormsg(rc_return);             \
+  }
 
 #endif
\ No newline at end of file
@@ -0,0 +1,202 @@
+#include <string.h>
+#include <stdlib.h>
+
+#include "dberror.h"
+#include "record_mgr.h"
+#include "expr.h"
+#include "tables.h"
+
+// implementations
+RC valueEquals (Value *left, Value *right, Value *result)
+{
+  if (left->dt != right->dt)
+    RETURN(RC_RM_COMPARE_VALUE_OF_DIFFERENT_DATATYPE);
+
+  result->dt= DT_BOOL;
+
+  switch (left->dt)
+  {
+    case DT_INT:
+      result->v.boolV= (left->v.intV == right->v.intV);
+      break;
+    case DT_FLOAT:
+      result->v.boolV= (left->v.floatV == right->v.floatV);
+      break;
+    case DT_BOOL:
+      result->v.boolV= (left->v.boolV == right->v.boolV);
+      break;
+    case DT_STRING:
+      result->v.boolV= (strcmp(left->v.stringV, right->v.stringV) == 0);
+      break;
+    default:
+      RETURN(RC_RM_UNKOWN_DATATYPE);
+  }
+
+  RETURN(RC_OK);
+}
+
+RC valueSmaller (Value *left, Value *right, Value *result)
+{
+  if (left->dt != right->dt)
+    RETURN(RC_RM_COMPARE_VALUE_OF_DIFFERENT_DATATYPE);
+
+  result->dt= DT_BOOL;
+
+  switch (left->dt)
+  {
+    case DT_INT:
+      result->v.boolV= (left->v.intV < right->v.intV);
+      break;
+    case DT_FLOAT:
+      result->v.boolV= (left->v.floatV < right->v.floatV);
+      break;
+    case DT_BOOL:
+      result->v.boolV= (left->v.boolV < right->v.boolV);
+      break;
+    case DT_STRING:
+      result->v.boolV= (strcmp(left->v.stringV, right->v.stringV) < 0);
+      break;
+    default:
+      RETURN(RC_RM_UNKOWN_DATATYPE);
+  }
+
+  RETURN(RC_OK);
+}
+
+RC boolNot (Value *input, Value *result)
+{
+  if (input->dt != DT_BOOL)
+    RETURN(RC_RM_BOOLEAN_EXPR_ARG_IS_NOT_BOOLEAN);
+  result->dt= DT_BOOL;
+  result->v.boolV= !(input->v.boolV);
+
+  RETURN(RC_OK);
+}
+
+RC boolAnd (Value *left, Value *right, Value *result)
+{
+  if (left->dt != DT_BOOL || right->dt != DT_BOOL)
+    RETURN(RC_RM_BOOLEAN_EXPR_ARG_IS_NOT_BOOLEAN);
+  result->dt= DT_BOOL;
+  result->v.boolV= (left->v.boolV && right->v.boolV);
+
+  RETURN(RC_OK);
+}
+
+RC boolOr (Value *left, Value *right, Value *result)
+{
+  if (left->dt != DT_BOOL || right->dt != DT_BOOL)
+    RETURN(RC_RM_BOOLEAN_EXPR_ARG_IS_NOT_BOOLEAN);
+  result->dt= DT_BOOL;
+  result->v.boolV= (left->v.boolV || right->v.boolV);
+
+  RETURN(RC_OK);
+}
+
+// Evaluate expression on a record. Caller frees *result with freeVal.
+RC evalExpr (Record *record, Schema *schema, Expr *expr, Value **result)
+{
+  Value *lIn= NULL;
+  Value *rIn= NULL;
+  Operator *op;
+  bool twoArgs;
+  RC rc= RC_OK;
+
+  switch (expr->type)
+  {
+    case EXPR_OP:
+      op= expr->expr.op;
+      twoArgs= (op->type != OP_BOOL_NOT);
+
+      rc= evalExpr(record, schema, op->args[0], &lIn);
+      if (rc != RC_OK)
+        RETURN(rc);
+      if (twoArgs)
+      {
+        rc= evalExpr(record, schema, op->args[1], &rIn);
+        if (rc != RC_OK)
+        {
+          freeVal(lIn);
+          RETURN(rc);
+        }
+      }
+
+      *result= (Value*) malloc(sizeof(Value));
+      switch (op->type)
+      {
+        case OP_BOOL_NOT:
+          rc= boolNot(lIn, *result);
+          break;
+        case OP_BOOL_AND:
+          rc= boolAnd(lIn, rIn, *result);
+          break;
+        case OP_BOOL_OR:
+          rc= boolOr(lIn, rIn, *result);
+          break;
+        case OP_COMP_EQUAL:
+          rc= valueEquals(lIn, rIn, *result);
+          break;
+        case OP_COMP_SMALLER:
+          rc= valueSmaller(lIn, rIn, *result);
+          break;
+        default:
+          break;
+      }
+
+      freeVal(lIn);
+      if (twoArgs)
+        freeVal(rIn);
+      if (rc != RC_OK)
+      {
+        free(*result);
+        *result= NULL;
+      }
+      break;
+
+    case EXPR_CONST:
+      *result= (Value*) malloc(sizeof(Value));
+      CPVAL(*result, expr->expr.cons);
+      break;
+
+    case EXPR_ATTRREF:
+      rc= getAttr(record, schema, expr->expr.attrRef, result);
+      break;
+  }
+
+  RETURN(rc);
+}
+
+RC freeExpr (Expr *expr)
+{
+  int i;
+
+  switch (expr->type)
+  {
+    case EXPR_OP:
+    {
+      Operator *op= expr->expr.op;
+      for (i=0; i < (op->type == OP_BOOL_NOT ? 1 : 2); i++)
+        freeExpr(op->args[i]);
+      free(op->args);
+      free(op);
+      break;
+    }
+    case EXPR_CONST:
+      freeVal(expr->expr.cons);
+      break;
+    case EXPR_ATTRREF:
+      break;
+  }
+  free(expr);
+
+  RETURN(RC_OK);
+}
+
+void freeVal (Value *val)
+{
+  if (val == NULL)
+    return;
+  if (val->dt == DT_STRING)
+    free(val->v.stringV);
+  free(val);
+}
@@ -0,0 +1,158 @@
+#include "frame_arena.h"
+#include <stdlib.h>
+#include <stdio.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+
+/*
+ * Frame arenas
+ *
+ * A chunk is mapped with mmap, so its pages are not placed until they
+ * are touched, and bound with mbind to its node before that happens.
+ * mbind is called through syscall() so that libnuma is not needed to
+ * build. MPOL_PREFERRED lets the kernel use another node when the
+ * asked one is full rather than fail the fault.
+ *
+ * Node count comes from /sys/devices/system/node, the node of the
+ * calling thread from getcpu.
+ */
+
+#define FA_MPOL_PREFERRED 1   // MPOL_PREFERRED of <numaif.h>
+#define FA_MAX_NODES      64  // Fits the one word node mask below
+
+// Not a interface
+static void bindChunk(void *addr, size_t size, int node);
+static FA_Chunk* newChunk(FA_Arena *arena, int node);
+
+static void bindChunk(void *addr, size_t size, int node)
+{
+#ifdef SYS_mbind
+  unsigned long mask= 1UL << node;
+
+  // Failure leaves chunk unbound, it is still good memory
+  syscall(SYS_mbind, addr, size, FA_MPOL_PREFERRED, &mask,
+          (unsigned long) FA_MAX_NODES, 0);
+#endif
+}
+
+static FA_Chunk* newChunk(FA_Arena *arena, int node)
+{
+  size_t page= (size_t) sysconf(_SC_PAGESIZE);
+  size_t header= (sizeof(FA_Chunk) + 63) & ~(size_t) 63;
+  size_t size= header + FA_CHUNK_FRAMES * arena->frameSize;
+  FA_Chunk *chunk;
+
+  size= (size + page - 1) & ~(page - 1);
+  chunk= (FA_Chunk*) mmap(NULL, size, PROT_READ | PROT_WRITE,
+                          MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+  if (chunk == MAP_FAILED)
+    return NULL;
+  if (arena->numNodes > 1)
+    bindChunk(chunk, size, node);
+
+  chunk->size= size;
+  chunk->next= arena->nodes[node].chunks;
+  arena->nodes[node].chunks= chunk;
+  arena->nodes[node].next= (char*) chunk + header;
+  arena->nodes[node].left= (int) ((size - header) / arena->frameSize);
+  return chunk;
+}
+
+void initFrameArena (FA_Arena *arena, size_t frameSize, int numNodes)
+{
+  int i;
+
+  if (numNodes <= 0)
+    numNodes= getNumaNodes();
+  if (numNodes > FA_MAX_NODES)
+    numNodes= FA_MAX_NODES;
+
+  // Frames start 64 byte aligned, as do frames after them
+  arena->frameSize= (frameSize + 63) & ~(size_t) 63;
+  arena->numNodes= numNodes;
+  arena->nodes= (FA_Node*) malloc(numNodes * sizeof(FA_Node));
+  for (i=0; i < numNodes; i++)
+  {
+    arena->nodes[i].chunks= NULL;
+    arena->nodes[i].freeList= NULL;
+    arena->nodes[i].next= NULL;
+    arena->nodes[i].left= 0;
+  }
+}
+
+void destroyFrameArena (FA_Arena *arena)
+{
+  FA_Chunk *chunk, *next;
+  int i;
+
+  for (i=0; i < arena->numNodes; i++)
+    for (chunk= arena->nodes[i].chunks; chunk; chunk= next)
+    {
+      next= chunk->next;
+      munmap(chunk, chunk->size);
+    }
+  free(arena->nodes);
+  arena->nodes= NULL;
+}
+
+// Frame of node, NULL if no memory could be mapped
+void *allocFrame (FA_Arena *arena, int node)
+{
+  FA_Node *n;
+  void *frame;
+
+  if (node < 0 || node >= arena->numNodes)
+    node= 0;
+  n= &arena->nodes[node];
+
+  if (n->freeList)
+  {
+    frame= n->freeList;
+    n->freeList= *(void**) frame;
+    return frame;
+  }
+  if (n->left == 0 && newChunk(arena, node) == NULL)
+    return NULL;
+  frame= n->next;
+  n->next+= arena->frameSize;
+  n->left--;
+  return frame;
+}
+
+// node must be the one frame was allocated for
+void freeFrame (FA_Arena *arena, void *frame, int node)
+{
+  FA_Node *n;
+
+  if (node < 0 || node >= arena->numNodes)
+    node= 0;
+  n= &arena->nodes[node];
+  *(void**) frame= n->freeList;
+  n->freeList= frame;
+}
+
+int getNumaNodes (void)
+{
+  char path[64];
+  int n;
+
+  for (n=0; n < FA_MAX_NODES; n++)
+  {
+    snprintf(path, sizeof(path), "/sys/devices/system/node/node%d", n);
+    if (access(path, F_OK) != 0)
+      break;
+  }
+  return n > 0 ? n : 1;
+}
+
+int getCurrentNumaNode (void)
+{
+#ifdef SYS_getcpu
+  unsigned int cpu, node;
+
+  if (syscall(SYS_getcpu, &cpu, &node, NULL) == 0)
+    return (int) node;
+#endif
+  return 0;
+}
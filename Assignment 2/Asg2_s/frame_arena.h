@@ -0,0 +1,48 @@
+#ifndef FRAME_ARENA_H
+#define FRAME_ARENA_H
+
+#include <stddef.h>
+
+/*
+ * Memory for page frames, one arena per NUMA node.
+ *
+ * Frames are cut from chunks that are bound to their node, so a frame
+ * lives on the node it was asked for no matter which thread touches
+ * it first. Freed frames are kept for reuse on the same node and all
+ * memory is returned when the arena is destroyed.
+ *
+ * On hosts with one node, or where binding is not allowed, chunks are
+ * plain memory and everything else works the same. Not thread safe,
+ * the buffer pool calls it under bm_mutex.
+ */
+#define FA_CHUNK_FRAMES 64
+
+typedef struct FA_Chunk {
+  struct FA_Chunk *next;
+  size_t size;              // Bytes mapped
+} FA_Chunk;
+
+typedef struct FA_Node {
+  FA_Chunk *chunks;
+  void *freeList;           // Freed frames, next pointer in frame
+  char *next;               // Uncut part of newest chunk
+  int left;                 // Frames left at next
+} FA_Node;
+
+typedef struct FA_Arena {
+  size_t frameSize;
+  int numNodes;
+  FA_Node *nodes;
+} FA_Arena;
+
+// numNodes 0 takes the number of nodes of the host
+extern void initFrameArena (FA_Arena *arena, size_t frameSize, int numNodes);
+extern void destroyFrameArena (FA_Arena *arena);
+extern void *allocFrame (FA_Arena *arena, int node);
+extern void freeFrame (FA_Arena *arena, void *frame, int node);
+
+// Host topology, 1 and 0 when it can not be told
+extern int getNumaNodes (void);
+extern int getCurrentNumaNode (void);
+
+#endif // FRAME_ARENA_H
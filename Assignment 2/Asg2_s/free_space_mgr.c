@@ -0,0 +1,467 @@
+#include "free_space_mgr.h"
+#include <string.h>
+#include <stdlib.h>
+
+/*
+ * Free space map
+ *
+ * Map pages live in the page file itself and are accessed through
+ * the buffer manager like any other page. Each one holds
+ * 1) Allocation bitmap of the data pages in its group.
+ * 2) Free space category of every data page, which is the
+ *    number of free bytes in units of FSM_CATEGORY_BYTES.
+ *
+ * Allocation: Find first group with an unallocated page using
+ *    in memory numAllocated, then set first clear bit of that group.
+ *
+ * Free space lookup: Find first group whose maxCategory is big
+ *    enough, then scan categories of that one map page.
+ *
+ * Category is rounded down when stored and rounded up when
+ * searched, so a page found has at least requested free bytes.
+ */
+
+#define BIT_IS_SET(map, i)  ((map)[(i) >> 3] & (1 << ((i) & 7)))
+#define SET_BIT(map, i)     ((map)[(i) >> 3] |= (1 << ((i) & 7)))
+#define CLEAR_BIT(map, i)   ((map)[(i) >> 3] &= ~(1 << ((i) & 7)))
+
+#define BYTES_TO_CATEGORY(b) \
+  ((b) / FSM_CATEGORY_BYTES > FSM_MAX_CATEGORY ? \
+   FSM_MAX_CATEGORY : (b) / FSM_CATEGORY_BYTES)
+
+// Not a interface
+static RC growSummary(FSM_Handle *fsm, int numGroups);
+static unsigned char groupMaxCategory(FSM_MapPage *map);
+static RC flushBulkBatch(FSM_BulkWriter *w);
+
+// Make sure in memory summary covers numGroups groups.
+static RC growSummary(FSM_Handle *fsm, int numGroups)
+{
+  int newCapacity;
+  int *numAllocated;
+  unsigned char *maxCategory;
+
+  if (numGroups > fsm->groupCapacity)
+  {
+    newCapacity= fsm->groupCapacity ? fsm->groupCapacity : 4;
+    while (newCapacity < numGroups)
+      newCapacity*= 2;
+
+    numAllocated= (int*) realloc(fsm->numAllocated, newCapacity * sizeof(int));
+    if (!numAllocated)
+      RETURN(RC_WRITE_FAILED);
+    fsm->numAllocated= numAllocated;
+    maxCategory= (unsigned char*) realloc(fsm->maxCategory, newCapacity);
+    if (!maxCategory)
+      RETURN(RC_WRITE_FAILED);
+    fsm->maxCategory= maxCategory;
+    fsm->groupCapacity= newCapacity;
+  }
+
+  // New groups are empty
+  for (; fsm->numGroups < numGroups; fsm->numGroups++)
+  {
+    fsm->numAllocated[fsm->numGroups]= 0;
+    fsm->maxCategory[fsm->numGroups]= 0;
+  }
+
+  RETURN(RC_OK);
+}
+
+// Best category of allocated pages in a map page
+static unsigned char groupMaxCategory(FSM_MapPage *map)
+{
+  unsigned char maxCat= 0;
+  int slot;
+
+  for (slot=0; slot < FSM_GROUP_PAGES; slot++)
+    if (map->category[slot] > maxCat && BIT_IS_SET(map->bitmap, slot))
+      maxCat= map->category[slot];
+  return maxCat;
+}
+
+// Build in memory summary from map pages
+RC initFreeSpaceMap (FSM_Handle *fsm, BM_BufferPool *const bm)
+{
+  BM_Pool_MgmtData *mgmtData= bm->mgmtData;
+  BM_PageHandle h;
+  FSM_MapPage *map;
+  int numGroups, g;
+  RC rc;
+
+  memset(fsm, 0, sizeof(FSM_Handle));
+  fsm->bm= bm;
+
+  // There is at least map page 0. Fresh file has zero page,
+  // which is an empty map page.
+  numGroups= (mgmtData->fh.totalNumPages + FSM_GROUP_SPAN - 1) / FSM_GROUP_SPAN;
+  if (numGroups < 1)
+    numGroups= 1;
+  rc= growSummary(fsm, numGroups);
+  if (rc != RC_OK)
+    RETURN(rc);
+
+  for (g=0; g < numGroups; g++)
+  {
+    rc= pinPage(bm, &h, FSM_MAP_PAGE(g));
+    if (rc != RC_OK)
+    {
+      shutdownFreeSpaceMap(fsm);
+      RETURN(rc);
+    }
+    map= (FSM_MapPage*) h.data;
+    fsm->numAllocated[g]= map->numAllocated;
+    fsm->maxCategory[g]= groupMaxCategory(map);
+    unpinPage(bm, &h);
+  }
+
+  RETURN(RC_OK);
+}
+
+RC shutdownFreeSpaceMap (FSM_Handle *fsm)
+{
+  free(fsm->numAllocated);
+  free(fsm->maxCategory);
+  fsm->numAllocated= NULL;
+  fsm->maxCategory= NULL;
+  fsm->numGroups= fsm->groupCapacity= 0;
+  RETURN(RC_OK);
+}
+
+// Allocate first free data page
+RC allocatePage (FSM_Handle *fsm, PageNumber *pageNum)
+{
+  BM_PageHandle h;
+  FSM_MapPage *map;
+  int g, slot, byte;
+  RC rc;
+
+  // Skip full groups, add a new group if all are full
+  for (g= fsm->allocHint; g < fsm->numGroups; g++)
+    if (fsm->numAllocated[g] < FSM_GROUP_PAGES)
+      break;
+  fsm->allocHint= g;
+  if (g == fsm->numGroups)
+  {
+    rc= growSummary(fsm, g+1);
+    if (rc != RC_OK)
+      RETURN(rc);
+  }
+
+  // Pinning a map page past end of file creates it zeroed
+  rc= pinPage(fsm->bm, &h, FSM_MAP_PAGE(g));
+  if (rc != RC_OK)
+    RETURN(rc);
+  map= (FSM_MapPage*) h.data;
+
+  for (byte=0; map->bitmap[byte] == 0xFF; byte++)
+    ;
+  for (slot= byte * 8; BIT_IS_SET(map->bitmap, slot); slot++)
+    ;
+
+  // New page is completely free
+  SET_BIT(map->bitmap, slot);
+  map->category[slot]= FSM_MAX_CATEGORY;
+  map->numAllocated++;
+  markDirty(fsm->bm, &h);
+  unpinPage(fsm->bm, &h);
+
+  fsm->numAllocated[g]++;
+  fsm->maxCategory[g]= FSM_MAX_CATEGORY;
+  *pageNum= FSM_MAP_PAGE(g) + 1 + slot;
+
+  RETURN(RC_OK);
+}
+
+// Return data page to allocator
+RC freePage (FSM_Handle *fsm, PageNumber pageNum)
+{
+  BM_PageHandle h;
+  FSM_MapPage *map;
+  int g= FSM_GROUP_OF(pageNum);
+  int slot= FSM_SLOT_OF(pageNum);
+  unsigned char oldCat;
+  RC rc;
+
+  if (pageNum < 0 || FSM_IS_MAP_PAGE(pageNum) || g >= fsm->numGroups)
+    RETURN(RC_PAGE_NOT_ALLOCATED);
+
+  rc= pinPage(fsm->bm, &h, FSM_MAP_PAGE(g));
+  if (rc != RC_OK)
+    RETURN(rc);
+  map= (FSM_MapPage*) h.data;
+
+  if (!BIT_IS_SET(map->bitmap, slot))
+  {
+    unpinPage(fsm->bm, &h);
+    RETURN(RC_PAGE_NOT_ALLOCATED);
+  }
+
+  oldCat= map->category[slot];
+  CLEAR_BIT(map->bitmap, slot);
+  map->category[slot]= 0;
+  map->numAllocated--;
+  if (oldCat == fsm->maxCategory[g])
+    fsm->maxCategory[g]= groupMaxCategory(map);
+  markDirty(fsm->bm, &h);
+  unpinPage(fsm->bm, &h);
+
+  fsm->numAllocated[g]--;
+  if (g < fsm->allocHint)
+    fsm->allocHint= g;
+
+  RETURN(RC_OK);
+}
+
+bool isPageAllocated (FSM_Handle *fsm, PageNumber pageNum)
+{
+  BM_PageHandle h;
+  int g= FSM_GROUP_OF(pageNum);
+  bool allocated;
+
+  if (pageNum < 0 || FSM_IS_MAP_PAGE(pageNum) || g >= fsm->numGroups)
+    return FALSE;
+  if (fsm->numAllocated[g] == 0)
+    return FALSE;
+
+  if (pinPage(fsm->bm, &h, FSM_MAP_PAGE(g)) != RC_OK)
+    return FALSE;
+  allocated= BIT_IS_SET(((FSM_MapPage*) h.data)->bitmap,
+                        FSM_SLOT_OF(pageNum)) ? TRUE : FALSE;
+  unpinPage(fsm->bm, &h);
+
+  return allocated;
+}
+
+// Record free bytes left in an allocated data page
+RC setPageFreeSpace (FSM_Handle *fsm, PageNumber pageNum, int freeBytes)
+{
+  BM_PageHandle h;
+  FSM_MapPage *map;
+  int g= FSM_GROUP_OF(pageNum);
+  int slot= FSM_SLOT_OF(pageNum);
+  unsigned char cat, oldCat;
+  RC rc;
+
+  if (pageNum < 0 || FSM_IS_MAP_PAGE(pageNum) || g >= fsm->numGroups)
+    RETURN(RC_PAGE_NOT_ALLOCATED);
+  cat= BYTES_TO_CATEGORY(freeBytes < 0 ? 0 : freeBytes);
+
+  rc= pinPage(fsm->bm, &h, FSM_MAP_PAGE(g));
+  if (rc != RC_OK)
+    RETURN(rc);
+  map= (FSM_MapPage*) h.data;
+
+  if (!BIT_IS_SET(map->bitmap, slot))
+  {
+    unpinPage(fsm->bm, &h);
+    RETURN(RC_PAGE_NOT_ALLOCATED);
+  }
+
+  oldCat= map->category[slot];
+  if (oldCat != cat)
+  {
+    map->category[slot]= cat;
+    if (cat > fsm->maxCategory[g])
+      fsm->maxCategory[g]= cat;
+    else if (oldCat == fsm->maxCategory[g])
+      fsm->maxCategory[g]= groupMaxCategory(map);
+    markDirty(fsm->bm, &h);
+  }
+  unpinPage(fsm->bm, &h);
+
+  RETURN(RC_OK);
+}
+
+// Find an allocated data page with at least freeBytes free
+RC findPageWithFreeSpace (FSM_Handle *fsm, int freeBytes, PageNumber *pageNum)
+{
+  BM_PageHandle h;
+  FSM_MapPage *map;
+  int g, slot, need;
+  RC rc;
+
+  // Round up, any allocated page has category 0 or more
+  need= (freeBytes + FSM_CATEGORY_BYTES - 1) / FSM_CATEGORY_BYTES;
+  if (need > FSM_MAX_CATEGORY)
+    RETURN(RC_NO_PAGE_WITH_FREE_SPACE);
+
+  for (g=0; g < fsm->numGroups; g++)
+  {
+    if (fsm->numAllocated[g] == 0 || fsm->maxCategory[g] < need)
+      continue;
+
+    rc= pinPage(fsm->bm, &h, FSM_MAP_PAGE(g));
+    if (rc != RC_OK)
+      RETURN(rc);
+    map= (FSM_MapPage*) h.data;
+
+    for (slot=0; slot < FSM_GROUP_PAGES; slot++)
+      if (map->category[slot] >= need && BIT_IS_SET(map->bitmap, slot))
+      {
+        unpinPage(fsm->bm, &h);
+        *pageNum= FSM_MAP_PAGE(g) + 1 + slot;
+        RETURN(RC_OK);
+      }
+
+    // Summary was stale, fix it up
+    fsm->maxCategory[g]= groupMaxCategory(map);
+    unpinPage(fsm->bm, &h);
+  }
+
+  RETURN(RC_NO_PAGE_WITH_FREE_SPACE);
+}
+
+/**************************************************
+ * Bulk writer
+ *
+ * File is written front to back: data pages in batches, map page of
+ * a group after its last data page. Map page records every page
+ * handed out as allocated, as allocatePage would have.
+ */
+static RC flushBulkBatch(FSM_BulkWriter *w)
+{
+  SM_PageHandle pages[FSM_BULK_BATCH_PAGES];
+  int i;
+  RC rc;
+
+  for (i=0; i < w->batchCount; i++)
+    pages[i]= w->batch + i * PAGE_SIZE;
+  rc= writeBlocks(w->batchStart, w->batchCount, &w->fh, pages);
+  if (rc != RC_OK)
+    RETURN(rc);
+
+  w->batchStart+= w->batchCount;
+  w->batchCount= 0;
+  RETURN(RC_OK);
+}
+
+RC startBulkWrite (FSM_BulkWriter *w, char *fileName)
+{
+  RC rc;
+
+  rc= createPageFile(fileName);
+  if (rc != RC_OK)
+    RETURN(rc);
+  rc= openPageFile(fileName, &w->fh);
+  if (rc != RC_OK)
+    RETURN(rc);
+
+  w->map= (char*) calloc(1, PAGE_SIZE);
+  w->batch= (char*) malloc(FSM_BULK_BATCH_PAGES * PAGE_SIZE);
+  if (!w->map || !w->batch)
+  {
+    abortBulkWrite(w);
+    RETURN(RC_WRITE_FAILED);
+  }
+  w->group= 0;
+  w->nextPage= FSM_MAP_PAGE(0) + 1;
+  w->batchStart= w->nextPage;
+  w->batchCount= 0;
+  RETURN(RC_OK);
+}
+
+RC bulkAllocatePage (FSM_BulkWriter *w, PageNumber *pageNum, char **data)
+{
+  FSM_MapPage *map= (FSM_MapPage*) w->map;
+  int slot;
+  RC rc;
+
+  // Group is full, finish its map page and go past next one
+  if (FSM_IS_MAP_PAGE(w->nextPage))
+  {
+    rc= flushBulkBatch(w);
+    if (rc == RC_OK)
+      rc= writeBlock(FSM_MAP_PAGE(w->group), &w->fh, w->map);
+    if (rc != RC_OK)
+      RETURN(rc);
+    memset(w->map, 0, PAGE_SIZE);
+    w->group++;
+    w->nextPage++;
+    w->batchStart= w->nextPage;
+  }
+  if (w->batchCount == FSM_BULK_BATCH_PAGES)
+  {
+    rc= flushBulkBatch(w);
+    if (rc != RC_OK)
+      RETURN(rc);
+  }
+
+  *data= w->batch + w->batchCount * PAGE_SIZE;
+  memset(*data, 0, PAGE_SIZE);
+  w->batchCount++;
+
+  slot= FSM_SLOT_OF(w->nextPage);
+  SET_BIT(map->bitmap, slot);
+  map->category[slot]= FSM_MAX_CATEGORY;
+  map->numAllocated++;
+
+  *pageNum= w->nextPage++;
+  RETURN(RC_OK);
+}
+
+// Page number next bulkAllocatePage returns
+PageNumber bulkNextPageNumber (FSM_BulkWriter *w)
+{
+  return FSM_IS_MAP_PAGE(w->nextPage) ? w->nextPage + 1 : w->nextPage;
+}
+
+// Only pages of group being written can be changed.
+RC bulkSetFreeSpace (FSM_BulkWriter *w, PageNumber pageNum, int freeBytes)
+{
+  FSM_MapPage *map= (FSM_MapPage*) w->map;
+
+  if (pageNum < 0 || pageNum >= w->nextPage
+      || FSM_GROUP_OF(pageNum) != w->group || FSM_IS_MAP_PAGE(pageNum))
+    RETURN(RC_PAGE_NOT_ALLOCATED);
+
+  map->category[FSM_SLOT_OF(pageNum)]= BYTES_TO_CATEGORY(freeBytes < 0 ? 0
+                                                         : freeBytes);
+  RETURN(RC_OK);
+}
+
+// Rewrite a page handed out before
+RC bulkWritePage (FSM_BulkWriter *w, PageNumber pageNum, char *data)
+{
+  if (pageNum < 0 || pageNum >= w->nextPage || FSM_IS_MAP_PAGE(pageNum))
+    RETURN(RC_PAGE_NOT_ALLOCATED);
+
+  if (pageNum >= w->batchStart)
+  {
+    memmove(w->batch + (pageNum - w->batchStart) * PAGE_SIZE, data, PAGE_SIZE);
+    RETURN(RC_OK);
+  }
+  return writeBlock(pageNum, &w->fh, data);
+}
+
+RC finishBulkWrite (FSM_BulkWriter *w)
+{
+  RC rc;
+
+  rc= flushBulkBatch(w);
+  if (rc == RC_OK)
+    rc= writeBlock(FSM_MAP_PAGE(w->group), &w->fh, w->map);
+  if (rc != RC_OK)
+  {
+    abortBulkWrite(w);
+    RETURN(rc);
+  }
+
+  free(w->map);
+  free(w->batch);
+  return closePageFile(&w->fh);
+}
+
+// Drop file written so far
+RC abortBulkWrite (FSM_BulkWriter *w)
+{
+  char *fileName= strdup(w->fh.fileName);
+  RC rc;
+
+  free(w->map);
+  free(w->batch);
+  closePageFile(&w->fh);
+  rc= destroyPageFile(fileName);
+  free(fileName);
+  RETURN(rc);
+}
@@ -0,0 +1,82 @@
+#ifndef FREE_SPACE_MGR_H
+#define FREE_SPACE_MGR_H
+
+#include "dberror.h"
+#include "buffer_mgr.h"
+
+/*
+ * Page file is split in groups. First page of every group is a
+ * map page, which tracks the data pages following it.
+ * | Map 0 | Data 1 .. 2048 | Map 2049 | Data 2050 .. 4097 | ...
+ */
+#define FSM_GROUP_PAGES      2048
+#define FSM_GROUP_SPAN       (FSM_GROUP_PAGES + 1)
+#define FSM_MAP_PAGE(group)  ((group) * FSM_GROUP_SPAN)
+#define FSM_GROUP_OF(pn)     ((pn) / FSM_GROUP_SPAN)
+#define FSM_SLOT_OF(pn)      ((pn) % FSM_GROUP_SPAN - 1)
+#define FSM_IS_MAP_PAGE(pn)  ((pn) % FSM_GROUP_SPAN == 0)
+
+// Free space is kept in categories of FSM_CATEGORY_BYTES bytes,
+// so that one byte describes a page.
+#define FSM_CATEGORY_BYTES   16
+#define FSM_MAX_CATEGORY     255
+
+// On disk layout of a map page
+typedef struct FSM_MapPage {
+  int numAllocated;
+  unsigned char bitmap[FSM_GROUP_PAGES / 8];  // 1 => page allocated
+  unsigned char category[FSM_GROUP_PAGES];    // Free bytes / 16
+} FSM_MapPage;
+
+// In memory summary of map pages, so that we only pin the
+// map page of the group we are going to use.
+typedef struct FSM_Handle {
+  BM_BufferPool *bm;
+  int numGroups;
+  int groupCapacity;            // Allocated entries in arrays below
+  int *numAllocated;            // Per group allocated data pages
+  unsigned char *maxCategory;   // Per group best free space category
+  int allocHint;                // No unallocated page in groups before it
+} FSM_Handle;
+
+// Sequential writer that fills a new page file without buffer pool,
+// used to bulk load. Data pages are handed out in page number order,
+// map pages are skipped and written when their group is done. Pages
+// are written in batches of FSM_BULK_BATCH_PAGES with one writeBlocks.
+#define FSM_BULK_BATCH_PAGES 64
+
+typedef struct FSM_BulkWriter {
+  SM_FileHandle fh;
+  char *map;              // Map page of group being written
+  int group;
+  char *batch;            // Pages not written yet
+  PageNumber batchStart;  // Page number of first page in batch
+  int batchCount;
+  PageNumber nextPage;
+} FSM_BulkWriter;
+
+// Free space map interface, not thread safe.
+RC initFreeSpaceMap (FSM_Handle *fsm, BM_BufferPool *const bm);
+RC shutdownFreeSpaceMap (FSM_Handle *fsm);
+
+// Page allocator. Allocated page may hold data of its previous use,
+// caller has to initialize it.
+RC allocatePage (FSM_Handle *fsm, PageNumber *pageNum);
+RC freePage (FSM_Handle *fsm, PageNumber pageNum);
+bool isPageAllocated (FSM_Handle *fsm, PageNumber pageNum);
+
+// Free space directory
+RC setPageFreeSpace (FSM_Handle *fsm, PageNumber pageNum, int freeBytes);
+RC findPageWithFreeSpace (FSM_Handle *fsm, int freeBytes, PageNumber *pageNum);
+
+// Bulk writer interface. Page returned by bulkAllocatePage is zeroed
+// and stays valid until next bulkAllocatePage.
+RC startBulkWrite (FSM_BulkWriter *w, char *fileName);
+RC bulkAllocatePage (FSM_BulkWriter *w, PageNumber *pageNum, char **data);
+PageNumber bulkNextPageNumber (FSM_BulkWriter *w);
+RC bulkSetFreeSpace (FSM_BulkWriter *w, PageNumber pageNum, int freeBytes);
+RC bulkWritePage (FSM_BulkWriter *w, PageNumber pageNum, char *data);
+RC finishBulkWrite (FSM_BulkWriter *w);
+RC abortBulkWrite (FSM_BulkWriter *w);
+
+#endif
@@ -0,0 +1,732 @@
+#include "hash_mgr.h"
+#include "storage_mgr.h"
+#include <string.h>
+#include <stdlib.h>
+
+/*
+ * Linear hashing index
+ *
+ * Buckets are chains of pages of the index file, accessed through
+ * the buffer pool and allocated with the free space map. Directory
+ * of primary pages is kept in memory, so a lookup pins only the
+ * pages of one chain.
+ *
+ * File grows by one bucket at a time. When entries exceed
+ * HS_SPLIT_LOAD of the primary pages, bucket splitPtr is split:
+ * its entries are spread over it and a new bucket at the end,
+ * using one more bit of the hash. After all buckets of a level
+ * are split, level goes up and splitPtr starts again at 0. So no
+ * insert pays for more than one split, and chains stay short.
+ *
+ * A split first fills the new bucket, while the old chain is left
+ * as it is. Only when that worked, splitPtr moves on and the old
+ * chain is compacted, so a failed split loses no entry. Once the
+ * directory can take no more buckets, inserts that would need a
+ * split fail with RC_IM_N_TO_LAGE.
+ *
+ * Delete fills the hole with last entry of the page. Overflow pages
+ * that become empty are unlinked and freed.
+ */
+
+// On disk index header
+typedef struct HS_IndexHeader {
+  int magic;
+  int keyType;
+  int level;
+  int splitPtr;
+  int numBuckets;
+  int numEntries;
+  int numOverflow;
+  int numDirPages;
+} HS_IndexHeader;
+
+#define HS_MAX_DIR_PAGES ((int) ((PAGE_SIZE - sizeof(HS_IndexHeader)) \
+                                 / sizeof(PageNumber)))
+#define HS_MAX_BUCKETS   (HS_MAX_DIR_PAGES * HS_DIR_ENTRIES)
+#define HS_DIR_PAGES(h)  ((PageNumber*) ((h) + 1))
+
+#define HEADER_PAGE (FSM_MAP_PAGE(0) + 1)
+#define INDEX_MGMT(hash) ((HS_IndexMgmtData*) (hash)->mgmtData)
+
+// Not a interface
+static RC keyFromValue(DataType keyType, Value *val, HS_Key *key);
+static unsigned int hashKey(HS_Key key);
+static int bucketOf(HS_IndexMgmtData *ix, unsigned int h);
+static RC newBucketPage(HS_IndexMgmtData *ix, BM_PageHandle *ph);
+static RC addBucket(HS_IndexMgmtData *ix, PageNumber primary);
+static void dropLastBucket(HS_IndexMgmtData *ix);
+static RC chainAppend(HS_IndexMgmtData *ix, BM_PageHandle *tail, HS_Entry *e);
+static RC splitBucket(HashHandle *hash);
+static RC writeIndexHeader(HashHandle *hash);
+static RC readDirectory(HS_IndexMgmtData *ix);
+
+/**************************************************
+ * Keys and hashing
+ */
+static RC keyFromValue(DataType keyType, Value *val, HS_Key *key)
+{
+  if (val->dt != keyType)
+    RETURN(RC_RM_COMPARE_VALUE_OF_DIFFERENT_DATATYPE);
+
+  switch (val->dt)
+  {
+    case DT_INT:
+      key->intV= val->v.intV;
+      break;
+    case DT_BOOL:
+      key->intV= val->v.boolV;
+      break;
+    case DT_FLOAT:
+      // -0.0 is equal to 0.0, it must get same hash
+      key->floatV= val->v.floatV == 0 ? 0 : val->v.floatV;
+      break;
+    default:
+      RETURN(RC_RM_UNKOWN_DATATYPE);
+  }
+  RETURN(RC_OK);
+}
+
+// Mix all key bits into the low bits bucketOf uses
+static unsigned int hashKey(HS_Key key)
+{
+  unsigned int h;
+
+  memcpy(&h, &key, sizeof(h));
+  h^= h >> 16;
+  h*= 0x85EBCA6B;
+  h^= h >> 13;
+  h*= 0xC2B2AE35;
+  h^= h >> 16;
+  return h;
+}
+
+static int bucketOf(HS_IndexMgmtData *ix, unsigned int h)
+{
+  unsigned int b= h & ((HS_INITIAL_BUCKETS << ix->level) - 1);
+
+  if ((int) b < ix->splitPtr)
+    b= h & ((HS_INITIAL_BUCKETS << (ix->level + 1)) - 1);
+  return b;
+}
+
+#define KEY_EQUAL(keyType, a, b) \
+  ((keyType) == DT_FLOAT ? (a).floatV == (b).floatV : (a).intV == (b).intV)
+
+/**************************************************
+ * Buckets and directory
+ */
+
+// Allocate and pin an empty bucket page
+static RC newBucketPage(HS_IndexMgmtData *ix, BM_PageHandle *ph)
+{
+  PageNumber pn;
+  RC rc;
+
+  rc= allocatePage(&ix->fsm, &pn);
+  if (rc != RC_OK)
+    RETURN(rc);
+  rc= pinPage(&ix->bm, ph, pn);
+  if (rc != RC_OK)
+    RETURN(rc);
+
+  memset(ph->data, 0, PAGE_SIZE);
+  HS_BUCKET(ph->data)->magic= HS_BUCKET_MAGIC;
+  HS_BUCKET(ph->data)->numEntries= 0;
+  HS_BUCKET(ph->data)->overflow= NO_PAGE;
+  markDirty(&ix->bm, ph);
+  RETURN(RC_OK);
+}
+
+// Append bucket to directory, in memory and on its page.
+static RC addBucket(HS_IndexMgmtData *ix, PageNumber primary)
+{
+  BM_PageHandle ph;
+  PageNumber *directory;
+  int b= ix->numBuckets;
+  RC rc;
+
+  if (b % HS_DIR_ENTRIES == 0)
+  {
+    // Directory page is full, start next one
+    if (ix->numDirPages == HS_MAX_DIR_PAGES)
+      RETURN(RC_IM_N_TO_LAGE);
+    directory= (PageNumber*) realloc(ix->directory,
+                                     (b + HS_DIR_ENTRIES) * sizeof(PageNumber));
+    if (!directory)
+      RETURN(RC_WRITE_FAILED);
+    ix->directory= directory;
+    rc= allocatePage(&ix->fsm, &ix->dirPages[ix->numDirPages]);
+    if (rc != RC_OK)
+      RETURN(rc);
+    ix->numDirPages++;
+  }
+  rc= pinPage(&ix->bm, &ph, ix->dirPages[b / HS_DIR_ENTRIES]);
+  if (rc != RC_OK)
+  {
+    if (b % HS_DIR_ENTRIES == 0)
+      freePage(&ix->fsm, ix->dirPages[--ix->numDirPages]);
+    RETURN(rc);
+  }
+  ((PageNumber*) ph.data)[b % HS_DIR_ENTRIES]= primary;
+  markDirty(&ix->bm, &ph);
+  unpinPage(&ix->bm, &ph);
+
+  ix->directory[b]= primary;
+  ix->numBuckets++;
+  RETURN(RC_OK);
+}
+
+// Undo addBucket of a bucket that was never used, pages of its
+// chain are freed. Pages that can not be pinned are left allocated.
+static void dropLastBucket(HS_IndexMgmtData *ix)
+{
+  BM_PageHandle ph;
+  PageNumber pn;
+  int b= --ix->numBuckets;
+
+  pn= ix->directory[b];
+  while (pn != NO_PAGE && pinPage(&ix->bm, &ph, pn) == RC_OK)
+  {
+    pn= HS_BUCKET(ph.data)->overflow;
+    HS_BUCKET(ph.data)->magic= 0;
+    markDirty(&ix->bm, &ph);
+    if (ph.pageNum != ix->directory[b])
+      ix->numOverflow--;
+    unpinPage(&ix->bm, &ph);
+    freePage(&ix->fsm, ph.pageNum);
+  }
+
+  if (b % HS_DIR_ENTRIES == 0)
+    freePage(&ix->fsm, ix->dirPages[--ix->numDirPages]);
+}
+
+// Add entry to pinned page of chain. When it is full it has to be
+// the tail, it gets an overflow page which becomes the pinned one.
+static RC chainAppend(HS_IndexMgmtData *ix, BM_PageHandle *tail, HS_Entry *e)
+{
+  HS_BucketHeader *hdr= HS_BUCKET(tail->data);
+  BM_PageHandle next;
+  RC rc;
+
+  if (hdr->numEntries == HS_ENTRIES_PER_PAGE)
+  {
+    rc= newBucketPage(ix, &next);
+    if (rc != RC_OK)
+      RETURN(rc);
+    hdr->overflow= next.pageNum;
+    markDirty(&ix->bm, tail);
+    unpinPage(&ix->bm, tail);
+    *tail= next;
+    hdr= HS_BUCKET(next.data);
+    ix->numOverflow++;
+  }
+
+  HS_ENTRIES(tail->data)[hdr->numEntries++]= *e;
+  markDirty(&ix->bm, tail);
+  RETURN(RC_OK);
+}
+
+// Split bucket splitPtr into itself and a new bucket at the end.
+// Whole old chain stays pinned, so that compacting it can not fail.
+static RC splitBucket(HashHandle *hash)
+{
+  HS_IndexMgmtData *ix= INDEX_MGMT(hash);
+  BM_PageHandle *old= NULL, *grown, tail;
+  HS_Entry *entries;
+  PageNumber pn, newPrimary;
+  unsigned int mask;
+  int oldBucket= ix->splitPtr, numOld= 0, capacity= 0;
+  int p, i, w, j;
+  RC rc= RC_OK;
+
+  if (ix->numBuckets == HS_MAX_BUCKETS)
+    RETURN(RC_IM_N_TO_LAGE);
+
+  pn= ix->directory[oldBucket];
+  while (pn != NO_PAGE && rc == RC_OK)
+  {
+    if (numOld == capacity)
+    {
+      capacity= capacity ? capacity * 2 : 4;
+      grown= (BM_PageHandle*) realloc(old, capacity * sizeof(BM_PageHandle));
+      if (!grown)
+      {
+        rc= RC_WRITE_FAILED;
+        break;
+      }
+      old= grown;
+    }
+    rc= pinPage(&ix->bm, &old[numOld], pn);
+    if (rc == RC_OK)
+      pn= HS_BUCKET(old[numOld++].data)->overflow;
+  }
+
+  // New bucket gets entries that move, old chain is not touched yet
+  if (rc == RC_OK)
+    rc= newBucketPage(ix, &tail);
+  if (rc == RC_OK)
+  {
+    newPrimary= tail.pageNum;
+    rc= addBucket(ix, newPrimary);
+    if (rc != RC_OK)
+    {
+      HS_BUCKET(tail.data)->magic= 0;
+      unpinPage(&ix->bm, &tail);
+      freePage(&ix->fsm, newPrimary);
+    }
+  }
+  if (rc != RC_OK)
+  {
+    for (p=0; p < numOld; p++)
+      unpinPage(&ix->bm, &old[p]);
+    free(old);
+    RETURN(rc);
+  }
+
+  mask= (HS_INITIAL_BUCKETS << (ix->level + 1)) - 1;
+  for (p=0; p < numOld && rc == RC_OK; p++)
+  {
+    entries= HS_ENTRIES(old[p].data);
+    for (i=0; i < HS_BUCKET(old[p].data)->numEntries && rc == RC_OK; i++)
+      if ((int) (hashKey(entries[i].key) & mask) != oldBucket)
+        rc= chainAppend(ix, &tail, &entries[i]);
+  }
+  unpinPage(&ix->bm, &tail);
+  if (rc != RC_OK)
+  {
+    dropLastBucket(ix);
+    for (p=0; p < numOld; p++)
+      unpinPage(&ix->bm, &old[p]);
+    free(old);
+    RETURN(rc);
+  }
+
+  // From now on old bucket uses one more hash bit
+  ix->splitPtr++;
+  if (ix->splitPtr == HS_INITIAL_BUCKETS << ix->level)
+  {
+    ix->level++;
+    ix->splitPtr= 0;
+  }
+
+  // Entries that stay slide to front of chain, writer never passes reader
+  w= 0;
+  j= 0;
+  for (p=0; p < numOld; p++)
+  {
+    entries= HS_ENTRIES(old[p].data);
+    for (i=0; i < HS_BUCKET(old[p].data)->numEntries; i++)
+    {
+      if ((int) (hashKey(entries[i].key) & mask) != oldBucket)
+        continue;
+      if (j == HS_ENTRIES_PER_PAGE)
+      {
+        HS_BUCKET(old[w].data)->numEntries= j;
+        w++;
+        j= 0;
+      }
+      HS_ENTRIES(old[w].data)[j++]= entries[i];
+    }
+  }
+  HS_BUCKET(old[w].data)->numEntries= j;
+  HS_BUCKET(old[w].data)->overflow= NO_PAGE;
+
+  // Overflow pages behind last one used are freed
+  for (p=0; p < numOld; p++)
+  {
+    if (p > w)
+    {
+      HS_BUCKET(old[p].data)->magic= 0;
+      freePage(&ix->fsm, old[p].pageNum);
+      ix->numOverflow--;
+    }
+    markDirty(&ix->bm, &old[p]);
+    unpinPage(&ix->bm, &old[p]);
+  }
+  free(old);
+  RETURN(RC_OK);
+}
+
+/**************************************************
+ * create, destroy, open, and close a hash index
+ */
+static RC writeIndexHeader(HashHandle *hash)
+{
+  HS_IndexMgmtData *ix= INDEX_MGMT(hash);
+  HS_IndexHeader *hdr;
+  BM_PageHandle ph;
+  RC rc;
+
+  rc= pinPage(&ix->bm, &ph, HEADER_PAGE);
+  if (rc != RC_OK)
+    RETURN(rc);
+
+  hdr= (HS_IndexHeader*) ph.data;
+  hdr->magic= HS_INDEX_MAGIC;
+  hdr->keyType= hash->keyType;
+  hdr->level= ix->level;
+  hdr->splitPtr= ix->splitPtr;
+  hdr->numBuckets= ix->numBuckets;
+  hdr->numEntries= ix->numEntries;
+  hdr->numOverflow= ix->numOverflow;
+  hdr->numDirPages= ix->numDirPages;
+  memcpy(HS_DIR_PAGES(hdr), ix->dirPages, ix->numDirPages * sizeof(PageNumber));
+
+  markDirty(&ix->bm, &ph);
+  unpinPage(&ix->bm, &ph);
+  RETURN(RC_OK);
+}
+
+// Load directory pages listed in header into memory
+static RC readDirectory(HS_IndexMgmtData *ix)
+{
+  BM_PageHandle ph;
+  int d, num;
+  RC rc;
+
+  ix->directory= (PageNumber*) malloc(ix->numDirPages * HS_DIR_ENTRIES
+                                      * sizeof(PageNumber));
+  for (d=0; d < ix->numDirPages; d++)
+  {
+    rc= pinPage(&ix->bm, &ph, ix->dirPages[d]);
+    if (rc != RC_OK)
+      RETURN(rc);
+    num= ix->numBuckets - d * HS_DIR_ENTRIES;
+    if (num > HS_DIR_ENTRIES)
+      num= HS_DIR_ENTRIES;
+    memcpy(&ix->directory[d * HS_DIR_ENTRIES], ph.data, num * sizeof(PageNumber));
+    unpinPage(&ix->bm, &ph);
+  }
+  RETURN(RC_OK);
+}
+
+RC createHash (char *idxId, DataType keyType)
+{
+  HashHandle hash;
+  HS_IndexMgmtData ix;
+  BM_PageHandle ph;
+  PageNumber headerPage;
+  int b;
+  RC rc;
+
+  if (keyType == DT_STRING)
+    RETURN(RC_RM_UNKOWN_DATATYPE);
+
+  rc= createPageFile(idxId);
+  if (rc != RC_OK)
+    RETURN(rc);
+  rc= initBufferPool(&ix.bm, idxId, HS_POOL_PAGES, RS_LRU, NULL);
+  if (rc != RC_OK)
+    RETURN(rc);
+  rc= initFreeSpaceMap(&ix.fsm, &ix.bm);
+  if (rc != RC_OK)
+  {
+    shutdownBufferPool(&ix.bm);
+    RETURN(rc);
+  }
+
+  ix.level= 0;
+  ix.splitPtr= 0;
+  ix.numBuckets= 0;
+  ix.numEntries= 0;
+  ix.numOverflow= 0;
+  ix.numDirPages= 0;
+  ix.dirPages= (PageNumber*) malloc(HS_MAX_DIR_PAGES * sizeof(PageNumber));
+  ix.directory= NULL;
+  hash.keyType= keyType;
+  hash.mgmtData= &ix;
+
+  // Header is first page allocated, then initial buckets.
+  rc= allocatePage(&ix.fsm, &headerPage);
+  for (b=0; b < HS_INITIAL_BUCKETS && rc == RC_OK; b++)
+  {
+    rc= newBucketPage(&ix, &ph);
+    if (rc == RC_OK)
+    {
+      unpinPage(&ix.bm, &ph);
+      rc= addBucket(&ix, ph.pageNum);
+    }
+  }
+  if (rc == RC_OK)
+    rc= writeIndexHeader(&hash);
+
+  free(ix.dirPages);
+  free(ix.directory);
+  shutdownFreeSpaceMap(&ix.fsm);
+  if (rc != RC_OK)
+  {
+    shutdownBufferPool(&ix.bm);
+    RETURN(rc);
+  }
+  return shutdownBufferPool(&ix.bm);
+}
+
+RC openHash (HashHandle **hash, char *idxId)
+{
+  HS_IndexMgmtData *ix;
+  HS_IndexHeader *hdr;
+  BM_PageHandle ph;
+  RC rc;
+
+  ix= (HS_IndexMgmtData*) malloc(sizeof(HS_IndexMgmtData));
+  rc= initBufferPool(&ix->bm, idxId, HS_POOL_PAGES, RS_LRU, NULL);
+  if (rc != RC_OK)
+  {
+    free(ix);
+    RETURN(rc);
+  }
+  rc= initFreeSpaceMap(&ix->fsm, &ix->bm);
+  if (rc == RC_OK)
+    rc= pinPage(&ix->bm, &ph, HEADER_PAGE);
+  if (rc != RC_OK || ((HS_IndexHeader*) ph.data)->magic != HS_INDEX_MAGIC)
+  {
+    if (rc == RC_OK)
+      unpinPage(&ix->bm, &ph);
+    shutdownFreeSpaceMap(&ix->fsm);
+    shutdownBufferPool(&ix->bm);
+    free(ix);
+    RETURN(rc != RC_OK ? rc : RC_FILE_NOT_FOUND);
+  }
+
+  hdr= (HS_IndexHeader*) ph.data;
+  ix->level= hdr->level;
+  ix->splitPtr= hdr->splitPtr;
+  ix->numBuckets= hdr->numBuckets;
+  ix->numEntries= hdr->numEntries;
+  ix->numOverflow= hdr->numOverflow;
+  ix->numDirPages= hdr->numDirPages;
+  ix->dirPages= (PageNumber*) malloc(HS_MAX_DIR_PAGES * sizeof(PageNumber));
+  memcpy(ix->dirPages, HS_DIR_PAGES(hdr), ix->numDirPages * sizeof(PageNumber));
+
+  *hash= (HashHandle*) malloc(sizeof(HashHandle));
+  (*hash)->keyType= (DataType) hdr->keyType;
+  (*hash)->idxId= strdup(idxId);
+  (*hash)->mgmtData= ix;
+  unpinPage(&ix->bm, &ph);
+
+  rc= readDirectory(ix);
+  if (rc != RC_OK)
+  {
+    closeHash(*hash);
+    RETURN(rc);
+  }
+  RETURN(RC_OK);
+}
+
+RC closeHash (HashHandle *hash)
+{
+  HS_IndexMgmtData *ix= INDEX_MGMT(hash);
+  RC rc;
+
+  rc= writeIndexHeader(hash);
+  if (rc != RC_OK)
+    RETURN(rc);
+  shutdownFreeSpaceMap(&ix->fsm);
+  rc= shutdownBufferPool(&ix->bm);
+  if (rc != RC_OK)
+    RETURN(rc);
+
+  free(ix->dirPages);
+  free(ix->directory);
+  free(hash->idxId);
+  free(ix);
+  free(hash);
+  RETURN(RC_OK);
+}
+
+RC deleteHash (char *idxId)
+{
+  return destroyPageFile(idxId);
+}
+
+/**************************************************
+ * access information about a hash index
+ */
+RC getHashNumEntries (HashHandle *hash, int *result)
+{
+  *result= INDEX_MGMT(hash)->numEntries;
+  RETURN(RC_OK);
+}
+
+RC getHashNumBuckets (HashHandle *hash, int *result)
+{
+  *result= INDEX_MGMT(hash)->numBuckets;
+  RETURN(RC_OK);
+}
+
+RC getHashNumOverflowPages (HashHandle *hash, int *result)
+{
+  *result= INDEX_MGMT(hash)->numOverflow;
+  RETURN(RC_OK);
+}
+
+/**************************************************
+ * index access
+ */
+RC findHashKey (HashHandle *hash, Value *key, RID *result)
+{
+  HS_IndexMgmtData *ix= INDEX_MGMT(hash);
+  BM_PageHandle ph;
+  HS_Entry *entries;
+  PageNumber pn;
+  HS_Key k;
+  int i, n;
+  RC rc;
+
+  rc= keyFromValue(hash->keyType, key, &k);
+  if (rc != RC_OK)
+    RETURN(rc);
+
+  pn= ix->directory[bucketOf(ix, hashKey(k))];
+  while (pn != NO_PAGE)
+  {
+    rc= pinPage(&ix->bm, &ph, pn);
+    if (rc != RC_OK)
+      RETURN(rc);
+    entries= HS_ENTRIES(ph.data);
+    n= HS_BUCKET(ph.data)->numEntries;
+    for (i=0; i < n; i++)
+    {
+      if (KEY_EQUAL(hash->keyType, entries[i].key, k))
+      {
+        *result= entries[i].rid;
+        unpinPage(&ix->bm, &ph);
+        RETURN(RC_OK);
+      }
+    }
+    pn= HS_BUCKET(ph.data)->overflow;
+    unpinPage(&ix->bm, &ph);
+  }
+
+  RETURN(RC_IM_KEY_NOT_FOUND);
+}
+
+RC insertHashKey (HashHandle *hash, Value *key, RID rid)
+{
+  HS_IndexMgmtData *ix= INDEX_MGMT(hash);
+  BM_PageHandle ph;
+  HS_Entry e, *entries;
+  PageNumber pn, roomPage;
+  int i, n;
+  RC rc;
+
+  rc= keyFromValue(hash->keyType, key, &e.key);
+  if (rc != RC_OK)
+    RETURN(rc);
+  e.rid= rid;
+
+  // Look for key in whole chain, remember first page with room
+  roomPage= NO_PAGE;
+  pn= ix->directory[bucketOf(ix, hashKey(e.key))];
+  while (TRUE)
+  {
+    rc= pinPage(&ix->bm, &ph, pn);
+    if (rc != RC_OK)
+      RETURN(rc);
+    entries= HS_ENTRIES(ph.data);
+    n= HS_BUCKET(ph.data)->numEntries;
+    for (i=0; i < n; i++)
+    {
+      if (KEY_EQUAL(hash->keyType, entries[i].key, e.key))
+      {
+        unpinPage(&ix->bm, &ph);
+        RETURN(RC_IM_KEY_ALREADY_EXISTS);
+      }
+    }
+    if (roomPage == NO_PAGE && n < HS_ENTRIES_PER_PAGE)
+      roomPage= pn;
+    pn= HS_BUCKET(ph.data)->overflow;
+    if (pn == NO_PAGE)
+      break;
+    unpinPage(&ix->bm, &ph);
+  }
+
+  // Index is full when entry would need a bucket past the directory
+  if (ix->numEntries + 1 > HS_SPLIT_LOAD * ix->numBuckets * HS_ENTRIES_PER_PAGE
+      && ix->numBuckets == HS_MAX_BUCKETS)
+  {
+    unpinPage(&ix->bm, &ph);
+    RETURN(RC_IM_N_TO_LAGE);
+  }
+
+  // Tail of chain is pinned. Hole left by a delete before it is
+  // used first, else entry goes to tail.
+  if (roomPage != NO_PAGE && roomPage != ph.pageNum)
+  {
+    unpinPage(&ix->bm, &ph);
+    rc= pinPage(&ix->bm, &ph, roomPage);
+    if (rc != RC_OK)
+      RETURN(rc);
+  }
+  rc= chainAppend(ix, &ph, &e);
+  unpinPage(&ix->bm, &ph);
+  if (rc != RC_OK)
+    RETURN(rc);
+  ix->numEntries++;
+
+  // Entry stays inserted when split fails, next insert tries again
+  if (ix->numEntries > HS_SPLIT_LOAD * ix->numBuckets * HS_ENTRIES_PER_PAGE)
+    return splitBucket(hash);
+  RETURN(RC_OK);
+}
+
+RC deleteHashKey (HashHandle *hash, Value *key)
+{
+  HS_IndexMgmtData *ix= INDEX_MGMT(hash);
+  BM_PageHandle ph, prev;
+  HS_BucketHeader *hdr;
+  HS_Entry *entries;
+  PageNumber pn;
+  HS_Key k;
+  int i;
+  RC rc;
+
+  rc= keyFromValue(hash->keyType, key, &k);
+  if (rc != RC_OK)
+    RETURN(rc);
+
+  prev.pageNum= NO_PAGE;
+  pn= ix->directory[bucketOf(ix, hashKey(k))];
+  while (pn != NO_PAGE)
+  {
+    rc= pinPage(&ix->bm, &ph, pn);
+    if (rc != RC_OK)
+      break;
+    hdr= HS_BUCKET(ph.data);
+    entries= HS_ENTRIES(ph.data);
+    for (i=0; i < hdr->numEntries; i++)
+      if (KEY_EQUAL(hash->keyType, entries[i].key, k))
+        break;
+
+    if (i < hdr->numEntries)
+    {
+      // Last entry of page fills the hole
+      entries[i]= entries[--hdr->numEntries];
+      markDirty(&ix->bm, &ph);
+      ix->numEntries--;
+
+      // Unlink empty overflow page
+      if (hdr->numEntries == 0 && prev.pageNum != NO_PAGE)
+      {
+        HS_BUCKET(prev.data)->overflow= hdr->overflow;
+        markDirty(&ix->bm, &prev);
+        hdr->magic= 0;
+        rc= freePage(&ix->fsm, ph.pageNum);
+        ix->numOverflow--;
+      }
+      unpinPage(&ix->bm, &ph);
+      if (prev.pageNum != NO_PAGE)
+        unpinPage(&ix->bm, &prev);
+      RETURN(rc);
+    }
+
+    if (prev.pageNum != NO_PAGE)
+      unpinPage(&ix->bm, &prev);
+    prev= ph;
+    pn= hdr->overflow;
+  }
+
+  if (prev.pageNum != NO_PAGE)
+    unpinPage(&ix->bm, &prev);
+  RETURN(rc == RC_OK ? RC_IM_KEY_NOT_FOUND : rc);
+}
@@ -0,0 +1,96 @@
+#ifndef HASH_MGR_H
+#define HASH_MGR_H
+
+#include "dberror.h"
+#include "buffer_mgr.h"
+#include "free_space_mgr.h"
+#include "tables.h"
+
+// Buffer pool used by every open hash index
+#define HS_POOL_PAGES 256
+
+/*
+ * Linear hashing index file layout
+ * | FSM map 0 | Index header 1 | Directory, bucket and overflow pages ... |
+ *
+ * Directory maps bucket number to the primary page of the bucket.
+ * Its pages are listed in index header. A bucket is a chain of
+ * pages linked through overflow.
+ * | HS_BucketHeader | HS_Entry[HS_ENTRIES_PER_PAGE] |
+ */
+#define HS_BUCKET_MAGIC 0x48534254 // "HSBT"
+#define HS_INDEX_MAGIC  0x48534958 // "HSIX"
+
+// Buckets before first split, power of 2
+#define HS_INITIAL_BUCKETS 4
+
+// Bucket is split when entries exceed this share of primary pages
+#define HS_SPLIT_LOAD 0.75
+
+typedef union HS_Key {
+  int intV;     // DT_INT and DT_BOOL
+  float floatV; // DT_FLOAT
+} HS_Key;
+
+typedef struct HS_Entry {
+  HS_Key key;
+  RID rid;
+} HS_Entry;
+
+typedef struct HS_BucketHeader {
+  int magic;
+  int numEntries;
+  PageNumber overflow;  // Next page of chain, NO_PAGE for last one
+} HS_BucketHeader;
+
+#define HS_ENTRIES_PER_PAGE ((int) ((PAGE_SIZE - sizeof(HS_BucketHeader)) \
+                                    / sizeof(HS_Entry)))
+#define HS_DIR_ENTRIES      ((int) (PAGE_SIZE / sizeof(PageNumber)))
+
+#define HS_BUCKET(page)     ((HS_BucketHeader*) (page))
+#define HS_ENTRIES(page)    ((HS_Entry*) ((page) + sizeof(HS_BucketHeader)))
+
+// Management data of open hash index, not thread safe.
+//
+// Bucket of hash h is h mod (HS_INITIAL_BUCKETS << level), or
+// h mod (HS_INITIAL_BUCKETS << (level + 1)) for buckets already
+// split in this round, which are those below splitPtr.
+typedef struct HS_IndexMgmtData {
+  BM_BufferPool bm;
+  FSM_Handle fsm;
+  int level;
+  int splitPtr;         // Next bucket to split
+  int numBuckets;
+  int numEntries;
+  int numOverflow;      // Overflow pages in all chains
+  int numDirPages;
+  PageNumber *dirPages;
+  PageNumber *directory; // Primary page of every bucket
+} HS_IndexMgmtData;
+
+// structure for accessing hash indexes
+typedef struct HashHandle {
+  DataType keyType;
+  char *idxId;
+  void *mgmtData;
+} HashHandle;
+
+// create, destroy, open, and close a hash index
+extern RC createHash (char *idxId, DataType keyType);
+extern RC openHash (HashHandle **hash, char *idxId);
+extern RC closeHash (HashHandle *hash);
+extern RC deleteHash (char *idxId);
+
+// access information about a hash index
+extern RC getHashNumEntries (HashHandle *hash, int *result);
+extern RC getHashNumBuckets (HashHandle *hash, int *result);
+extern RC getHashNumOverflowPages (HashHandle *hash, int *result);
+
+// index access. insertHashKey fails with RC_IM_N_TO_LAGE when the
+// index has as many buckets as its directory pages can list. When it
+// fails because of the split after the insert, the key is inserted.
+extern RC findHashKey (HashHandle *hash, Value *key, RID *result);
+extern RC insertHashKey (HashHandle *hash, Value *key, RID rid);
+extern RC deleteHashKey (HashHandle *hash, Value *key);
+
+#endif // HASH_MGR_H
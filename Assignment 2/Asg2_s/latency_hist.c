@@ -0,0 +1,141 @@
+#include "latency_hist.h"
+#include <string.h>
+#include <time.h>
+
+/*
+ * Latency histograms
+ *
+ * Recording costs a clock read at start and end, and relaxed atomic
+ * adds for the bucket, count and sum. When tracking is off only one
+ * load of the switch is left on the measured path.
+ *
+ * CLOCK_MONOTONIC_RAW is read through the vDSO, so it does not enter
+ * the kernel. Unlike a raw rdtsc it needs no calibration to ns and
+ * is not affected by frequency changes or migration between CPUs.
+ */
+
+static bool trackingOn= FALSE;
+
+// Not a interface
+static int bucketOf(long long ns);
+static long long bucketTop(int bucket);
+
+static int bucketOf(long long ns)
+{
+  int m;
+
+  if (ns < LH_SUB_BUCKETS)
+    return ns < 0 ? 0 : (int) ns;
+  m= 63 - __builtin_clzll((unsigned long long) ns);
+  if (m > LH_MAX_BIT)
+    return LH_NUM_BUCKETS - 1;
+  return (m - LH_SUB_BITS + 1) * LH_SUB_BUCKETS
+         + (int) (ns >> (m - LH_SUB_BITS)) - LH_SUB_BUCKETS;
+}
+
+// Largest value that goes to bucket
+static long long bucketTop(int bucket)
+{
+  int group= bucket / LH_SUB_BUCKETS, sub= bucket % LH_SUB_BUCKETS;
+  int shift;
+
+  if (group == 0)
+    return bucket;
+  shift= group - 1;
+  return ((long long) (LH_SUB_BUCKETS + sub + 1) << shift) - 1;
+}
+
+void setLatencyTracking (bool on)
+{
+  __atomic_store_n(&trackingOn, on, __ATOMIC_RELAXED);
+}
+
+bool latencyTrackingOn (void)
+{
+  return __atomic_load_n(&trackingOn, __ATOMIC_RELAXED);
+}
+
+long long latencyStart (void)
+{
+  struct timespec ts;
+
+  if (!latencyTrackingOn())
+    return 0;
+  clock_gettime(CLOCK_MONOTONIC_RAW, &ts);
+  return ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+void recordLatencySince (LH_Histogram *h, long long start)
+{
+  struct timespec ts;
+
+  if (start == 0)
+    return;
+  clock_gettime(CLOCK_MONOTONIC_RAW, &ts);
+  recordLatency(h, ts.tv_sec * 1000000000LL + ts.tv_nsec - start);
+}
+
+void initLatencyHistogram (LH_Histogram *h)
+{
+  memset(h, 0, sizeof(LH_Histogram));
+}
+
+void recordLatency (LH_Histogram *h, long long ns)
+{
+  long long max;
+
+  __atomic_fetch_add(&h->counts[bucketOf(ns)], 1, __ATOMIC_RELAXED);
+  __atomic_fetch_add(&h->count, 1, __ATOMIC_RELAXED);
+  __atomic_fetch_add(&h->sum, ns, __ATOMIC_RELAXED);
+
+  max= __atomic_load_n(&h->max, __ATOMIC_RELAXED);
+  while (ns > max
+         && !__atomic_compare_exchange_n(&h->max, &max, ns, TRUE,
+                                         __ATOMIC_RELAXED, __ATOMIC_RELAXED))
+    ;
+}
+
+// Buckets are copied one by one while others may record, count is
+// taken from the copied buckets so that percentiles add up.
+RC getLatencySnapshot (LH_Histogram *h, LH_Snapshot *snap)
+{
+  int i;
+
+  snap->count= 0;
+  for (i=0; i < LH_NUM_BUCKETS; i++)
+  {
+    snap->counts[i]= __atomic_load_n(&h->counts[i], __ATOMIC_RELAXED);
+    snap->count+= snap->counts[i];
+  }
+  snap->sum= __atomic_load_n(&h->sum, __ATOMIC_RELAXED);
+  snap->max= __atomic_load_n(&h->max, __ATOMIC_RELAXED);
+  snap->p50= getLatencyPercentile(snap, 0.5);
+  snap->p99= getLatencyPercentile(snap, 0.99);
+  snap->p999= getLatencyPercentile(snap, 0.999);
+  RETURN(RC_OK);
+}
+
+long long getLatencyPercentile (LH_Snapshot *snap, double q)
+{
+  long long rank, seen= 0, top;
+  int i;
+
+  if (snap->count == 0)
+    return 0;
+  rank= (long long) (q * snap->count + 0.999999);
+  if (rank < 1)
+    rank= 1;
+
+  for (i=0; i < LH_NUM_BUCKETS; i++)
+  {
+    seen+= snap->counts[i];
+    if (seen >= rank)
+      break;
+  }
+  if (i == LH_NUM_BUCKETS)
+    i--;
+
+  // Bucket top can lie above anything recorded
+  top= bucketTop(i);
+  return top > snap->max && snap->max > 0 ? snap->max : top;
+}
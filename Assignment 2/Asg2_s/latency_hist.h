@@ -0,0 +1,54 @@
+#ifndef LATENCY_HIST_H
+#define LATENCY_HIST_H
+
+#include "dberror.h"
+#include "dt.h"
+
+/*
+ * Latency histogram in nanoseconds, log bucketed like HDR histograms.
+ *
+ * Values below LH_SUB_BUCKETS have a bucket each. Above, every power
+ * of two range [2^m, 2^(m+1)) is split in LH_SUB_BUCKETS linear
+ * buckets, so a value is known within 1/LH_SUB_BUCKETS of itself.
+ * Values from 2^(LH_MAX_BIT+1) on go to the last bucket.
+ */
+#define LH_SUB_BITS    4
+#define LH_SUB_BUCKETS (1 << LH_SUB_BITS)
+#define LH_MAX_BIT     46  // 2^46 ns is about 19 hours
+#define LH_NUM_BUCKETS ((LH_MAX_BIT - LH_SUB_BITS + 2) * LH_SUB_BUCKETS)
+
+// Recorded to from any thread with atomic adds
+typedef struct LH_Histogram {
+  long long counts[LH_NUM_BUCKETS];
+  long long count;
+  long long sum;
+  long long max;
+} LH_Histogram;
+
+// Copy of a histogram, percentiles are upper ends of their buckets
+typedef struct LH_Snapshot {
+  long long counts[LH_NUM_BUCKETS];
+  long long count;
+  long long sum;
+  long long max;
+  long long p50;
+  long long p99;
+  long long p999;
+} LH_Snapshot;
+
+// Recording is off until switched on, for all histograms.
+extern void setLatencyTracking (bool on);
+extern bool latencyTrackingOn (void);
+
+// Monotonic clock in nanoseconds, start of a measured interval.
+// Returns 0 while tracking is off, recordLatencySince then does nothing.
+extern long long latencyStart (void);
+extern void recordLatencySince (LH_Histogram *h, long long start);
+
+extern void initLatencyHistogram (LH_Histogram *h);
+extern void recordLatency (LH_Histogram *h, long long ns);
+extern RC getLatencySnapshot (LH_Histogram *h, LH_Snapshot *snap);
+// Smallest value at or below which q (0..1) of recorded values lie
+extern long long getLatencyPercentile (LH_Snapshot *snap, double q);
+
+#endif // LATENCY_HIST_H
@@ -1,9 +1,12 @@
-#ifndef LRU 
-#define LRU
-#include "buffer_mgr.h"
-
-BM_PageFrame* retriveLRUFrame(BM_StrategyInfo *si);
-void appendMRUFrame (BM_StrategyInfo *si, BM_PageFrame *pf);
-void reuseLRUFrame(BM_StrategyInfo *si, BM_PageFrame *pf);
-void cleanLRUlist   (BM_StrategyInfo *si);
+#ifndef LRU 
+#define LRU
+#include "buffer_mgr.h"
+
+BM_PageFrame* retriveLRUFrame(BM_StrategyInfo *si);
+BM_PageFrame* retriveLRUFrameOnNode(BM_StrategyInfo *si, int node,
+                                    int lookahead);
+void appendMRUFrame (BM_StrategyInfo *si, BM_PageFrame *pf);
+void prependLRUFrame (BM_StrategyInfo *si, BM_PageFrame *pf);
+void reuseLRUFrame(BM_StrategyInfo *si, BM_PageFrame *pf);
+void cleanLRUlist   (BM_StrategyInfo *si);
 #endif
\ No newline at end of file
@@ -0,0 +1,513 @@
+#include "mrc.h"
+#include "buffer_trace.h"
+#include <stdlib.h>
+#include <string.h>
+#include <limits.h>
+
+/*
+ * Miss ratio curves
+ *
+ * LRU has the inclusion property, a page is in a pool of c frames iff
+ * fewer than c other pages were referenced since its last reference
+ * (Mattson et al.). So one pass computing the reuse distance of every
+ * reference gives the misses of all pool sizes. Distances are counted
+ * with a Fenwick tree over reference times holding a 1 at the last
+ * reference of every page, O(log n) per reference.
+ *
+ * SHARDS (Waldspurger et al.) only follows pages whose hash falls
+ * below sampleRate. A distance d among sampled pages stands for d /
+ * sampleRate among all pages, ratios are taken over sampled references.
+ *
+ * MIN is simulated per pool size with a max heap of cached pages keyed
+ * by their next reference, the root is evicted on a miss.
+ *
+ * Both passes number the pages of a trace 0..distinct-1 through a hash
+ * table first, so their per page arrays do not grow with page numbers.
+ *
+ * The online estimator cannot size its Fenwick tree by the number of
+ * references. When time runs past the tree, last reference times of
+ * pages are renumbered 1..numPages in order and the tree is rebuilt,
+ * which keeps distances and costs O(numPages log numPages) every
+ * treeSize - numPages references.
+ */
+
+#define SAMPLE_BITS 24
+#define MIN_TREE_SIZE 1024
+
+// Cached pages of the MIN simulation
+typedef struct MinHeap {
+  int *pages;             // Dense page ids
+  long long *keys;
+  int *pos;               // Heap slot of page, -1 if not cached
+  int count;
+} MinHeap;
+
+// Not a interface
+static unsigned long long mixPage(PageNumber p);
+static unsigned int pageHash(PageNumber p);
+static int *densePageIds(const PageNumber *pages, long long num,
+                         int *numIds);
+static void fenwickAdd(int *tree, long long size, long long i, int v);
+static long long fenwickSum(int *tree, long long i);
+static void heapSwap(MinHeap *h, int a, int b);
+static void heapUp(MinHeap *h, int i);
+static void heapDown(MinHeap *h, int i);
+static int findSlot(MRC_Estimator *e, PageNumber p);
+static void growTable(MRC_Estimator *e);
+static void renumberTimes(MRC_Estimator *e);
+static int cmpTimes(const void *a, const void *b);
+
+static unsigned long long mixPage(PageNumber p)
+{
+  unsigned long long x= (unsigned long long) p + 0x9E3779B97F4A7C15ULL;
+
+  x= (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ULL;
+  x= (x ^ (x >> 27)) * 0x94D049BB133111EBULL;
+  return x ^ (x >> 31);
+}
+
+static unsigned int pageHash(PageNumber p)
+{
+  return (unsigned int) (mixPage(p) & ((1U << SAMPLE_BITS) - 1));
+}
+
+// Id of the page of every reference, ids are given in order of first
+// reference. Table is at most half full, so probes stay short.
+static int *densePageIds(const PageNumber *pages, long long num,
+                         int *numIds)
+{
+  PageNumber *keys;
+  int *ids, *slotIds;
+  long long i, size= 16, slot;
+
+  while (size < 2 * num)
+    size*= 2;
+  keys= (PageNumber*) malloc(size * sizeof(PageNumber));
+  slotIds= (int*) malloc(size * sizeof(int));
+  ids= (int*) malloc((num > 0 ? num : 1) * sizeof(int));
+  for (i=0; i < size; i++)
+    keys[i]= NO_PAGE;
+
+  *numIds= 0;
+  for (i=0; i < num; i++)
+  {
+    slot= (long long) (mixPage(pages[i]) & (size - 1));
+    while (keys[slot] != NO_PAGE && keys[slot] != pages[i])
+      slot= (slot + 1) & (size - 1);
+    if (keys[slot] == NO_PAGE)
+    {
+      keys[slot]= pages[i];
+      slotIds[slot]= (*numIds)++;
+    }
+    ids[i]= slotIds[slot];
+  }
+
+  free(keys);
+  free(slotIds);
+  return ids;
+}
+
+static void fenwickAdd(int *tree, long long size, long long i, int v)
+{
+  for (; i <= size; i+= i & -i)
+    tree[i]+= v;
+}
+
+static long long fenwickSum(int *tree, long long i)
+{
+  long long sum= 0;
+
+  for (; i > 0; i-= i & -i)
+    sum+= tree[i];
+  return sum;
+}
+
+RC readTracePins (const char *traceFile, PageNumber **pages, long long *num)
+{
+  BM_TraceReader *reader;
+  PageNumber *buf, pageNum;
+  long long n= 0, capacity= 1024;
+  TR_Op op;
+  RC rc;
+
+  rc= openTraceReader(&reader, traceFile);
+  if (rc != RC_OK)
+    RETURN(rc);
+
+  buf= (PageNumber*) malloc(capacity * sizeof(PageNumber));
+  while ((rc= nextTraceRecord(reader, &op, &pageNum)) == RC_OK)
+  {
+    if (op != TR_PIN)
+      continue;
+    if (n == capacity)
+    {
+      capacity*= 2;
+      buf= (PageNumber*) realloc(buf, capacity * sizeof(PageNumber));
+    }
+    buf[n++]= pageNum;
+  }
+  closeTraceReader(reader);
+  if (rc != RC_TRACE_END)
+  {
+    free(buf);
+    RETURN(rc);
+  }
+
+  *pages= buf;
+  *num= n;
+  RETURN(RC_OK);
+}
+
+/**************************************************
+ * LRU curve
+ */
+RC computeLRUCurve (const PageNumber *pages, long long num, int maxSize,
+                    double sampleRate, MRC_Curve *curve)
+{
+  unsigned int threshold;
+  long long *last, i, t= 0, d, scaled;
+  int *tree, *ids, numIds, c, p;
+
+  if (maxSize <= 0 || sampleRate <= 0 || sampleRate > 1)
+    RETURN(RC_MRC_INVALID_PARAM);
+  threshold= (unsigned int) (sampleRate * (1U << SAMPLE_BITS));
+
+  ids= densePageIds(pages, num, &numIds);
+  last= (long long*) calloc(numIds + 1, sizeof(long long));
+  tree= (int*) calloc(num + 1, sizeof(int));
+
+  curve->maxSize= maxSize;
+  curve->sampleRate= sampleRate;
+  curve->hits= (long long*) calloc(maxSize + 1, sizeof(long long));
+
+  // Times start at 1, last[p] == 0 is a first reference
+  for (i=0; i < num; i++)
+  {
+    if (sampleRate < 1 && pageHash(pages[i]) >= threshold)
+      continue;
+    p= ids[i];
+    t++;
+    if (last[p] > 0)
+    {
+      d= fenwickSum(tree, t - 1) - fenwickSum(tree, last[p]) + 1;
+      scaled= (long long) (d / sampleRate);
+      if (scaled <= maxSize)
+        curve->hits[scaled]++;
+      fenwickAdd(tree, num, last[p], -1);
+    }
+    fenwickAdd(tree, num, t, 1);
+    last[p]= t;
+  }
+  curve->numAccesses= t;
+
+  // Distance histogram to hits per pool size
+  for (c=1; c <= maxSize; c++)
+    curve->hits[c]+= curve->hits[c - 1];
+
+  free(tree);
+  free(last);
+  free(ids);
+  RETURN(RC_OK);
+}
+
+// Sizes above maxSize get the miss ratio of maxSize
+double getLRUMissRatio (MRC_Curve *curve, int size)
+{
+  if (curve->numAccesses == 0)
+    return 0.0;
+  if (size <= 0)
+    return 1.0;
+  if (size > curve->maxSize)
+    size= curve->maxSize;
+  return 1.0 - (double) curve->hits[size] / curve->numAccesses;
+}
+
+void freeMRCurve (MRC_Curve *curve)
+{
+  free(curve->hits);
+  curve->hits= NULL;
+}
+
+/**************************************************
+ * Belady's MIN
+ */
+static void heapSwap(MinHeap *h, int a, int b)
+{
+  int p= h->pages[a];
+  long long k= h->keys[a];
+
+  h->pages[a]= h->pages[b];
+  h->keys[a]= h->keys[b];
+  h->pages[b]= p;
+  h->keys[b]= k;
+  h->pos[h->pages[a]]= a;
+  h->pos[h->pages[b]]= b;
+}
+
+static void heapUp(MinHeap *h, int i)
+{
+  while (i > 0 && h->keys[(i - 1) / 2] < h->keys[i])
+  {
+    heapSwap(h, i, (i - 1) / 2);
+    i= (i - 1) / 2;
+  }
+}
+
+static void heapDown(MinHeap *h, int i)
+{
+  int child;
+
+  while ((child= 2 * i + 1) < h->count)
+  {
+    if (child + 1 < h->count && h->keys[child + 1] > h->keys[child])
+      child++;
+    if (h->keys[i] >= h->keys[child])
+      break;
+    heapSwap(h, i, child);
+    i= child;
+  }
+}
+
+RC simulateMIN (const PageNumber *pages, long long num, int size,
+                long long *misses)
+{
+  MinHeap h;
+  long long *next, *seen, i;
+  int *ids, numIds, p, slot;
+
+  if (size <= 0)
+    RETURN(RC_MRC_INVALID_PARAM);
+
+  // Next reference of every reference, backwards
+  ids= densePageIds(pages, num, &numIds);
+  next= (long long*) malloc((num > 0 ? num : 1) * sizeof(long long));
+  seen= (long long*) malloc((numIds + 1) * sizeof(long long));
+  for (p=0; p < numIds; p++)
+    seen[p]= LLONG_MAX;
+  for (i=num - 1; i >= 0; i--)
+  {
+    next[i]= seen[ids[i]];
+    seen[ids[i]]= i;
+  }
+  free(seen);
+
+  h.pages= (int*) malloc(size * sizeof(int));
+  h.keys= (long long*) malloc(size * sizeof(long long));
+  h.pos= (int*) malloc((numIds + 1) * sizeof(int));
+  memset(h.pos, -1, (numIds + 1) * sizeof(int));
+  h.count= 0;
+
+  *misses= 0;
+  for (i=0; i < num; i++)
+  {
+    p= ids[i];
+    slot= h.pos[p];
+    if (slot >= 0)
+    {
+      // Next reference only moves later
+      h.keys[slot]= next[i];
+      heapUp(&h, slot);
+      continue;
+    }
+
+    (*misses)++;
+    if (h.count < size)
+    {
+      slot= h.count++;
+      h.pages[slot]= p;
+      h.keys[slot]= next[i];
+      h.pos[p]= slot;
+      heapUp(&h, slot);
+    }
+    else
+    {
+      h.pos[h.pages[0]]= -1;
+      h.pages[0]= p;
+      h.keys[0]= next[i];
+      h.pos[p]= 0;
+      heapDown(&h, 0);
+    }
+  }
+
+  free(h.pages);
+  free(h.keys);
+  free(h.pos);
+  free(next);
+  free(ids);
+  RETURN(RC_OK);
+}
+
+/**************************************************
+ * Online estimator
+ */
+static int findSlot(MRC_Estimator *e, PageNumber p)
+{
+  int slot= (int) (pageHash(p) & (e->tableSize - 1));
+
+  while (e->pages[slot] != NO_PAGE && e->pages[slot] != p)
+    slot= (slot + 1) & (e->tableSize - 1);
+  return slot;
+}
+
+static void growTable(MRC_Estimator *e)
+{
+  PageNumber *oldPages= e->pages;
+  long long *oldTimes= e->times;
+  int oldSize= e->tableSize, i, slot;
+
+  e->tableSize*= 2;
+  e->pages= (PageNumber*) malloc(e->tableSize * sizeof(PageNumber));
+  e->times= (long long*) malloc(e->tableSize * sizeof(long long));
+  for (i=0; i < e->tableSize; i++)
+    e->pages[i]= NO_PAGE;
+  for (i=0; i < oldSize; i++)
+    if (oldPages[i] != NO_PAGE)
+    {
+      slot= findSlot(e, oldPages[i]);
+      e->pages[slot]= oldPages[i];
+      e->times[slot]= oldTimes[i];
+    }
+  free(oldPages);
+  free(oldTimes);
+}
+
+static int cmpTimes(const void *a, const void *b)
+{
+  long long x= **(long long* const*) a, y= **(long long* const*) b;
+  return x < y ? -1 : (x > y ? 1 : 0);
+}
+
+static void renumberTimes(MRC_Estimator *e)
+{
+  long long **order, i;
+  int n= 0, slot;
+
+  order= (long long**) malloc((e->numPages + 1) * sizeof(long long*));
+  for (slot=0; slot < e->tableSize; slot++)
+    if (e->pages[slot] != NO_PAGE)
+      order[n++]= &e->times[slot];
+  qsort(order, n, sizeof(long long*), cmpTimes);
+
+  // Keep at least as much room for new times as there are pages
+  if (e->treeSize < 2LL * n)
+  {
+    e->treeSize= 4LL * n;
+    free(e->tree);
+    e->tree= (int*) malloc((e->treeSize + 1) * sizeof(int));
+  }
+
+  // Tree of ones at 1..n, built bottom up
+  memset(e->tree, 0, (e->treeSize + 1) * sizeof(int));
+  for (i=1; i <= e->treeSize; i++)
+  {
+    if (i <= n)
+    {
+      *order[i - 1]= i;
+      e->tree[i]++;
+    }
+    if (i + (i & -i) <= e->treeSize)
+      e->tree[i + (i & -i)]+= e->tree[i];
+  }
+  e->now= n;
+  free(order);
+}
+
+RC initMRCEstimator (MRC_Estimator *e, int maxSize, double sampleRate)
+{
+  int i;
+
+  if (maxSize <= 0 || sampleRate <= 0 || sampleRate > 1)
+    RETURN(RC_MRC_INVALID_PARAM);
+
+  e->maxSize= maxSize;
+  e->sampleRate= sampleRate;
+  e->threshold= (unsigned int) (sampleRate * (1U << SAMPLE_BITS));
+  e->numAccesses= 0;
+  e->dist= (long long*) calloc(maxSize + 1, sizeof(long long));
+  e->tableSize= 64;
+  e->numPages= 0;
+  e->pages= (PageNumber*) malloc(e->tableSize * sizeof(PageNumber));
+  e->times= (long long*) malloc(e->tableSize * sizeof(long long));
+  for (i=0; i < e->tableSize; i++)
+    e->pages[i]= NO_PAGE;
+  e->treeSize= MIN_TREE_SIZE;
+  e->tree= (int*) calloc(e->treeSize + 1, sizeof(int));
+  e->now= 0;
+  RETURN(RC_OK);
+}
+
+void recordMRCAccess (MRC_Estimator *e, PageNumber pageNum)
+{
+  long long d, scaled;
+  int slot;
+
+  if (e->sampleRate < 1 && pageHash(pageNum) >= e->threshold)
+    return;
+
+  if (e->now == e->treeSize)
+    renumberTimes(e);
+  e->now++;
+  e->numAccesses++;
+
+  slot= findSlot(e, pageNum);
+  if (e->pages[slot] == pageNum)
+  {
+    d= fenwickSum(e->tree, e->now - 1) - fenwickSum(e->tree, e->times[slot]) + 1;
+    scaled= (long long) (d / e->sampleRate);
+    if (scaled <= e->maxSize)
+      e->dist[scaled]++;
+    fenwickAdd(e->tree, e->treeSize, e->times[slot], -1);
+  }
+  else
+  {
+    e->pages[slot]= pageNum;
+    if (++e->numPages * 2 > e->tableSize)
+    {
+      growTable(e);
+      slot= findSlot(e, pageNum);
+    }
+  }
+  fenwickAdd(e->tree, e->treeSize, e->now, 1);
+  e->times[slot]= e->now;
+}
+
+// Sizes above maxSize get the hit ratio of maxSize
+double getEstimatedHitRatio (MRC_Estimator *e, int size)
+{
+  long long hits= 0;
+  int d;
+
+  if (e->numAccesses == 0 || size <= 0)
+    return 0.0;
+  if (size > e->maxSize)
+    size= e->maxSize;
+  for (d=1; d <= size; d++)
+    hits+= e->dist[d];
+  return (double) hits / e->numAccesses;
+}
+
+// Forget references seen so far
+void resetMRCEstimator (MRC_Estimator *e)
+{
+  int i;
+
+  e->numAccesses= 0;
+  memset(e->dist, 0, (e->maxSize + 1) * sizeof(long long));
+  for (i=0; i < e->tableSize; i++)
+    e->pages[i]= NO_PAGE;
+  e->numPages= 0;
+  memset(e->tree, 0, (e->treeSize + 1) * sizeof(int));
+  e->now= 0;
+}
+
+void freeMRCEstimator (MRC_Estimator *e)
+{
+  free(e->dist);
+  free(e->pages);
+  free(e->times);
+  free(e->tree);
+  e->dist= NULL;
+  e->pages= NULL;
+  e->times= NULL;
+  e->tree= NULL;
+}
@@ -0,0 +1,61 @@
+#ifndef MRC_H
+#define MRC_H
+
+#include "dberror.h"
+#include "buffer_mgr.h"
+
+/*
+ * Miss ratio curves of page reference strings, e.g. the pins of an
+ * access trace. Unpins and pinning itself are not modelled, every
+ * reference may evict any other page.
+ *
+ * The LRU curve gives the miss ratio of every pool size up to maxSize
+ * from one pass. Pages are sampled SHARDS style with sampleRate, 1.0
+ * means exact.
+ */
+typedef struct MRC_Curve {
+  int maxSize;
+  double sampleRate;
+  long long numAccesses;    // Sampled references
+  long long *hits;          // hits[c] sampled hits with c frames
+} MRC_Curve;
+
+// Pins of a trace recorded with startPoolTrace, *pages is malloc'd
+extern RC readTracePins (const char *traceFile, PageNumber **pages,
+                         long long *num);
+
+extern RC computeLRUCurve (const PageNumber *pages, long long num,
+                           int maxSize, double sampleRate, MRC_Curve *curve);
+extern double getLRUMissRatio (MRC_Curve *curve, int size);
+extern void freeMRCurve (MRC_Curve *curve);
+
+// Misses of Belady's MIN, evicting the page used again last
+extern RC simulateMIN (const PageNumber *pages, long long num, int size,
+                       long long *misses);
+
+// Online LRU curve, fed one reference at a time. Memory grows with
+// the sampled pages only, caller serializes calls.
+typedef struct MRC_Estimator {
+  int maxSize;
+  double sampleRate;
+  unsigned int threshold;
+  long long numAccesses;    // Sampled references
+  long long *dist;          // dist[d] sampled references at distance d
+  // Last reference time of sampled pages, open addressing
+  PageNumber *pages;
+  long long *times;
+  int tableSize;
+  int numPages;
+  // Fenwick tree over times, renumbered when now reaches treeSize
+  int *tree;
+  long long treeSize;
+  long long now;
+} MRC_Estimator;
+
+extern RC initMRCEstimator (MRC_Estimator *e, int maxSize, double sampleRate);
+extern void recordMRCAccess (MRC_Estimator *e, PageNumber pageNum);
+extern double getEstimatedHitRatio (MRC_Estimator *e, int size);
+extern void resetMRCEstimator (MRC_Estimator *e);
+extern void freeMRCEstimator (MRC_Estimator *e);
+
+#endif // MRC_H
@@ -0,0 +1,153 @@
+/*
+ * Scores replacement strategies on an access trace against Belady's
+ * MIN, the fewest misses any strategy can have on it.
+ *
+ * Prints, for every pool size, the miss ratio of LRU taken from the
+ * miss ratio curve, of MIN, and with -p of FIFO, LRU and CLOCK as
+ * measured by replaying the trace on a real pool.
+ *
+ * gcc -O2 -I. -o mrc_sim mrc_sim.c mrc.c buffer_trace.c buffer_mgr.c \
+ *     buffer_mgr_stat.c storage_mgr.c page_compress.c page_table.c \
+ *     lru_linked_list.c page_latch.c frame_arena.c latency_hist.c \
+ *     dberror.c -lpthread
+ *
+ * usage: mrc_sim traceFile [-s poolSizes] [-r sampleRate] [-p]
+ *   poolSizes   comma separated, default powers of two up to the
+ *               number of distinct pages
+ *   sampleRate  SHARDS rate of the LRU curve, default 1 (exact)
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "dberror.h"
+#include "storage_mgr.h"
+#include "buffer_mgr.h"
+#include "buffer_trace.h"
+#include "mrc.h"
+
+#define SCRATCH_FILE "mrc_sim.bin"
+#define MAX_SIZES 64
+
+#define CHECK_RC(code)                                                  \
+  do {                                                                  \
+    RC _rc= (code);                                                     \
+    if (_rc != RC_OK)                                                   \
+    {                                                                   \
+      char *_msg= errorMessage(_rc);                                    \
+      fprintf(stderr, "%s:%d: %s\n", __FILE__, __LINE__, _msg);         \
+      free(_msg);                                                       \
+      exit(1);                                                          \
+    }                                                                   \
+  } while (0)
+
+static int distinctPages(const PageNumber *pages, long long num)
+{
+  PageNumber max= 0;
+  char *seen;
+  long long i;
+  int n= 0;
+
+  for (i=0; i < num; i++)
+    if (pages[i] > max)
+      max= pages[i];
+  seen= (char*) calloc(max + 1, 1);
+  for (i=0; i < num; i++)
+    if (!seen[pages[i]])
+    {
+      seen[pages[i]]= 1;
+      n++;
+    }
+  free(seen);
+  return n;
+}
+
+static double replayMissRatio(const char *traceFile,
+                              ReplacementStrategy strategy, int size)
+{
+  BM_ReplayResult r;
+  long long accesses;
+
+  CHECK_RC(replayTrace(traceFile, SCRATCH_FILE, strategy, size, &r));
+  accesses= r.stats.hits + r.stats.misses;
+  return accesses ? (double) r.stats.misses / accesses : 0.0;
+}
+
+int main(int argc, char **argv)
+{
+  int sizes[MAX_SIZES], numSizes= 0, maxSize= 0, i, opt, distinct;
+  double sampleRate= 1.0;
+  bool replay= FALSE;
+  PageNumber *pages;
+  long long num, misses;
+  MRC_Curve curve;
+  char *tok, *save;
+
+  while ((opt= getopt(argc, argv, "s:r:p")) != -1)
+  {
+    switch (opt)
+    {
+      case 's':
+        for (tok= strtok_r(optarg, ",", &save); tok && numSizes < MAX_SIZES;
+             tok= strtok_r(NULL, ",", &save))
+          sizes[numSizes++]= atoi(tok);
+        break;
+      case 'r': sampleRate= atof(optarg); break;
+      case 'p': replay= TRUE; break;
+      default: optind= argc + 1; break;
+    }
+  }
+  if (optind != argc - 1)
+  {
+    fprintf(stderr, "usage: %s traceFile [-s poolSizes] [-r sampleRate] [-p]\n",
+            argv[0]);
+    return 1;
+  }
+
+  initStorageManager();
+  CHECK_RC(readTracePins(argv[optind], &pages, &num));
+  distinct= distinctPages(pages, num);
+  if (numSizes == 0)
+    for (i=1; numSizes < MAX_SIZES; i*= 2)
+    {
+      sizes[numSizes++]= i < distinct ? i : distinct;
+      if (i >= distinct)
+        break;
+    }
+  for (i=0; i < numSizes; i++)
+  {
+    if (sizes[i] <= 0)
+    {
+      fprintf(stderr, "bad pool size %d\n", sizes[i]);
+      return 1;
+    }
+    if (sizes[i] > maxSize)
+      maxSize= sizes[i];
+  }
+
+  printf("# %lld pins, %d distinct pages, sample rate %g\n", num, distinct,
+         sampleRate);
+  CHECK_RC(computeLRUCurve(pages, num, maxSize, sampleRate, &curve));
+  printf("%8s %10s %10s", "frames", "lru_curve", "min");
+  if (replay)
+    printf(" %10s %10s %10s", "fifo", "lru", "clock");
+  printf("\n");
+
+  for (i=0; i < numSizes; i++)
+  {
+    CHECK_RC(simulateMIN(pages, num, sizes[i], &misses));
+    printf("%8d %10.4f %10.4f", sizes[i], getLRUMissRatio(&curve, sizes[i]),
+           num ? (double) misses / num : 0.0);
+    if (replay)
+      printf(" %10.4f %10.4f %10.4f",
+             replayMissRatio(argv[optind], RS_FIFO, sizes[i]),
+             replayMissRatio(argv[optind], RS_LRU, sizes[i]),
+             replayMissRatio(argv[optind], RS_CLOCK, sizes[i]));
+    printf("\n");
+  }
+
+  freeMRCurve(&curve);
+  free(pages);
+  return 0;
+}
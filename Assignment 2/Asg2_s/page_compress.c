@@ -0,0 +1,124 @@
+#include "page_compress.h"
+#include <string.h>
+
+/*
+ * Page compression
+ *
+ * Page images are mostly zeros and small tuples, so a byte
+ * oriented run length encoding captures most of the win
+ * without pulling in an external codec.
+ *
+ * Image is a sequence of runs, each starting with a control byte c.
+ * | c < 0x80  | literal run, next (c + 1) bytes are copied as is.
+ * | c >= 0x80 | repeat run, next byte is repeated (c - 0x80 + 3) times.
+ *
+ * Repeat runs are only used for 3 or more equal bytes, shorter
+ * runs are cheaper as literals.
+ */
+
+#define MAX_LITERAL_RUN 128
+#define MIN_REPEAT_RUN  3
+#define MAX_REPEAT_RUN  (0x7F + MIN_REPEAT_RUN)
+
+// Length of run of equal bytes starting at pos, capped to MAX_REPEAT_RUN.
+static int repeatRunLength(const char *page, int pos)
+{
+  int len= 1;
+  while (pos+len < PAGE_SIZE && len < MAX_REPEAT_RUN
+         && page[pos+len] == page[pos])
+    len++;
+  return len;
+}
+
+int isZeroPage(const char *page)
+{
+  const long *word= (const long*) page;
+  int i;
+
+  for (i=0; i < PAGE_SIZE / (int) sizeof(long); i++)
+    if (word[i])
+      return 0;
+  return 1;
+}
+
+int compressPage(const char *page, char *out)
+{
+  int pos= 0, outLen= 0;
+  int litStart= -1, litLen= 0;
+  int runLen;
+
+  while (pos < PAGE_SIZE)
+  {
+    runLen= repeatRunLength(page, pos);
+    if (runLen >= MIN_REPEAT_RUN)
+    {
+      // Close pending literal run first
+      if (litLen)
+      {
+        out[outLen++]= (char) (litLen - 1);
+        memcpy(&out[outLen], &page[litStart], litLen);
+        outLen+= litLen;
+        litLen= 0;
+      }
+      out[outLen++]= (char) (0x80 + runLen - MIN_REPEAT_RUN);
+      out[outLen++]= page[pos];
+      pos+= runLen;
+      continue;
+    }
+
+    // Short run, keep it as literal
+    if (!litLen)
+      litStart= pos;
+    litLen++;
+    pos++;
+    if (litLen == MAX_LITERAL_RUN)
+    {
+      out[outLen++]= (char) (litLen - 1);
+      memcpy(&out[outLen], &page[litStart], litLen);
+      outLen+= litLen;
+      litLen= 0;
+    }
+  }
+
+  if (litLen)
+  {
+    out[outLen++]= (char) (litLen - 1);
+    memcpy(&out[outLen], &page[litStart], litLen);
+    outLen+= litLen;
+  }
+
+  return outLen;
+}
+
+RC decompressPage(const char *in, int len, char *page)
+{
+  int inPos= 0, pos= 0, runLen;
+  unsigned char c;
+
+  while (inPos < len)
+  {
+    c= (unsigned char) in[inPos++];
+    if (c < 0x80)
+    {
+      runLen= c + 1;
+      if (pos + runLen > PAGE_SIZE || inPos + runLen > len)
+        RETURN(RC_READ_FAILED);
+      memcpy(&page[pos], &in[inPos], runLen);
+      inPos+= runLen;
+    }
+    else
+    {
+      runLen= c - 0x80 + MIN_REPEAT_RUN;
+      if (pos + runLen > PAGE_SIZE || inPos >= len)
+        RETURN(RC_READ_FAILED);
+      memset(&page[pos], in[inPos++], runLen);
+    }
+    pos+= runLen;
+  }
+
+  // Image must expand to exactly one page
+  if (pos != PAGE_SIZE)
+    RETURN(RC_READ_FAILED);
+
+  RETURN(RC_OK);
+}
@@ -0,0 +1,19 @@
+#ifndef PAGE_COMPRESS_H
+#define PAGE_COMPRESS_H
+#include "dberror.h"
+
+// Worst case size of a compressed page image. Every 128 literal
+// bytes cost one extra control byte.
+#define PAGE_COMPRESS_BOUND (PAGE_SIZE + (PAGE_SIZE / 128) + 1)
+
+// Returns 1 if every byte of the page is zero.
+int isZeroPage(const char *page);
+
+// RLE compress PAGE_SIZE bytes from page into out.
+// Returns number of bytes written to out.
+int compressPage(const char *page, char *out);
+
+// Expand len bytes of compressed image into PAGE_SIZE bytes of page.
+RC decompressPage(const char *in, int len, char *page);
+
+#endif
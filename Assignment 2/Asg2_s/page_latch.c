@@ -0,0 +1,147 @@
+#include "page_latch.h"
+
+/*
+ * Page latches
+ *
+ * The latch is one int, taken and given back with compare and swap
+ * when there is no contention. A thread that can not get it spins
+ * PL_SPINS times, as holders of page latches usually only copy a few
+ * bytes, and then sleeps on cond. The sleepers count is raised before
+ * the last try and read after every release, with full fences in
+ * between, so a release never misses a thread about to sleep and
+ * uncontended releases do not touch the mutex.
+ *
+ * An exclusive holder makes version odd when it gets the latch and
+ * even again before it gives it back. A read that starts and ends on
+ * the same even version saw no writer.
+ */
+
+#define PL_SPINS 100
+
+#if defined(__x86_64__) || defined(__i386__)
+#define CPU_RELAX() __builtin_ia32_pause()
+#else
+#define CPU_RELAX() __asm__ __volatile__("" ::: "memory")
+#endif
+
+// Not a interface
+static bool tryShared(PL_Latch *latch);
+static bool tryExclusive(PL_Latch *latch);
+static bool tryMode(PL_Latch *latch, PL_Mode mode);
+
+// New readers wait behind waiting writers
+static bool tryShared(PL_Latch *latch)
+{
+  int s= __atomic_load_n(&latch->state, __ATOMIC_RELAXED);
+
+  while (s >= 0
+         && __atomic_load_n(&latch->writersWaiting, __ATOMIC_RELAXED) == 0)
+  {
+    if (__atomic_compare_exchange_n(&latch->state, &s, s + 1, TRUE,
+                                    __ATOMIC_ACQUIRE, __ATOMIC_RELAXED))
+      return TRUE;
+  }
+  return FALSE;
+}
+
+static bool tryExclusive(PL_Latch *latch)
+{
+  int s= 0;
+
+  if (!__atomic_compare_exchange_n(&latch->state, &s, -1, FALSE,
+                                   __ATOMIC_ACQUIRE, __ATOMIC_RELAXED))
+    return FALSE;
+  // Only holder writes version. Fence keeps writes to page behind it.
+  __atomic_store_n(&latch->version, latch->version + 1, __ATOMIC_RELAXED);
+  __atomic_thread_fence(__ATOMIC_RELEASE);
+  return TRUE;
+}
+
+static bool tryMode(PL_Latch *latch, PL_Mode mode)
+{
+  return mode == PL_EXCLUSIVE ? tryExclusive(latch) : tryShared(latch);
+}
+
+void initLatch (PL_Latch *latch)
+{
+  latch->state= 0;
+  latch->writersWaiting= 0;
+  latch->sleepers= 0;
+  latch->version= 0;
+  pthread_mutex_init(&latch->mutex, NULL);
+  pthread_cond_init(&latch->cond, NULL);
+}
+
+void destroyLatch (PL_Latch *latch)
+{
+  pthread_cond_destroy(&latch->cond);
+  pthread_mutex_destroy(&latch->mutex);
+}
+
+void acquireLatch (PL_Latch *latch, PL_Mode mode)
+{
+  int i;
+
+  // A writer only counts as waiting once its first try failed
+  if (tryMode(latch, mode))
+    return;
+
+  if (mode == PL_EXCLUSIVE)
+    __atomic_fetch_add(&latch->writersWaiting, 1, __ATOMIC_RELAXED);
+
+  for (i=0; i < PL_SPINS; i++)
+  {
+    CPU_RELAX();
+    if (tryMode(latch, mode))
+      goto done;
+  }
+
+  pthread_mutex_lock(&latch->mutex);
+  __atomic_fetch_add(&latch->sleepers, 1, __ATOMIC_RELAXED);
+  __atomic_thread_fence(__ATOMIC_SEQ_CST);
+  while (!tryMode(latch, mode))
+    pthread_cond_wait(&latch->cond, &latch->mutex);
+  __atomic_fetch_sub(&latch->sleepers, 1, __ATOMIC_RELAXED);
+  pthread_mutex_unlock(&latch->mutex);
+
+done:
+  if (mode == PL_EXCLUSIVE)
+    __atomic_fetch_sub(&latch->writersWaiting, 1, __ATOMIC_RELAXED);
+}
+
+bool tryAcquireLatch (PL_Latch *latch, PL_Mode mode)
+{
+  return tryMode(latch, mode);
+}
+
+void releaseLatch (PL_Latch *latch, PL_Mode mode)
+{
+  if (mode == PL_EXCLUSIVE)
+  {
+    __atomic_store_n(&latch->version, latch->version + 1, __ATOMIC_RELEASE);
+    __atomic_store_n(&latch->state, 0, __ATOMIC_RELEASE);
+  }
+  else if (__atomic_sub_fetch(&latch->state, 1, __ATOMIC_RELEASE) > 0)
+    return;   // Other readers still hold it, nobody can get in
+
+  __atomic_thread_fence(__ATOMIC_SEQ_CST);
+  if (__atomic_load_n(&latch->sleepers, __ATOMIC_RELAXED) > 0)
+  {
+    pthread_mutex_lock(&latch->mutex);
+    pthread_cond_broadcast(&latch->cond);
+    pthread_mutex_unlock(&latch->mutex);
+  }
+}
+
+unsigned int startLatchRead (PL_Latch *latch)
+{
+  return __atomic_load_n(&latch->version, __ATOMIC_ACQUIRE);
+}
+
+// Fence keeps reads of page ahead of the second load of version
+bool validateLatchRead (PL_Latch *latch, unsigned int version)
+{
+  __atomic_thread_fence(__ATOMIC_ACQUIRE);
+  return (version & 1) == 0
+         && __atomic_load_n(&latch->version, __ATOMIC_RELAXED) == version;
+}
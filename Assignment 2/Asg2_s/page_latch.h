@@ -0,0 +1,49 @@
+#ifndef PAGE_LATCH_H
+#define PAGE_LATCH_H
+
+#include <pthread.h>
+
+#include "dt.h"
+
+/*
+ * Reader/writer latch of a page frame.
+ *
+ * Many threads may hold a latch shared, or one thread exclusive.
+ * Latches are not recursive: a thread taking a latch it already holds
+ * waits for itself. Waiters spin a while, then sleep. A waiting
+ * exclusive request keeps new shared requests out, so writers are not
+ * starved by a steady stream of readers.
+ *
+ * Readers may also go without the latch, like with a seqlock: take
+ * the version with startLatchRead, read, and keep what was read only
+ * if validateLatchRead says no exclusive holder came in between.
+ * Such readers write nothing shared, so they do not move the latch's
+ * cache line between cores.
+ */
+typedef enum PL_Mode {
+  PL_SHARED = 1,
+  PL_EXCLUSIVE = 2
+} PL_Mode;
+
+typedef struct PL_Latch {
+  int state;              // Shared holders, -1 when held exclusive
+  int writersWaiting;     // Exclusive requests not granted yet
+  int sleepers;           // Threads waiting on cond
+  unsigned int version;   // Odd while held exclusive
+  pthread_mutex_t mutex;
+  pthread_cond_t cond;
+} PL_Latch;
+
+extern void initLatch (PL_Latch *latch);
+extern void destroyLatch (PL_Latch *latch);
+
+extern void acquireLatch (PL_Latch *latch, PL_Mode mode);
+// Only succeeds if latch can be had without waiting
+extern bool tryAcquireLatch (PL_Latch *latch, PL_Mode mode);
+extern void releaseLatch (PL_Latch *latch, PL_Mode mode);
+
+// Optimistic reads, no state of latch is changed
+extern unsigned int startLatchRead (PL_Latch *latch);
+extern bool validateLatchRead (PL_Latch *latch, unsigned int version);
+
+#endif // PAGE_LATCH_H
@@ -0,0 +1,377 @@
+#include "pool_mgr.h"
+#include <string.h>
+#include <stdlib.h>
+#include <errno.h>
+#include <time.h>
+
+/*
+ * Pool manager
+ *
+ * Every managed pool tracks its miss ratio curve (see mrc.h), so it
+ * can tell how many hits step frames more or less would have given.
+ * The curve is scaled by pins since the last round: a pool is worth
+ * growing if its working set does not fit and it is busy now.
+ *
+ *   gain(p) = (hit(n + step) - hit(n)) * pins
+ *   loss(p) = (hit(n) - hit(n - step)) * pins
+ *
+ * A round first gives free frames to the pool with largest gain. Then
+ * while the largest gain of one pool beats the smallest loss of
+ * another by PM_HYSTERESIS, step frames move from the second to the
+ * first. A shrinking pool may keep frames of pinned pages, only the
+ * frames it gave up move.
+ */
+
+// Gain must beat loss by this factor, so frames do not flip back and
+// forth on noise of sampled curves
+#define PM_HYSTERESIS 1.2
+
+// Not a interface
+static int findPool(PM_PoolManager *pm, BM_BufferPool *bm);
+static double gainOf(PM_PoolManager *pm, PM_Pool *p, long long pins);
+static double lossOf(PM_PoolManager *pm, PM_Pool *p, long long pins);
+static int growPool(PM_PoolManager *pm, PM_Pool *p, int frames);
+static void *rebalanceThread(void *arg);
+
+static int findPool(PM_PoolManager *pm, BM_BufferPool *bm)
+{
+  int i;
+
+  for (i=0; i < pm->numPools; i++)
+    if (pm->pools[i].bm == bm)
+      return i;
+  return -1;
+}
+
+// Hits step more frames would have given, 0 if pool can not grow
+static double gainOf(PM_PoolManager *pm, PM_Pool *p, long long pins)
+{
+  int n= p->bm->numPages, more;
+  double now, then;
+
+  more= n + pm->step <= p->maxPages ? pm->step : p->maxPages - n;
+  if (more <= 0 || pins == 0)
+    return 0;
+  getPredictedHitRatio(p->bm, n, &now);
+  getPredictedHitRatio(p->bm, n + more, &then);
+  return (then - now) * pins;
+}
+
+// Hits lost with step frames less, -1 if pool can not shrink
+static double lossOf(PM_PoolManager *pm, PM_Pool *p, long long pins)
+{
+  int n= p->bm->numPages;
+  double now, then;
+
+  if (n - pm->step < p->minPages)
+    return -1;
+  if (pins == 0)
+    return 0;
+  getPredictedHitRatio(p->bm, n, &now);
+  getPredictedHitRatio(p->bm, n - pm->step, &then);
+  return (now - then) * pins;
+}
+
+// Grow by up to frames within maxPages, returns frames added
+static int growPool(PM_PoolManager *pm, PM_Pool *p, int frames)
+{
+  int n= p->bm->numPages;
+
+  if (n + frames > p->maxPages)
+    frames= p->maxPages - n;
+  if (frames <= 0 || resizeBufferPool(p->bm, n + frames) != RC_OK)
+    return 0;
+  pm->used+= frames;
+  return frames;
+}
+
+RC initPoolManager (PM_PoolManager *pm, int budget, int step,
+                    double sampleRate)
+{
+  if (budget <= 0 || step <= 0)
+    RETURN(RC_POOL_INVALID_SIZE);
+  if (sampleRate <= 0 || sampleRate > 1)
+    RETURN(RC_MRC_INVALID_PARAM);
+
+  pm->budget= budget;
+  pm->used= 0;
+  pm->step= step;
+  pm->sampleRate= sampleRate;
+  pm->numPools= 0;
+  pm->capacity= 4;
+  pm->pools= (PM_Pool*) malloc(pm->capacity * sizeof(PM_Pool));
+  pm->running= FALSE;
+  pthread_mutex_init(&pm->mutex, NULL);
+  pthread_cond_init(&pm->cond, NULL);
+  RETURN(RC_OK);
+}
+
+RC shutdownPoolManager (PM_PoolManager *pm)
+{
+  RC rc;
+
+  stopRebalancing(pm);
+  while (pm->numPools > 0)
+  {
+    rc= removeManagedPool(pm, pm->pools[pm->numPools - 1].bm);
+    if (rc != RC_OK)
+      RETURN(rc);
+  }
+
+  free(pm->pools);
+  pthread_cond_destroy(&pm->cond);
+  pthread_mutex_destroy(&pm->mutex);
+  RETURN(RC_OK);
+}
+
+RC addManagedPool (PM_PoolManager *pm, BM_BufferPool *const bm,
+                   const char *const pageFileName,
+                   ReplacementStrategy strategy, int minPages, int maxPages)
+{
+  PM_Pool *p;
+  RC rc;
+
+  if (minPages <= 0 || maxPages < minPages)
+    RETURN(RC_POOL_INVALID_SIZE);
+
+  pthread_mutex_lock(&pm->mutex);
+  if (pm->used + minPages > pm->budget)
+  {
+    pthread_mutex_unlock(&pm->mutex);
+    RETURN(RC_POOL_BUDGET_EXCEEDED);
+  }
+
+  // Room for pool first, nothing to undo if it can not be had
+  if (pm->numPools == pm->capacity)
+  {
+    p= (PM_Pool*) realloc(pm->pools, 2 * pm->capacity * sizeof(PM_Pool));
+    if (p == NULL)
+    {
+      pthread_mutex_unlock(&pm->mutex);
+      RETURN(RC_WRITE_FAILED);
+    }
+    pm->pools= p;
+    pm->capacity*= 2;
+  }
+
+  rc= initBufferPool(bm, pageFileName, minPages, strategy, NULL);
+  if (rc != RC_OK)
+  {
+    pthread_mutex_unlock(&pm->mutex);
+    RETURN(rc);
+  }
+  rc= enableMissRatioTracking(bm, maxPages, pm->sampleRate);
+  if (rc != RC_OK)
+  {
+    shutdownBufferPool(bm);
+    pthread_mutex_unlock(&pm->mutex);
+    RETURN(rc);
+  }
+
+  p= &pm->pools[pm->numPools++];
+  p->bm= bm;
+  p->minPages= minPages;
+  p->maxPages= maxPages;
+  p->lastPins= 0;
+  pm->used+= minPages;
+
+  pthread_mutex_unlock(&pm->mutex);
+  RETURN(RC_OK);
+}
+
+RC removeManagedPool (PM_PoolManager *pm, BM_BufferPool *const bm)
+{
+  int i, numPages;
+  RC rc;
+
+  pthread_mutex_lock(&pm->mutex);
+  i= findPool(pm, bm);
+  if (i < 0)
+  {
+    pthread_mutex_unlock(&pm->mutex);
+    RETURN(RC_POOL_NOT_MANAGED);
+  }
+
+  numPages= bm->numPages;
+  rc= shutdownBufferPool(bm);
+  if (rc != RC_OK)
+  {
+    pthread_mutex_unlock(&pm->mutex);
+    RETURN(rc);
+  }
+  pm->used-= numPages;
+  pm->pools[i]= pm->pools[--pm->numPools];
+
+  pthread_mutex_unlock(&pm->mutex);
+  RETURN(RC_OK);
+}
+
+int getFreeFrames (PM_PoolManager *pm)
+{
+  int freeFrames;
+
+  pthread_mutex_lock(&pm->mutex);
+  freeFrames= pm->budget - pm->used;
+  pthread_mutex_unlock(&pm->mutex);
+  return freeFrames;
+}
+
+/**************************************************
+ * Rebalancing
+ */
+RC rebalancePools (PM_PoolManager *pm, int *moved)
+{
+  BM_PoolStats stats;
+  long long *pins;
+  double gain, loss, g, l;
+  int i, to, from, before, given, round;
+
+  *moved= 0;
+  pthread_mutex_lock(&pm->mutex);
+  if (pm->numPools == 0)
+  {
+    pthread_mutex_unlock(&pm->mutex);
+    RETURN(RC_OK);
+  }
+
+  pins= (long long*) malloc(pm->numPools * sizeof(long long));
+  for (i=0; i < pm->numPools; i++)
+  {
+    getPoolStats(pm->pools[i].bm, &stats);
+    pins[i]= stats.hits + stats.misses - pm->pools[i].lastPins;
+    if (pins[i] < 0)  // Stats were reset
+      pins[i]= stats.hits + stats.misses;
+    pm->pools[i].lastPins= stats.hits + stats.misses;
+  }
+
+  // Each pass moves step frames at most, every pool can take part
+  // in a few moves per round
+  for (round=0; round < 2 * pm->numPools; round++)
+  {
+    to= -1;
+    gain= 0;
+    for (i=0; i < pm->numPools; i++)
+    {
+      g= gainOf(pm, &pm->pools[i], pins[i]);
+      if (g > gain)
+      {
+        gain= g;
+        to= i;
+      }
+    }
+    if (to < 0)
+      break;
+
+    // Free frames first
+    if (pm->used < pm->budget)
+    {
+      given= growPool(pm, &pm->pools[to],
+                      pm->budget - pm->used < pm->step
+                      ? pm->budget - pm->used : pm->step);
+      *moved+= given;
+      if (given == 0)
+        break;
+      continue;
+    }
+
+    from= -1;
+    loss= 0;
+    for (i=0; i < pm->numPools; i++)
+    {
+      if (i == to)
+        continue;
+      l= lossOf(pm, &pm->pools[i], pins[i]);
+      if (l >= 0 && (from < 0 || l < loss))
+      {
+        loss= l;
+        from= i;
+      }
+    }
+    if (from < 0 || gain <= loss * PM_HYSTERESIS)
+      break;
+
+    // Shrink may stop early at pinned pages
+    before= pm->pools[from].bm->numPages;
+    resizeBufferPool(pm->pools[from].bm, before - pm->step);
+    pm->used-= before - pm->pools[from].bm->numPages;
+    given= growPool(pm, &pm->pools[to], before - pm->pools[from].bm->numPages);
+    *moved+= given;
+    if (given == 0)
+      break;
+  }
+
+  free(pins);
+  pthread_mutex_unlock(&pm->mutex);
+  RETURN(RC_OK);
+}
+
+static void *rebalanceThread(void *arg)
+{
+  PM_PoolManager *pm= (PM_PoolManager*) arg;
+  struct timespec until;
+  int moved;
+
+  pthread_mutex_lock(&pm->mutex);
+  while (pm->running)
+  {
+    clock_gettime(CLOCK_REALTIME, &until);
+    until.tv_sec+= pm->periodMs / 1000;
+    until.tv_nsec+= (long) (pm->periodMs % 1000) * 1000000;
+    if (until.tv_nsec >= 1000000000)
+    {
+      until.tv_sec++;
+      until.tv_nsec-= 1000000000;
+    }
+    if (pthread_cond_timedwait(&pm->cond, &pm->mutex, &until) != ETIMEDOUT)
+      continue;
+
+    pthread_mutex_unlock(&pm->mutex);
+    rebalancePools(pm, &moved);
+    pthread_mutex_lock(&pm->mutex);
+  }
+  pthread_mutex_unlock(&pm->mutex);
+  return NULL;
+}
+
+// Rebalance every periodMs on a thread of the pool manager
+RC startRebalancing (PM_PoolManager *pm, int periodMs)
+{
+  if (periodMs <= 0)
+    RETURN(RC_POOL_INVALID_SIZE);
+
+  pthread_mutex_lock(&pm->mutex);
+  if (pm->running)
+  {
+    pthread_mutex_unlock(&pm->mutex);
+    RETURN(RC_OK);
+  }
+  pm->running= TRUE;
+  pm->periodMs= periodMs;
+  pthread_mutex_unlock(&pm->mutex);
+
+  if (pthread_create(&pm->thread, NULL, rebalanceThread, pm) != 0)
+  {
+    // Nothing to join, stopRebalancing must see it stopped
+    pthread_mutex_lock(&pm->mutex);
+    pm->running= FALSE;
+    pthread_mutex_unlock(&pm->mutex);
+    RETURN(RC_POOL_THREAD_FAILED);
+  }
+  RETURN(RC_OK);
+}
+
+RC stopRebalancing (PM_PoolManager *pm)
+{
+  pthread_mutex_lock(&pm->mutex);
+  if (!pm->running)
+  {
+    pthread_mutex_unlock(&pm->mutex);
+    RETURN(RC_OK);
+  }
+  pm->running= FALSE;
+  pthread_cond_signal(&pm->cond);
+  pthread_mutex_unlock(&pm->mutex);
+
+  pthread_join(pm->thread, NULL);
+  RETURN(RC_OK);
+}
@@ -0,0 +1,60 @@
+#ifndef POOL_MGR_H
+#define POOL_MGR_H
+
+#include <pthread.h>
+
+#include "dberror.h"
+#include "buffer_mgr.h"
+
+/*
+ * Pool manager, one budget of frames shared by many buffer pools.
+ *
+ * Pools start with their minimum size. rebalancePools hands out free
+ * frames and moves frames from pools that would lose least hits to
+ * pools that would gain most, step frames at a time, keeping every
+ * pool within its minimum and maximum size.
+ */
+typedef struct PM_Pool {
+  BM_BufferPool *bm;
+  int minPages;
+  int maxPages;
+  long long lastPins;       // hits + misses at last rebalance
+} PM_Pool;
+
+typedef struct PM_PoolManager {
+  int budget;               // Frames of all pools together
+  int used;                 // Frames held by pools
+  int step;                 // Frames moved at a time
+  double sampleRate;        // Of miss ratio tracking in pools
+  PM_Pool *pools;
+  int numPools;
+  int capacity;
+  pthread_mutex_t mutex;    // Guards all of the above
+
+  // Background rebalancing
+  pthread_t thread;
+  pthread_cond_t cond;
+  bool running;
+  int periodMs;
+} PM_PoolManager;
+
+extern RC initPoolManager (PM_PoolManager *pm, int budget, int step,
+                           double sampleRate);
+// Stops rebalancing and shuts down all pools still managed
+extern RC shutdownPoolManager (PM_PoolManager *pm);
+
+// Pool is created with minPages frames taken from the budget
+extern RC addManagedPool (PM_PoolManager *pm, BM_BufferPool *const bm,
+                          const char *const pageFileName,
+                          ReplacementStrategy strategy,
+                          int minPages, int maxPages);
+// Pool is shut down and its frames go back to the budget
+extern RC removeManagedPool (PM_PoolManager *pm, BM_BufferPool *const bm);
+extern int getFreeFrames (PM_PoolManager *pm);
+
+// One round, moved is number of frames that changed pool
+extern RC rebalancePools (PM_PoolManager *pm, int *moved);
+extern RC startRebalancing (PM_PoolManager *pm, int periodMs);
+extern RC stopRebalancing (PM_PoolManager *pm);
+
+#endif // POOL_MGR_H
@@ -0,0 +1,1243 @@
+#include "record_mgr.h"
+#include <string.h>
+#include <stdlib.h>
+
+/*
+ * Heap file record manager
+ *
+ * Table is a page file managed by its own buffer pool.
+ * | FSM map 0 | Table header 1 | Data pages ... |
+ *
+ * Data pages are allocated and freed through the free space map,
+ * which is also the free space directory used to place inserts.
+ * Free space of a data page is reported to it after every change.
+ *
+ * Tuples are stored encoded, DT_STRING attributes only take their
+ * actual length plus a 2 byte length prefix. So tuples are variable
+ * length on page even though Record data has fixed layout.
+ *
+ * Update that does not fit in its page moves the tuple to an other
+ * page. Home slot then keeps a forward RID, so RID handed out on
+ * insert stays valid until tuple is deleted.
+ */
+
+// On disk table header, followed by attribute info, key attributes
+// and attribute names.
+typedef struct RM_TableHeader {
+  int magic;
+  int numTuples;
+  int numAttr;
+  int keySize;
+} RM_TableHeader;
+
+typedef struct RM_AttrInfo {
+  int dataType;
+  int typeLength;
+} RM_AttrInfo;
+
+#define STRING_LEN_BYTES sizeof(unsigned short)
+#define MIN_STORED_LEN   ((int) sizeof(RID)) // Room for a forward RID
+#define STORED_LEN(len)  ((len) < MIN_STORED_LEN ? MIN_STORED_LEN : (len))
+#define HEADER_PAGE      (FSM_MAP_PAGE(0) + 1)
+
+#define TABLE_MGMT(rel)  ((RM_TableMgmtData*) (rel)->mgmtData)
+
+// Not a interface
+static int attrSize(Schema *schema, int attrNum);
+static int attrOffset(Schema *schema, int attrNum);
+static int maxEncodedSize(Schema *schema);
+static int encodeTuple(Schema *schema, char *data, char *out);
+static void decodeTuple(Schema *schema, char *in, char *data);
+static void initDataPage(char *page);
+static void compactPage(char *page);
+static int pagePutTuple(char *page, char *tuple, int len, int flags);
+static void pageRemoveTuple(char *page, int slotNo);
+static bool pageReplaceTuple(char *page, int slotNo, char *tuple, int len);
+static int pageAvailable(char *page);
+static RC pinSlot(RM_TableMgmtData *tbl, RID id, BM_PageHandle *ph,
+                  RM_Slot **slot);
+static RC pinMovedSlot(RM_TableMgmtData *tbl, RID home, RID target,
+                       BM_PageHandle *ph, RM_Slot **slot);
+static bool forwardsTo(RM_TableMgmtData *tbl, RID home, RID target);
+static RC placeTuple(RM_TableMgmtData *tbl, char *tuple, int len, int flags,
+                     RID *rid);
+static RC releaseDataPage(RM_TableMgmtData *tbl, BM_PageHandle *ph);
+static RC checkSchema(Schema *schema);
+static void formatTableHeader(Schema *schema, int numTuples, char *page);
+static RC finishLoadPage(RM_TableLoad *load);
+static void extractColumns(Schema *schema, VE_Predicate *pred, char *tuple,
+                           int row);
+static void selectPage(Schema *schema, RM_ScanMgmtData *sm);
+static bool readScanSlot(RM_TableData *rel, RM_ScanMgmtData *sm, int slotNo,
+                         Record *record);
+
+/**************************************************
+ * Tuple encoding
+ */
+static int attrSize(Schema *schema, int attrNum)
+{
+  switch (schema->dataTypes[attrNum])
+  {
+    case DT_INT:
+      return sizeof(int);
+    case DT_FLOAT:
+      return sizeof(float);
+    case DT_BOOL:
+      return sizeof(bool);
+    case DT_STRING:
+      return schema->typeLength[attrNum];
+  }
+  return 0;
+}
+
+static int attrOffset(Schema *schema, int attrNum)
+{
+  int i, offset= 0;
+  for (i=0; i < attrNum; i++)
+    offset+= attrSize(schema, i);
+  return offset;
+}
+
+static int maxEncodedSize(Schema *schema)
+{
+  int i, size= 0;
+  for (i=0; i < schema->numAttr; i++)
+  {
+    size+= attrSize(schema, i);
+    if (schema->dataTypes[i] == DT_STRING)
+      size+= STRING_LEN_BYTES;
+  }
+  return size;
+}
+
+// Encode fixed layout record data, returns encoded length.
+static int encodeTuple(Schema *schema, char *data, char *out)
+{
+  int i, size, len= 0;
+  unsigned short strLen;
+
+  for (i=0; i < schema->numAttr; i++)
+  {
+    size= attrSize(schema, i);
+    if (schema->dataTypes[i] == DT_STRING)
+    {
+      // Only store used part of string
+      strLen= (unsigned short) strnlen(data, size);
+      memcpy(&out[len], &strLen, STRING_LEN_BYTES);
+      len+= STRING_LEN_BYTES;
+      memcpy(&out[len], data, strLen);
+      len+= strLen;
+    }
+    else
+    {
+      memcpy(&out[len], data, size);
+      len+= size;
+    }
+    data+= size;
+  }
+
+  return len;
+}
+
+// Decode tuple into fixed layout record data
+static void decodeTuple(Schema *schema, char *in, char *data)
+{
+  int i, size;
+  unsigned short strLen;
+
+  for (i=0; i < schema->numAttr; i++)
+  {
+    size= attrSize(schema, i);
+    if (schema->dataTypes[i] == DT_STRING)
+    {
+      memcpy(&strLen, in, STRING_LEN_BYTES);
+      in+= STRING_LEN_BYTES;
+      memset(data, 0, size);
+      memcpy(data, in, strLen);
+      in+= strLen;
+    }
+    else
+    {
+      memcpy(data, in, size);
+      in+= size;
+    }
+    data+= size;
+  }
+}
+
+/**************************************************
+ * Slotted page functions, work on pinned page data.
+ */
+static void initDataPage(char *page)
+{
+  RM_PageHeader *hdr= (RM_PageHeader*) page;
+  hdr->magic= RM_PAGE_MAGIC;
+  hdr->numSlots= 0;
+  hdr->numLive= 0;
+  hdr->freeStart= sizeof(RM_PageHeader);
+  hdr->freeEnd= PAGE_SIZE;
+  hdr->freeBytes= PAGE_SIZE - sizeof(RM_PageHeader);
+}
+
+// Move all tuples to end of page, so that free space is contiguous.
+static void compactPage(char *page)
+{
+  RM_PageHeader *hdr= (RM_PageHeader*) page;
+  RM_Slot *slots= RM_SLOTS(page);
+  char tmp[PAGE_SIZE];
+  int i, pos= PAGE_SIZE;
+
+  for (i=0; i < hdr->numSlots; i++)
+  {
+    if (slots[i].flags == RM_SLOT_FREE)
+      continue;
+    pos-= slots[i].length;
+    memcpy(&tmp[pos], &page[slots[i].offset], slots[i].length);
+    slots[i].offset= pos;
+  }
+
+  memcpy(&page[pos], &tmp[pos], PAGE_SIZE - pos);
+  hdr->freeEnd= pos;
+}
+
+// Bytes a new tuple can use, new slot may be needed for it.
+static int pageAvailable(char *page)
+{
+  int avail= ((RM_PageHeader*) page)->freeBytes - (int) sizeof(RM_Slot);
+  return avail < 0 ? 0 : avail;
+}
+
+// Store tuple in page, caller checked pageAvailable. Returns slot number.
+static int pagePutTuple(char *page, char *tuple, int len, int flags)
+{
+  RM_PageHeader *hdr= (RM_PageHeader*) page;
+  RM_Slot *slots= RM_SLOTS(page);
+  int slotNo, newSlot;
+
+  for (slotNo=0; slotNo < hdr->numSlots; slotNo++)
+    if (slots[slotNo].flags == RM_SLOT_FREE)
+      break;
+  newSlot= (slotNo == hdr->numSlots) ? sizeof(RM_Slot) : 0;
+
+  if (hdr->freeEnd - hdr->freeStart < len + newSlot)
+    compactPage(page);
+
+  if (newSlot)
+  {
+    hdr->numSlots++;
+    hdr->freeStart+= newSlot;
+    hdr->freeBytes-= newSlot;
+  }
+
+  hdr->freeEnd-= len;
+  memcpy(&page[hdr->freeEnd], tuple, len);
+  slots[slotNo].offset= hdr->freeEnd;
+  slots[slotNo].length= len;
+  slots[slotNo].flags= flags;
+  hdr->freeBytes-= len;
+  hdr->numLive++;
+
+  return slotNo;
+}
+
+static void pageRemoveTuple(char *page, int slotNo)
+{
+  RM_PageHeader *hdr= (RM_PageHeader*) page;
+  RM_Slot *slots= RM_SLOTS(page);
+
+  hdr->freeBytes+= slots[slotNo].length;
+  if (slots[slotNo].offset == hdr->freeEnd)
+    hdr->freeEnd+= slots[slotNo].length;
+  slots[slotNo].flags= RM_SLOT_FREE;
+  slots[slotNo].length= 0;
+  hdr->numLive--;
+
+  // Give back trailing free slots
+  while (hdr->numSlots > 0 && slots[hdr->numSlots-1].flags == RM_SLOT_FREE)
+  {
+    hdr->numSlots--;
+    hdr->freeStart-= sizeof(RM_Slot);
+    hdr->freeBytes+= sizeof(RM_Slot);
+  }
+}
+
+// Replace tuple of a slot keeping its flags, FALSE if page has no room.
+static bool pageReplaceTuple(char *page, int slotNo, char *tuple, int len)
+{
+  RM_PageHeader *hdr= (RM_PageHeader*) page;
+  RM_Slot *slot= &RM_SLOTS(page)[slotNo];
+  int flags= slot->flags;
+
+  // Shrinking tuple is updated in place
+  if (len <= slot->length)
+  {
+    memcpy(&page[slot->offset], tuple, len);
+    hdr->freeBytes+= slot->length - len;
+    slot->length= len;
+    return TRUE;
+  }
+
+  if (hdr->freeBytes + slot->length < len)
+    return FALSE;
+
+  // Drop old image, compaction must not keep it.
+  hdr->freeBytes+= slot->length;
+  if (slot->offset == hdr->freeEnd)
+    hdr->freeEnd+= slot->length;
+  slot->flags= RM_SLOT_FREE;
+  if (hdr->freeEnd - hdr->freeStart < len)
+    compactPage(page);
+
+  hdr->freeEnd-= len;
+  memcpy(&page[hdr->freeEnd], tuple, len);
+  slot->offset= hdr->freeEnd;
+  slot->length= len;
+  slot->flags= flags;
+  hdr->freeBytes-= len;
+  return TRUE;
+}
+
+/**************************************************
+ * Table page helpers
+ */
+
+// Pin page of a RID and check that slot holds a record
+static RC pinSlot(RM_TableMgmtData *tbl, RID id, BM_PageHandle *ph,
+                  RM_Slot **slot)
+{
+  RM_PageHeader *hdr;
+  RC rc;
+
+  if (id.page <= HEADER_PAGE || FSM_IS_MAP_PAGE(id.page) || id.slot < 0
+      || id.page >= ((BM_Pool_MgmtData*) tbl->bm.mgmtData)->fh.totalNumPages)
+    RETURN(RC_RM_NO_SUCH_RECORD);
+
+  rc= pinPage(&tbl->bm, ph, id.page);
+  if (rc != RC_OK)
+    RETURN(rc);
+
+  hdr= (RM_PageHeader*) ph->data;
+  if (hdr->magic != RM_PAGE_MAGIC || id.slot >= hdr->numSlots)
+  {
+    unpinPage(&tbl->bm, ph);
+    RETURN(RC_RM_NO_SUCH_RECORD);
+  }
+
+  *slot= &RM_SLOTS(ph->data)[id.slot];
+  RETURN(RC_OK);
+}
+
+// Pin slot a forward RID of home points to, and check that it still
+// holds the tuple moved out of home.
+static RC pinMovedSlot(RM_TableMgmtData *tbl, RID home, RID target,
+                       BM_PageHandle *ph, RM_Slot **slot)
+{
+  RID back;
+  RC rc;
+
+  rc= pinSlot(tbl, target, ph, slot);
+  if (rc != RC_OK)
+    RETURN(rc);
+
+  if ((*slot)->flags == RM_SLOT_MOVED)
+  {
+    memcpy(&back, &ph->data[(*slot)->offset], sizeof(RID));
+    if (back.page == home.page && back.slot == home.slot)
+      RETURN(RC_OK);
+  }
+  unpinPage(&tbl->bm, ph);
+  RETURN(RC_RM_NO_SUCH_RECORD);
+}
+
+// Does slot home still forward to target?
+static bool forwardsTo(RM_TableMgmtData *tbl, RID home, RID target)
+{
+  BM_PageHandle ph;
+  RM_Slot *slot;
+  RID forward;
+  bool result= FALSE;
+
+  if (pinSlot(tbl, home, &ph, &slot) != RC_OK)
+    return FALSE;
+  if (slot->flags == RM_SLOT_FORWARD)
+  {
+    memcpy(&forward, &ph.data[slot->offset], sizeof(RID));
+    result= forward.page == target.page && forward.slot == target.slot;
+  }
+  unpinPage(&tbl->bm, &ph);
+  return result;
+}
+
+// Store tuple in page chosen by free space map
+static RC placeTuple(RM_TableMgmtData *tbl, char *tuple, int len, int flags,
+                     RID *rid)
+{
+  BM_PageHandle ph;
+  PageNumber pn;
+  bool newPage= FALSE;
+  RC rc;
+
+  rc= findPageWithFreeSpace(&tbl->fsm, len, &pn);
+  if (rc == RC_NO_PAGE_WITH_FREE_SPACE)
+  {
+    rc= allocatePage(&tbl->fsm, &pn);
+    newPage= TRUE;
+  }
+  if (rc != RC_OK)
+    RETURN(rc);
+
+  rc= pinPage(&tbl->bm, &ph, pn);
+  if (rc != RC_OK)
+  {
+    if (newPage)
+      freePage(&tbl->fsm, pn);
+    RETURN(rc);
+  }
+  if (newPage)
+    initDataPage(ph.data);
+
+  rid->page= pn;
+  rid->slot= pagePutTuple(ph.data, tuple, len, flags);
+  markDirty(&tbl->bm, &ph);
+  rc= setPageFreeSpace(&tbl->fsm, pn, pageAvailable(ph.data));
+  unpinPage(&tbl->bm, &ph);
+
+  RETURN(rc);
+}
+
+// Report free space of modified page, give it back if it is empty.
+// Unpins the page.
+static RC releaseDataPage(RM_TableMgmtData *tbl, BM_PageHandle *ph)
+{
+  RM_PageHeader *hdr= (RM_PageHeader*) ph->data;
+  RC rc;
+
+  markDirty(&tbl->bm, ph);
+  if (hdr->numLive == 0)
+  {
+    // Scans skip pages without magic
+    memset(hdr, 0, sizeof(RM_PageHeader));
+    rc= freePage(&tbl->fsm, ph->pageNum);
+  }
+  else
+    rc= setPageFreeSpace(&tbl->fsm, ph->pageNum, pageAvailable(ph->data));
+  unpinPage(&tbl->bm, ph);
+
+  RETURN(rc);
+}
+
+/**************************************************
+ * table and manager
+ */
+RC initRecordManager (void *mgmtData)
+{
+  initStorageManager();
+  RETURN(RC_OK);
+}
+
+RC shutdownRecordManager ()
+{
+  RETURN(RC_OK);
+}
+
+// Check that tuples and header of schema fit in pages.
+static RC checkSchema(Schema *schema)
+{
+  int i, size;
+
+  if (maxEncodedSize(schema) > PAGE_SIZE - (int) (sizeof(RM_PageHeader)
+                                     + sizeof(RM_Slot) + sizeof(RID)))
+    RETURN(RC_RM_TUPLE_TOO_BIG);
+
+  // Header must fit in its page
+  size= sizeof(RM_TableHeader) + schema->numAttr * sizeof(RM_AttrInfo)
+        + schema->keySize * sizeof(int);
+  for (i=0; i < schema->numAttr; i++)
+    size+= strlen(schema->attrNames[i]) + 1;
+  if (size > PAGE_SIZE)
+    RETURN(RC_RM_SCHEMA_TOO_BIG);
+
+  RETURN(RC_OK);
+}
+
+static void formatTableHeader(Schema *schema, int numTuples, char *page)
+{
+  RM_TableHeader *hdr;
+  RM_AttrInfo *attrs;
+  char *pos;
+  int i;
+
+  memset(page, 0, PAGE_SIZE);
+  hdr= (RM_TableHeader*) page;
+  hdr->magic= RM_TABLE_MAGIC;
+  hdr->numTuples= numTuples;
+  hdr->numAttr= schema->numAttr;
+  hdr->keySize= schema->keySize;
+
+  attrs= (RM_AttrInfo*) (hdr + 1);
+  for (i=0; i < schema->numAttr; i++)
+  {
+    attrs[i].dataType= schema->dataTypes[i];
+    attrs[i].typeLength= schema->typeLength[i];
+  }
+  pos= (char*) &attrs[schema->numAttr];
+  memcpy(pos, schema->keyAttrs, schema->keySize * sizeof(int));
+  pos+= schema->keySize * sizeof(int);
+  for (i=0; i < schema->numAttr; i++)
+  {
+    strcpy(pos, schema->attrNames[i]);
+    pos+= strlen(schema->attrNames[i]) + 1;
+  }
+}
+
+RC createTable (char *name, Schema *schema)
+{
+  BM_BufferPool bm;
+  BM_PageHandle ph;
+  FSM_Handle fsm;
+  PageNumber headerPage;
+  RC rc;
+
+  rc= checkSchema(schema);
+  if (rc != RC_OK)
+    RETURN(rc);
+
+  rc= createPageFile(name);
+  if (rc != RC_OK)
+    RETURN(rc);
+  rc= initBufferPool(&bm, name, RM_POOL_PAGES, RS_LRU, NULL);
+  if (rc != RC_OK)
+    RETURN(rc);
+  rc= initFreeSpaceMap(&fsm, &bm);
+  if (rc != RC_OK)
+  {
+    shutdownBufferPool(&bm);
+    RETURN(rc);
+  }
+
+  // First page allocated is table header, it never takes tuples.
+  rc= allocatePage(&fsm, &headerPage);
+  if (rc == RC_OK)
+    rc= setPageFreeSpace(&fsm, headerPage, 0);
+  if (rc == RC_OK)
+    rc= pinPage(&bm, &ph, headerPage);
+  if (rc != RC_OK)
+  {
+    shutdownFreeSpaceMap(&fsm);
+    shutdownBufferPool(&bm);
+    RETURN(rc);
+  }
+
+  formatTableHeader(schema, 0, ph.data);
+  markDirty(&bm, &ph);
+  unpinPage(&bm, &ph);
+  shutdownFreeSpaceMap(&fsm);
+  return shutdownBufferPool(&bm);
+}
+
+RC openTable (RM_TableData *rel, char *name)
+{
+  RM_TableMgmtData *tbl;
+  BM_PageHandle ph;
+  RM_TableHeader *hdr;
+  RM_AttrInfo *attrs;
+  char **names;
+  DataType *types;
+  int *lengths, *keys;
+  char *pos;
+  int i;
+  RC rc;
+
+  tbl= (RM_TableMgmtData*) malloc(sizeof(RM_TableMgmtData));
+  rc= initBufferPool(&tbl->bm, name, RM_POOL_PAGES, RS_LRU, NULL);
+  if (rc != RC_OK)
+  {
+    free(tbl);
+    RETURN(rc);
+  }
+  // Header check catches files that are no tables
+  rc= initFreeSpaceMap(&tbl->fsm, &tbl->bm);
+  if (rc == RC_OK)
+    rc= pinPage(&tbl->bm, &ph, HEADER_PAGE);
+  if (rc != RC_OK || ((RM_TableHeader*) ph.data)->magic != RM_TABLE_MAGIC)
+  {
+    if (rc == RC_OK)
+      unpinPage(&tbl->bm, &ph);
+    shutdownFreeSpaceMap(&tbl->fsm);
+    shutdownBufferPool(&tbl->bm);
+    free(tbl);
+    RETURN(rc != RC_OK ? rc : RC_FILE_NOT_FOUND);
+  }
+
+  hdr= (RM_TableHeader*) ph.data;
+  tbl->headerPage= HEADER_PAGE;
+  tbl->numTuples= hdr->numTuples;
+
+  names= (char**) malloc(hdr->numAttr * sizeof(char*));
+  types= (DataType*) malloc(hdr->numAttr * sizeof(DataType));
+  lengths= (int*) malloc(hdr->numAttr * sizeof(int));
+  keys= (int*) malloc(hdr->keySize * sizeof(int));
+
+  attrs= (RM_AttrInfo*) (hdr + 1);
+  for (i=0; i < hdr->numAttr; i++)
+  {
+    types[i]= (DataType) attrs[i].dataType;
+    lengths[i]= attrs[i].typeLength;
+  }
+  pos= (char*) &attrs[hdr->numAttr];
+  memcpy(keys, pos, hdr->keySize * sizeof(int));
+  pos+= hdr->keySize * sizeof(int);
+  for (i=0; i < hdr->numAttr; i++)
+  {
+    names[i]= strdup(pos);
+    pos+= strlen(pos) + 1;
+  }
+
+  rel->schema= createSchema(hdr->numAttr, names, types, lengths,
+                            hdr->keySize, keys);
+  unpinPage(&tbl->bm, &ph);
+
+  rel->name= strdup(name);
+  rel->mgmtData= tbl;
+  RETURN(RC_OK);
+}
+
+RC closeTable (RM_TableData *rel)
+{
+  RM_TableMgmtData *tbl= TABLE_MGMT(rel);
+  BM_PageHandle ph;
+  RC rc;
+
+  // Persist tuple count
+  rc= pinPage(&tbl->bm, &ph, tbl->headerPage);
+  if (rc != RC_OK)
+    RETURN(rc);
+  ((RM_TableHeader*) ph.data)->numTuples= tbl->numTuples;
+  markDirty(&tbl->bm, &ph);
+  unpinPage(&tbl->bm, &ph);
+
+  shutdownFreeSpaceMap(&tbl->fsm);
+  rc= shutdownBufferPool(&tbl->bm);
+  if (rc != RC_OK)
+    RETURN(rc);
+
+  freeSchema(rel->schema);
+  free(rel->name);
+  free(tbl);
+  rel->schema= NULL;
+  rel->name= NULL;
+  rel->mgmtData= NULL;
+
+  RETURN(RC_OK);
+}
+
+RC deleteTable (char *name)
+{
+  return destroyPageFile(name);
+}
+
+int getNumTuples (RM_TableData *rel)
+{
+  return TABLE_MGMT(rel)->numTuples;
+}
+
+/**************************************************
+ * bulk loading of a new table
+ *
+ * Data pages are filled one after the other and written through
+ * a bulk writer, so loading neither searches free space nor goes
+ * through a buffer pool. Every page keeps (1 - fillFactor) of its
+ * space free for later updates.
+ */
+RC startTableLoad (RM_TableLoad **load, char *name, Schema *schema,
+                   float fillFactor)
+{
+  RM_TableLoad *l;
+  char *page;
+  RC rc;
+
+  rc= checkSchema(schema);
+  if (rc != RC_OK)
+    RETURN(rc);
+  if (fillFactor <= 0 || fillFactor > 1)
+    fillFactor= 1;
+
+  l= (RM_TableLoad*) malloc(sizeof(RM_TableLoad));
+  rc= startBulkWrite(&l->writer, name);
+  if (rc != RC_OK)
+  {
+    free(l);
+    RETURN(rc);
+  }
+
+  // Header page comes first like in createTable, it is written last.
+  rc= bulkAllocatePage(&l->writer, &l->headerPage, &page);
+  if (rc == RC_OK)
+    rc= bulkSetFreeSpace(&l->writer, l->headerPage, 0);
+  if (rc != RC_OK)
+  {
+    abortBulkWrite(&l->writer);
+    free(l);
+    RETURN(rc);
+  }
+
+  l->schema= schema;
+  l->page= NULL;
+  l->pageNum= NO_PAGE;
+  l->minFree= (int) ((1 - fillFactor) * (PAGE_SIZE - sizeof(RM_PageHeader)));
+  l->numTuples= 0;
+  *load= l;
+  RETURN(RC_OK);
+}
+
+// Report free space of filled page to map
+static RC finishLoadPage(RM_TableLoad *load)
+{
+  if (load->page == NULL)
+    RETURN(RC_OK);
+  return bulkSetFreeSpace(&load->writer, load->pageNum,
+                          pageAvailable(load->page));
+}
+
+RC loadRecord (RM_TableLoad *load, Record *record)
+{
+  char tuple[PAGE_SIZE];
+  int len;
+  RC rc;
+
+  len= STORED_LEN(encodeTuple(load->schema, record->data, tuple));
+
+  // Start new page when tuple would eat into reserved space
+  if (load->page == NULL || (((RM_PageHeader*) load->page)->numLive > 0
+      && pageAvailable(load->page) - len < load->minFree))
+  {
+    rc= finishLoadPage(load);
+    if (rc == RC_OK)
+      rc= bulkAllocatePage(&load->writer, &load->pageNum, &load->page);
+    if (rc != RC_OK)
+      RETURN(rc);
+    initDataPage(load->page);
+  }
+
+  record->id.page= load->pageNum;
+  record->id.slot= pagePutTuple(load->page, tuple, len, RM_SLOT_USED);
+  load->numTuples++;
+  RETURN(RC_OK);
+}
+
+RC finishTableLoad (RM_TableLoad *load)
+{
+  char header[PAGE_SIZE];
+  RC rc;
+
+  formatTableHeader(load->schema, load->numTuples, header);
+  rc= finishLoadPage(load);
+  if (rc == RC_OK)
+    rc= bulkWritePage(&load->writer, load->headerPage, header);
+  if (rc == RC_OK)
+    rc= finishBulkWrite(&load->writer);
+  else
+    abortBulkWrite(&load->writer);
+
+  free(load);
+  RETURN(rc);
+}
+
+/**************************************************
+ * handling records in a table
+ */
+RC insertRecord (RM_TableData *rel, Record *record)
+{
+  RM_TableMgmtData *tbl= TABLE_MGMT(rel);
+  char tuple[PAGE_SIZE];
+  int len;
+  RC rc;
+
+  len= encodeTuple(rel->schema, record->data, tuple);
+  rc= placeTuple(tbl, tuple, STORED_LEN(len), RM_SLOT_USED, &record->id);
+  if (rc != RC_OK)
+    RETURN(rc);
+
+  tbl->numTuples++;
+  RETURN(RC_OK);
+}
+
+RC deleteRecord (RM_TableData *rel, RID id)
+{
+  RM_TableMgmtData *tbl= TABLE_MGMT(rel);
+  BM_PageHandle ph, tph;
+  RM_Slot *slot, *tslot;
+  RID target;
+  RC rc;
+
+  rc= pinSlot(tbl, id, &ph, &slot);
+  if (rc != RC_OK)
+    RETURN(rc);
+
+  if (slot->flags != RM_SLOT_USED && slot->flags != RM_SLOT_FORWARD)
+  {
+    unpinPage(&tbl->bm, &ph);
+    RETURN(RC_RM_NO_SUCH_RECORD);
+  }
+
+  // Moved tuple goes away with its home slot
+  if (slot->flags == RM_SLOT_FORWARD)
+  {
+    memcpy(&target, &ph.data[slot->offset], sizeof(RID));
+    rc= pinMovedSlot(tbl, id, target, &tph, &tslot);
+    if (rc == RC_OK)
+    {
+      pageRemoveTuple(tph.data, target.slot);
+      rc= releaseDataPage(tbl, &tph);
+    }
+    if (rc != RC_OK)
+    {
+      unpinPage(&tbl->bm, &ph);
+      RETURN(rc);
+    }
+  }
+
+  pageRemoveTuple(ph.data, id.slot);
+  rc= releaseDataPage(tbl, &ph);
+  if (rc != RC_OK)
+    RETURN(rc);
+
+  tbl->numTuples--;
+  RETURN(RC_OK);
+}
+
+RC updateRecord (RM_TableData *rel, Record *record)
+{
+  RM_TableMgmtData *tbl= TABLE_MGMT(rel);
+  BM_PageHandle ph, tph;
+  RM_Slot *slot, *tslot;
+  char image[PAGE_SIZE];  // Home RID followed by tuple, for moved tuples
+  char *tuple= &image[sizeof(RID)];
+  int len;
+  RID target, moved;
+  RC rc;
+
+  len= encodeTuple(rel->schema, record->data, tuple);
+  memcpy(image, &record->id, sizeof(RID));
+
+  rc= pinSlot(tbl, record->id, &ph, &slot);
+  if (rc != RC_OK)
+    RETURN(rc);
+
+  if (slot->flags == RM_SLOT_USED)
+  {
+    if (pageReplaceTuple(ph.data, record->id.slot, tuple, STORED_LEN(len)))
+      return releaseDataPage(tbl, &ph);
+
+    // No room in home page, move tuple and leave forward RID behind.
+    rc= placeTuple(tbl, image, sizeof(RID) + len, RM_SLOT_MOVED, &moved);
+    if (rc != RC_OK)
+    {
+      unpinPage(&tbl->bm, &ph);
+      RETURN(rc);
+    }
+    pageReplaceTuple(ph.data, record->id.slot, (char*) &moved, sizeof(RID));
+    slot->flags= RM_SLOT_FORWARD;
+    return releaseDataPage(tbl, &ph);
+  }
+
+  if (slot->flags != RM_SLOT_FORWARD)
+  {
+    unpinPage(&tbl->bm, &ph);
+    RETURN(RC_RM_NO_SUCH_RECORD);
+  }
+
+  // Tuple was moved before, try to update it where it is.
+  memcpy(&target, &ph.data[slot->offset], sizeof(RID));
+  rc= pinMovedSlot(tbl, record->id, target, &tph, &tslot);
+  if (rc != RC_OK)
+  {
+    unpinPage(&tbl->bm, &ph);
+    RETURN(rc);
+  }
+  if (pageReplaceTuple(tph.data, target.slot, image, sizeof(RID) + len))
+  {
+    unpinPage(&tbl->bm, &ph);
+    return releaseDataPage(tbl, &tph);
+  }
+
+  // Old copy stays until new one is placed, failure changes nothing.
+  rc= placeTuple(tbl, image, sizeof(RID) + len, RM_SLOT_MOVED, &moved);
+  if (rc != RC_OK)
+  {
+    unpinPage(&tbl->bm, &tph);
+    unpinPage(&tbl->bm, &ph);
+    RETURN(rc);
+  }
+
+  // Forward RID has fixed size, it is always replaced in place.
+  memcpy(&ph.data[slot->offset], &moved, sizeof(RID));
+  markDirty(&tbl->bm, &ph);
+  unpinPage(&tbl->bm, &ph);
+
+  pageRemoveTuple(tph.data, target.slot);
+  return releaseDataPage(tbl, &tph);
+}
+
+RC getRecord (RM_TableData *rel, RID id, Record *record)
+{
+  RM_TableMgmtData *tbl= TABLE_MGMT(rel);
+  BM_PageHandle ph, tph;
+  RM_Slot *slot, *tslot;
+  RID target;
+  RC rc;
+
+  rc= pinSlot(tbl, id, &ph, &slot);
+  if (rc != RC_OK)
+    RETURN(rc);
+
+  if (slot->flags == RM_SLOT_USED)
+    decodeTuple(rel->schema, &ph.data[slot->offset], record->data);
+  else if (slot->flags == RM_SLOT_FORWARD)
+  {
+    memcpy(&target, &ph.data[slot->offset], sizeof(RID));
+    rc= pinMovedSlot(tbl, id, target, &tph, &tslot);
+    if (rc == RC_OK)
+    {
+      decodeTuple(rel->schema, &tph.data[tslot->offset + sizeof(RID)],
+                  record->data);
+      unpinPage(&tbl->bm, &tph);
+    }
+  }
+  else
+    rc= RC_RM_NO_SUCH_RECORD;
+  unpinPage(&tbl->bm, &ph);
+
+  if (rc != RC_OK)
+    RETURN(rc);
+  record->id= id;
+  RETURN(RC_OK);
+}
+
+/**************************************************
+ * scans
+ */
+RC startScan (RM_TableData *rel, RM_ScanHandle *scan, Expr *cond)
+{
+  RM_ScanMgmtData *sm;
+
+  sm= (RM_ScanMgmtData*) malloc(sizeof(RM_ScanMgmtData));
+  sm->cond= cond;
+  sm->pred= (cond != NULL) ? vePrepare(rel->schema, cond) : NULL;
+  sm->ph.pageNum= NO_PAGE;
+  sm->nextPage= HEADER_PAGE + 1;
+  sm->nextSlot= 0;
+  sm->numSel= 0;
+  sm->nextSel= 0;
+
+  scan->rel= rel;
+  scan->mgmtData= sm;
+  RETURN(RC_OK);
+}
+
+// Copy attributes used by batch condition into its columns
+static void extractColumns(Schema *schema, VE_Predicate *pred, char *tuple,
+                           int row)
+{
+  VE_Column *col;
+  unsigned short strLen;
+  bool boolV;
+  int i;
+
+  for (i=0; i < schema->numAttr; i++)
+  {
+    if (schema->dataTypes[i] == DT_STRING)
+    {
+      memcpy(&strLen, tuple, STRING_LEN_BYTES);
+      tuple+= STRING_LEN_BYTES + strLen;
+      continue;
+    }
+
+    col= &pred->cols[i];
+    if (col->used)
+    {
+      if (col->dt == DT_FLOAT)
+        memcpy(&col->v.floatV[row], tuple, sizeof(float));
+      else if (col->dt == DT_BOOL)
+      {
+        memcpy(&boolV, tuple, sizeof(bool));
+        col->v.intV[row]= boolV;
+      }
+      else
+        memcpy(&col->v.intV[row], tuple, sizeof(int));
+    }
+    tuple+= attrSize(schema, i);
+  }
+}
+
+// Evaluate batch condition over all tuples of pinned page, and
+// keep slots of matching ones.
+static void selectPage(Schema *schema, RM_ScanMgmtData *sm)
+{
+  RM_PageHeader *hdr= (RM_PageHeader*) sm->ph.data;
+  RM_Slot *slots= RM_SLOTS(sm->ph.data);
+  unsigned short rowSlots[VE_BATCH_SIZE];
+  unsigned short sel[VE_BATCH_SIZE];
+  int i, numRows= 0;
+
+  sm->numSel= 0;
+  sm->nextSel= 0;
+  if (hdr->magic != RM_PAGE_MAGIC)
+    return;
+
+  for (i=0; i < hdr->numSlots; i++)
+  {
+    if (slots[i].flags == RM_SLOT_USED)
+      extractColumns(schema, sm->pred, &sm->ph.data[slots[i].offset],
+                     numRows);
+    else if (slots[i].flags == RM_SLOT_MOVED)
+      extractColumns(schema, sm->pred,
+                     &sm->ph.data[slots[i].offset + sizeof(RID)], numRows);
+    else
+      continue;
+    rowSlots[numRows++]= i;
+  }
+
+  sm->numSel= veSelect(sm->pred, numRows, sel);
+  for (i=0; i < sm->numSel; i++)
+    sm->selSlots[i]= rowSlots[sel[i]];
+}
+
+// Decode tuple of a slot of scanned page, FALSE if slot has none.
+// Moved tuples are reported with their home RID, forward slots
+// are skipped. A moved tuple counts only while its home slot still
+// forwards to it.
+static bool readScanSlot(RM_TableData *rel, RM_ScanMgmtData *sm, int slotNo,
+                         Record *record)
+{
+  RM_Slot *slot= &RM_SLOTS(sm->ph.data)[slotNo];
+  Schema *schema= rel->schema;
+  RID here;
+
+  if (slot->flags == RM_SLOT_USED)
+  {
+    record->id.page= sm->ph.pageNum;
+    record->id.slot= slotNo;
+    decodeTuple(schema, &sm->ph.data[slot->offset], record->data);
+    return TRUE;
+  }
+  if (slot->flags == RM_SLOT_MOVED)
+  {
+    memcpy(&record->id, &sm->ph.data[slot->offset], sizeof(RID));
+    here.page= sm->ph.pageNum;
+    here.slot= slotNo;
+    if (!forwardsTo(TABLE_MGMT(rel), record->id, here))
+      return FALSE;
+    decodeTuple(schema, &sm->ph.data[slot->offset + sizeof(RID)],
+                record->data);
+    return TRUE;
+  }
+  return FALSE;
+}
+
+// Returns next record matching condition. Page being scanned stays
+// pinned between calls, so scan pins every page once.
+// Conditions vePrepare compiled are evaluated for whole page at once,
+// others tuple at a time with evalExpr.
+RC next (RM_ScanHandle *scan, Record *record)
+{
+  RM_TableMgmtData *tbl= TABLE_MGMT(scan->rel);
+  RM_ScanMgmtData *sm= (RM_ScanMgmtData*) scan->mgmtData;
+  Schema *schema= scan->rel->schema;
+  RM_PageHeader *hdr;
+  Value *result;
+  int totalPages;
+  RC rc;
+
+  while (TRUE)
+  {
+    // Pin next data page
+    if (sm->ph.pageNum == NO_PAGE)
+    {
+      totalPages= ((BM_Pool_MgmtData*) tbl->bm.mgmtData)->fh.totalNumPages;
+      while (sm->nextPage < totalPages && FSM_IS_MAP_PAGE(sm->nextPage))
+        sm->nextPage++;
+      if (sm->nextPage >= totalPages)
+        RETURN(RC_RM_NO_MORE_TUPLES);
+
+      rc= pinPage(&tbl->bm, &sm->ph, sm->nextPage);
+      if (rc != RC_OK)
+        RETURN(rc);
+      sm->nextSlot= 0;
+      if (sm->pred != NULL)
+        selectPage(schema, sm);
+    }
+
+    if (sm->pred != NULL)
+    {
+      while (sm->nextSel < sm->numSel)
+        if (readScanSlot(scan->rel, sm, sm->selSlots[sm->nextSel++], record))
+          RETURN(RC_OK);
+    }
+    else
+    {
+      hdr= (RM_PageHeader*) sm->ph.data;
+      while (hdr->magic == RM_PAGE_MAGIC && sm->nextSlot < hdr->numSlots)
+      {
+        if (!readScanSlot(scan->rel, sm, sm->nextSlot++, record))
+          continue;
+        if (sm->cond == NULL)
+          RETURN(RC_OK);
+
+        rc= evalExpr(record, schema, sm->cond, &result);
+        if (rc != RC_OK)
+          RETURN(rc);
+        if (result->dt != DT_BOOL)
+        {
+          freeVal(result);
+          RETURN(RC_RM_EXPR_RESULT_IS_NOT_BOOLEAN);
+        }
+        if (result->v.boolV)
+        {
+          freeVal(result);
+          RETURN(RC_OK);
+        }
+        freeVal(result);
+      }
+    }
+
+    unpinPage(&tbl->bm, &sm->ph);
+    sm->ph.pageNum= NO_PAGE;
+    sm->nextPage++;
+  }
+}
+
+RC closeScan (RM_ScanHandle *scan)
+{
+  RM_TableMgmtData *tbl= TABLE_MGMT(scan->rel);
+  RM_ScanMgmtData *sm= (RM_ScanMgmtData*) scan->mgmtData;
+
+  if (sm->ph.pageNum != NO_PAGE)
+    unpinPage(&tbl->bm, &sm->ph);
+  veFree(sm->pred);
+  free(sm);
+  scan->mgmtData= NULL;
+
+  RETURN(RC_OK);
+}
+
+/**************************************************
+ * dealing with schemas
+ */
+int getRecordSize (Schema *schema)
+{
+  return attrOffset(schema, schema->numAttr);
+}
+
+// Schema takes ownership of passed arrays
+Schema *createSchema (int numAttr, char **attrNames, DataType *dataTypes,
+                      int *typeLength, int keySize, int *keys)
+{
+  Schema *schema= (Schema*) malloc(sizeof(Schema));
+  schema->numAttr= numAttr;
+  schema->attrNames= attrNames;
+  schema->dataTypes= dataTypes;
+  schema->typeLength= typeLength;
+  schema->keySize= keySize;
+  schema->keyAttrs= keys;
+  return schema;
+}
+
+RC freeSchema (Schema *schema)
+{
+  int i;
+  for (i=0; i < schema->numAttr; i++)
+    free(schema->attrNames[i]);
+  free(schema->attrNames);
+  free(schema->dataTypes);
+  free(schema->typeLength);
+  free(schema->keyAttrs);
+  free(schema);
+  RETURN(RC_OK);
+}
+
+/**************************************************
+ * dealing with records and attribute values
+ */
+RC createRecord (Record **record, Schema *schema)
+{
+  *record= (Record*) malloc(sizeof(Record));
+  (*record)->data= (char*) calloc(1, getRecordSize(schema));
+  (*record)->id.page= NO_PAGE;
+  (*record)->id.slot= -1;
+  RETURN(RC_OK);
+}
+
+RC freeRecord (Record *record)
+{
+  free(record->data);
+  free(record);
+  RETURN(RC_OK);
+}
+
+RC getAttr (Record *record, Schema *schema, int attrNum, Value **value)
+{
+  char *attr;
+  int size;
+
+  if (attrNum < 0 || attrNum >= schema->numAttr)
+    RETURN(RC_RM_UNKOWN_DATATYPE);
+
+  attr= record->data + attrOffset(schema, attrNum);
+  *value= (Value*) malloc(sizeof(Value));
+  (*value)->dt= schema->dataTypes[attrNum];
+
+  switch (schema->dataTypes[attrNum])
+  {
+    case DT_INT:
+      memcpy(&(*value)->v.intV, attr, sizeof(int));
+      break;
+    case DT_FLOAT:
+      memcpy(&(*value)->v.floatV, attr, sizeof(float));
+      break;
+    case DT_BOOL:
+      memcpy(&(*value)->v.boolV, attr, sizeof(bool));
+      break;
+    case DT_STRING:
+      size= schema->typeLength[attrNum];
+      (*value)->v.stringV= (char*) malloc(size + 1);
+      memcpy((*value)->v.stringV, attr, size);
+      (*value)->v.stringV[size]= '\0';
+      break;
+  }
+
+  RETURN(RC_OK);
+}
+
+RC setAttr (Record *record, Schema *schema, int attrNum, Value *value)
+{
+  char *attr;
+  int size;
+
+  if (attrNum < 0 || attrNum >= schema->numAttr)
+    RETURN(RC_RM_UNKOWN_DATATYPE);
+  if (value->dt != schema->dataTypes[attrNum])
+    RETURN(RC_RM_COMPARE_VALUE_OF_DIFFERENT_DATATYPE);
+
+  attr= record->data + attrOffset(schema, attrNum);
+  switch (value->dt)
+  {
+    case DT_INT:
+      memcpy(attr, &value->v.intV, sizeof(int));
+      break;
+    case DT_FLOAT:
+      memcpy(attr, &value->v.floatV, sizeof(float));
+      break;
+    case DT_BOOL:
+      memcpy(attr, &value->v.boolV, sizeof(bool));
+      break;
+    case DT_STRING:
+      // Unused tail is zero, encoding relies on it
+      size= schema->typeLength[attrNum];
+      memset(attr, 0, size);
+      strncpy(attr, value->v.stringV, size);
+      break;
+  }
+
+  RETURN(RC_OK);
+}
@@ -0,0 +1,124 @@
+#ifndef RECORD_MGR_H
+#define RECORD_MGR_H
+
+#include "dberror.h"
+#include "buffer_mgr.h"
+#include "free_space_mgr.h"
+#include "expr.h"
+#include "vector_eval.h"
+#include "tables.h"
+
+// Buffer pool used by every open table
+#define RM_POOL_PAGES 64
+
+/*
+ * Slotted page layout
+ * | RM_PageHeader | RM_Slot[numSlots] -> free space <- tuple data |
+ *
+ * Slot array grows forward from header, tuple data grows backward
+ * from end of page. Slot number never changes while tuple is alive,
+ * so RID stays valid when page is compacted.
+ */
+#define RM_PAGE_MAGIC  0x52534C54 // "RSLT"
+#define RM_TABLE_MAGIC 0x5254424C // "RTBL"
+
+// Slot states
+#define RM_SLOT_FREE    0
+#define RM_SLOT_USED    1
+#define RM_SLOT_FORWARD 2 // Tuple moved, data is RID of new place
+#define RM_SLOT_MOVED   3 // Tuple of other slot, data starts with home RID
+
+typedef struct RM_PageHeader {
+  int magic;
+  int numSlots;
+  int freeStart;  // End of slot array
+  int freeEnd;    // Start of tuple data
+  int freeBytes;  // Free bytes including holes left by deleted tuples
+  int numLive;    // Slots not free
+} RM_PageHeader;
+
+typedef struct RM_Slot {
+  unsigned short offset;
+  unsigned short length;
+  unsigned short flags;
+} RM_Slot;
+
+#define RM_SLOTS(page) ((RM_Slot*) ((page) + sizeof(RM_PageHeader)))
+
+// Management data of open table
+typedef struct RM_TableMgmtData {
+  BM_BufferPool bm;
+  FSM_Handle fsm;
+  PageNumber headerPage;
+  int numTuples;
+} RM_TableMgmtData;
+
+// State of a table being bulk loaded
+typedef struct RM_TableLoad {
+  Schema *schema;
+  FSM_BulkWriter writer;
+  PageNumber headerPage;
+  char *page;         // Data page being filled, NULL before first record
+  PageNumber pageNum;
+  int minFree;        // Bytes every page keeps free for updates
+  int numTuples;
+} RM_TableLoad;
+
+// Bookkeeping for scans
+typedef struct RM_ScanHandle
+{
+  RM_TableData *rel;
+  void *mgmtData;
+} RM_ScanHandle;
+
+typedef struct RM_ScanMgmtData {
+  Expr *cond;
+  VE_Predicate *pred; // Batch compiled cond, NULL if evalExpr is used
+  BM_PageHandle ph;   // Page being scanned, pinned if ph.pageNum != NO_PAGE
+  PageNumber nextPage;
+  int nextSlot;
+
+  // Slots of scanned page matching pred
+  unsigned short selSlots[VE_BATCH_SIZE];
+  int numSel;
+  int nextSel;
+} RM_ScanMgmtData;
+
+// table and manager
+extern RC initRecordManager (void *mgmtData);
+extern RC shutdownRecordManager ();
+extern RC createTable (char *name, Schema *schema);
+extern RC openTable (RM_TableData *rel, char *name);
+extern RC closeTable (RM_TableData *rel);
+extern RC deleteTable (char *name);
+extern int getNumTuples (RM_TableData *rel);
+
+// handling records in a table
+extern RC insertRecord (RM_TableData *rel, Record *record);
+extern RC deleteRecord (RM_TableData *rel, RID id);
+extern RC updateRecord (RM_TableData *rel, Record *record);
+extern RC getRecord (RM_TableData *rel, RID id, Record *record);
+
+// bulk loading of a new table, records are stored in order given.
+// Pages are filled to fillFactor (0 < fillFactor <= 1).
+extern RC startTableLoad (RM_TableLoad **load, char *name, Schema *schema, float fillFactor);
+extern RC loadRecord (RM_TableLoad *load, Record *record);
+extern RC finishTableLoad (RM_TableLoad *load);
+
+// scans
+extern RC startScan (RM_TableData *rel, RM_ScanHandle *scan, Expr *cond);
+extern RC next (RM_ScanHandle *scan, Record *record);
+extern RC closeScan (RM_ScanHandle *scan);
+
+// dealing with schemas
+extern int getRecordSize (Schema *schema);
+extern Schema *createSchema (int numAttr, char **attrNames, DataType *dataTypes, int *typeLength, int keySize, int *keys);
+extern RC freeSchema (Schema *schema);
+
+// dealing with records and attribute values
+extern RC createRecord (Record **record, Schema *schema);
+extern RC freeRecord (Record *record);
+extern RC getAttr (Record *record, Schema *schema, int attrNum, Value **value);
+extern RC setAttr (Record *record, Schema *schema, int attrNum, Value *value);
+
+#endif // RECORD_MGR_H
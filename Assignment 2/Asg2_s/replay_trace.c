@@ -0,0 +1,114 @@
+/*
+ * Replays a buffer pool access trace, recorded with startPoolTrace,
+ * under each given replacement strategy and pool size. Prints one
+ * line per run so strategies can be compared on the same accesses.
+ *
+ * Built by make bench, or
+ * gcc -O2 -I. -o replay_trace replay_trace.c buffer_trace.c mrc.c \
+ *     buffer_mgr.c buffer_mgr_stat.c storage_mgr.c page_compress.c \
+ *     page_table.c lru_linked_list.c page_latch.c frame_arena.c \
+ *     latency_hist.c dberror.c -lpthread
+ *
+ * usage: replay_trace traceFile [strategies] [poolSizes]
+ *   strategies  comma separated FIFO,LRU,CLOCK (default all)
+ *   poolSizes   comma separated frame counts (default 10,100,1000)
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "dberror.h"
+#include "storage_mgr.h"
+#include "buffer_mgr.h"
+#include "buffer_trace.h"
+
+#define SCRATCH_FILE "replay_trace.bin"
+
+static const char *strategyName(ReplacementStrategy s)
+{
+  switch (s)
+  {
+    case RS_FIFO: return "FIFO";
+    case RS_LRU: return "LRU";
+    case RS_CLOCK: return "CLOCK";
+    default: return "?";
+  }
+}
+
+static int parseStrategy(const char *name, ReplacementStrategy *s)
+{
+  if (strcmp(name, "FIFO") == 0)
+    *s= RS_FIFO;
+  else if (strcmp(name, "LRU") == 0)
+    *s= RS_LRU;
+  else if (strcmp(name, "CLOCK") == 0)
+    *s= RS_CLOCK;
+  else
+    return 0;
+  return 1;
+}
+
+static void replayOne(const char *traceFile, ReplacementStrategy s, int size)
+{
+  BM_ReplayResult r;
+  long long accesses;
+  RC rc;
+
+  rc= replayTrace(traceFile, SCRATCH_FILE, s, size, &r);
+  if (rc != RC_OK)
+  {
+    char *msg= errorMessage(rc);
+    fprintf(stderr, "%s %d: %s\n", strategyName(s), size, msg);
+    free(msg);
+    exit(1);
+  }
+
+  accesses= r.stats.hits + r.stats.misses;
+  printf("%-6s %8d %12lld %8.4f %10lld %10lld %10lld %8lld %12.0f\n",
+         strategyName(s), size, r.numPins,
+         accesses ? (double) r.stats.hits / accesses : 0.0,
+         r.stats.numReadIO, r.stats.numWriteIO, r.stats.dirtyEvictions,
+         r.failedPins, r.seconds > 0 ? r.numRecords / r.seconds : 0.0);
+}
+
+int main(int argc, char **argv)
+{
+  char *strategies, *sizes, *s, *z, *t, *sSave, *zSave;
+  ReplacementStrategy strategy;
+  int size;
+
+  if (argc < 2)
+  {
+    fprintf(stderr, "usage: %s traceFile [strategies] [poolSizes]\n", argv[0]);
+    return 1;
+  }
+  strategies= strdup(argc > 2 ? argv[2] : "FIFO,LRU,CLOCK");
+  sizes= argc > 3 ? argv[3] : "10,100,1000";
+
+  initStorageManager();
+  printf("%-6s %8s %12s %8s %10s %10s %10s %8s %12s\n", "policy", "frames",
+         "pins", "hitratio", "reads", "writes", "dirtyevict", "failed",
+         "ops/s");
+  for (s= strtok_r(strategies, ",", &sSave); s; s= strtok_r(NULL, ",", &sSave))
+  {
+    if (!parseStrategy(s, &strategy))
+    {
+      fprintf(stderr, "unknown strategy %s\n", s);
+      return 1;
+    }
+    z= strdup(sizes);
+    for (t= strtok_r(z, ",", &zSave); t; t= strtok_r(NULL, ",", &zSave))
+    {
+      size= atoi(t);
+      if (size <= 0)
+      {
+        fprintf(stderr, "bad pool size %s\n", t);
+        return 1;
+      }
+      replayOne(argv[1], strategy, size);
+    }
+    free(z);
+  }
+  free(strategies);
+  return 0;
+}
@@ -0,0 +1,109 @@
+#include <string.h>
+#include <stdlib.h>
+#include <stdio.h>
+
+#include "dberror.h"
+#include "tables.h"
+#include "record_mgr.h"
+
+// Size of buffer serializing a single value, strings get their own length
+#define VALUE_BUF_SIZE 64
+
+// Parse value written as type character followed by value,
+// e.g. "i10", "f1.5", "sabc", "bt".
+Value *stringToValue (char *val)
+{
+  Value *result= (Value*) malloc(sizeof(Value));
+
+  switch (val[0])
+  {
+    case 'i':
+      result->dt= DT_INT;
+      result->v.intV= atoi(val + 1);
+      break;
+    case 'f':
+      result->dt= DT_FLOAT;
+      result->v.floatV= atof(val + 1);
+      break;
+    case 's':
+      result->dt= DT_STRING;
+      result->v.stringV= strdup(val + 1);
+      break;
+    case 'b':
+      result->dt= DT_BOOL;
+      result->v.boolV= (val[1] == 't') ? TRUE : FALSE;
+      break;
+    default:
+      result->dt= DT_INT;
+      result->v.intV= -1;
+      break;
+  }
+
+  return result;
+}
+
+// Caller frees returned string
+char *serializeValue (Value *val)
+{
+  char *result;
+
+  if (val->dt == DT_STRING)
+    return strdup(val->v.stringV);
+
+  result= (char*) malloc(VALUE_BUF_SIZE);
+  switch (val->dt)
+  {
+    case DT_INT:
+      snprintf(result, VALUE_BUF_SIZE, "%d", val->v.intV);
+      break;
+    case DT_FLOAT:
+      snprintf(result, VALUE_BUF_SIZE, "%f", val->v.floatV);
+      break;
+    case DT_BOOL:
+      strcpy(result, val->v.boolV ? "true" : "false");
+      break;
+    default:
+      result[0]= '\0';
+      break;
+  }
+
+  return result;
+}
+
+// Record as "[page-slot] (a:1,b:xyz)", caller frees returned string
+char *serializeRecord (Record *record, Schema *schema)
+{
+  char **values;
+  char *result;
+  Value *val;
+  int i, size;
+
+  values= (char**) malloc(schema->numAttr * sizeof(char*));
+  size= VALUE_BUF_SIZE;
+  for (i=0; i < schema->numAttr; i++)
+  {
+    if (getAttr(record, schema, i, &val) != RC_OK)
+    {
+      values[i]= strdup("");
+      continue;
+    }
+    values[i]= serializeValue(val);
+    freeVal(val);
+    size+= strlen(schema->attrNames[i]) + strlen(values[i]) + 2;
+  }
+
+  result= (char*) malloc(size);
+  sprintf(result, "[%i-%i] (", record->id.page, record->id.slot);
+  for (i=0; i < schema->numAttr; i++)
+  {
+    strcat(result, i == 0 ? "" : ",");
+    strcat(result, schema->attrNames[i]);
+    strcat(result, ":");
+    strcat(result, values[i]);
+    free(values[i]);
+  }
+  strcat(result, ")");
+  free(values);
+
+  return result;
+}
@@ -0,0 +1,753 @@
+#include "sort_mgr.h"
+#include "storage_mgr.h"
+#include <string.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <pthread.h>
+
+/*
+ * External merge sort
+ *
+ * Replacement selection. Records are kept in the workspace frames
+ * and a heap orders them by run number, then by record. Smallest
+ * record is written to the current run and the incoming record takes
+ * its slot. If it is smaller than the record just written it can not
+ * go in the current run any more and gets the next run number. On
+ * random input runs come out about twice the workspace, sorted input
+ * is a single run. When input ends before the workspace is full
+ * nothing is written, records are returned from the heap.
+ *
+ * Merge. While more runs are left than can be merged at once, the
+ * oldest ones are merged into a new run, just as many as needed so
+ * that the rest can be merged in one go. That last merge feeds
+ * getSortRecord. The run with the smallest current record is found
+ * with a loser tree, log2(k) compares per record.
+ *
+ * Every run being merged has two frames. While records of one are
+ * returned a reader thread loads the next page of the run into the
+ * other. Run files are opened and closed only while the reader is
+ * idle, handle table of the storage manager is not thread safe.
+ */
+
+typedef struct ES_Run {
+  int id;          // File is <tempPrefix>.sort<id>
+  int numRecords;
+} ES_Run;
+
+typedef struct ES_HeapItem {
+  int run;
+  int slot;        // Record in workspace
+} ES_HeapItem;
+
+// Run being merged. Page p of run is loaded into buf[p % 2].
+typedef struct ES_Cursor {
+  SM_FileHandle fh;
+  bool open;
+  char *buf[2];
+  int cur;             // Buffer records are returned from
+  int pos;             // Record of cur returned next
+  int count[2];        // Records in buffer
+  bool ready[2];       // Set by reader when load is done
+  RC readRc[2];
+  PageNumber nextPage; // Next page to load
+  int numPages;
+  int numRecords;
+  int left;            // Records not returned yet, 0 when exhausted
+} ES_Cursor;
+
+typedef struct ES_ReadRequest {
+  ES_Cursor *cursor;
+  PageNumber page;
+} ES_ReadRequest;
+
+typedef struct ES_SortMgmtData {
+  BM_BufferPool *bm;
+  int numFrames;
+  char **frames;
+  char *tempPrefix;
+  int perPage;            // Records in a page
+  int numRecords;
+  bool inputDone;
+  int numInitialRuns;
+  int numMerges;
+
+  // Replacement selection
+  int capacity;           // Records the workspace holds
+  ES_HeapItem *heap;
+  int heapSize;
+  int curRun;
+
+  // Run being written, last frame is its page
+  bool writing;
+  SM_FileHandle outFile;
+  ES_Run outRun;
+  PageNumber outPage;
+  int outCount;           // Records in page
+
+  // Runs on disk, runs[firstRun .. numRuns-1] are not merged yet
+  ES_Run *runs;
+  int firstRun;
+  int numRuns;
+  int nextId;
+
+  // Merge
+  int fanIn;
+  int numCursors;
+  ES_Cursor *cursors;
+  int *tree;              // tree[0] winner, tree[1..k-1] losers
+
+  // Reader thread
+  bool readerStarted;
+  pthread_t reader;
+  pthread_mutex_t mutex;
+  pthread_cond_t work;    // Request queued or stop
+  pthread_cond_t done;    // Request loaded
+  ES_ReadRequest *queue;
+  int qHead;
+  int qCount;
+  bool stop;
+} ES_SortMgmtData;
+
+#define SORT_MGMT(sort)   ((ES_SortMgmtData*) (sort)->mgmtData)
+#define SLOT(sort,s,i)    ((s)->frames[(i) / (s)->perPage]                  \
+                           + ((i) % (s)->perPage) * (sort)->recordSize)
+#define CUR_RECORD(sort,c) ((c)->buf[(c)->cur] + (c)->pos * (sort)->recordSize)
+#define OUT_FRAME(s)      ((s)->frames[(s)->numFrames - 1])
+
+// Not a interface
+static char *runFileName(ES_SortMgmtData *s, int id);
+static bool heapLess(ES_SortHandle *sort, ES_HeapItem a, ES_HeapItem b);
+static void siftUp(ES_SortHandle *sort, int i);
+static void siftDown(ES_SortHandle *sort, int i);
+static RC startRun(ES_SortHandle *sort);
+static RC appendToRun(ES_SortHandle *sort, char *record);
+static RC endRun(ES_SortHandle *sort);
+static RC outputSmallest(ES_SortHandle *sort);
+static void *readerMain(void *arg);
+static void requestPage(ES_SortMgmtData *s, ES_Cursor *c);
+static RC waitPage(ES_SortMgmtData *s, ES_Cursor *c, int b);
+static RC openCursors(ES_SortHandle *sort, int k);
+static void closeCursors(ES_SortMgmtData *s, bool destroy);
+static RC advance(ES_SortHandle *sort, ES_Cursor *c);
+static bool beats(ES_SortHandle *sort, int a, int b);
+static int buildTree(ES_SortHandle *sort, int node);
+static void replay(ES_SortHandle *sort, int w);
+static RC mergeRuns(ES_SortHandle *sort, int k);
+
+static char *runFileName(ES_SortMgmtData *s, int id)
+{
+  char *name= (char*) malloc(strlen(s->tempPrefix) + 20);
+  sprintf(name, "%s.sort%d", s->tempPrefix, id);
+  return name;
+}
+
+/**************************************************
+ * replacement selection
+ */
+static bool heapLess(ES_SortHandle *sort, ES_HeapItem a, ES_HeapItem b)
+{
+  ES_SortMgmtData *s= SORT_MGMT(sort);
+
+  if (a.run != b.run)
+    return a.run < b.run;
+  return sort->cmp(SLOT(sort, s, a.slot), SLOT(sort, s, b.slot),
+                   sort->cmpCtx) < 0;
+}
+
+static void siftUp(ES_SortHandle *sort, int i)
+{
+  ES_SortMgmtData *s= SORT_MGMT(sort);
+  ES_HeapItem item= s->heap[i];
+
+  while (i > 0 && heapLess(sort, item, s->heap[(i - 1) / 2]))
+  {
+    s->heap[i]= s->heap[(i - 1) / 2];
+    i= (i - 1) / 2;
+  }
+  s->heap[i]= item;
+}
+
+static void siftDown(ES_SortHandle *sort, int i)
+{
+  ES_SortMgmtData *s= SORT_MGMT(sort);
+  ES_HeapItem item= s->heap[i];
+  int child;
+
+  while ((child= 2 * i + 1) < s->heapSize)
+  {
+    if (child + 1 < s->heapSize
+        && heapLess(sort, s->heap[child + 1], s->heap[child]))
+      child++;
+    if (!heapLess(sort, s->heap[child], item))
+      break;
+    s->heap[i]= s->heap[child];
+    i= child;
+  }
+  s->heap[i]= item;
+}
+
+static RC startRun(ES_SortHandle *sort)
+{
+  ES_SortMgmtData *s= SORT_MGMT(sort);
+  char *name;
+  RC rc;
+
+  s->outRun.id= s->nextId++;
+  s->outRun.numRecords= 0;
+  s->outPage= 0;
+  s->outCount= 0;
+
+  name= runFileName(s, s->outRun.id);
+  destroyPageFile(name);
+  rc= createPageFile(name);
+  if (rc == RC_OK)
+    rc= openPageFile(name, &s->outFile);
+  if (rc != RC_OK)
+    destroyPageFile(name);
+  free(name);
+  if (rc != RC_OK)
+    RETURN(rc);
+
+  s->writing= TRUE;
+  RETURN(RC_OK);
+}
+
+static RC appendToRun(ES_SortHandle *sort, char *record)
+{
+  ES_SortMgmtData *s= SORT_MGMT(sort);
+  RC rc;
+
+  memcpy(OUT_FRAME(s) + s->outCount * sort->recordSize, record,
+         sort->recordSize);
+  s->outRun.numRecords++;
+  if (++s->outCount < s->perPage)
+    RETURN(RC_OK);
+
+  rc= writeBlock(s->outPage, &s->outFile, OUT_FRAME(s));
+  s->outPage++;
+  s->outCount= 0;
+  RETURN(rc);
+}
+
+// Write last page of run and add it to the runs to merge
+static RC endRun(ES_SortHandle *sort)
+{
+  ES_SortMgmtData *s= SORT_MGMT(sort);
+  RC rc= RC_OK;
+
+  if (s->outCount > 0)
+    rc= writeBlock(s->outPage, &s->outFile, OUT_FRAME(s));
+  if (rc == RC_OK)
+    rc= closePageFile(&s->outFile);
+  else
+    closePageFile(&s->outFile);
+  s->writing= FALSE;
+
+  s->runs= (ES_Run*) realloc(s->runs, (s->numRuns + 1) * sizeof(ES_Run));
+  s->runs[s->numRuns++]= s->outRun;
+  RETURN(rc);
+}
+
+// Write smallest record of heap to its run, starting the run if it is
+// a new one. Its slot is free afterwards.
+static RC outputSmallest(ES_SortHandle *sort)
+{
+  ES_SortMgmtData *s= SORT_MGMT(sort);
+  RC rc;
+
+  if (!s->writing || s->heap[0].run != s->curRun)
+  {
+    if (s->writing)
+    {
+      rc= endRun(sort);
+      if (rc != RC_OK)
+        RETURN(rc);
+    }
+    s->curRun= s->heap[0].run;
+    rc= startRun(sort);
+    if (rc != RC_OK)
+      RETURN(rc);
+  }
+
+  return appendToRun(sort, SLOT(sort, s, s->heap[0].slot));
+}
+
+/**************************************************
+ * run reader
+ */
+static void *readerMain(void *arg)
+{
+  ES_SortMgmtData *s= (ES_SortMgmtData*) arg;
+  ES_ReadRequest r;
+  RC rc;
+  int b;
+
+  pthread_mutex_lock(&s->mutex);
+  for (;;)
+  {
+    while (s->qCount == 0 && !s->stop)
+      pthread_cond_wait(&s->work, &s->mutex);
+    if (s->stop)
+      break;
+    r= s->queue[s->qHead];
+    s->qHead= (s->qHead + 1) % (2 * s->fanIn);
+    s->qCount--;
+    pthread_mutex_unlock(&s->mutex);
+
+    b= r.page % 2;
+    rc= readBlock(r.page, &r.cursor->fh, r.cursor->buf[b]);
+
+    pthread_mutex_lock(&s->mutex);
+    r.cursor->readRc[b]= rc;
+    r.cursor->ready[b]= TRUE;
+    pthread_cond_broadcast(&s->done);
+  }
+  pthread_mutex_unlock(&s->mutex);
+  return NULL;
+}
+
+// Queue load of next page of cursor, at most two are outstanding
+static void requestPage(ES_SortMgmtData *s, ES_Cursor *c)
+{
+  int b= c->nextPage % 2, first= c->nextPage * s->perPage;
+
+  c->ready[b]= FALSE;
+  c->count[b]= c->numRecords - first < s->perPage ? c->numRecords - first
+                                                  : s->perPage;
+
+  pthread_mutex_lock(&s->mutex);
+  s->queue[(s->qHead + s->qCount) % (2 * s->fanIn)].cursor= c;
+  s->queue[(s->qHead + s->qCount) % (2 * s->fanIn)].page= c->nextPage;
+  s->qCount++;
+  pthread_cond_signal(&s->work);
+  pthread_mutex_unlock(&s->mutex);
+
+  c->nextPage++;
+}
+
+static RC waitPage(ES_SortMgmtData *s, ES_Cursor *c, int b)
+{
+  pthread_mutex_lock(&s->mutex);
+  while (!c->ready[b])
+    pthread_cond_wait(&s->done, &s->mutex);
+  pthread_mutex_unlock(&s->mutex);
+  RETURN(c->readRc[b]);
+}
+
+/**************************************************
+ * merge
+ */
+
+// Open k oldest runs and load their first pages
+static RC openCursors(ES_SortHandle *sort, int k)
+{
+  ES_SortMgmtData *s= SORT_MGMT(sort);
+  ES_Cursor *c;
+  char *name;
+  int i;
+  RC rc;
+
+  s->numCursors= k;
+  for (i=0; i < k; i++)
+  {
+    c= &s->cursors[i];
+    c->open= FALSE;
+    c->buf[0]= s->frames[2 * i];
+    c->buf[1]= s->frames[2 * i + 1];
+    c->cur= 0;
+    c->pos= 0;
+    c->nextPage= 0;
+    c->numRecords= c->left= s->runs[s->firstRun + i].numRecords;
+    c->numPages= (c->numRecords + s->perPage - 1) / s->perPage;
+  }
+
+  // Reader must not run while handles are registered
+  for (i=0; i < k; i++)
+  {
+    name= runFileName(s, s->runs[s->firstRun + i].id);
+    rc= openPageFile(name, &s->cursors[i].fh);
+    free(name);
+    if (rc != RC_OK)
+      RETURN(rc);
+    s->cursors[i].open= TRUE;
+  }
+
+  for (i=0; i < k; i++)
+  {
+    c= &s->cursors[i];
+    requestPage(s, c);
+    if (c->numPages > 1)
+      requestPage(s, c);
+  }
+  for (i=0; i < k; i++)
+  {
+    rc= waitPage(s, &s->cursors[i], 0);
+    if (rc != RC_OK)
+      RETURN(rc);
+  }
+
+  s->tree[0]= k == 1 ? 0 : buildTree(sort, 1);
+  RETURN(RC_OK);
+}
+
+// Close files of cursors, reader must be idle
+static void closeCursors(ES_SortMgmtData *s, bool destroy)
+{
+  char *name;
+  int i;
+
+  for (i=0; i < s->numCursors; i++)
+  {
+    if (s->cursors[i].open)
+      closePageFile(&s->cursors[i].fh);
+    s->cursors[i].open= FALSE;
+    if (destroy)
+    {
+      name= runFileName(s, s->runs[s->firstRun + i].id);
+      destroyPageFile(name);
+      free(name);
+    }
+  }
+  if (destroy)
+    s->firstRun+= s->numCursors;
+  s->numCursors= 0;
+}
+
+// Step past current record, switching to the other buffer at end
+// of page, which then starts loading the page after next.
+static RC advance(ES_SortHandle *sort, ES_Cursor *c)
+{
+  ES_SortMgmtData *s= SORT_MGMT(sort);
+  RC rc;
+
+  c->left--;
+  if (++c->pos < c->count[c->cur] || c->left == 0)
+    RETURN(RC_OK);
+
+  c->cur= 1 - c->cur;
+  c->pos= 0;
+  rc= waitPage(s, c, c->cur);
+  if (rc != RC_OK)
+    RETURN(rc);
+  if (c->nextPage < c->numPages)
+    requestPage(s, c);
+  RETURN(RC_OK);
+}
+
+// Whether current record of cursor a goes before the one of b.
+// Exhausted cursors lose, equal records go in run order.
+static bool beats(ES_SortHandle *sort, int a, int b)
+{
+  ES_SortMgmtData *s= SORT_MGMT(sort);
+  ES_Cursor *ca= &s->cursors[a], *cb= &s->cursors[b];
+  int r;
+
+  if (ca->left == 0)
+    return FALSE;
+  if (cb->left == 0)
+    return TRUE;
+  r= sort->cmp(CUR_RECORD(sort, ca), CUR_RECORD(sort, cb), sort->cmpCtx);
+  return r < 0 || (r == 0 && a < b);
+}
+
+// Play tournament below node, leaves are k..2k-1 for cursors
+// 0..k-1. Loser is kept at node, winner goes up.
+static int buildTree(ES_SortHandle *sort, int node)
+{
+  ES_SortMgmtData *s= SORT_MGMT(sort);
+  int k= s->numCursors, w1, w2;
+
+  if (node >= k)
+    return node - k;
+  w1= buildTree(sort, 2 * node);
+  w2= buildTree(sort, 2 * node + 1);
+  if (beats(sort, w1, w2))
+  {
+    s->tree[node]= w2;
+    return w1;
+  }
+  s->tree[node]= w1;
+  return w2;
+}
+
+// Cursor w moved on, play its new record against losers up the path
+static void replay(ES_SortHandle *sort, int w)
+{
+  ES_SortMgmtData *s= SORT_MGMT(sort);
+  int node, tmp;
+
+  for (node= (w + s->numCursors) / 2; node > 0; node/= 2)
+    if (beats(sort, s->tree[node], w))
+    {
+      tmp= s->tree[node];
+      s->tree[node]= w;
+      w= tmp;
+    }
+  s->tree[0]= w;
+}
+
+// Merge k oldest runs into a new run
+static RC mergeRuns(ES_SortHandle *sort, int k)
+{
+  ES_SortMgmtData *s= SORT_MGMT(sort);
+  ES_Cursor *c;
+  RC rc;
+
+  rc= startRun(sort);
+  if (rc == RC_OK)
+    rc= openCursors(sort, k);
+
+  while (rc == RC_OK)
+  {
+    c= &s->cursors[s->tree[0]];
+    if (c->left == 0)
+      break;
+    rc= appendToRun(sort, CUR_RECORD(sort, c));
+    if (rc == RC_OK)
+      rc= advance(sort, c);
+    replay(sort, s->tree[0]);
+  }
+  if (rc != RC_OK)
+    RETURN(rc);
+
+  closeCursors(s, TRUE);
+  s->numMerges++;
+  return endRun(sort);
+}
+
+/**************************************************
+ * interface
+ */
+RC openSort (ES_SortHandle **sort, BM_BufferPool *bm, int numFrames,
+             int recordSize, ES_Compare cmp, void *cmpCtx, char *tempPrefix)
+{
+  ES_SortHandle *h;
+  ES_SortMgmtData *s;
+  int i;
+  RC rc;
+
+  if (recordSize <= 0 || recordSize > PAGE_SIZE)
+    RETURN(RC_ES_RECORD_TOO_BIG);
+  if (numFrames < ES_MIN_FRAMES)
+    RETURN(RC_ES_TOO_FEW_FRAMES);
+
+  s= (ES_SortMgmtData*) calloc(1, sizeof(ES_SortMgmtData));
+  s->bm= bm;
+  s->numFrames= numFrames;
+  s->frames= (char**) malloc(numFrames * sizeof(char*));
+  if (bm != NULL)
+  {
+    rc= reserveFrames(bm, numFrames, s->frames);
+    if (rc != RC_OK)
+    {
+      free(s->frames);
+      free(s);
+      RETURN(rc);
+    }
+  }
+  else
+    for (i=0; i < numFrames; i++)
+      s->frames[i]= (char*) malloc(PAGE_SIZE);
+
+  s->tempPrefix= strdup(tempPrefix);
+  s->perPage= PAGE_SIZE / recordSize;
+  s->capacity= (numFrames - 1) * s->perPage;
+  s->heap= (ES_HeapItem*) malloc(s->capacity * sizeof(ES_HeapItem));
+
+  s->fanIn= (numFrames - 1) / 2;
+  if (s->fanIn > ES_MAX_FAN_IN)
+    s->fanIn= ES_MAX_FAN_IN;
+  s->cursors= (ES_Cursor*) calloc(s->fanIn, sizeof(ES_Cursor));
+  s->tree= (int*) malloc(s->fanIn * sizeof(int));
+  s->queue= (ES_ReadRequest*) malloc(2 * s->fanIn * sizeof(ES_ReadRequest));
+  pthread_mutex_init(&s->mutex, NULL);
+  pthread_cond_init(&s->work, NULL);
+  pthread_cond_init(&s->done, NULL);
+
+  h= (ES_SortHandle*) malloc(sizeof(ES_SortHandle));
+  h->recordSize= recordSize;
+  h->cmp= cmp;
+  h->cmpCtx= cmpCtx;
+  h->mgmtData= s;
+  *sort= h;
+  RETURN(RC_OK);
+}
+
+RC closeSort (ES_SortHandle *sort)
+{
+  ES_SortMgmtData *s= SORT_MGMT(sort);
+  char *name;
+  RC rc= RC_OK;
+  int i;
+
+  if (s->readerStarted)
+  {
+    pthread_mutex_lock(&s->mutex);
+    s->stop= TRUE;
+    pthread_cond_signal(&s->work);
+    pthread_mutex_unlock(&s->mutex);
+    pthread_join(s->reader, NULL);
+  }
+  pthread_cond_destroy(&s->done);
+  pthread_cond_destroy(&s->work);
+  pthread_mutex_destroy(&s->mutex);
+
+  // Runs left after an error or when not all records were read
+  closeCursors(s, FALSE);
+  if (s->writing)
+  {
+    closePageFile(&s->outFile);
+    name= runFileName(s, s->outRun.id);
+    destroyPageFile(name);
+    free(name);
+  }
+  for (i= s->firstRun; i < s->numRuns; i++)
+  {
+    name= runFileName(s, s->runs[i].id);
+    destroyPageFile(name);
+    free(name);
+  }
+
+  if (s->bm != NULL)
+    rc= releaseFrames(s->bm, s->numFrames, s->frames);
+  else
+    for (i=0; i < s->numFrames; i++)
+      free(s->frames[i]);
+
+  free(s->frames);
+  free(s->tempPrefix);
+  free(s->heap);
+  free(s->runs);
+  free(s->cursors);
+  free(s->tree);
+  free(s->queue);
+  free(s);
+  free(sort);
+  RETURN(rc);
+}
+
+RC putSortRecord (ES_SortHandle *sort, void *record)
+{
+  ES_SortMgmtData *s= SORT_MGMT(sort);
+  char *slot;
+  RC rc;
+
+  if (s->inputDone)
+    RETURN(RC_ES_NO_MORE_RECORDS);
+
+  // Filling workspace, all records go in first run
+  if (s->heapSize < s->capacity)
+  {
+    memcpy(SLOT(sort, s, s->heapSize), record, sort->recordSize);
+    s->heap[s->heapSize].run= 0;
+    s->heap[s->heapSize].slot= s->heapSize;
+    siftUp(sort, s->heapSize++);
+    s->numRecords++;
+    RETURN(RC_OK);
+  }
+
+  rc= outputSmallest(sort);
+  if (rc != RC_OK)
+    RETURN(rc);
+
+  slot= SLOT(sort, s, s->heap[0].slot);
+  if (sort->cmp(record, slot, sort->cmpCtx) < 0)
+    s->heap[0].run= s->curRun + 1;
+  memcpy(slot, record, sort->recordSize);
+  siftDown(sort, 0);
+  s->numRecords++;
+  RETURN(RC_OK);
+}
+
+RC finishSortInput (ES_SortHandle *sort)
+{
+  ES_SortMgmtData *s= SORT_MGMT(sort);
+  int left, k;
+  RC rc;
+
+  if (s->inputDone)
+    RETURN(RC_OK);
+  s->inputDone= TRUE;
+
+  // Nothing went to disk, records are returned from the heap
+  if (!s->writing)
+    RETURN(RC_OK);
+
+  while (s->heapSize > 0)
+  {
+    rc= outputSmallest(sort);
+    if (rc != RC_OK)
+      RETURN(rc);
+    s->heap[0]= s->heap[--s->heapSize];
+    siftDown(sort, 0);
+  }
+  rc= endRun(sort);
+  if (rc != RC_OK)
+    RETURN(rc);
+  s->numInitialRuns= s->numRuns;
+
+  s->readerStarted= pthread_create(&s->reader, NULL, readerMain, s) == 0;
+  if (!s->readerStarted)
+    RETURN(RC_READ_FAILED);
+
+  // First merge takes only enough runs that the rest merge at once
+  while ((left= s->numRuns - s->firstRun) > s->fanIn)
+  {
+    k= left - s->fanIn + 1;
+    rc= mergeRuns(sort, k > s->fanIn ? s->fanIn : k);
+    if (rc != RC_OK)
+      RETURN(rc);
+  }
+
+  return openCursors(sort, s->numRuns - s->firstRun);
+}
+
+RC getSortRecord (ES_SortHandle *sort, void *record)
+{
+  ES_SortMgmtData *s= SORT_MGMT(sort);
+  ES_Cursor *c;
+  RC rc;
+
+  if (!s->inputDone)
+  {
+    rc= finishSortInput(sort);
+    if (rc != RC_OK)
+      RETURN(rc);
+  }
+
+  if (s->numInitialRuns == 0)
+  {
+    if (s->heapSize == 0)
+      RETURN(RC_ES_NO_MORE_RECORDS);
+    memcpy(record, SLOT(sort, s, s->heap[0].slot), sort->recordSize);
+    s->heap[0]= s->heap[--s->heapSize];
+    siftDown(sort, 0);
+    RETURN(RC_OK);
+  }
+
+  c= &s->cursors[s->tree[0]];
+  if (c->left == 0)
+    RETURN(RC_ES_NO_MORE_RECORDS);
+  memcpy(record, CUR_RECORD(sort, c), sort->recordSize);
+  rc= advance(sort, c);
+  replay(sort, s->tree[0]);
+  RETURN(rc);
+}
+
+RC getSortNumRecords (ES_SortHandle *sort, int *result)
+{
+  *result= SORT_MGMT(sort)->numRecords;
+  RETURN(RC_OK);
+}
+
+RC getSortNumRuns (ES_SortHandle *sort, int *result)
+{
+  *result= SORT_MGMT(sort)->numInitialRuns;
+  RETURN(RC_OK);
+}
+
+RC getSortNumMerges (ES_SortHandle *sort, int *result)
+{
+  *result= SORT_MGMT(sort)->numMerges;
+  RETURN(RC_OK);
+}
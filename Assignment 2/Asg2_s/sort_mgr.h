@@ -0,0 +1,58 @@
+#ifndef SORT_MGR_H
+#define SORT_MGR_H
+
+#include "dberror.h"
+#include "buffer_mgr.h"
+
+/*
+ * External merge sort of fixed size records
+ *
+ * Workspace is numFrames page frames. Sorted runs are written
+ * to temporary page files <tempPrefix>.sort<N>, records are packed
+ * in pages of the run, a record never spans two pages.
+ */
+
+// Input needs a frame for output, merge two frames per run and
+// one for output, merging at least two runs.
+#define ES_MIN_FRAMES 5
+
+// Most runs merged at once, every one holds an open file.
+#define ES_MAX_FAN_IN 64
+
+// Orders records like qsort, ctx is passed through from openSort.
+typedef int (*ES_Compare) (const void *a, const void *b, void *ctx);
+
+// structure for accessing a sort
+typedef struct ES_SortHandle {
+  int recordSize;
+  ES_Compare cmp;
+  void *cmpCtx;
+  void *mgmtData;
+} ES_SortHandle;
+
+// Frames are reserved from bm until closeSort, bm NULL sorts in
+// memory allocated for numFrames pages.
+extern RC openSort (ES_SortHandle **sort, BM_BufferPool *bm, int numFrames,
+                    int recordSize, ES_Compare cmp, void *cmpCtx,
+                    char *tempPrefix);
+extern RC closeSort (ES_SortHandle *sort);
+
+// Records are put in any order, after finishSortInput they are
+// returned in order until RC_ES_NO_MORE_RECORDS.
+//
+// From finishSortInput to closeSort a reader thread loads pages of
+// the runs. Meanwhile callers may open, read, write and close other
+// page files, and use bm, but must not touch the runs' files or call
+// into the same sort from a second thread.
+extern RC putSortRecord (ES_SortHandle *sort, void *record);
+extern RC finishSortInput (ES_SortHandle *sort);
+extern RC getSortRecord (ES_SortHandle *sort, void *record);
+
+// access information about a sort
+extern RC getSortNumRecords (ES_SortHandle *sort, int *result);
+// Runs written by replacement selection, 0 when input fit in memory
+extern RC getSortNumRuns (ES_SortHandle *sort, int *result);
+// Merges writing a new run, final merge feeding getSortRecord excluded
+extern RC getSortNumMerges (ES_SortHandle *sort, int *result);
+
+#endif // SORT_MGR_H
@@ -6,15 +6,103 @@
 #include <string.h>
 #include <stdio.h>
 #include <unistd.h>
+#include <sys/uio.h>
+#include <pthread.h>
+#include "page_compress.h"
 
 #define MAX_FILE_HANDLE 256 // This can be = max fd's per process
 #define BYTES_TO_PAGE(bytes) ((bytes-1) / PAGE_SIZE)
-#define PAGE_OFFSET(pageNo)  (pageNo * PAGE_SIZE)
+#define PAGE_OFFSET(mgmtInfo, pageNo) \
+    ((mgmtInfo)->dataOffset + (off_t) (pageNo) * PAGE_SIZE)
+#define DEFAULT_GROWTH_CHUNK 64 // Pages added to file per extent
+#define MAX_IOV 1024            // Pages per vectored read or write, IOV_MAX of Linux
+
+/*
+ * Page file format
+ * | Header (SM_HEADER_SIZE) | Page 0 | Page 1 | ... | Unused extent |
+ *
+ * Header keeps the number of pages in use. File is grown by whole
+ * extents of growth chunk pages with a single ftruncate, which leaves
+ * a hole, so new pages cost neither a write nor disk blocks until
+ * they are written. Header is written with every new extent and on
+ * close. While file is open it counts all pages of the extents, so
+ * after a crash no page that may hold data is handed out as new, the
+ * file only ends in up to an extent of zero pages.
+ *
+ * Files written before the header was introduced have no magic,
+ * their page count is still derived from the file size.
+ *
+ * Compressed page file format
+ * | Header (SM_HEADER_SIZE) | Page images and page map, any order |
+ *
+ * Page map has one SM_PageMapEntry per logical page and is kept in
+ * memory while the file is open. It is written on close, header then
+ * points to it. Zero pages are elided, they only cost a map entry.
+ *
+ * Bytes the map on disk points to are never overwritten. A page whose
+ * image is mapped on disk gets a new image elsewhere, only images
+ * placed since the map was written are rewritten in place. Replaced
+ * images and the old map are freed once the header points to the new
+ * map, so a file that was not closed keeps the map of its last close
+ * and all images it names. Free bytes are reused first fit, free
+ * bytes at the end are cut off on close, so rewriting pages does not
+ * grow the file. Maps are only written when a page was written.
+ */
+#define SM_PLAIN_MAGIC      "ADOPPAGE"
+#define SM_COMPRESSED_MAGIC "ADOZPAGE"
+#define SM_HEADER_SIZE      PAGE_SIZE
+#define SM_IMAGE_ALIGN      64  // Slack so that page can grow in place
+#define ALIGN_IMAGE(len)    (((len) + SM_IMAGE_ALIGN - 1) & ~(SM_IMAGE_ALIGN - 1))
+
+#define SM_FORMAT_PLAIN      0
+#define SM_FORMAT_COMPRESSED 1
+#define SM_FORMAT_LEGACY     2 // Headerless plain file
+
+typedef struct SM_FileHeader {
+  char magic[8];
+  int totalNumPages;
+  int allocatedPages;   // Plain format, pages covered by file size
+  long long mapOffset;
+  long long dataEnd;
+} SM_FileHeader;
+
+typedef struct SM_PageMapEntry {
+  long long offset; // Location of page image in file
+  int length;       // 0 => zero page, PAGE_SIZE => stored uncompressed
+  int capacity;     // Bytes reserved at offset, for rewrite in place
+} SM_PageMapEntry;
+
+// Byte range of compressed file
+typedef struct SM_Extent {
+  long long offset;
+  long long length;
+} SM_Extent;
+
+typedef struct SM_ExtentList {
+  SM_Extent *ext;
+  int count;
+  int size;             // Allocated entries in ext
+} SM_ExtentList;
 
 // Management information
 typedef struct SM_FileMgmtInfo {
   int fd;
-  // we can add some new elements as required, in future.
+  int format;
+
+  // Plain format only
+  off_t dataOffset;     // File offset of page 0
+  int allocatedPages;   // Pages covered by current extent
+
+  // Compressed format only
+  SM_PageMapEntry *pageMap;
+  char *fresh;          // Per page, image placed since map was written
+  int mapSize;          // Allocated entries in pageMap and fresh
+  long long dataEnd;    // End of used bytes, new extents start here
+  int mapDirty;         // Map changed since it was last written
+  long long mapOffset;  // Map the header points to
+  long long mapBytes;
+  SM_ExtentList freeExt;    // Unused bytes before dataEnd, by offset
+  SM_ExtentList pendingExt; // Replaced images still named by map on disk
 }SM_FileMgmtInfo;
 
 // Storage manager
@@ -22,9 +110,17 @@ typedef struct SM {
    SM_FileHandle* openHandles[MAX_FILE_HANDLE];
    int handleCount;
    int init;
+   int growthChunk;
 }SM;
 static SM storageManager; // As it is static it will be initialized
 
+// Guards openHandles, files may be opened while other threads read
+static pthread_mutex_t handleMutex= PTHREAD_MUTEX_INITIALIZER;
+
+// Latency of page reads and writes, recorded while tracking is on
+static LH_Histogram readLatency;
+static LH_Histogram writeLatency;
+
 // STATIC FUNCTIONS
 // Is storage manager initialized?
 static RC isStorageManagerInitialized()
@@ -37,17 +133,22 @@ static RC isStorageManagerInitialized()
 // Is fHandle know to Storage Engine ?
 static RC isFileHandleOpen(SM_FileHandle *fHandle)
 {
-    int i;
-    int handleCount= storageManager.handleCount;
-    for(i=0; i<MAX_FILE_HANDLE && handleCount; i++)
+    int i, found= 0;
+    int handleCount;
+
+    pthread_mutex_lock(&handleMutex);
+    handleCount= storageManager.handleCount;
+    for(i=0; i<MAX_FILE_HANDLE && handleCount && !found; i++)
     {
         if (storageManager.openHandles[i] == 0)
             continue;
         handleCount--;
-        if (storageManager.openHandles[i] == fHandle)
-            RETURN(RC_OK);
+        found= storageManager.openHandles[i] == fHandle;
     }
+    pthread_mutex_unlock(&handleMutex);
 
+    if (found)
+        RETURN(RC_OK);
     RETURN(RC_FILE_HANDLE_NOT_INIT);
 }
 
@@ -55,13 +156,17 @@ static RC isFileHandleOpen(SM_FileHandle *fHandle)
 static RC registerFileHandle(SM_FileHandle *fHandle)
 {
     int i;
+
+    pthread_mutex_lock(&handleMutex);
     for(i=0; i<MAX_FILE_HANDLE; i++)
         if (storageManager.openHandles[i] == 0)
         {
             storageManager.openHandles[i]= fHandle;
             storageManager.handleCount++;
+            pthread_mutex_unlock(&handleMutex);
             RETURN(RC_OK);
         }
+    pthread_mutex_unlock(&handleMutex);
 
     RETURN(RC_MAX_FILE_HANDLE_OPEN);
 }
@@ -70,7 +175,10 @@ static RC registerFileHandle(SM_FileHandle *fHandle)
 static RC deregisterFileHandle(SM_FileHandle *fHandle)
 {
     int i;
-    int handleCount= storageManager.handleCount;
+    int handleCount;
+
+    pthread_mutex_lock(&handleMutex);
+    handleCount= storageManager.handleCount;
     for(i=0; i<MAX_FILE_HANDLE && handleCount; i++)
     {
         if (!storageManager.openHandles[i])
@@ -79,16 +187,18 @@ static RC deregisterFileHandle(SM_FileHandle *fHandle)
         if (storageManager.openHandles[i] == fHandle)
         {
             storageManager.openHandles[i]= 0;
+            storageManager.handleCount--;
+            pthread_mutex_unlock(&handleMutex);
             RETURN(RC_OK);
         }
     }
+    pthread_mutex_unlock(&handleMutex);
 
     RETURN(RC_FILE_HANDLE_NOT_INIT);
 }
 
 // Get the last page number based on file size.
-// We can alternatively store last page number within
-// the page file, but it is not necessary for now.
+// Only used for legacy files, others keep it in header.
 static int getLastPageNo(char* fileName)
 {
     struct stat st;
@@ -96,6 +206,418 @@ static int getLastPageNo(char* fileName)
     return BYTES_TO_PAGE(st.st_size); 
 }
 
+// Make sure page map can hold numPages entries. New entries are zero pages.
+static RC growPageMap(SM_FileMgmtInfo *mgmtInfo, int numPages)
+{
+    SM_PageMapEntry *map;
+    char *fresh;
+    int newSize;
+
+    if (numPages <= mgmtInfo->mapSize)
+        RETURN(RC_OK);
+
+    newSize= mgmtInfo->mapSize ? mgmtInfo->mapSize : 64;
+    while (newSize < numPages)
+        newSize*= 2;
+
+    fresh= (char*) realloc(mgmtInfo->fresh, newSize);
+    if (!fresh)
+        RETURN(RC_WRITE_FAILED);
+    mgmtInfo->fresh= fresh;
+    map= (SM_PageMapEntry*) realloc(mgmtInfo->pageMap,
+                                    newSize * sizeof(SM_PageMapEntry));
+    if (!map)
+        RETURN(RC_WRITE_FAILED);
+    memset(&map[mgmtInfo->mapSize], 0,
+           (newSize - mgmtInfo->mapSize) * sizeof(SM_PageMapEntry));
+    memset(&fresh[mgmtInfo->mapSize], 0, newSize - mgmtInfo->mapSize);
+    mgmtInfo->pageMap= map;
+    mgmtInfo->mapSize= newSize;
+    RETURN(RC_OK);
+}
+
+static void freeMgmtInfo(SM_FileMgmtInfo *mgmtInfo)
+{
+    free(mgmtInfo->pageMap);
+    free(mgmtInfo->fresh);
+    free(mgmtInfo->freeExt.ext);
+    free(mgmtInfo->pendingExt.ext);
+    free(mgmtInfo);
+}
+
+// Put extent at position pos of list.
+static RC insertExtent(SM_ExtentList *list, int pos,
+                       long long offset, long long length)
+{
+    SM_Extent *ext;
+    int newSize;
+
+    if (list->count == list->size)
+    {
+        newSize= list->size ? list->size * 2 : 16;
+        ext= (SM_Extent*) realloc(list->ext, newSize * sizeof(SM_Extent));
+        if (!ext)
+            RETURN(RC_WRITE_FAILED);
+        list->ext= ext;
+        list->size= newSize;
+    }
+    memmove(&list->ext[pos + 1], &list->ext[pos],
+            (list->count - pos) * sizeof(SM_Extent));
+    list->ext[pos].offset= offset;
+    list->ext[pos].length= length;
+    list->count++;
+    RETURN(RC_OK);
+}
+
+static void removeExtent(SM_ExtentList *list, int pos)
+{
+    list->count--;
+    memmove(&list->ext[pos], &list->ext[pos + 1],
+            (list->count - pos) * sizeof(SM_Extent));
+}
+
+// Give bytes back to free list. Neighbours are merged, free bytes at
+// end of data area shrink it instead. A failure only loses the bytes.
+static void releaseExtent(SM_FileMgmtInfo *mgmtInfo,
+                          long long offset, long long length)
+{
+    SM_ExtentList *list= &mgmtInfo->freeExt;
+    int i;
+
+    if (length <= 0)
+        return;
+
+    for (i=0; i < list->count && list->ext[i].offset < offset; i++)
+        ;
+    if (i > 0 && list->ext[i-1].offset + list->ext[i-1].length == offset)
+    {
+        i--;
+        offset= list->ext[i].offset;
+        length+= list->ext[i].length;
+        removeExtent(list, i);
+    }
+    if (i < list->count && offset + length == list->ext[i].offset)
+    {
+        length+= list->ext[i].length;
+        removeExtent(list, i);
+    }
+
+    if (offset + length == mgmtInfo->dataEnd)
+        mgmtInfo->dataEnd= offset;
+    else
+        insertExtent(list, i, offset, length);
+}
+
+// Find room for length bytes, first fit in free list or at end of data.
+static long long takeExtent(SM_FileMgmtInfo *mgmtInfo, long long length)
+{
+    SM_ExtentList *list= &mgmtInfo->freeExt;
+    long long offset;
+    int i;
+
+    for (i=0; i < list->count; i++)
+        if (list->ext[i].length >= length)
+        {
+            offset= list->ext[i].offset;
+            list->ext[i].offset+= length;
+            list->ext[i].length-= length;
+            if (list->ext[i].length == 0)
+                removeExtent(list, i);
+            return offset;
+        }
+
+    offset= mgmtInfo->dataEnd;
+    mgmtInfo->dataEnd+= length;
+    return offset;
+}
+
+// Forget image of page. Bytes placed since map was written are free
+// now, others only once the header points to a map without them.
+static void dropImage(SM_FileMgmtInfo *mgmtInfo, int pageNum)
+{
+    SM_PageMapEntry *entry= &mgmtInfo->pageMap[pageNum];
+
+    if (entry->capacity > 0)
+    {
+        if (mgmtInfo->fresh[pageNum])
+            releaseExtent(mgmtInfo, entry->offset, entry->capacity);
+        else
+            insertExtent(&mgmtInfo->pendingExt, mgmtInfo->pendingExt.count,
+                         entry->offset, entry->capacity);
+    }
+    entry->offset= 0;
+    entry->length= entry->capacity= 0;
+    mgmtInfo->fresh[pageNum]= 0;
+}
+
+static int compareExtents(const void *a, const void *b)
+{
+    long long x= ((const SM_Extent*) a)->offset;
+    long long y= ((const SM_Extent*) b)->offset;
+    return x < y ? -1 : x > y;
+}
+
+// Read header and page map of compressed file. Map and images must lie
+// in the file without overlap, the gaps between them are free.
+// Returns number of pages in file or -1 on failure.
+static int loadPageMap(SM_FileMgmtInfo *mgmtInfo, SM_FileHeader *hdr)
+{
+    SM_PageMapEntry *entry;
+    SM_Extent *used;
+    struct stat st;
+    long long mapBytes, end;
+    int i, numUsed= 0, ok= 1;
+
+    if (fstat(mgmtInfo->fd, &st) < 0 || hdr->totalNumPages < 0
+        || hdr->mapOffset < SM_HEADER_SIZE)
+        return -1;
+    mapBytes= (long long) hdr->totalNumPages * sizeof(SM_PageMapEntry);
+    if (hdr->mapOffset + mapBytes > st.st_size)
+        return -1;
+
+    if (growPageMap(mgmtInfo, hdr->totalNumPages) != RC_OK)
+        return -1;
+    if (pread(mgmtInfo->fd, mgmtInfo->pageMap, mapBytes, hdr->mapOffset)
+        < mapBytes)
+        return -1;
+
+    used= (SM_Extent*) malloc((hdr->totalNumPages + 1) * sizeof(SM_Extent));
+    if (!used)
+        return -1;
+    used[numUsed].offset= hdr->mapOffset;
+    used[numUsed++].length= mapBytes;
+    for (i=0; i < hdr->totalNumPages && ok; i++)
+    {
+        entry= &mgmtInfo->pageMap[i];
+        ok= entry->length >= 0 && entry->length <= PAGE_SIZE
+            && entry->capacity >= entry->length;
+        if (ok && entry->capacity > 0)
+        {
+            used[numUsed].offset= entry->offset;
+            used[numUsed++].length= entry->capacity;
+        }
+    }
+
+    // Free list is what lies between map and images
+    qsort(used, numUsed, sizeof(SM_Extent), compareExtents);
+    end= SM_HEADER_SIZE;
+    for (i=0; i < numUsed && ok; i++)
+    {
+        ok= used[i].offset >= end
+            && used[i].offset + used[i].length <= st.st_size;
+        if (ok && used[i].offset > end)
+            ok= insertExtent(&mgmtInfo->freeExt, mgmtInfo->freeExt.count,
+                             end, used[i].offset - end) == RC_OK;
+        end= used[i].offset + used[i].length;
+    }
+    free(used);
+    if (!ok)
+        return -1;
+
+    mgmtInfo->dataEnd= end;
+    mgmtInfo->mapOffset= hdr->mapOffset;
+    mgmtInfo->mapBytes= mapBytes;
+    return hdr->totalNumPages;
+}
+
+// Write file header of given format at start of file.
+static RC writeHeader(int fd, SM_FileHeader *hdr, const char *magic)
+{
+    memcpy(hdr->magic, magic, sizeof(hdr->magic));
+    if (pwrite(fd, hdr, sizeof(SM_FileHeader), 0)
+        < (int) sizeof(SM_FileHeader))
+        RETURN(RC_WRITE_FAILED);
+    RETURN(RC_OK);
+}
+
+// Persist page count and extent size of plain file.
+static RC flushPlainHeader(SM_FileHandle *fHandle, int numPages)
+{
+    SM_FileMgmtInfo *mgmtInfo= (SM_FileMgmtInfo*) fHandle->mgmtInfo;
+    SM_FileHeader hdr;
+
+    memset(&hdr, 0, sizeof(hdr));
+    hdr.totalNumPages= numPages;
+    hdr.allocatedPages= mgmtInfo->allocatedPages;
+    return writeHeader(mgmtInfo->fd, &hdr, SM_PLAIN_MAGIC);
+}
+
+// Persist page map in free space and point header to it. Old map and
+// replaced images are only freed after that.
+static RC flushPageMap(SM_FileHandle *fHandle)
+{
+    SM_FileMgmtInfo *mgmtInfo= (SM_FileMgmtInfo*) fHandle->mgmtInfo;
+    SM_PageMapEntry *entry;
+    SM_FileHeader hdr;
+    long long mapBytes= (long long) fHandle->totalNumPages
+                        * sizeof(SM_PageMapEntry);
+    long long end;
+    int i;
+
+    if (!mgmtInfo->mapDirty)
+        RETURN(RC_OK);
+
+    memset(&hdr, 0, sizeof(hdr));
+    hdr.totalNumPages= fHandle->totalNumPages;
+    hdr.mapOffset= takeExtent(mgmtInfo, mapBytes);
+    if (pwrite(mgmtInfo->fd, mgmtInfo->pageMap, mapBytes, hdr.mapOffset)
+        < mapBytes)
+    {
+        releaseExtent(mgmtInfo, hdr.mapOffset, mapBytes);
+        RETURN(RC_WRITE_FAILED);
+    }
+
+    // Data ends with last extent the new map needs
+    end= hdr.mapOffset + mapBytes;
+    for (i=0; i < fHandle->totalNumPages; i++)
+    {
+        entry= &mgmtInfo->pageMap[i];
+        if (entry->capacity > 0 && entry->offset + entry->capacity > end)
+            end= entry->offset + entry->capacity;
+    }
+    hdr.dataEnd= end;
+    if (writeHeader(mgmtInfo->fd, &hdr, SM_COMPRESSED_MAGIC) != RC_OK)
+    {
+        releaseExtent(mgmtInfo, hdr.mapOffset, mapBytes);
+        RETURN(RC_WRITE_FAILED);
+    }
+
+    // Nothing on disk names old map and replaced images any more
+    releaseExtent(mgmtInfo, mgmtInfo->mapOffset, mgmtInfo->mapBytes);
+    for (i=0; i < mgmtInfo->pendingExt.count; i++)
+        releaseExtent(mgmtInfo, mgmtInfo->pendingExt.ext[i].offset,
+                      mgmtInfo->pendingExt.ext[i].length);
+    mgmtInfo->pendingExt.count= 0;
+    memset(mgmtInfo->fresh, 0, mgmtInfo->mapSize);
+    mgmtInfo->mapOffset= hdr.mapOffset;
+    mgmtInfo->mapBytes= mapBytes;
+    mgmtInfo->mapDirty= 0;
+
+    // Free bytes at end of data area are cut off
+    if (ftruncate(mgmtInfo->fd, mgmtInfo->dataEnd) < 0)
+        RETURN(RC_WRITE_FAILED);
+    RETURN(RC_OK);
+}
+
+// Grow file to hold numPages. Plain files are extended by whole
+// extents, so most calls are only bookkeeping.
+static RC growFile(SM_FileHandle *fHandle, int numPages)
+{
+    SM_FileMgmtInfo *mgmtInfo= (SM_FileMgmtInfo*) fHandle->mgmtInfo;
+    int chunk= storageManager.growthChunk;
+    int newAlloc;
+
+    if (numPages <= fHandle->totalNumPages)
+        RETURN(RC_OK);
+
+    if (mgmtInfo->format == SM_FORMAT_COMPRESSED)
+    {
+        // Zero pages of compressed file are only map entries
+        if (growPageMap(mgmtInfo, numPages) != RC_OK)
+            RETURN(RC_WRITE_FAILED);
+        mgmtInfo->mapDirty= 1;
+    }
+    else if (numPages > mgmtInfo->allocatedPages)
+    {
+        // Legacy files derive page count from size, they can't have slack.
+        newAlloc= numPages;
+        if (mgmtInfo->format == SM_FORMAT_PLAIN && chunk > 1)
+            newAlloc= ((numPages + chunk - 1) / chunk) * chunk;
+
+        if (ftruncate(mgmtInfo->fd, PAGE_OFFSET(mgmtInfo, newAlloc)) < 0)
+            RETURN(RC_WRITE_FAILED);
+        mgmtInfo->allocatedPages= newAlloc;
+
+        // Close writes exact count, until then whole extent is in use
+        if (mgmtInfo->format == SM_FORMAT_PLAIN
+            && flushPlainHeader(fHandle, newAlloc) != RC_OK)
+            RETURN(RC_WRITE_FAILED);
+    }
+
+    fHandle->totalNumPages= numPages;
+    RETURN(RC_OK);
+}
+
+// Expand page image of compressed file into memPage
+static RC readCompressedPage(int pageNum, SM_FileMgmtInfo *mgmtInfo,
+                             SM_PageHandle memPage)
+{
+    SM_PageMapEntry *entry= &mgmtInfo->pageMap[pageNum];
+    char image[PAGE_COMPRESS_BOUND];
+
+    // Zero page, nothing stored on disk.
+    if (entry->length == 0)
+    {
+        memset(memPage, 0, PAGE_SIZE);
+        RETURN(RC_OK);
+    }
+
+    if (entry->length == PAGE_SIZE)
+    {
+        if (pread(mgmtInfo->fd, memPage, PAGE_SIZE, entry->offset) < PAGE_SIZE)
+            RETURN(RC_READ_FAILED);
+        RETURN(RC_OK);
+    }
+
+    if (pread(mgmtInfo->fd, image, entry->length, entry->offset)
+        < entry->length)
+        RETURN(RC_READ_FAILED);
+    return decompressPage(image, entry->length, memPage);
+}
+
+// Compress memPage and store it. Image is rewritten in place only if
+// map on disk does not name it and it still fits.
+static RC writeCompressedPage(int pageNum, SM_FileMgmtInfo *mgmtInfo,
+                              SM_PageHandle memPage)
+{
+    SM_PageMapEntry *entry= &mgmtInfo->pageMap[pageNum];
+    char image[PAGE_COMPRESS_BOUND];
+    char *src= image;
+    long long offset;
+    int len, capacity;
+
+    mgmtInfo->mapDirty= 1;
+
+    // Elide zero pages, they need no bytes on disk.
+    if (isZeroPage(memPage))
+    {
+        dropImage(mgmtInfo, pageNum);
+        RETURN(RC_OK);
+    }
+
+    len= compressPage(memPage, image);
+    if (len >= PAGE_SIZE)
+    {
+        // Incompressible, store raw image.
+        src= memPage;
+        len= PAGE_SIZE;
+    }
+
+    if (mgmtInfo->fresh[pageNum] && len <= entry->capacity)
+    {
+        if (pwrite(mgmtInfo->fd, src, len, entry->offset) < len)
+            RETURN(RC_WRITE_FAILED);
+        entry->length= len;
+        RETURN(RC_OK);
+    }
+
+    // New image is written before the map names it
+    capacity= ALIGN_IMAGE(len);
+    offset= takeExtent(mgmtInfo, capacity);
+    if (pwrite(mgmtInfo->fd, src, len, offset) < len)
+    {
+        releaseExtent(mgmtInfo, offset, capacity);
+        RETURN(RC_WRITE_FAILED);
+    }
+    dropImage(mgmtInfo, pageNum);
+    entry->offset= offset;
+    entry->length= len;
+    entry->capacity= capacity;
+    mgmtInfo->fresh[pageNum]= 1;
+
+    RETURN(RC_OK);
+}
+
 /************************************************************
  *                    interface                             *
  ************************************************************/
@@ -103,13 +625,23 @@ static int getLastPageNo(char* fileName)
 void initStorageManager (void)
 {
     if (isStorageManagerInitialized() != RC_OK)
+    {
         storageManager.init= 1;
+        storageManager.growthChunk= DEFAULT_GROWTH_CHUNK;
+    }
+}
+
+/* Set number of pages a page file grows by, 1 disables extents */
+void setPageFileGrowthChunk (int numPages)
+{
+    storageManager.growthChunk= numPages > 0 ? numPages : 1;
 }
 
 /* Create page file */
 RC createPageFile (char *fileName)
 {
     int fd;
+    SM_FileHeader hdr;
 
     // Is storage manager initialized?
     if (isStorageManagerInitialized() != RC_OK)
@@ -119,24 +651,60 @@ RC createPageFile (char *fileName)
     if ((fd= open(fileName, O_CREAT|O_EXCL|O_RDWR, S_IRWXU)) > 0 )
     //if ((fd= open(fileName, O_CREAT|O_RDWR, S_IRWXU)) > 0 )
     {
-        // Add 1 page with zerobytes of page size
-        char zeropage[PAGE_SIZE];
-        memset(zeropage, 0, PAGE_SIZE);
-        if (write(fd, zeropage, PAGE_SIZE) < PAGE_SIZE)
+        // Header and 1 zero page, which is a hole in the file.
+        memset(&hdr, 0, sizeof(hdr));
+        hdr.totalNumPages= hdr.allocatedPages= 1;
+        if (writeHeader(fd, &hdr, SM_PLAIN_MAGIC) != RC_OK
+            || ftruncate(fd, SM_HEADER_SIZE + PAGE_SIZE) < 0)
         {
           close(fd);
           RETURN(RC_WRITE_FAILED);
         }
 
+        close(fd);
         RETURN(RC_OK);
     }
     RETURN(RC_FILE_CREATE_FAILED);
 }
 
+/* Create page file that stores compressed page images */
+RC createCompressedPageFile (char *fileName)
+{
+    int fd;
+    SM_FileHeader hdr;
+    SM_PageMapEntry zeroEntry;
+
+    // Is storage manager initialized?
+    if (isStorageManagerInitialized() != RC_OK)
+        RETURN(RC_SM_NOT_INIT);
+
+    if ((fd= open(fileName, O_CREAT|O_EXCL|O_RDWR, S_IRWXU)) < 0)
+        RETURN(RC_FILE_CREATE_FAILED);
+
+    // 1 zero page, which is elided and only needs a map entry.
+    memset(&hdr, 0, sizeof(hdr));
+    hdr.totalNumPages= 1;
+    hdr.mapOffset= SM_HEADER_SIZE;
+    hdr.dataEnd= SM_HEADER_SIZE + sizeof(zeroEntry);
+    memset(&zeroEntry, 0, sizeof(zeroEntry));
+
+    if (writeHeader(fd, &hdr, SM_COMPRESSED_MAGIC) != RC_OK
+        || pwrite(fd, &zeroEntry, sizeof(zeroEntry), hdr.mapOffset)
+           < (int) sizeof(zeroEntry))
+    {
+        close(fd);
+        RETURN(RC_WRITE_FAILED);
+    }
+
+    close(fd);
+    RETURN(RC_OK);
+}
+
 /* Open the page file and register it with Storage Engine */
 RC openPageFile (char *fileName, SM_FileHandle *fHandle)
 {
     int fd;
+    SM_FileHeader hdr;
 
     // Is storage manager initialized?
     if (isStorageManagerInitialized() != RC_OK)
@@ -152,14 +720,45 @@ RC openPageFile (char *fileName, SM_FileHandle *fHandle)
         fHandle->fileName= (char*) malloc(strlen(fileName)+1);
         strcpy(fHandle->fileName, fileName);
         fHandle->curPagePos= 0;
-        
-        fHandle->totalNumPages= getLastPageNo(fHandle->fileName)+1;
 
         SM_FileMgmtInfo *mgmtInfo= (SM_FileMgmtInfo*) 
-                                     malloc(sizeof(SM_FileMgmtInfo));
+                                     calloc(1, sizeof(SM_FileMgmtInfo));
         mgmtInfo->fd= fd;
         fHandle->mgmtInfo= mgmtInfo;
 
+        // Format is recognized by header magic.
+        if (read(fd, &hdr, sizeof(hdr)) < (int) sizeof(hdr))
+            memset(&hdr, 0, sizeof(hdr));
+
+        if (memcmp(hdr.magic, SM_COMPRESSED_MAGIC, sizeof(hdr.magic)) == 0)
+        {
+            mgmtInfo->format= SM_FORMAT_COMPRESSED;
+            fHandle->totalNumPages= loadPageMap(mgmtInfo, &hdr);
+            if (fHandle->totalNumPages < 0)
+            {
+                close(fd);
+                freeMgmtInfo(mgmtInfo);
+                free(fHandle->fileName);
+                fHandle->mgmtInfo= NULL;
+                fHandle->fileName= NULL;
+                RETURN(RC_READ_FAILED);
+            }
+        }
+        else if (memcmp(hdr.magic, SM_PLAIN_MAGIC, sizeof(hdr.magic)) == 0)
+        {
+            mgmtInfo->format= SM_FORMAT_PLAIN;
+            mgmtInfo->dataOffset= SM_HEADER_SIZE;
+            mgmtInfo->allocatedPages= hdr.allocatedPages;
+            fHandle->totalNumPages= hdr.totalNumPages;
+        }
+        else
+        {
+            mgmtInfo->format= SM_FORMAT_LEGACY;
+            mgmtInfo->dataOffset= 0;
+            fHandle->totalNumPages= getLastPageNo(fHandle->fileName)+1;
+            mgmtInfo->allocatedPages= fHandle->totalNumPages;
+        }
+
         // Register the fHandle
         registerFileHandle(fHandle);
 
@@ -171,6 +770,9 @@ RC openPageFile (char *fileName, SM_FileHandle *fHandle)
 /* Close the page file and de-register it from Storage Engine */
 RC closePageFile (SM_FileHandle *fHandle)
 {
+    RC rc;
+    SM_FileMgmtInfo *mgmtInfo;
+
     // Is storage manager initialized?
     if (isStorageManagerInitialized() != RC_OK)
         RETURN(RC_SM_NOT_INIT);
@@ -179,8 +781,19 @@ RC closePageFile (SM_FileHandle *fHandle)
     if (isFileHandleOpen(fHandle) != RC_OK)
         RETURN(RC_FILE_HANDLE_NOT_INIT);
 
+    mgmtInfo= (SM_FileMgmtInfo*) fHandle->mgmtInfo;
+
+    // Page count and page map live in memory while file is open
+    rc= RC_OK;
+    if (mgmtInfo->format == SM_FORMAT_COMPRESSED)
+        rc= flushPageMap(fHandle);
+    else if (mgmtInfo->format == SM_FORMAT_PLAIN)
+        rc= flushPlainHeader(fHandle, fHandle->totalNumPages);
+    if (rc != RC_OK)
+        RETURN(rc);
+
     // Close the file
-    if (close(((SM_FileMgmtInfo*)fHandle->mgmtInfo)->fd) < 0 )
+    if (close(mgmtInfo->fd) < 0 )
         RETURN(RC_FILE_CLOSE_FAILED);
 
     // Deregister handle from storage manager
@@ -189,7 +802,7 @@ RC closePageFile (SM_FileHandle *fHandle)
     // Free mem allocated for fHandle
     free(fHandle->fileName);
     fHandle->fileName= NULL;
-    free(fHandle->mgmtInfo);
+    freeMgmtInfo(mgmtInfo);
     fHandle->mgmtInfo= NULL;
 
     RETURN(RC_OK);
@@ -213,17 +826,31 @@ RC destroyPageFile (char *fileName)
 static RC readBytes(int pageNum, SM_FileHandle *fHandle, SM_PageHandle memPage)
 {
     int fd;
+    RC rc;
+    SM_FileMgmtInfo *mgmtInfo;
+    long long start= latencyStart();
     // Do we have this page?
     if (pageNum >= fHandle->totalNumPages || pageNum < 0)
         RETURN(RC_READ_NON_EXISTING_PAGE);
 
     // Read the block
-    fd= (int) ((SM_FileMgmtInfo*) fHandle->mgmtInfo)->fd;
-    lseek(fd, PAGE_OFFSET(pageNum), SEEK_SET);
-    if (read(fd, memPage, PAGE_SIZE) < PAGE_SIZE)
-        RETURN(RC_READ_FAILED);
+    mgmtInfo= (SM_FileMgmtInfo*) fHandle->mgmtInfo;
+    if (mgmtInfo->format == SM_FORMAT_COMPRESSED)
+    {
+        rc= readCompressedPage(pageNum, mgmtInfo, memPage);
+        if (rc != RC_OK)
+            RETURN(rc);
+    }
+    else
+    {
+        fd= mgmtInfo->fd;
+        if (pread(fd, memPage, PAGE_SIZE, PAGE_OFFSET(mgmtInfo, pageNum))
+            < PAGE_SIZE)
+            RETURN(RC_READ_FAILED);
+    }
 
     fHandle->curPagePos= pageNum;
+    recordLatencySince(&readLatency, start);
     RETURN(RC_OK);
 }
 
@@ -231,18 +858,32 @@ static RC readBytes(int pageNum, SM_FileHandle *fHandle, SM_PageHandle memPage)
 static RC writeBytes(int pageNum, SM_FileHandle *fHandle, SM_PageHandle memPage)
 {
     int fd;
+    RC rc;
+    SM_FileMgmtInfo *mgmtInfo;
+    long long start= latencyStart();
     // Do we have this page?
     if(pageNum < 0)
         RETURN(RC_READ_NON_EXISTING_PAGE);
 
-    // Read the block
-    fd= (int) ((SM_FileMgmtInfo*) fHandle->mgmtInfo)->fd;
-    lseek(fd, PAGE_OFFSET(pageNum), SEEK_SET);
-    if (pageNum >= fHandle->totalNumPages)
-        fHandle->totalNumPages= pageNum+1;
-    if (write(fd, memPage, PAGE_SIZE) < PAGE_SIZE)
+    // Write the block
+    mgmtInfo= (SM_FileMgmtInfo*) fHandle->mgmtInfo;
+    if (growFile(fHandle, pageNum+1) != RC_OK)
         RETURN(RC_WRITE_FAILED);
+    if (mgmtInfo->format == SM_FORMAT_COMPRESSED)
+    {
+        rc= writeCompressedPage(pageNum, mgmtInfo, memPage);
+        if (rc != RC_OK)
+            RETURN(rc);
+    }
+    else
+    {
+        fd= mgmtInfo->fd;
+        if (pwrite(fd, memPage, PAGE_SIZE, PAGE_OFFSET(mgmtInfo, pageNum))
+            < PAGE_SIZE)
+            RETURN(RC_WRITE_FAILED);
+    }
 
+    recordLatencySince(&writeLatency, start);
     RETURN(RC_OK);
 }
 
@@ -260,6 +901,69 @@ RC readBlock (int pageNum, SM_FileHandle *fHandle, SM_PageHandle memPage)
     return readBytes(pageNum, fHandle, memPage);
 }
 
+/* Read numPages consecutive pages starting at startPage. Plain files
+   give them with one vectored read per MAX_IOV pages, each recorded
+   as one read latency. */
+RC readBlocks (int startPage, int numPages, SM_FileHandle *fHandle, SM_PageHandle *pages)
+{
+    SM_FileMgmtInfo *mgmtInfo;
+    struct iovec iov[MAX_IOV];
+    ssize_t len;
+    long long start;
+    int i, j, count;
+    RC rc;
+
+    // Is storage manager initialized?
+    if (isStorageManagerInitialized() != RC_OK)
+        RETURN(RC_SM_NOT_INIT);
+
+    // Is this handle already in use?
+    if (isFileHandleOpen(fHandle) != RC_OK)
+        RETURN(RC_FILE_HANDLE_NOT_INIT);
+
+    // Do we have these pages?
+    if (startPage < 0 || numPages < 0
+        || startPage + numPages > fHandle->totalNumPages)
+        RETURN(RC_READ_NON_EXISTING_PAGE);
+    if (numPages == 0)
+        RETURN(RC_OK);
+
+    mgmtInfo= (SM_FileMgmtInfo*) fHandle->mgmtInfo;
+    if (mgmtInfo->format == SM_FORMAT_COMPRESSED)
+    {
+        // Images are scattered over the file, read them one by one.
+        for (i=0; i < numPages; i++)
+        {
+            start= latencyStart();
+            rc= readCompressedPage(startPage + i, mgmtInfo, pages[i]);
+            if (rc != RC_OK)
+                RETURN(rc);
+            recordLatencySince(&readLatency, start);
+        }
+    }
+    else
+    {
+        for (i=0; i < numPages; i+= count)
+        {
+            count= numPages - i < MAX_IOV ? numPages - i : MAX_IOV;
+            for (j=0; j < count; j++)
+            {
+                iov[j].iov_base= pages[i + j];
+                iov[j].iov_len= PAGE_SIZE;
+            }
+            start= latencyStart();
+            len= preadv(mgmtInfo->fd, iov, count,
+                        PAGE_OFFSET(mgmtInfo, startPage + i));
+            if (len < (ssize_t) count * PAGE_SIZE)
+                RETURN(RC_READ_FAILED);
+            recordLatencySince(&readLatency, start);
+        }
+    }
+
+    fHandle->curPagePos= startPage + numPages - 1;
+    RETURN(RC_OK);
+}
+
 /* Read current page position */
 int getBlockPos (SM_FileHandle *fHandle)
 {
@@ -350,6 +1054,65 @@ RC writeBlock (int pageNum, SM_FileHandle *fHandle, SM_PageHandle memPage)
     return writeBytes (pageNum, fHandle, memPage);
 }
 
+/* Write numPages consecutive pages starting at startPage. Plain files
+   take them with one vectored write per MAX_IOV pages, each recorded
+   as one write latency. */
+RC writeBlocks (int startPage, int numPages, SM_FileHandle *fHandle, SM_PageHandle *pages)
+{
+    SM_FileMgmtInfo *mgmtInfo;
+    struct iovec iov[MAX_IOV];
+    ssize_t len;
+    long long start;
+    int i, j, count;
+    RC rc;
+
+    // Is storage manager initialized?
+    if (isStorageManagerInitialized() != RC_OK)
+        RETURN(RC_SM_NOT_INIT);
+
+    // Is this handle already in use?
+    if (isFileHandleOpen(fHandle) != RC_OK)
+        RETURN(RC_FILE_HANDLE_NOT_INIT);
+
+    if (startPage < 0 || numPages < 0)
+        RETURN(RC_READ_NON_EXISTING_PAGE);
+    if (growFile(fHandle, startPage + numPages) != RC_OK)
+        RETURN(RC_WRITE_FAILED);
+
+    mgmtInfo= (SM_FileMgmtInfo*) fHandle->mgmtInfo;
+    if (mgmtInfo->format == SM_FORMAT_COMPRESSED)
+    {
+        // Every image has its own place, nothing to gain from one write.
+        for (i=0; i < numPages; i++)
+        {
+            start= latencyStart();
+            rc= writeCompressedPage(startPage + i, mgmtInfo, pages[i]);
+            if (rc != RC_OK)
+                RETURN(rc);
+            recordLatencySince(&writeLatency, start);
+        }
+        RETURN(RC_OK);
+    }
+
+    for (i=0; i < numPages; i+= count)
+    {
+        count= numPages - i < MAX_IOV ? numPages - i : MAX_IOV;
+        for (j=0; j < count; j++)
+        {
+            iov[j].iov_base= pages[i + j];
+            iov[j].iov_len= PAGE_SIZE;
+        }
+        start= latencyStart();
+        len= pwritev(mgmtInfo->fd, iov, count,
+                     PAGE_OFFSET(mgmtInfo, startPage + i));
+        if (len < (ssize_t) count * PAGE_SIZE)
+            RETURN(RC_WRITE_FAILED);
+        recordLatencySince(&writeLatency, start);
+    }
+
+    RETURN(RC_OK);
+}
+
 /* writing blocks to current page number */
 RC writeCurrentBlock (SM_FileHandle *fHandle, SM_PageHandle memPage)
 {
@@ -367,7 +1130,6 @@ RC writeCurrentBlock (SM_FileHandle *fHandle, SM_PageHandle memPage)
 /* Append a new block to page file */
 RC appendEmptyBlock (SM_FileHandle *fHandle)
 {
-    char zeropage[PAGE_SIZE];
     // Is storage manager initialized?
     if (isStorageManagerInitialized() != RC_OK)
         RETURN(RC_SM_NOT_INIT);
@@ -376,14 +1138,12 @@ RC appendEmptyBlock (SM_FileHandle *fHandle)
     if (isFileHandleOpen(fHandle) != RC_OK)
         RETURN(RC_FILE_HANDLE_NOT_INIT);
 
-    memset(zeropage, 0, PAGE_SIZE);
-	return writeBytes (fHandle->totalNumPages, fHandle, (SM_PageHandle) &zeropage);
+    return growFile(fHandle, fHandle->totalNumPages+1);
 }
 
 /* Make sure that page file has specified number of pages */
 RC ensureCapacity (int numberOfPages, SM_FileHandle *fHandle)
 {
-    char zeropage[PAGE_SIZE];
     // Is storage manager initialized?
     if (isStorageManagerInitialized() != RC_OK)
         RETURN(RC_SM_NOT_INIT);
@@ -392,10 +1152,19 @@ RC ensureCapacity (int numberOfPages, SM_FileHandle *fHandle)
     if (isFileHandleOpen(fHandle) != RC_OK)
         RETURN(RC_FILE_HANDLE_NOT_INIT);
 
-    if (numberOfPages > fHandle->totalNumPages)
-    {
-        memset(zeropage, 0, PAGE_SIZE);
-        return writeBytes (numberOfPages-1, fHandle, (SM_PageHandle) &zeropage);
-    }
+    return growFile(fHandle, numberOfPages);
+}
+
+/* Latency of page reads and writes since last reset */
+RC getIOLatency (LH_Snapshot *read, LH_Snapshot *write)
+{
+    getLatencySnapshot(&readLatency, read);
+    getLatencySnapshot(&writeLatency, write);
     RETURN(RC_OK);
 }
+
+void resetIOLatency (void)
+{
+    initLatencyHistogram(&readLatency);
+    initLatencyHistogram(&writeLatency);
+}
@@ -1,43 +1,53 @@
-#ifndef STORAGE_MGR_H
-#define STORAGE_MGR_H
-
-#include "dberror.h"
-
-/************************************************************
- *                    handle data structures                *
- ************************************************************/
-typedef struct SM_FileHandle {
-  char *fileName;
-  int totalNumPages;
-  int curPagePos;
-  void *mgmtInfo;
-} SM_FileHandle;
-
-typedef char* SM_PageHandle;
-
-/************************************************************
- *                    interface                             *
- ************************************************************/
-/* manipulating page files */
-extern void initStorageManager (void);
-extern RC createPageFile (char *fileName);
-extern RC openPageFile (char *fileName, SM_FileHandle *fHandle);
-extern RC closePageFile (SM_FileHandle *fHandle);
-extern RC destroyPageFile (char *fileName);
-
-/* reading blocks from disc */
-extern RC readBlock (int pageNum, SM_FileHandle *fHandle, SM_PageHandle memPage);
-extern int getBlockPos (SM_FileHandle *fHandle);
-extern RC readFirstBlock (SM_FileHandle *fHandle, SM_PageHandle memPage);
-extern RC readPreviousBlock (SM_FileHandle *fHandle, SM_PageHandle memPage);
-extern RC readCurrentBlock (SM_FileHandle *fHandle, SM_PageHandle memPage);
-extern RC readNextBlock (SM_FileHandle *fHandle, SM_PageHandle memPage);
-extern RC readLastBlock (SM_FileHandle *fHandle, SM_PageHandle memPage);
-
-/* writing blocks to a page file */
-extern RC writeBlock (int pageNum, SM_FileHandle *fHandle, SM_PageHandle memPage);
-extern RC writeCurrentBlock (SM_FileHandle *fHandle, SM_PageHandle memPage);
-extern RC appendEmptyBlock (SM_FileHandle *fHandle);
-extern RC ensureCapacity (int numberOfPages, SM_FileHandle *fHandle);
-
+#ifndef STORAGE_MGR_H
+#define STORAGE_MGR_H
+
+#include "dberror.h"
+#include "latency_hist.h"
+
+/************************************************************
+ *                    handle data structures                *
+ ************************************************************/
+typedef struct SM_FileHandle {
+  char *fileName;
+  int totalNumPages;
+  int curPagePos;
+  void *mgmtInfo;
+} SM_FileHandle;
+
+typedef char* SM_PageHandle;
+
+/************************************************************
+ *                    interface                             *
+ ************************************************************/
+/* manipulating page files */
+extern void initStorageManager (void);
+extern void setPageFileGrowthChunk (int numPages);
+extern RC createPageFile (char *fileName);
+extern RC createCompressedPageFile (char *fileName);
+extern RC openPageFile (char *fileName, SM_FileHandle *fHandle);
+extern RC closePageFile (SM_FileHandle *fHandle);
+extern RC destroyPageFile (char *fileName);
+
+/* reading blocks from disc */
+extern RC readBlock (int pageNum, SM_FileHandle *fHandle, SM_PageHandle memPage);
+extern RC readBlocks (int startPage, int numPages, SM_FileHandle *fHandle, SM_PageHandle *pages);
+extern int getBlockPos (SM_FileHandle *fHandle);
+extern RC readFirstBlock (SM_FileHandle *fHandle, SM_PageHandle memPage);
+extern RC readPreviousBlock (SM_FileHandle *fHandle, SM_PageHandle memPage);
+extern RC readCurrentBlock (SM_FileHandle *fHandle, SM_PageHandle memPage);
+extern RC readNextBlock (SM_FileHandle *fHandle, SM_PageHandle memPage);
+extern RC readLastBlock (SM_FileHandle *fHandle, SM_PageHandle memPage);
+
+/* writing blocks to a page file */
+extern RC writeBlock (int pageNum, SM_FileHandle *fHandle, SM_PageHandle memPage);
+extern RC writeCurrentBlock (SM_FileHandle *fHandle, SM_PageHandle memPage);
+extern RC writeBlocks (int startPage, int numPages, SM_FileHandle *fHandle, SM_PageHandle *pages);
+extern RC appendEmptyBlock (SM_FileHandle *fHandle);
+extern RC ensureCapacity (int numberOfPages, SM_FileHandle *fHandle);
+
+/* latency of page reads and writes, see setLatencyTracking. A vectored
+   read of readBlocks counts as one read. */
+extern RC getIOLatency (LH_Snapshot *read, LH_Snapshot *write);
+extern void resetIOLatency (void);
+
 #endif
\ No newline at end of file
@@ -0,0 +1,90 @@
+#ifndef TABLES_H
+#define TABLES_H
+
+#include "dt.h"
+
+// Data Types, Records, and Schemas
+typedef enum DataType {
+  DT_INT = 0,
+  DT_STRING = 1,
+  DT_FLOAT = 2,
+  DT_BOOL = 3
+} DataType;
+
+typedef struct Value {
+  DataType dt;
+  union v {
+    int intV;
+    char *stringV;
+    float floatV;
+    bool boolV;
+  } v;
+} Value;
+
+typedef struct RID {
+  int page;
+  int slot;
+} RID;
+
+typedef struct Record
+{
+  RID id;
+  char *data;
+} Record;
+
+// information of a table schema: its attributes, datatypes,
+// DT_STRING attributes are stored with at most typeLength bytes.
+typedef struct Schema
+{
+  int numAttr;
+  char **attrNames;
+  DataType *dataTypes;
+  int *typeLength;
+  int *keyAttrs;
+  int keySize;
+} Schema;
+
+// TableData: Management Structure for a Record Manager to handle one relation
+typedef struct RM_TableData
+{
+  char *name;
+  Schema *schema;
+  void *mgmtData;
+} RM_TableData;
+
+#define MAKE_STRING_VALUE(result, value)				\
+  do {									\
+    (result) = (Value *) malloc(sizeof(Value));				\
+    (result)->dt = DT_STRING;						\
+    (result)->v.stringV = (char *) malloc(strlen(value) + 1);		\
+    strcpy((result)->v.stringV, value);					\
+  } while(0)
+
+
+#define MAKE_VALUE(result, datatype, value)				\
+  do {									\
+    (result) = (Value *) malloc(sizeof(Value));				\
+    (result)->dt = datatype;						\
+    switch(datatype)							\
+      {									\
+      case DT_INT:							\
+	(result)->v.intV = value;					\
+	break;								\
+      case DT_FLOAT:							\
+	(result)->v.floatV = value;					\
+	break;								\
+      case DT_BOOL:							\
+	(result)->v.boolV = value;					\
+	break;								\
+      default:								\
+	break;								\
+      }									\
+  } while(0)
+
+
+// debug and read methods
+extern Value *stringToValue (char *value);
+extern char *serializeValue (Value *val);
+extern char *serializeRecord (Record *record, Schema *schema);
+
+#endif
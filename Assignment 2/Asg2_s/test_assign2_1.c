@@ -1,12 +1,19 @@
 #include "storage_mgr.h"
 #include "buffer_mgr_stat.h"
 #include "buffer_mgr.h"
+#include "free_space_mgr.h"
+#include "buffer_trace.h"
+#include "mrc.h"
+#include "pool_mgr.h"
 #include "dberror.h"
 #include "test_helper.h"
 
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <sched.h>
+#include <unistd.h>
+#include <sys/stat.h>
 
 // var to store the current test's name
 char *testName;
@@ -37,6 +44,35 @@ static void testReadPage (void);
 
 static void testFIFO (void);
 static void testLRU (void);
+static void testPoolStats (void);
+static void testLatencyHistograms (void);
+static void testPoolSnapshot (void);
+static void testTraceReplay (void);
+static void testMissRatioCurve (void);
+static void testPredictedHitRatio (void);
+static void testResizePool (void);
+static void testPoolManager (void);
+static void testStaleHandles (void);
+static void testBatchPin (void);
+static void testPageLatches (void);
+static void *latchWriter (void *arg);
+static void *latchReader (void *arg);
+static void testOptimisticReads (void);
+static void *optimisticWriter (void *arg);
+static void *optimisticReader (void *arg);
+static void copyCounters (const char *data, void *arg);
+static void testSnapshotReads (void);
+static void *snapshotReader (void *arg);
+static void testFrameArena (void);
+static void testThreadErrors (void);
+static void *errorThread (void *arg);
+static void *pinThread (void *arg);
+static void testCompressedPageMap (void);
+static void testCompressedRewrites (void);
+static void fillRewrite (char *page, int pageNum, int version);
+static void testPageFileExtents (void);
+static void testFreeSpaceMap (void);
+static void testFlushedPages (void);
 
 // main method
 int 
@@ -49,6 +85,26 @@ main (void)
   testReadPage();
   testFIFO();
   testLRU();
+  testPoolStats();
+  testLatencyHistograms();
+  testPoolSnapshot();
+  testTraceReplay();
+  testMissRatioCurve();
+  testPredictedHitRatio();
+  testResizePool();
+  testPoolManager();
+  testStaleHandles();
+  testBatchPin();
+  testPageLatches();
+  testOptimisticReads();
+  testSnapshotReads();
+  testFrameArena();
+  testThreadErrors();
+  testCompressedPageMap();
+  testCompressedRewrites();
+  testPageFileExtents();
+  testFreeSpaceMap();
+  testFlushedPages();
 }
 
 // create n pages with content "Page X" and read them back to check whether the content is right
@@ -296,4 +352,1553 @@ testLRU (void)
   free(bm);
   free(h);
   TEST_DONE();
-}
\ No newline at end of file
+}
+
+// pin random pages of the pool from a thread
+#define STAT_THREADS 4
+#define STAT_PINS 10000
+void *
+pinThread (void *arg)
+{
+  BM_BufferPool *bm = (BM_BufferPool *) arg;
+  BM_PageHandle h;
+  unsigned int seed = (unsigned int) (size_t) &h;
+  int i;
+
+  for(i = 0; i < STAT_PINS; i++)
+    {
+      if (pinPage(bm, &h, rand_r(&seed) % 20) != RC_OK)
+        continue;
+      unpinPage(bm, &h);
+    }
+  return NULL;
+}
+
+// test hit, miss and eviction counters
+void
+testPoolStats (void)
+{
+  BM_BufferPool *bm = MAKE_POOL();
+  BM_PageHandle *h = MAKE_PAGE_HANDLE();
+  BM_PoolStats stats;
+  pthread_t threads[STAT_THREADS];
+  int i;
+  testName = "Testing buffer pool statistics";
+
+  CHECK(createPageFile("testbuffer.bin"));
+  createDummyPages(bm, 20);
+  CHECK(initBufferPool(bm, "testbuffer.bin", 3, RS_FIFO, NULL));
+
+  // pages 0-2 are read, 0 and 1 are hits, 3 and 4 evict 0 and 1
+  for(i = 0; i < 3; i++)
+    {
+      CHECK(pinPage(bm, h, i));
+      CHECK(unpinPage(bm, h));
+    }
+  CHECK(pinPage(bm, h, 0));
+  CHECK(markDirty(bm, h));
+  CHECK(unpinPage(bm, h));
+  CHECK(pinPage(bm, h, 1));
+  CHECK(unpinPage(bm, h));
+  CHECK(pinPage(bm, h, 3));
+  CHECK(unpinPage(bm, h));
+  CHECK(pinPage(bm, h, 4));
+  CHECK(markDirty(bm, h));
+  CHECK(unpinPage(bm, h));
+  CHECK(forceFlushPool(bm));
+
+  CHECK(getPoolStats(bm, &stats));
+  ASSERT_EQUALS_INT(2, (int) stats.hits, "hits");
+  ASSERT_EQUALS_INT(5, (int) stats.misses, "misses");
+  ASSERT_EQUALS_INT(1, (int) stats.dirtyEvictions, "dirty evictions");
+  ASSERT_EQUALS_INT(1, (int) stats.cleanEvictions, "clean evictions");
+  ASSERT_EQUALS_INT(1, (int) stats.flushes, "flushes");
+  ASSERT_EQUALS_INT(5, (int) stats.numReadIO, "read I/Os");
+  ASSERT_EQUALS_INT(2, (int) stats.numWriteIO, "write I/Os");
+  ASSERT_EQUALS_INT(5 * PAGE_SIZE, (int) stats.bytesRead, "bytes read");
+  ASSERT_EQUALS_INT(2 * PAGE_SIZE, (int) stats.bytesWritten, "bytes written");
+
+  // counters stay exact with concurrent pins
+  CHECK(resetPoolStats(bm));
+  for(i = 0; i < STAT_THREADS; i++)
+    pthread_create(&threads[i], NULL, pinThread, bm);
+  for(i = 0; i < STAT_THREADS; i++)
+    pthread_join(threads[i], NULL);
+  CHECK(getPoolStats(bm, &stats));
+  ASSERT_EQUALS_INT(STAT_THREADS * STAT_PINS, (int) (stats.hits + stats.misses),
+                    "every pin is a hit or a miss");
+  ASSERT_EQUALS_INT((int) stats.numReadIO, getNumReadIO(bm), "read I/Os");
+  ASSERT_TRUE(stats.numReadIO <= stats.misses, "reads only on misses");
+
+  CHECK(shutdownBufferPool(bm));
+  CHECK(destroyPageFile("testbuffer.bin"));
+
+  free(bm);
+  free(h);
+  TEST_DONE();
+}
+
+// test latency histograms of pinPage and page I/O
+void
+testLatencyHistograms (void)
+{
+  BM_BufferPool *bm = MAKE_POOL();
+  BM_PageHandle *h = MAKE_PAGE_HANDLE();
+  LH_Histogram *hist = (LH_Histogram *) malloc(sizeof(LH_Histogram));
+  LH_Snapshot *hit = (LH_Snapshot *) malloc(sizeof(LH_Snapshot));
+  LH_Snapshot *miss = (LH_Snapshot *) malloc(sizeof(LH_Snapshot));
+  BM_PageHandle batch[10];
+  PageNumber nums[10];
+  SM_FileHandle fh;
+  SM_PageHandle pages[10];
+  long long v;
+  int i;
+  testName = "Testing latency histograms";
+
+  // percentiles are within a bucket of the exact ones
+  initLatencyHistogram(hist);
+  for(v = 1; v <= 100000; v++)
+    recordLatency(hist, v * 10);
+  CHECK(getLatencySnapshot(hist, hit));
+  ASSERT_EQUALS_INT(100000, (int) hit->count, "values recorded");
+  ASSERT_EQUALS_INT(1000000, (int) hit->max, "max value");
+  ASSERT_TRUE(hit->p50 >= 500000 && hit->p50 <= 500000 + 500000 / LH_SUB_BUCKETS, "p50");
+  ASSERT_TRUE(hit->p99 >= 990000 && hit->p99 <= 1000000, "p99");
+  ASSERT_TRUE(hit->p999 >= 999000 && hit->p999 <= 1000000, "p999");
+  ASSERT_TRUE(getLatencyPercentile(hit, 0.0) == 10, "smallest value");
+  recordLatency(hist, 1LL << 60);
+  CHECK(getLatencySnapshot(hist, hit));
+  ASSERT_TRUE(hit->counts[LH_NUM_BUCKETS - 1] == 1, "huge value in last bucket");
+
+  CHECK(createPageFile("testbuffer.bin"));
+  createDummyPages(bm, 20);
+  CHECK(initBufferPool(bm, "testbuffer.bin", 10, RS_LRU, NULL));
+  resetIOLatency();
+
+  // nothing is recorded while tracking is off
+  CHECK(pinPage(bm, h, 0));
+  CHECK(unpinPage(bm, h));
+  CHECK(getPinLatency(bm, hit, miss));
+  ASSERT_EQUALS_INT(0, (int) (hit->count + miss->count), "tracking off");
+
+  setLatencyTracking(TRUE);
+  for(i = 0; i < 10; i++)
+    {
+      CHECK(pinPage(bm, h, i));
+      CHECK(unpinPage(bm, h));
+    }
+  for(i = 0; i < 10; i++)
+    {
+      CHECK(pinPage(bm, h, 9 - i));
+      CHECK(unpinPage(bm, h));
+    }
+  setLatencyTracking(FALSE);
+
+  CHECK(getPinLatency(bm, hit, miss));
+  ASSERT_EQUALS_INT(11, (int) hit->count, "pin hits timed");
+  ASSERT_EQUALS_INT(9, (int) miss->count, "pin misses timed");
+  ASSERT_TRUE(miss->p50 <= miss->p99 && miss->p99 <= miss->p999
+              && miss->p999 <= miss->max, "percentiles in order");
+  CHECK(getIOLatency(hit, miss));
+  ASSERT_EQUALS_INT(9, (int) hit->count, "page reads timed");
+  ASSERT_EQUALS_INT(0, (int) miss->count, "no page writes");
+
+  // one vectored read for the batch
+  for(i = 0; i < 10; i++)
+    nums[i] = 10 + i;
+  setLatencyTracking(TRUE);
+  CHECK(pinPages(bm, batch, nums, 10));
+  setLatencyTracking(FALSE);
+  CHECK(getIOLatency(hit, miss));
+  ASSERT_EQUALS_INT(10, (int) hit->count, "batch read timed once");
+  CHECK(getPinLatency(bm, hit, miss));
+  ASSERT_EQUALS_INT(10, (int) miss->count, "missed batch timed once");
+
+  // one vectored write for the batch, one write per compressed page
+  for(i = 0; i < 10; i++)
+    pages[i] = batch[i].data;
+  CHECK(openPageFile("testbuffer.bin", &fh));
+  setLatencyTracking(TRUE);
+  CHECK(writeBlocks(10, 10, &fh, pages));
+  setLatencyTracking(FALSE);
+  CHECK(closePageFile(&fh));
+  CHECK(getIOLatency(hit, miss));
+  ASSERT_EQUALS_INT(1, (int) miss->count, "batch write timed once");
+
+  CHECK(createCompressedPageFile("testbuffer2.bin"));
+  CHECK(openPageFile("testbuffer2.bin", &fh));
+  setLatencyTracking(TRUE);
+  CHECK(writeBlocks(0, 10, &fh, pages));
+  setLatencyTracking(FALSE);
+  CHECK(closePageFile(&fh));
+  CHECK(destroyPageFile("testbuffer2.bin"));
+  CHECK(getIOLatency(hit, miss));
+  ASSERT_EQUALS_INT(11, (int) miss->count, "compressed writes timed");
+  CHECK(unpinPages(bm, batch, 10));
+
+  setLatencyTracking(TRUE);
+  CHECK(pinPages(bm, batch, nums, 10));
+  setLatencyTracking(FALSE);
+  CHECK(unpinPages(bm, batch, 10));
+  CHECK(getPinLatency(bm, hit, miss));
+  ASSERT_EQUALS_INT(12, (int) hit->count, "batch of hits timed once");
+
+  CHECK(shutdownBufferPool(bm));
+  CHECK(destroyPageFile("testbuffer.bin"));
+
+  free(hist);
+  free(hit);
+  free(miss);
+  free(bm);
+  free(h);
+  TEST_DONE();
+}
+
+// test snapshot of all frames and of changed frames
+void
+testPoolSnapshot (void)
+{
+  BM_BufferPool *bm = MAKE_POOL();
+  BM_PageHandle *h = MAKE_PAGE_HANDLE();
+  BM_PoolSnapshot snap, small;
+  unsigned long long epoch;
+  int i, testint;
+  testName = "Testing pool snapshots";
+
+  CHECK(createPageFile("testbuffer.bin"));
+  createDummyPages(bm, 10);
+  CHECK(initBufferPool(bm, "testbuffer.bin", 4, RS_FIFO, NULL));
+  CHECK(initPoolSnapshot(&snap, 4));
+  CHECK(initPoolSnapshot(&small, 3));
+
+  for(i = 0; i < 3; i++)
+    {
+      CHECK(pinPage(bm, h, i));
+      CHECK(unpinPage(bm, h));
+    }
+  CHECK(pinPage(bm, h, 1));
+  CHECK(markDirty(bm, h));
+
+  CHECK(getPoolSnapshot(bm, &snap));
+  ASSERT_EQUALS_INT(4, snap.count, "all frames");
+  ASSERT_EQUALS_INT(1, snap.pageNums[1], "page of frame 1");
+  ASSERT_EQUALS_INT(1, snap.fixCounts[1], "fix count of frame 1");
+  ASSERT_TRUE(snap.dirty[1] && !snap.dirty[0], "dirty flags");
+  ASSERT_EQUALS_INT(NO_PAGE, snap.pageNums[3], "free frame");
+  testint = getPoolSnapshot(bm, &small);
+  ASSERT_EQUALS_INT(RC_SNAPSHOT_TOO_SMALL, testint, "snapshot too small");
+
+  // nothing changed since snapshot
+  epoch = snap.epoch;
+  CHECK(getPoolChanges(bm, epoch, &snap));
+  ASSERT_EQUALS_INT(0, snap.count, "no changes");
+  ASSERT_TRUE(snap.epoch == epoch, "epoch unchanged");
+
+  // unpin page 1 and read page 5 into free frame
+  CHECK(unpinPage(bm, h));
+  CHECK(pinPage(bm, h, 5));
+  CHECK(getPoolChanges(bm, epoch, &small));
+  ASSERT_EQUALS_INT(2, small.count, "two frames changed");
+  ASSERT_EQUALS_INT(1, small.frameIds[0], "frame 1 changed");
+  ASSERT_EQUALS_INT(0, small.fixCounts[0], "frame 1 unpinned");
+  ASSERT_EQUALS_INT(3, small.frameIds[1], "frame 3 changed");
+  ASSERT_EQUALS_INT(5, small.pageNums[1], "frame 3 holds page 5");
+  ASSERT_TRUE(small.epoch > epoch, "epoch advanced");
+  CHECK(unpinPage(bm, h));
+
+  freePoolSnapshot(&snap);
+  freePoolSnapshot(&small);
+  CHECK(shutdownBufferPool(bm));
+  CHECK(destroyPageFile("testbuffer.bin"));
+
+  free(bm);
+  free(h);
+  TEST_DONE();
+}
+
+// ************************************************************
+// Replaying a recorded trace with same strategy and pool size gives
+// same hits and misses as the recorded run.
+void
+testTraceReplay (void)
+{
+  BM_BufferPool *bm = MAKE_POOL();
+  BM_PageHandle *h = MAKE_PAGE_HANDLE();
+  BM_PoolStats stats;
+  BM_ReplayResult result;
+  BM_TraceReader *reader;
+  TR_Op op;
+  PageNumber pageNum;
+  int i, numOps = 5000, numRecords = 0, testint;
+  testName = "Testing access trace and replay";
+
+  CHECK(createPageFile("testbuffer.bin"));
+  CHECK(initBufferPool(bm, "testbuffer.bin", 8, RS_LRU, NULL));
+  TEST_CHECK(startPoolTrace(bm, "testbuffer.trace"));
+  testint = startPoolTrace(bm, "testbuffer.trace2");
+  ASSERT_EQUALS_INT(RC_FILE_HANDLE_IN_USE, testint, "trace already on");
+
+  // skewed random accesses, some of them writes
+  srand(42);
+  for (i = 0; i < numOps; i++)
+    {
+      int page = (rand() % 4 == 0) ? rand() % 40 : rand() % 6;
+      CHECK(pinPage(bm, h, page));
+      numRecords++;
+      if (rand() % 3 == 0)
+        {
+          CHECK(markDirty(bm, h));
+          numRecords++;
+        }
+      CHECK(unpinPage(bm, h));
+      numRecords++;
+    }
+  // unpin of a page not pinned is traced too
+  h->pageNum = 3;
+  testint = unpinPage(bm, h);
+  ASSERT_EQUALS_INT(RC_PAGE_NOT_PINNED, testint, "page 3 not pinned");
+  numRecords++;
+  TEST_CHECK(stopPoolTrace(bm));
+  testint = stopPoolTrace(bm);
+  ASSERT_EQUALS_INT(RC_FILE_HANDLE_NOT_INIT, testint, "trace already off");
+  CHECK(getPoolStats(bm, &stats));
+  CHECK(shutdownBufferPool(bm));
+  CHECK(destroyPageFile("testbuffer.bin"));
+
+  // records read back in order
+  TEST_CHECK(openTraceReader(&reader, "testbuffer.trace"));
+  TEST_CHECK(nextTraceRecord(reader, &op, &pageNum));
+  ASSERT_EQUALS_INT(TR_PIN, op, "first record is a pin");
+  testint = 1;
+  while (nextTraceRecord(reader, &op, &pageNum) == RC_OK)
+    testint++;
+  ASSERT_EQUALS_INT(numRecords, testint, "all accesses traced");
+  ASSERT_EQUALS_INT(TR_UNPIN, op, "last record is an unpin");
+  ASSERT_EQUALS_INT(3, pageNum, "last record is page 3");
+  TEST_CHECK(closeTraceReader(reader));
+
+  TEST_CHECK(replayTrace("testbuffer.trace", "testreplay.bin", RS_LRU, 8,
+                         &result));
+  ASSERT_TRUE(result.numRecords == numRecords, "records replayed");
+  ASSERT_TRUE(result.numPins == numOps, "pins replayed");
+  ASSERT_TRUE(result.failedPins == 0, "no pin failed");
+  ASSERT_TRUE(result.stats.hits == stats.hits, "same hits");
+  ASSERT_TRUE(result.stats.misses == stats.misses, "same misses");
+  ASSERT_TRUE(result.stats.dirtyEvictions == stats.dirtyEvictions,
+              "same dirty evictions");
+
+  // larger pool cannot miss more under LRU
+  TEST_CHECK(replayTrace("testbuffer.trace", "testreplay.bin", RS_LRU, 32,
+                         &result));
+  ASSERT_TRUE(result.stats.misses <= stats.misses, "fewer misses");
+
+  testint = openTraceReader(&reader, "testbuffer.bin");
+  ASSERT_EQUALS_INT(RC_FILE_NOT_FOUND, testint, "no such trace");
+  CHECK(createPageFile("testbuffer.bin"));
+  testint = replayTrace("testbuffer.bin", "testreplay.bin", RS_LRU, 8,
+                        &result);
+  ASSERT_EQUALS_INT(RC_TRACE_INVALID, testint, "page file is not a trace");
+  CHECK(destroyPageFile("testbuffer.bin"));
+  remove("testbuffer.trace");
+
+  free(bm);
+  free(h);
+  TEST_DONE();
+}
+
+// ************************************************************
+// LRU curve gives the misses of a real LRU pool of every size, MIN
+// never misses more than any strategy.
+void
+testMissRatioCurve (void)
+{
+  BM_BufferPool *bm = MAKE_POOL();
+  BM_PageHandle *h = MAKE_PAGE_HANDLE();
+  BM_ReplayResult result;
+  MRC_Curve curve, sampled;
+  PageNumber *pages;
+  PageNumber belady[] = { 0, 1, 2, 0, 3, 0, 1, 2, 3, 0 };
+  PageNumber sparse[10];
+  long long num, misses;
+  int i, size, testint;
+  int sizes[] = { 1, 4, 16, 64 };
+  ReplacementStrategy strategies[] = { RS_FIFO, RS_LRU, RS_CLOCK };
+  testName = "Testing miss ratio curves and MIN";
+
+  // with 3 frames MIN misses 0 1 2 3 and then 2, LRU hits 0 twice
+  TEST_CHECK(simulateMIN(belady, 10, 3, &misses));
+  ASSERT_TRUE(misses == 5, "MIN misses on textbook string");
+  TEST_CHECK(computeLRUCurve(belady, 10, 3, 1.0, &curve));
+  ASSERT_TRUE(curve.numAccesses == 10, "all references counted");
+  ASSERT_TRUE(curve.hits[3] == 2, "LRU hits with 3 frames");
+  ASSERT_TRUE(curve.hits[1] == 0, "LRU hits with 1 frame");
+  freeMRCurve(&curve);
+
+  // same string on pages up to 3 << 29, only page count matters
+  for (i = 0; i < 10; i++)
+    sparse[i] = belady[i] << 29;
+  TEST_CHECK(simulateMIN(sparse, 10, 3, &misses));
+  ASSERT_TRUE(misses == 5, "MIN misses on sparse pages");
+  TEST_CHECK(computeLRUCurve(sparse, 10, 3, 1.0, &curve));
+  ASSERT_TRUE(curve.hits[3] == 2, "LRU hits on sparse pages");
+  freeMRCurve(&curve);
+
+  // skewed random trace recorded from a pool
+  CHECK(createPageFile("testbuffer.bin"));
+  CHECK(initBufferPool(bm, "testbuffer.bin", 16, RS_LRU, NULL));
+  CHECK(startPoolTrace(bm, "testbuffer.trace"));
+  srand(7);
+  for (i = 0; i < 20000; i++)
+    {
+      CHECK(pinPage(bm, h, (rand() % 3 == 0) ? rand() % 200 : rand() % 20));
+      CHECK(unpinPage(bm, h));
+    }
+  CHECK(stopPoolTrace(bm));
+  CHECK(shutdownBufferPool(bm));
+  CHECK(destroyPageFile("testbuffer.bin"));
+
+  TEST_CHECK(readTracePins("testbuffer.trace", &pages, &num));
+  ASSERT_TRUE(num == 20000, "pins read from trace");
+  TEST_CHECK(computeLRUCurve(pages, num, 64, 1.0, &curve));
+  TEST_CHECK(computeLRUCurve(pages, num, 64, 0.25, &sampled));
+  for (i = 0; i < 4; i++)
+    {
+      size = sizes[i];
+      TEST_CHECK(replayTrace("testbuffer.trace", "testreplay.bin", RS_LRU,
+                             size, &result));
+      ASSERT_TRUE(result.stats.misses
+                  == (long long) (getLRUMissRatio(&curve, size) * num + 0.5),
+                  "LRU curve matches LRU pool");
+      ASSERT_TRUE(getLRUMissRatio(&sampled, size)
+                  - getLRUMissRatio(&curve, size) < 0.1
+                  && getLRUMissRatio(&curve, size)
+                  - getLRUMissRatio(&sampled, size) < 0.1,
+                  "sampled curve close to exact one");
+
+      TEST_CHECK(simulateMIN(pages, num, size, &misses));
+      for (testint = 0; testint < 3; testint++)
+        {
+          TEST_CHECK(replayTrace("testbuffer.trace", "testreplay.bin",
+                                 strategies[testint], size, &result));
+          ASSERT_TRUE(misses <= result.stats.misses, "MIN is a lower bound");
+        }
+    }
+  ASSERT_TRUE(getLRUMissRatio(&curve, 1000) == getLRUMissRatio(&curve, 64),
+              "sizes above curve use its end");
+
+  testint = computeLRUCurve(pages, num, 64, 1.5, &sampled);
+  ASSERT_EQUALS_INT(RC_MRC_INVALID_PARAM, testint, "bad sample rate");
+  testint = simulateMIN(pages, num, 0, &misses);
+  ASSERT_EQUALS_INT(RC_MRC_INVALID_PARAM, testint, "bad pool size");
+
+  freeMRCurve(&curve);
+  freeMRCurve(&sampled);
+  free(pages);
+  remove("testbuffer.trace");
+  free(bm);
+  free(h);
+  TEST_DONE();
+}
+
+// ************************************************************
+// Unsampled estimator predicts hits of the LRU pool it runs in
+// exactly, also after its times were renumbered many times.
+void
+testPredictedHitRatio (void)
+{
+  BM_BufferPool *bm = MAKE_POOL();
+  BM_PageHandle *h = MAKE_PAGE_HANDLE();
+  BM_PoolStats stats;
+  BM_ReplayResult result;
+  double ratio, small, large;
+  int i, testint;
+  testName = "Testing online hit ratio prediction";
+
+  CHECK(createPageFile("testbuffer.bin"));
+  CHECK(initBufferPool(bm, "testbuffer.bin", 16, RS_LRU, NULL));
+  testint = getPredictedHitRatio(bm, 16, &ratio);
+  ASSERT_EQUALS_INT(RC_MRC_NOT_ENABLED, testint, "tracking off");
+  testint = enableMissRatioTracking(bm, 64, 0);
+  ASSERT_EQUALS_INT(RC_MRC_INVALID_PARAM, testint, "bad sample rate");
+
+  // warm up, then count from a reset
+  TEST_CHECK(enableMissRatioTracking(bm, 64, 1.0));
+  CHECK(startPoolTrace(bm, "testbuffer.trace"));
+  srand(11);
+  for (i = 0; i < 30000; i++)
+    {
+      CHECK(pinPage(bm, h, (rand() % 4 == 0) ? rand() % 300 : rand() % 24));
+      CHECK(unpinPage(bm, h));
+    }
+  CHECK(stopPoolTrace(bm));
+  CHECK(getPoolStats(bm, &stats));
+
+  TEST_CHECK(getPredictedHitRatio(bm, 16, &ratio));
+  ASSERT_TRUE((long long) (ratio * 30000 + 0.5) == stats.hits,
+              "predicted hits of own size");
+  TEST_CHECK(getPredictedHitRatio(bm, 8, &small));
+  TEST_CHECK(getPredictedHitRatio(bm, 32, &large));
+  ASSERT_TRUE(small < ratio && ratio < large, "more frames, more hits");
+
+  // a larger pool replaying same pins hits as predicted
+  TEST_CHECK(replayTrace("testbuffer.trace", "testreplay.bin", RS_LRU, 32,
+                         &result));
+  ASSERT_TRUE((long long) (large * 30000 + 0.5) == result.stats.hits,
+              "predicted hits of larger pool");
+  remove("testbuffer.trace");
+
+  // sampled estimate is close
+  TEST_CHECK(enableMissRatioTracking(bm, 64, 0.25));
+  for (i = 0; i < 30000; i++)
+    {
+      CHECK(pinPage(bm, h, (rand() % 4 == 0) ? rand() % 300 : rand() % 24));
+      CHECK(unpinPage(bm, h));
+    }
+  TEST_CHECK(getPredictedHitRatio(bm, 32, &ratio));
+  ASSERT_TRUE(ratio > large - 0.1 && ratio < large + 0.1,
+              "sampled prediction close");
+
+  CHECK(resetPoolStats(bm));
+  TEST_CHECK(getPredictedHitRatio(bm, 32, &ratio));
+  ASSERT_TRUE(ratio == 0.0, "reset with stats");
+  TEST_CHECK(disableMissRatioTracking(bm));
+  testint = disableMissRatioTracking(bm);
+  ASSERT_EQUALS_INT(RC_MRC_NOT_ENABLED, testint, "already off");
+
+  CHECK(shutdownBufferPool(bm));
+  CHECK(destroyPageFile("testbuffer.bin"));
+  free(bm);
+  free(h);
+  TEST_DONE();
+}
+
+// ************************************************************
+void
+testResizePool (void)
+{
+  BM_BufferPool *bm = MAKE_POOL();
+  BM_PageHandle *h = MAKE_PAGE_HANDLE();
+  BM_PageHandle *pinned = MAKE_PAGE_HANDLE();
+  ReplacementStrategy strategies[] = { RS_FIFO, RS_LRU, RS_CLOCK };
+  char *data, expected[32];
+  int i, s, testint;
+  testName = "Testing buffer pool resizing";
+
+  CHECK(createPageFile("testbuffer.bin"));
+  createDummyPages(bm, 40);
+
+  for (s = 0; s < 3; s++)
+    {
+      CHECK(initBufferPool(bm, "testbuffer.bin", 4, strategies[s], NULL));
+      CHECK(pinPage(bm, pinned, 7));
+      data = pinned->data;
+
+      // grown pool keeps pinned page in place and caches more pages
+      TEST_CHECK(resizeBufferPool(bm, 16));
+      ASSERT_EQUALS_INT(16, bm->numPages, "grown");
+      ASSERT_TRUE(data == pinned->data, "pinned page did not move");
+      for (i = 20; i < 35; i++)
+        {
+          CHECK(pinPage(bm, h, i));
+          CHECK(unpinPage(bm, h));
+        }
+      ASSERT_EQUALS_INT(15, getNumReadIO(bm) - 1, "one read per page");
+      for (i = 20; i < 35; i++)
+        {
+          CHECK(pinPage(bm, h, i));
+          CHECK(unpinPage(bm, h));
+        }
+      ASSERT_EQUALS_INT(16, getNumReadIO(bm), "all pages stayed cached");
+
+      // shrinking stops at pinned pages
+      CHECK(pinPage(bm, h, 30));
+      testint = resizeBufferPool(bm, 1);
+      ASSERT_EQUALS_INT(RC_FRAME_IN_USE, testint, "pages pinned");
+      ASSERT_EQUALS_INT(2, bm->numPages, "shrunk to pinned frames");
+      ASSERT_TRUE(data == pinned->data, "pinned page did not move");
+      ASSERT_TRUE(strcmp(pinned->data, "Page-7") == 0, "pinned page intact");
+      CHECK(unpinPage(bm, h));
+      TEST_CHECK(resizeBufferPool(bm, 1));
+      ASSERT_EQUALS_INT(1, bm->numPages, "shrunk");
+      testint = resizeBufferPool(bm, 0);
+      ASSERT_EQUALS_INT(RC_POOL_INVALID_SIZE, testint, "size 0");
+
+      // pool of one frame still works
+      CHECK(unpinPage(bm, pinned));
+      for (i = 0; i < 10; i++)
+        {
+          CHECK(pinPage(bm, h, i));
+          sprintf(expected, "%s-%i", "Page", i);
+          ASSERT_EQUALS_STRING(expected, h->data, "page read in small pool");
+          CHECK(unpinPage(bm, h));
+        }
+      CHECK(shutdownBufferPool(bm));
+    }
+
+  CHECK(destroyPageFile("testbuffer.bin"));
+  free(bm);
+  free(h);
+  free(pinned);
+  TEST_DONE();
+}
+
+// ************************************************************
+// Pool that re-reads a large working set takes frames from pools
+// that hit anyway.
+void
+testPoolManager (void)
+{
+  PM_PoolManager pm;
+  BM_BufferPool *hot = MAKE_POOL();
+  BM_BufferPool *cold = MAKE_POOL();
+  BM_BufferPool *extra = MAKE_POOL();
+  BM_PageHandle *h = MAKE_PAGE_HANDLE();
+  int i, round, moved, testint;
+  testName = "Testing pool manager";
+
+  CHECK(createPageFile("testbuffer.bin"));
+  CHECK(createPageFile("testbuffer2.bin"));
+  TEST_CHECK(initPoolManager(&pm, 64, 4, 1.0));
+  TEST_CHECK(addManagedPool(&pm, hot, "testbuffer.bin", RS_LRU, 8, 60));
+  TEST_CHECK(addManagedPool(&pm, cold, "testbuffer2.bin", RS_CLOCK, 4, 60));
+  testint = addManagedPool(&pm, extra, "testbuffer.bin", RS_LRU, 53, 60);
+  ASSERT_EQUALS_INT(RC_POOL_BUDGET_EXCEEDED, testint, "budget");
+  ASSERT_EQUALS_INT(52, getFreeFrames(&pm), "free frames");
+
+  // idle pools get nothing
+  TEST_CHECK(rebalancePools(&pm, &moved));
+  ASSERT_EQUALS_INT(0, moved, "nothing moved");
+
+  srand(5);
+  for (round = 0; round < 20; round++)
+    {
+      for (i = 0; i < 2000; i++)
+        {
+          CHECK(pinPage(hot, h, rand() % 40));
+          CHECK(unpinPage(hot, h));
+          CHECK(pinPage(cold, h, rand() % 3));
+          CHECK(unpinPage(cold, h));
+        }
+      TEST_CHECK(rebalancePools(&pm, &moved));
+      if (hot->numPages + cold->numPages > 64)
+        ASSERT_TRUE(FALSE, "within budget");
+    }
+  ASSERT_TRUE(hot->numPages >= 40, "hot pool holds its working set");
+  ASSERT_TRUE(cold->numPages >= 4, "cold pool kept its minimum");
+  ASSERT_EQUALS_INT(64 - hot->numPages - cold->numPages, getFreeFrames(&pm),
+                    "frames accounted");
+
+  // cold pool gives frames back when hot needs them
+  CHECK(removeManagedPool(&pm, cold));
+  testint = removeManagedPool(&pm, cold);
+  ASSERT_EQUALS_INT(RC_POOL_NOT_MANAGED, testint, "removed");
+  TEST_CHECK(addManagedPool(&pm, cold, "testbuffer2.bin", RS_FIFO, 20, 30));
+  for (round = 0; round < 10; round++)
+    {
+      for (i = 0; i < 2000; i++)
+        {
+          CHECK(pinPage(hot, h, rand() % 58));
+          CHECK(unpinPage(hot, h));
+          CHECK(pinPage(cold, h, rand() % 2));
+          CHECK(unpinPage(cold, h));
+        }
+      TEST_CHECK(rebalancePools(&pm, &moved));
+    }
+  ASSERT_TRUE(cold->numPages == 20, "cold pool at minimum");
+  ASSERT_TRUE(hot->numPages == 44, "hot pool has rest of budget");
+
+  // background rebalancing
+  TEST_CHECK(startRebalancing(&pm, 5));
+  for (i = 0; i < 20000; i++)
+    {
+      CHECK(pinPage(hot, h, rand() % 58));
+      CHECK(unpinPage(hot, h));
+    }
+  TEST_CHECK(stopRebalancing(&pm));
+
+  TEST_CHECK(shutdownPoolManager(&pm));
+  CHECK(destroyPageFile("testbuffer.bin"));
+  CHECK(destroyPageFile("testbuffer2.bin"));
+  free(hot);
+  free(cold);
+  free(extra);
+  free(h);
+  TEST_DONE();
+}
+
+// ************************************************************
+// Handles whose frame went to another page or index still work
+// through the page number.
+void
+testStaleHandles (void)
+{
+  BM_BufferPool *bm = MAKE_POOL();
+  BM_PageHandle *h = MAKE_PAGE_HANDLE();
+  BM_PageHandle old, last;
+  int *fixCounts, testint;
+  testName = "Testing stale page handles";
+
+  CHECK(createPageFile("testbuffer.bin"));
+  CHECK(initBufferPool(bm, "testbuffer.bin", 3, RS_FIFO, NULL));
+
+  // page 1 leaves frame 1 and comes back in frame 2
+  CHECK(pinPage(bm, h, 0));
+  CHECK(unpinPage(bm, h));
+  CHECK(pinPage(bm, &old, 1));
+  TEST_CHECK(unpinPage(bm, &old));
+  testint = unpinPage(bm, &old);
+  ASSERT_EQUALS_INT(RC_PAGE_NOT_PINNED, testint, "unpinned twice");
+  CHECK(pinPage(bm, h, 2));
+  CHECK(unpinPage(bm, h));
+  CHECK(pinPage(bm, h, 3));
+  CHECK(unpinPage(bm, h));
+  CHECK(pinPage(bm, h, 4));
+  CHECK(unpinPage(bm, h));
+  CHECK(pinPage(bm, h, 1));
+  ASSERT_TRUE(h->frameNo != old.frameNo, "page 1 in another frame");
+  TEST_CHECK(markDirty(bm, &old));
+  TEST_CHECK(unpinPage(bm, &old));
+  fixCounts = getFixCounts(bm);
+  ASSERT_EQUALS_INT(0, fixCounts[h->frameNo], "stale handle found page");
+  free(fixCounts);
+
+  // frame of handle moves when pool shrinks
+  CHECK(resizeBufferPool(bm, 4));
+  CHECK(pinPage(bm, &last, 9));
+  ASSERT_EQUALS_INT(3, last.frameNo, "page 9 in last frame");
+  CHECK(resizeBufferPool(bm, 2));
+  TEST_CHECK(markDirty(bm, &last));
+  TEST_CHECK(unpinPage(bm, &last));
+
+  // handle holding only a page number
+  CHECK(pinPage(bm, h, 5));
+  old.pageNum = 5;
+  old.frameNo = 12345;
+  TEST_CHECK(unpinPage(bm, &old));
+  old.frameNo = -1;
+  testint = unpinPage(bm, &old);
+  ASSERT_EQUALS_INT(RC_PAGE_NOT_PINNED, testint, "page 5 unpinned");
+
+  CHECK(shutdownBufferPool(bm));
+  CHECK(destroyPageFile("testbuffer.bin"));
+  free(bm);
+  free(h);
+  TEST_DONE();
+}
+
+// ************************************************************
+// Pages of a batch are pinned all together or not at all.
+void
+testBatchPin (void)
+{
+  BM_BufferPool *bm = MAKE_POOL();
+  BM_PageHandle *h = MAKE_PAGE_HANDLE();
+  BM_PageHandle batch[5];
+  PageNumber nums[5] = {6, 2, 3, 6, 4};
+  PageNumber tooMany[5] = {1, 5, 7, 8, 9};
+  PageNumber grow[2] = {21, 20};
+  BM_PageHandle largeBatch[100];
+  PageNumber large[100];
+  PageNumber *frameContents;
+  BM_PoolStats stats;
+  char expected[16];
+  int *fixCounts, i, empty, testint;
+  testName = "Testing batch pin and unpin";
+
+  CHECK(createPageFile("testbuffer.bin"));
+  createDummyPages(bm, 10);
+  CHECK(initBufferPool(bm, "testbuffer.bin", 5, RS_LRU, NULL));
+
+  // page 6 twice, read once
+  CHECK(pinPages(bm, batch, nums, 5));
+  for (i = 0; i < 5; i++)
+    {
+      sprintf(expected, "%s-%i", "Page", nums[i]);
+      ASSERT_EQUALS_STRING(expected, batch[i].data, "batch page content");
+    }
+  ASSERT_TRUE(batch[0].data == batch[3].data, "repeated page shares frame");
+  CHECK(getPoolStats(bm, &stats));
+  ASSERT_EQUALS_INT(4, (int) stats.misses, "4 misses");
+  ASSERT_EQUALS_INT(1, (int) stats.hits, "1 hit");
+  ASSERT_EQUALS_INT(4, getNumReadIO(bm), "4 pages read");
+  fixCounts = getFixCounts(bm);
+  ASSERT_EQUALS_INT(2, fixCounts[batch[0].frameNo], "page 6 pinned twice");
+  free(fixCounts);
+
+  CHECK(unpinPages(bm, batch, 5));
+  testint = unpinPages(bm, batch, 5);
+  ASSERT_EQUALS_INT(RC_PAGE_NOT_PINNED, testint, "batch unpinned twice");
+
+  // 4 unpinned frames for 5 new pages
+  CHECK(pinPage(bm, h, 0));
+  testint = pinPages(bm, batch, tooMany, 5);
+  ASSERT_EQUALS_INT(RC_BUFFER_POOL_FULL, testint, "batch does not fit");
+  fixCounts = getFixCounts(bm);
+  frameContents = getFrameContents(bm);
+  empty = 0;
+  for (i = 0; i < 5; i++)
+    {
+      if (frameContents[i] == 0)
+        ASSERT_EQUALS_INT(1, fixCounts[i], "page 0 still pinned");
+      else
+        ASSERT_EQUALS_INT(0, fixCounts[i], "batch pins undone");
+      if (frameContents[i] == NO_PAGE)
+        empty++;
+    }
+  ASSERT_EQUALS_INT(4, empty, "frames of failed batch are empty");
+  free(fixCounts);
+  free(frameContents);
+  CHECK(unpinPage(bm, h));
+
+  CHECK(pinPage(bm, h, 1));
+  ASSERT_EQUALS_STRING("Page-1", h->data, "page 1 read after failed batch");
+  CHECK(unpinPage(bm, h));
+
+  // pages past end of file are added
+  CHECK(pinPages(bm, batch, grow, 2));
+  ASSERT_EQUALS_STRING("", batch[0].data, "new page 21 empty");
+  ASSERT_EQUALS_STRING("", batch[1].data, "new page 20 empty");
+  CHECK(unpinPages(bm, batch, 2));
+
+  // batch larger than what pinPages keeps on stack
+  CHECK(resizeBufferPool(bm, 100));
+  for (i = 0; i < 100; i++)
+    large[i] = 99 - i;
+  CHECK(pinPages(bm, largeBatch, large, 100));
+  for (i = 90; i < 100; i++)
+    {
+      sprintf(expected, "%s-%i", "Page", large[i]);
+      ASSERT_EQUALS_STRING(expected, largeBatch[i].data, "large batch content");
+    }
+  CHECK(unpinPages(bm, largeBatch, 100));
+
+  CHECK(shutdownBufferPool(bm));
+  CHECK(destroyPageFile("testbuffer.bin"));
+  free(bm);
+  free(h);
+  TEST_DONE();
+}
+
+// ************************************************************
+// Writers bump two counters of page 0 one after the other, readers
+// must never see them differ.
+#define LATCH_THREADS 4
+#define LATCH_ROUNDS 2000
+static int latchMismatches;
+
+void *
+latchWriter (void *arg)
+{
+  BM_BufferPool *bm = (BM_BufferPool *) arg;
+  BM_PageHandle h;
+  volatile int *counters;
+  int i;
+
+  for(i = 0; i < LATCH_ROUNDS; i++)
+    {
+      if (pinPageLatched(bm, &h, 0, PL_EXCLUSIVE) != RC_OK)
+        continue;
+      counters = (volatile int *) h.data;
+      counters[0]++;
+      counters[1]++;
+      markDirty(bm, &h);
+      unpinPageLatched(bm, &h, PL_EXCLUSIVE);
+    }
+  return NULL;
+}
+
+void *
+latchReader (void *arg)
+{
+  BM_BufferPool *bm = (BM_BufferPool *) arg;
+  BM_PageHandle h;
+  volatile int *counters;
+  int i;
+
+  for(i = 0; i < LATCH_ROUNDS; i++)
+    {
+      if (pinPageLatched(bm, &h, 0, PL_SHARED) != RC_OK)
+        continue;
+      counters = (volatile int *) h.data;
+      if (counters[0] != counters[1])
+        __atomic_fetch_add(&latchMismatches, 1, __ATOMIC_RELAXED);
+      unpinPageLatched(bm, &h, PL_SHARED);
+    }
+  return NULL;
+}
+
+void
+testPageLatches (void)
+{
+  BM_BufferPool *bm = MAKE_POOL();
+  BM_PageHandle *h = MAKE_PAGE_HANDLE();
+  BM_PageHandle other;
+  pthread_t threads[2 * LATCH_THREADS];
+  PL_Latch latch;
+  int *fixCounts, i, testint;
+  testName = "Testing page latches";
+
+  // shared holders keep writers out, not readers
+  initLatch(&latch);
+  acquireLatch(&latch, PL_SHARED);
+  ASSERT_TRUE(tryAcquireLatch(&latch, PL_SHARED), "second reader");
+  ASSERT_TRUE(!tryAcquireLatch(&latch, PL_EXCLUSIVE), "writer waits");
+  releaseLatch(&latch, PL_SHARED);
+  releaseLatch(&latch, PL_SHARED);
+  ASSERT_TRUE(tryAcquireLatch(&latch, PL_EXCLUSIVE), "writer after readers");
+  ASSERT_TRUE(!tryAcquireLatch(&latch, PL_SHARED), "reader waits");
+  releaseLatch(&latch, PL_EXCLUSIVE);
+  destroyLatch(&latch);
+
+  CHECK(createPageFile("testbuffer.bin"));
+  CHECK(initBufferPool(bm, "testbuffer.bin", 3, RS_LRU, NULL));
+
+  testint = pinPageLatched(bm, h, 0, 0);
+  ASSERT_EQUALS_INT(RC_LATCH_INVALID_MODE, testint, "bad latch mode");
+  CHECK(pinPageLatched(bm, h, 0, PL_SHARED));
+  CHECK(pinPageLatched(bm, &other, 0, PL_SHARED));
+  fixCounts = getFixCounts(bm);
+  ASSERT_EQUALS_INT(2, fixCounts[h->frameNo], "latched page pinned twice");
+  free(fixCounts);
+  CHECK(unpinPageLatched(bm, &other, PL_SHARED));
+  CHECK(unpinPageLatched(bm, h, PL_SHARED));
+  testint = unpinPageLatched(bm, h, PL_SHARED);
+  ASSERT_EQUALS_INT(RC_PAGE_NOT_PINNED, testint, "latched page unpinned twice");
+
+  latchMismatches = 0;
+  for(i = 0; i < LATCH_THREADS; i++)
+    {
+      pthread_create(&threads[2 * i], NULL, latchWriter, bm);
+      pthread_create(&threads[2 * i + 1], NULL, latchReader, bm);
+    }
+  for(i = 0; i < 2 * LATCH_THREADS; i++)
+    pthread_join(threads[i], NULL);
+  ASSERT_EQUALS_INT(0, latchMismatches, "readers never saw a half update");
+  CHECK(pinPage(bm, h, 0));
+  ASSERT_EQUALS_INT(LATCH_THREADS * LATCH_ROUNDS, ((int *) h->data)[0],
+                    "no update lost");
+  CHECK(unpinPage(bm, h));
+
+  CHECK(shutdownBufferPool(bm));
+  CHECK(destroyPageFile("testbuffer.bin"));
+  free(bm);
+  free(h);
+  TEST_DONE();
+}
+
+// ************************************************************
+// Same counters as above, readers go without latch. Counters are
+// read and written as relaxed atomics, optimistic readers race with
+// writers by design.
+static int optimisticCalls;
+
+void
+copyCounters (const char *data, void *arg)
+{
+  int *copy = (int *) arg;
+
+  copy[0] = __atomic_load_n((int *) data, __ATOMIC_RELAXED);
+  copy[1] = __atomic_load_n((int *) data + 1, __ATOMIC_RELAXED);
+  __atomic_fetch_add(&optimisticCalls, 1, __ATOMIC_RELAXED);
+}
+
+void *
+optimisticWriter (void *arg)
+{
+  BM_BufferPool *bm = (BM_BufferPool *) arg;
+  BM_PageHandle h;
+  int *counters;
+  int i;
+
+  for(i = 0; i < LATCH_ROUNDS; i++)
+    {
+      if (pinPageLatched(bm, &h, 0, PL_EXCLUSIVE) != RC_OK)
+        continue;
+      counters = (int *) h.data;
+      __atomic_store_n(&counters[0], counters[0] + 1, __ATOMIC_RELAXED);
+      __atomic_store_n(&counters[1], counters[1] + 1, __ATOMIC_RELAXED);
+      markDirty(bm, &h);
+      unpinPageLatched(bm, &h, PL_EXCLUSIVE);
+    }
+  return NULL;
+}
+
+void *
+optimisticReader (void *arg)
+{
+  BM_BufferPool *bm = (BM_BufferPool *) arg;
+  BM_PageHandle h;
+  int copy[2];
+  int i;
+
+  if (pinPage(bm, &h, 0) != RC_OK)
+    return NULL;
+  for(i = 0; i < 10 * LATCH_ROUNDS; i++)
+    {
+      readPageOptimistic(bm, &h, copyCounters, copy);
+      if (copy[0] != copy[1])
+        __atomic_fetch_add(&latchMismatches, 1, __ATOMIC_RELAXED);
+    }
+  unpinPage(bm, &h);
+  return NULL;
+}
+
+void
+testOptimisticReads (void)
+{
+  BM_BufferPool *bm = MAKE_POOL();
+  BM_PageHandle *h = MAKE_PAGE_HANDLE();
+  pthread_t threads[2 * LATCH_THREADS];
+  PL_Latch latch;
+  unsigned int version;
+  int copy[2], i;
+  testName = "Testing optimistic page reads";
+
+  // writer in between fails validation
+  initLatch(&latch);
+  version = startLatchRead(&latch);
+  ASSERT_TRUE(validateLatchRead(&latch, version), "no writer");
+  acquireLatch(&latch, PL_SHARED);
+  ASSERT_TRUE(validateLatchRead(&latch, version), "readers do not count");
+  releaseLatch(&latch, PL_SHARED);
+  acquireLatch(&latch, PL_EXCLUSIVE);
+  ASSERT_TRUE(!validateLatchRead(&latch, version), "writer came in");
+  ASSERT_TRUE(!validateLatchRead(&latch, startLatchRead(&latch)),
+              "writer still holds latch");
+  releaseLatch(&latch, PL_EXCLUSIVE);
+  ASSERT_TRUE(!validateLatchRead(&latch, version), "writer was there");
+  ASSERT_TRUE(validateLatchRead(&latch, startLatchRead(&latch)),
+              "writer gone");
+  destroyLatch(&latch);
+
+  CHECK(createPageFile("testbuffer.bin"));
+  CHECK(initBufferPool(bm, "testbuffer.bin", 3, RS_LRU, NULL));
+
+  CHECK(pinPage(bm, h, 0));
+  ((int *) h->data)[0] = 7;
+  ((int *) h->data)[1] = 8;
+  optimisticCalls = 0;
+  CHECK(readPageOptimistic(bm, h, copyCounters, copy));
+  ASSERT_EQUALS_INT(1, optimisticCalls, "one read without writers");
+  ASSERT_EQUALS_INT(8, copy[1], "page read");
+  ((int *) h->data)[0] = 0;
+  ((int *) h->data)[1] = 0;
+  CHECK(unpinPage(bm, h));
+
+  latchMismatches = 0;
+  for(i = 0; i < LATCH_THREADS; i++)
+    {
+      pthread_create(&threads[2 * i], NULL, optimisticWriter, bm);
+      pthread_create(&threads[2 * i + 1], NULL, optimisticReader, bm);
+    }
+  for(i = 0; i < 2 * LATCH_THREADS; i++)
+    pthread_join(threads[i], NULL);
+  ASSERT_EQUALS_INT(0, latchMismatches, "no half update validated");
+  CHECK(pinPage(bm, h, 0));
+  ASSERT_EQUALS_INT(LATCH_THREADS * LATCH_ROUNDS, ((int *) h->data)[0],
+                    "no update lost");
+  CHECK(unpinPage(bm, h));
+
+  CHECK(shutdownBufferPool(bm));
+  CHECK(destroyPageFile("testbuffer.bin"));
+  free(bm);
+  free(h);
+  TEST_DONE();
+}
+
+// ************************************************************
+// Writers bump the counters of page 0 while snapshot readers look at
+// them twice, a pinned snapshot must not change in between.
+void *
+snapshotReader (void *arg)
+{
+  BM_BufferPool *bm = (BM_BufferPool *) arg;
+  BM_PageHandle h;
+  int *counters;
+  int i, first;
+
+  for(i = 0; i < LATCH_ROUNDS; i++)
+    {
+      if (pinPageSnapshot(bm, &h, 0) != RC_OK)
+        continue;
+      counters = (int *) h.data;
+      first = counters[0];
+      sched_yield();
+      if (counters[0] != first || counters[1] != first)
+        __atomic_fetch_add(&latchMismatches, 1, __ATOMIC_RELAXED);
+      unpinPageSnapshot(bm, &h);
+    }
+  return NULL;
+}
+
+void
+testSnapshotReads (void)
+{
+  BM_BufferPool *bm = MAKE_POOL();
+  BM_PageHandle *h = MAKE_PAGE_HANDLE();
+  BM_PageHandle snap, w;
+  pthread_t threads[2 * LATCH_THREADS];
+  PageNumber *frameContents;
+  int *fixCounts, i, testint;
+  testName = "Testing snapshot reads";
+
+  CHECK(createPageFile("testbuffer.bin"));
+  CHECK(initBufferPool(bm, "testbuffer.bin", 4, RS_LRU, NULL));
+  CHECK(pinPageLatched(bm, &w, 0, PL_EXCLUSIVE));
+  strcpy(w.data, "v1");
+  CHECK(markDirty(bm, &w));
+  CHECK(unpinPageLatched(bm, &w, PL_EXCLUSIVE));
+
+  // writer gets a copy, snapshot keeps v1
+  CHECK(pinPageSnapshot(bm, &snap, 0));
+  CHECK(pinPageLatched(bm, &w, 0, PL_EXCLUSIVE));
+  ASSERT_TRUE(w.data != snap.data, "writer has own frame");
+  ASSERT_EQUALS_STRING("v1", w.data, "copy has page");
+  strcpy(w.data, "v2");
+  CHECK(markDirty(bm, &w));
+  CHECK(unpinPageLatched(bm, &w, PL_EXCLUSIVE));
+  ASSERT_EQUALS_STRING("v1", snap.data, "snapshot unchanged");
+  CHECK(pinPage(bm, h, 0));
+  ASSERT_EQUALS_STRING("v2", h->data, "new pins see v2");
+  fixCounts = getFixCounts(bm);
+  ASSERT_EQUALS_INT(1, fixCounts[snap.frameNo], "shadow pinned by snapshot");
+  free(fixCounts);
+
+  // shadow frame is freed with its last pin
+  CHECK(unpinPageSnapshot(bm, &snap));
+  testint = unpinPageSnapshot(bm, &snap);
+  ASSERT_EQUALS_INT(RC_PAGE_NOT_PINNED, testint, "snapshot unpinned twice");
+  frameContents = getFrameContents(bm);
+  ASSERT_EQUALS_INT(NO_PAGE, frameContents[snap.frameNo], "shadow emptied");
+  free(frameContents);
+
+  // no snapshot readers, page is written in place
+  CHECK(pinPageLatched(bm, &w, 0, PL_EXCLUSIVE));
+  ASSERT_TRUE(w.data == h->data, "writer in place");
+  CHECK(unpinPageLatched(bm, &w, PL_EXCLUSIVE));
+  CHECK(unpinPage(bm, h));
+
+  // only the copy is written back
+  CHECK(shutdownBufferPool(bm));
+  CHECK(initBufferPool(bm, "testbuffer.bin", 1, RS_LRU, NULL));
+  CHECK(pinPageSnapshot(bm, &snap, 0));
+  ASSERT_EQUALS_STRING("v2", snap.data, "v2 written back");
+  testint = pinPageLatched(bm, &w, 0, PL_EXCLUSIVE);
+  ASSERT_EQUALS_INT(RC_BUFFER_POOL_FULL, testint, "no frame for copy");
+  fixCounts = getFixCounts(bm);
+  ASSERT_EQUALS_INT(1, fixCounts[0], "failed writer unpinned");
+  free(fixCounts);
+  CHECK(unpinPageSnapshot(bm, &snap));
+  CHECK(shutdownBufferPool(bm));
+
+  // room for a shadow per reader
+  CHECK(initBufferPool(bm, "testbuffer.bin", 16, RS_LRU, NULL));
+  CHECK(pinPage(bm, h, 0));
+  memset(h->data, 0, 2 * sizeof(int));
+  CHECK(markDirty(bm, h));
+  CHECK(unpinPage(bm, h));
+  latchMismatches = 0;
+  for(i = 0; i < LATCH_THREADS; i++)
+    {
+      pthread_create(&threads[2 * i], NULL, latchWriter, bm);
+      pthread_create(&threads[2 * i + 1], NULL, snapshotReader, bm);
+    }
+  for(i = 0; i < 2 * LATCH_THREADS; i++)
+    pthread_join(threads[i], NULL);
+  ASSERT_EQUALS_INT(0, latchMismatches, "snapshots never changed");
+  CHECK(pinPage(bm, h, 0));
+  ASSERT_EQUALS_INT(LATCH_THREADS * LATCH_ROUNDS, ((int *) h->data)[0],
+                    "no update lost");
+  CHECK(unpinPage(bm, h));
+
+  CHECK(shutdownBufferPool(bm));
+  CHECK(destroyPageFile("testbuffer.bin"));
+  free(bm);
+  free(h);
+  TEST_DONE();
+}
+
+// ************************************************************
+// Two nodes work on any host, binding to a missing node is skipped.
+#define ARENA_FRAMES 200
+void
+testFrameArena (void)
+{
+  FA_Arena arena;
+  char *frames[ARENA_FRAMES];
+  void *again;
+  int i, bad, nodes;
+  testName = "Testing frame arenas";
+
+  nodes = getNumaNodes();
+  ASSERT_TRUE(nodes >= 1, "at least one node");
+  i = getCurrentNumaNode();
+  ASSERT_TRUE(i >= 0 && i < nodes, "thread on a known node");
+
+  initFrameArena(&arena, sizeof(BM_PageFrame), 2);
+  ASSERT_EQUALS_INT(2, arena.numNodes, "two nodes asked for");
+  for (i = 0; i < ARENA_FRAMES; i++)
+    {
+      frames[i] = allocFrame(&arena, i % 2);
+      memset(frames[i], i, sizeof(BM_PageFrame));
+    }
+  bad = 0;
+  for (i = 0; i < ARENA_FRAMES; i++)
+    if ((size_t) frames[i] % 64 != 0
+        || frames[i][0] != (char) i
+        || frames[i][sizeof(BM_PageFrame) - 1] != (char) i)
+      bad++;
+  ASSERT_EQUALS_INT(0, bad, "frames aligned and apart");
+
+  // freed frame is reused on its node only
+  freeFrame(&arena, frames[7], 1);
+  again = allocFrame(&arena, 0);
+  ASSERT_TRUE(again != frames[7], "node 0 does not get node 1 frame");
+  again = allocFrame(&arena, 1);
+  ASSERT_TRUE(again == frames[7], "node 1 frame reused");
+  destroyFrameArena(&arena);
+
+  TEST_DONE();
+}
+
+// ************************************************************
+// Errors of one thread do not change message of another.
+void *
+errorThread (void *arg)
+{
+  BM_BufferPool *bm = (BM_BufferPool *) arg;
+
+  if (resizeBufferPool(bm, 0) != RC_POOL_INVALID_SIZE)
+    return NULL;
+  return RC_message;
+}
+
+void
+testThreadErrors (void)
+{
+  BM_BufferPool *bm = MAKE_POOL();
+  BM_PageHandle *h = MAKE_PAGE_HANDLE();
+  pthread_t thread;
+  char *message, *threadMessage;
+  int testint;
+  testName = "Testing error messages per thread";
+
+  CHECK(createPageFile("testbuffer.bin"));
+  CHECK(initBufferPool(bm, "testbuffer.bin", 3, RS_FIFO, NULL));
+  h->pageNum = 1;
+  h->frameNo = -1;
+  testint = unpinPage(bm, h);
+  ASSERT_EQUALS_INT(RC_PAGE_NOT_PINNED, testint, "page 1 not pinned");
+  message = RC_message;
+
+  pthread_create(&thread, NULL, errorThread, bm);
+  pthread_join(thread, (void **) &threadMessage);
+  ASSERT_TRUE(threadMessage != NULL && threadMessage != message,
+              "thread has own message");
+  ASSERT_TRUE(RC_message == message, "message of main thread kept");
+
+  // success leaves message of last error
+  CHECK(pinPage(bm, h, 0));
+  CHECK(unpinPage(bm, h));
+  ASSERT_TRUE(RC_message == message, "RC_OK does not touch message");
+
+  CHECK(shutdownBufferPool(bm));
+  CHECK(destroyPageFile("testbuffer.bin"));
+  free(bm);
+  free(h);
+  TEST_DONE();
+}
+
+// ************************************************************
+// Page map of compressed file survives a missing close.
+void
+testCompressedPageMap (void)
+{
+  SM_FileHandle fh, other;
+  char page[PAGE_SIZE], expected[PAGE_SIZE], noise[PAGE_SIZE];
+  struct stat st;
+  int i;
+  testName = "Testing page map of compressed file";
+
+  CHECK(createCompressedPageFile("testbuffer.bin"));
+  CHECK(openPageFile("testbuffer.bin", &fh));
+  for (i = 0; i < 4; i++)
+    {
+      memset(page, 0, PAGE_SIZE);
+      sprintf(page, "Page-%i", i);
+      CHECK(writeBlock(i, &fh, page));
+    }
+  CHECK(closePageFile(&fh));
+
+  // page 1 no longer compresses, image moves behind persisted map
+  CHECK(openPageFile("testbuffer.bin", &fh));
+  for (i = 0; i < PAGE_SIZE; i++)
+    noise[i] = (char) rand();
+  CHECK(writeBlock(1, &fh, noise));
+
+  // without close, file still has map of last close
+  CHECK(openPageFile("testbuffer.bin", &other));
+  ASSERT_EQUALS_INT(4, other.totalNumPages, "pages of last close");
+  for (i = 0; i < 4; i++)
+    {
+      memset(expected, 0, PAGE_SIZE);
+      sprintf(expected, "Page-%i", i);
+      CHECK(readBlock(i, &other, page));
+      ASSERT_TRUE(memcmp(expected, page, PAGE_SIZE) == 0, "old image readable");
+    }
+  CHECK(closePageFile(&other));
+  CHECK(closePageFile(&fh));
+
+  CHECK(openPageFile("testbuffer.bin", &other));
+  CHECK(readBlock(1, &other, page));
+  ASSERT_TRUE(memcmp(noise, page, PAGE_SIZE) == 0, "new image after close");
+  CHECK(closePageFile(&other));
+
+  // map cut short by file size is refused
+  stat("testbuffer.bin", &st);
+  ASSERT_TRUE(truncate("testbuffer.bin", st.st_size - 8) == 0, "file cut");
+  ASSERT_ERROR(openPageFile("testbuffer.bin", &other), "map past end of file");
+
+  CHECK(destroyPageFile("testbuffer.bin"));
+  TEST_DONE();
+}
+
+// ************************************************************
+// Rewriting pages of compressed file reuses the bytes of old images.
+void
+testCompressedRewrites (void)
+{
+  SM_FileHandle fh, other;
+  char page[PAGE_SIZE], expected[PAGE_SIZE];
+  struct stat st;
+  int round, i, j;
+  testName = "Testing rewrites of compressed file";
+
+  CHECK(createCompressedPageFile("testbuffer.bin"));
+  for (round = 0; round < 20; round++)
+    {
+      CHECK(openPageFile("testbuffer.bin", &fh));
+      for (j = 0; j < 3; j++)
+        for (i = 0; i < 16; i++)
+          {
+            fillRewrite(page, i, round * 3 + j);
+            CHECK(writeBlock(i, &fh, page));
+          }
+
+      // without close, images of last close are untouched
+      CHECK(openPageFile("testbuffer.bin", &other));
+      for (i = 0; round > 0 && i < 16; i++)
+        {
+          fillRewrite(expected, i, round * 3 - 1);
+          CHECK(readBlock(i, &other, page));
+          ASSERT_TRUE(memcmp(expected, page, PAGE_SIZE) == 0, "old image kept");
+        }
+      CHECK(closePageFile(&other));
+      CHECK(closePageFile(&fh));
+
+      // live images take at most 16 pages, old ones are reused
+      stat("testbuffer.bin", &st);
+      ASSERT_TRUE(st.st_size <= 34 * PAGE_SIZE, "file size bounded");
+
+      CHECK(openPageFile("testbuffer.bin", &fh));
+      for (i = 0; i < 16; i++)
+        {
+          fillRewrite(expected, i, round * 3 + 2);
+          CHECK(readBlock(i, &fh, page));
+          ASSERT_TRUE(memcmp(expected, page, PAGE_SIZE) == 0, "last image read");
+        }
+      CHECK(closePageFile(&fh));
+    }
+
+  CHECK(destroyPageFile("testbuffer.bin"));
+  TEST_DONE();
+}
+
+// Text, noise or zero page, every version of a page changes kind.
+void
+fillRewrite (char *page, int pageNum, int version)
+{
+  int i;
+
+  memset(page, 0, PAGE_SIZE);
+  switch ((pageNum + version) % 3)
+    {
+    case 0:
+      sprintf(page, "Page-%i-%i", pageNum, version);
+      break;
+    case 1:
+      srand(pageNum * 1000 + version);
+      for (i = 0; i < PAGE_SIZE; i++)
+        page[i] = (char) rand();
+      break;
+    }
+}
+
+// ************************************************************
+// Header of plain file covers every extent handed out.
+void
+testPageFileExtents (void)
+{
+  SM_FileHandle fh, other;
+  char page[PAGE_SIZE], expected[PAGE_SIZE];
+  int i;
+  testName = "Testing extents of plain page file";
+
+  CHECK(createPageFile("testbuffer.bin"));
+  CHECK(openPageFile("testbuffer.bin", &fh));
+  CHECK(ensureCapacity(10, &fh));
+  memset(expected, 0, PAGE_SIZE);
+  sprintf(expected, "Page-%i", 9);
+  CHECK(writeBlock(9, &fh, expected));
+
+  // without close, header still counts page 9
+  CHECK(openPageFile("testbuffer.bin", &other));
+  ASSERT_TRUE(other.totalNumPages >= 10, "extent counted");
+  CHECK(readBlock(9, &other, page));
+  ASSERT_TRUE(memcmp(expected, page, PAGE_SIZE) == 0, "page 9 kept");
+  CHECK(appendEmptyBlock(&other));
+  CHECK(readLastBlock(&other, page));
+  for (i = 0; i < PAGE_SIZE && page[i] == 0; i++)
+    ;
+  ASSERT_EQUALS_INT(PAGE_SIZE, i, "appended page is empty");
+  CHECK(closePageFile(&other));
+  CHECK(closePageFile(&fh));
+
+  // close writes exact count
+  CHECK(openPageFile("testbuffer.bin", &other));
+  ASSERT_EQUALS_INT(10, other.totalNumPages, "pages after close");
+  CHECK(closePageFile(&other));
+
+  CHECK(destroyPageFile("testbuffer.bin"));
+  TEST_DONE();
+}
+
+// ************************************************************
+// Freed pages are handed out again, full groups are skipped.
+void
+testFreeSpaceMap (void)
+{
+  BM_BufferPool *bm = MAKE_POOL();
+  FSM_Handle *fsm = (FSM_Handle *) malloc(sizeof(FSM_Handle));
+  PageNumber page;
+  int i;
+  testName = "Testing free space map";
+
+  CHECK(createPageFile("test_fsm.bin"));
+  CHECK(initBufferPool(bm, "test_fsm.bin", 4, RS_LRU, NULL));
+  CHECK(initFreeSpaceMap(fsm, bm));
+
+  for(i = 1; i <= 3; i++)
+    {
+      CHECK(allocatePage(fsm, &page));
+      ASSERT_EQUALS_INT(i, page, "pages after map page");
+    }
+  CHECK(freePage(fsm, 2));
+  ASSERT_TRUE(!isPageAllocated(fsm, 2), "page 2 freed");
+  ASSERT_EQUALS_INT(RC_PAGE_NOT_ALLOCATED, freePage(fsm, 2), "freed twice");
+  ASSERT_EQUALS_INT(RC_PAGE_NOT_ALLOCATED, freePage(fsm, 0), "map page");
+  CHECK(allocatePage(fsm, &page));
+  ASSERT_EQUALS_INT(2, page, "freed page reused");
+
+  // lookups round up, so page found has enough room
+  CHECK(setPageFreeSpace(fsm, 1, 100));
+  CHECK(setPageFreeSpace(fsm, 2, 0));
+  CHECK(setPageFreeSpace(fsm, 3, 1000));
+  CHECK(findPageWithFreeSpace(fsm, 500, &page));
+  ASSERT_EQUALS_INT(3, page, "page with 1000 free bytes");
+  CHECK(findPageWithFreeSpace(fsm, 90, &page));
+  ASSERT_EQUALS_INT(1, page, "page with 100 free bytes");
+  ASSERT_EQUALS_INT(RC_NO_PAGE_WITH_FREE_SPACE,
+                    findPageWithFreeSpace(fsm, 2000, &page), "no page");
+  ASSERT_EQUALS_INT(RC_PAGE_NOT_ALLOCATED, setPageFreeSpace(fsm, 4, 10),
+                    "page 4 not allocated");
+
+  // fill group 0, next page is past map page of group 1
+  for(i = 4; i <= FSM_GROUP_PAGES; i++)
+    CHECK(allocatePage(fsm, &page));
+  ASSERT_EQUALS_INT(FSM_GROUP_PAGES, page, "last page of group 0");
+  CHECK(allocatePage(fsm, &page));
+  ASSERT_EQUALS_INT(FSM_MAP_PAGE(1) + 1, page, "first page of group 1");
+  ASSERT_TRUE(!isPageAllocated(fsm, FSM_MAP_PAGE(1)), "map page not allocated");
+  CHECK(freePage(fsm, 1000));
+  CHECK(allocatePage(fsm, &page));
+  ASSERT_EQUALS_INT(1000, page, "freed page of full group reused");
+
+  // summary is rebuilt from map pages
+  CHECK(shutdownFreeSpaceMap(fsm));
+  CHECK(shutdownBufferPool(bm));
+  CHECK(initBufferPool(bm, "test_fsm.bin", 4, RS_LRU, NULL));
+  CHECK(initFreeSpaceMap(fsm, bm));
+  ASSERT_TRUE(isPageAllocated(fsm, FSM_MAP_PAGE(1) + 1), "page of group 1 kept");
+  CHECK(findPageWithFreeSpace(fsm, 500, &page));
+  ASSERT_EQUALS_INT(3, page, "free space kept");
+  CHECK(allocatePage(fsm, &page));
+  ASSERT_EQUALS_INT(FSM_MAP_PAGE(1) + 2, page, "group 0 still full");
+
+  CHECK(shutdownFreeSpaceMap(fsm));
+  CHECK(shutdownBufferPool(bm));
+  CHECK(destroyPageFile("test_fsm.bin"));
+  free(bm);
+  free(fsm);
+  TEST_DONE();
+}
+
+// ************************************************************
+// Flushed page stays in its frame, evicted dirty page leaves it.
+void
+testFlushedPages (void)
+{
+  BM_BufferPool *bm = MAKE_POOL();
+  BM_PageHandle *h = MAKE_PAGE_HANDLE();
+  ReplacementStrategy strategies[3] = {RS_FIFO, RS_LRU, RS_CLOCK};
+  PageNumber *frameContents;
+  int s, i, frame, copies;
+  testName = "Testing flushed and evicted dirty pages";
+
+  for (s = 0; s < 3; s++)
+    {
+      CHECK(createPageFile("testbuffer.bin"));
+      CHECK(initBufferPool(bm, "testbuffer.bin", 3, strategies[s], NULL));
+
+      CHECK(pinPage(bm, h, 0));
+      sprintf(h->data, "%s-%i", "Page", 0);
+      CHECK(markDirty(bm, h));
+      CHECK(forcePage(bm, h));
+      frameContents = getFrameContents(bm);
+      for (frame = 0; frame < 3 && frameContents[frame] != 0; frame++)
+        ;
+      free(frameContents);
+      CHECK(unpinPage(bm, h));
+      CHECK(pinPage(bm, h, 0));
+      frameContents = getFrameContents(bm);
+      ASSERT_EQUALS_INT(0, frameContents[frame], "flushed page in same frame");
+      free(frameContents);
+      ASSERT_EQUALS_INT(1, getNumReadIO(bm), "flushed page not read again");
+
+      // dirty page 0 is written out and leaves pool
+      CHECK(markDirty(bm, h));
+      CHECK(unpinPage(bm, h));
+      for (i = 1; i <= 5; i++)
+        {
+          CHECK(pinPage(bm, h, i));
+          sprintf(h->data, "%s-%i", "Page", i);
+          CHECK(markDirty(bm, h));
+          CHECK(unpinPage(bm, h));
+        }
+      CHECK(pinPage(bm, h, 0));
+      ASSERT_EQUALS_STRING("Page-0", h->data, "evicted page read back");
+      frameContents = getFrameContents(bm);
+      for (i = 0, copies = 0; i < 3; i++)
+        if (frameContents[i] == 0)
+          copies++;
+      ASSERT_EQUALS_INT(1, copies, "page 0 in one frame");
+      free(frameContents);
+      CHECK(unpinPage(bm, h));
+
+      CHECK(shutdownBufferPool(bm));
+      CHECK(destroyPageFile("testbuffer.bin"));
+    }
+  free(bm);
+  free(h);
+  TEST_DONE();
+}
@@ -0,0 +1,884 @@
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+
+#include "dberror.h"
+#include "expr.h"
+#include "record_mgr.h"
+#include "tables.h"
+#include "test_helper.h"
+
+#define ASSERT_EQUALS_RECORDS(_l,_r, schema, message)			\
+  do {									\
+    Record *_lR = _l;                                                   \
+    Record *_rR = _r;                                                   \
+    ASSERT_TRUE(memcmp(_lR->data,_rR->data,getRecordSize(schema)) == 0, message); \
+  } while(0)
+
+typedef struct TestRecord {
+  int a;
+  char *b;
+  int c;
+} TestRecord;
+
+// var to store the current test's name
+char *testName;
+
+// helper methods
+static Schema *testSchema (void);
+static Record *fromTestRecord (Schema *schema, TestRecord in);
+static Record *testRecord (Schema *schema, int a, char *b, int c);
+
+// test methods
+static void testRecords (void);
+static void testCreateTableAndInsert (void);
+static void testUpdateTable (void);
+static void testScans (void);
+static void testManyRecords (void);
+static void testGrowingUpdates (void);
+static void testFailedMove (void);
+static void testBatchConditions (void);
+static void testBulkLoad (void);
+
+// main method
+int
+main (void)
+{
+  testName = "";
+
+  testRecords();
+  testCreateTableAndInsert();
+  testUpdateTable();
+  testScans();
+  testManyRecords();
+  testGrowingUpdates();
+  testFailedMove();
+  testBatchConditions();
+  testBulkLoad();
+
+  return 0;
+}
+
+// ************************************************************
+void
+testRecords (void)
+{
+  TestRecord expected[] = {
+    {1, "aaaa", 3},
+  };
+  Schema *schema;
+  Record *r, *check;
+  Value *value;
+  testName = "test creating records and manipulating attributes";
+
+  schema = testSchema();
+  TEST_CHECK(createRecord(&r, schema));
+  MAKE_VALUE(value, DT_INT, 1);
+  TEST_CHECK(setAttr(r, schema, 0, value));
+  freeVal(value);
+  MAKE_STRING_VALUE(value, "aaaa");
+  TEST_CHECK(setAttr(r, schema, 1, value));
+  freeVal(value);
+  MAKE_VALUE(value, DT_INT, 3);
+  TEST_CHECK(setAttr(r, schema, 2, value));
+  freeVal(value);
+
+  check = fromTestRecord(schema, expected[0]);
+  ASSERT_EQUALS_RECORDS(check, r, schema, "expected record");
+  freeRecord(check);
+
+  TEST_CHECK(getAttr(r, schema, 1, &value));
+  ASSERT_EQUALS_STRING("aaaa", value->v.stringV, "string attribute");
+  freeVal(value);
+
+  freeRecord(r);
+  freeSchema(schema);
+  TEST_DONE();
+}
+
+// ************************************************************
+void
+testCreateTableAndInsert (void)
+{
+  RM_TableData *table = (RM_TableData *) malloc(sizeof(RM_TableData));
+  TestRecord inserts[] = {
+    {1, "aaaa", 3},
+    {2, "bbbb", 2},
+    {3, "cccc", 1},
+    {4, "dddd", 3},
+    {5, "eeee", 5},
+    {6, "ffff", 1},
+    {7, "gggg", 3},
+    {8, "hhhh", 3},
+    {9, "iiii", 2}
+  };
+  int numInserts = 9, i;
+  Record *r;
+  RID *rids;
+  Schema *schema;
+  testName = "test creating a new table and inserting tuples";
+  schema = testSchema();
+  rids = (RID *) malloc(sizeof(RID) * numInserts);
+
+  TEST_CHECK(initRecordManager(NULL));
+  TEST_CHECK(createTable("test_table_r",schema));
+  TEST_CHECK(openTable(table, "test_table_r"));
+
+  // insert rows into table
+  for(i = 0; i < numInserts; i++)
+    {
+      r = fromTestRecord(schema, inserts[i]);
+      TEST_CHECK(insertRecord(table,r));
+      rids[i] = r->id;
+      freeRecord(r);
+    }
+  ASSERT_EQUALS_INT(numInserts, getNumTuples(table), "number of tuples");
+
+  TEST_CHECK(closeTable(table));
+  TEST_CHECK(openTable(table, "test_table_r"));
+  ASSERT_EQUALS_INT(numInserts, getNumTuples(table), "number of tuples after reopen");
+
+  // randomly retrieve records from the table and compare to inserted ones
+  for(i = 0; i < 1000; i++)
+    {
+      int pos = rand() % numInserts;
+      RID rid = rids[pos];
+      Record *expected = fromTestRecord(schema, inserts[pos]);
+      TEST_CHECK(createRecord(&r, schema));
+      TEST_CHECK(getRecord(table, rid, r));
+      ASSERT_EQUALS_RECORDS(expected, r, schema, "compare records");
+      freeRecord(r);
+      freeRecord(expected);
+    }
+
+  TEST_CHECK(closeTable(table));
+  TEST_CHECK(deleteTable("test_table_r"));
+  TEST_CHECK(shutdownRecordManager());
+
+  free(rids);
+  free(table);
+  freeSchema(schema);
+  TEST_DONE();
+}
+
+// ************************************************************
+void
+testUpdateTable (void)
+{
+  RM_TableData *table = (RM_TableData *) malloc(sizeof(RM_TableData));
+  TestRecord inserts[] = {
+    {1, "aaaa", 3},
+    {2, "bbbb", 2},
+    {3, "cccc", 1},
+    {4, "dddd", 3},
+    {5, "eeee", 5},
+    {6, "ffff", 1},
+    {7, "gggg", 3},
+    {8, "hhhh", 3},
+    {9, "iiii", 2},
+    {10, "jjjj", 5},
+  };
+  TestRecord updates[] = {
+    {1, "iiii", 6},
+    {2, "iiii", 6},
+    {3, "iiii", 6}
+  };
+  int deletes[] = {9, 6, 7, 8, 5};
+  TestRecord finalR[] = {
+    {1, "iiii", 6},
+    {2, "iiii", 6},
+    {3, "iiii", 6},
+    {4, "dddd", 3},
+    {5, "eeee", 5},
+  };
+  int numInserts = 10, numUpdates = 3, numDeletes = 5, numFinal = 5, i;
+  Record *r;
+  RID *rids;
+  Schema *schema;
+  testName = "test creating a new table and insert,update,delete tuples";
+  schema = testSchema();
+  rids = (RID *) malloc(sizeof(RID) * numInserts);
+
+  TEST_CHECK(initRecordManager(NULL));
+  TEST_CHECK(createTable("test_table_r",schema));
+  TEST_CHECK(openTable(table, "test_table_r"));
+
+  for(i = 0; i < numInserts; i++)
+    {
+      r = fromTestRecord(schema, inserts[i]);
+      TEST_CHECK(insertRecord(table,r));
+      rids[i] = r->id;
+      freeRecord(r);
+    }
+
+  for(i = 0; i < numDeletes; i++)
+    TEST_CHECK(deleteRecord(table,rids[deletes[i]]));
+  ASSERT_ERROR(deleteRecord(table,rids[deletes[0]]), "deleting deleted record");
+
+  for(i = 0; i < numUpdates; i++)
+    {
+      r = fromTestRecord(schema, updates[i]);
+      r->id = rids[i];
+      TEST_CHECK(updateRecord(table,r));
+      freeRecord(r);
+    }
+  ASSERT_EQUALS_INT(numFinal, getNumTuples(table), "number of tuples");
+
+  TEST_CHECK(closeTable(table));
+  TEST_CHECK(openTable(table, "test_table_r"));
+
+  for(i = 0; i < numFinal; i++)
+    {
+      Record *expected = fromTestRecord(schema, finalR[i]);
+      TEST_CHECK(createRecord(&r, schema));
+      TEST_CHECK(getRecord(table, rids[i], r));
+      ASSERT_EQUALS_RECORDS(expected, r, schema, "compare records");
+      freeRecord(r);
+      freeRecord(expected);
+    }
+  TEST_CHECK(createRecord(&r, schema));
+  ASSERT_ERROR(getRecord(table, rids[deletes[0]], r), "reading deleted record");
+  freeRecord(r);
+
+  TEST_CHECK(closeTable(table));
+  TEST_CHECK(deleteTable("test_table_r"));
+  TEST_CHECK(shutdownRecordManager());
+
+  free(rids);
+  free(table);
+  freeSchema(schema);
+  TEST_DONE();
+}
+
+// ************************************************************
+void
+testScans (void)
+{
+  RM_TableData *table = (RM_TableData *) malloc(sizeof(RM_TableData));
+  TestRecord inserts[] = {
+    {1, "aaaa", 3},
+    {2, "bbbb", 2},
+    {3, "cccc", 1},
+    {4, "dddd", 3},
+    {5, "eeee", 5},
+    {6, "ffff", 1},
+    {7, "gggg", 3},
+    {8, "hhhh", 3},
+    {9, "iiii", 2},
+    {10, "jjjj", 5},
+  };
+  int numInserts = 10, i, count;
+  Record *r;
+  Schema *schema;
+  RM_ScanHandle *sc = (RM_ScanHandle *) malloc(sizeof(RM_ScanHandle));
+  Expr *sel, *left, *right, *notExpr;
+  Value *value;
+  RC rc;
+  testName = "test scans with conditions";
+  schema = testSchema();
+
+  TEST_CHECK(initRecordManager(NULL));
+  TEST_CHECK(createTable("test_table_r",schema));
+  TEST_CHECK(openTable(table, "test_table_r"));
+
+  for(i = 0; i < numInserts; i++)
+    {
+      r = fromTestRecord(schema, inserts[i]);
+      TEST_CHECK(insertRecord(table,r));
+      freeRecord(r);
+    }
+
+  // c = 3
+  MAKE_VALUE(value, DT_INT, 3);
+  MAKE_CONS(left, value);
+  MAKE_ATTRREF(right, 2);
+  MAKE_BINOP_EXPR(sel, left, right, OP_COMP_EQUAL);
+
+  TEST_CHECK(createRecord(&r, schema));
+  TEST_CHECK(startScan(table, sc, sel));
+  count = 0;
+  while((rc = next(sc, r)) == RC_OK)
+    {
+      Record *check;
+      ASSERT_EQUALS_INT(3, *((int *) (r->data + getRecordSize(schema) - sizeof(int))), "scanned c");
+      TEST_CHECK(createRecord(&check, schema));
+      TEST_CHECK(getRecord(table, r->id, check));
+      ASSERT_EQUALS_RECORDS(check, r, schema, "scan RID reads same record");
+      freeRecord(check);
+      count++;
+    }
+  ASSERT_EQUALS_INT(RC_RM_NO_MORE_TUPLES, rc, "scan ended");
+  ASSERT_EQUALS_INT(4, count, "matching c = 3");
+  TEST_CHECK(closeScan(sc));
+
+  // NOT (a < 5)
+  MAKE_UNOP_EXPR(notExpr, NULL, OP_BOOL_NOT);
+  MAKE_ATTRREF(left, 0);
+  MAKE_VALUE(value, DT_INT, 5);
+  MAKE_CONS(right, value);
+  freeExpr(sel);
+  MAKE_BINOP_EXPR(sel, left, right, OP_COMP_SMALLER);
+  notExpr->expr.op->args[0] = sel;
+
+  TEST_CHECK(startScan(table, sc, notExpr));
+  count = 0;
+  while((rc = next(sc, r)) == RC_OK)
+    count++;
+  ASSERT_EQUALS_INT(RC_RM_NO_MORE_TUPLES, rc, "scan ended");
+  ASSERT_EQUALS_INT(6, count, "matching a >= 5");
+  TEST_CHECK(closeScan(sc));
+
+  // a without comparison is not a condition
+  MAKE_ATTRREF(sel, 0);
+  TEST_CHECK(startScan(table, sc, sel));
+  ASSERT_EQUALS_INT(RC_RM_EXPR_RESULT_IS_NOT_BOOLEAN, next(sc, r), "non boolean condition");
+  TEST_CHECK(closeScan(sc));
+  freeExpr(sel);
+
+  freeRecord(r);
+  freeExpr(notExpr);
+  TEST_CHECK(closeTable(table));
+  TEST_CHECK(deleteTable("test_table_r"));
+  TEST_CHECK(shutdownRecordManager());
+
+  free(table);
+  free(sc);
+  freeSchema(schema);
+  TEST_DONE();
+}
+
+// ************************************************************
+void
+testManyRecords (void)
+{
+  RM_TableData *table = (RM_TableData *) malloc(sizeof(RM_TableData));
+  RM_ScanHandle *sc = (RM_ScanHandle *) malloc(sizeof(RM_ScanHandle));
+  int numInserts = 10000, i, count;
+  Record *r;
+  RID *rids;
+  Schema *schema;
+  RC rc;
+  testName = "test many inserts and deletes over many pages";
+  schema = testSchema();
+  rids = (RID *) malloc(sizeof(RID) * numInserts);
+
+  TEST_CHECK(initRecordManager(NULL));
+  TEST_CHECK(createTable("test_table_t",schema));
+  TEST_CHECK(openTable(table, "test_table_t"));
+
+  for(i = 0; i < numInserts; i++)
+    {
+      r = testRecord(schema, i, "abcd", i % 7);
+      TEST_CHECK(insertRecord(table,r));
+      rids[i] = r->id;
+      freeRecord(r);
+    }
+  ASSERT_TRUE(rids[numInserts - 1].page > 2, "records span several pages");
+
+  // delete every other record, space is reused by next inserts
+  for(i = 0; i < numInserts; i += 2)
+    TEST_CHECK(deleteRecord(table, rids[i]));
+  for(i = 0; i < numInserts; i += 2)
+    {
+      r = testRecord(schema, i, "ab", i % 7);
+      TEST_CHECK(insertRecord(table,r));
+      ASSERT_TRUE(r->id.page <= rids[numInserts - 1].page, "freed space is reused");
+      rids[i] = r->id;
+      freeRecord(r);
+    }
+  ASSERT_EQUALS_INT(numInserts, getNumTuples(table), "number of tuples");
+
+  TEST_CHECK(closeTable(table));
+  TEST_CHECK(openTable(table, "test_table_t"));
+
+  TEST_CHECK(createRecord(&r, schema));
+  for(i = 0; i < numInserts; i++)
+    {
+      Record *expected = testRecord(schema, i, (i % 2) ? "abcd" : "ab", i % 7);
+      TEST_CHECK(getRecord(table, rids[i], r));
+      if (memcmp(expected->data, r->data, getRecordSize(schema)) != 0)
+        ASSERT_TRUE(FALSE, "compare records");
+      freeRecord(expected);
+    }
+
+  TEST_CHECK(startScan(table, sc, NULL));
+  count = 0;
+  while((rc = next(sc, r)) == RC_OK)
+    count++;
+  ASSERT_EQUALS_INT(RC_RM_NO_MORE_TUPLES, rc, "scan ended");
+  ASSERT_EQUALS_INT(numInserts, count, "scan finds all records");
+  TEST_CHECK(closeScan(sc));
+  freeRecord(r);
+
+  TEST_CHECK(closeTable(table));
+  TEST_CHECK(deleteTable("test_table_t"));
+  TEST_CHECK(shutdownRecordManager());
+
+  free(rids);
+  free(table);
+  free(sc);
+  freeSchema(schema);
+  TEST_DONE();
+}
+
+// ************************************************************
+// Updates growing a tuple past free space of its page move it, RID must
+// keep working for get, update, delete and scan.
+void
+testGrowingUpdates (void)
+{
+  RM_TableData *table = (RM_TableData *) malloc(sizeof(RM_TableData));
+  RM_ScanHandle *sc = (RM_ScanHandle *) malloc(sizeof(RM_ScanHandle));
+  char longStr[101];
+  int numInserts = 500, i, count;
+  Record *r, *expected;
+  RID *rids;
+  Schema *schema;
+  RC rc;
+  testName = "test updates that move records";
+  schema = testSchema();
+  rids = (RID *) malloc(sizeof(RID) * numInserts);
+  schema->typeLength[1] = 100;
+  memset(longStr, 'x', 100);
+  longStr[100] = '\0';
+
+  TEST_CHECK(initRecordManager(NULL));
+  TEST_CHECK(createTable("test_table_u",schema));
+  TEST_CHECK(openTable(table, "test_table_u"));
+
+  for(i = 0; i < numInserts; i++)
+    {
+      r = testRecord(schema, i, "", i);
+      TEST_CHECK(insertRecord(table,r));
+      rids[i] = r->id;
+      freeRecord(r);
+    }
+
+  // grow every record twice, second update moves some tuples again
+  for(i = 0; i < numInserts; i++)
+    {
+      r = testRecord(schema, i, longStr + 50, i);
+      r->id = rids[i];
+      TEST_CHECK(updateRecord(table,r));
+      freeRecord(r);
+    }
+  for(i = 0; i < numInserts; i++)
+    {
+      r = testRecord(schema, i, longStr, -i);
+      r->id = rids[i];
+      TEST_CHECK(updateRecord(table,r));
+      freeRecord(r);
+    }
+
+  TEST_CHECK(createRecord(&r, schema));
+  for(i = 0; i < numInserts; i++)
+    {
+      expected = testRecord(schema, i, longStr, -i);
+      TEST_CHECK(getRecord(table, rids[i], r));
+      ASSERT_EQUALS_RECORDS(expected, r, schema, "moved record");
+      freeRecord(expected);
+    }
+
+  for(i = 0; i < numInserts; i += 3)
+    TEST_CHECK(deleteRecord(table, rids[i]));
+
+  TEST_CHECK(startScan(table, sc, NULL));
+  count = 0;
+  while((rc = next(sc, r)) == RC_OK)
+    {
+      ASSERT_TRUE(r->id.page == rids[*((int *) r->data)].page
+                  && r->id.slot == rids[*((int *) r->data)].slot, "scan reports home RID");
+      count++;
+    }
+  ASSERT_EQUALS_INT(RC_RM_NO_MORE_TUPLES, rc, "scan ended");
+  ASSERT_EQUALS_INT(numInserts - (numInserts + 2) / 3, count, "records left");
+  TEST_CHECK(closeScan(sc));
+  freeRecord(r);
+
+  TEST_CHECK(closeTable(table));
+  TEST_CHECK(deleteTable("test_table_u"));
+  TEST_CHECK(shutdownRecordManager());
+
+  free(rids);
+  free(table);
+  free(sc);
+  freeSchema(schema);
+  TEST_DONE();
+}
+
+// ************************************************************
+// Moving a tuple again fails when no frame is left for a new page,
+// the record must keep its old value.
+void
+testFailedMove (void)
+{
+  RM_TableData *table = (RM_TableData *) malloc(sizeof(RM_TableData));
+  RM_ScanHandle *sc = (RM_ScanHandle *) malloc(sizeof(RM_ScanHandle));
+  BM_PageHandle blockers[RM_POOL_PAGES];
+  BM_BufferPool *bm;
+  char str[2001];
+  Record *a, *r, *expected;
+  int i, count, numBlockers = RM_POOL_PAGES - 2;
+  int fill[] = { 2000, 1900, 2000, 800 };
+  Schema *schema;
+  RC rc;
+  testName = "test failed move of a moved record";
+  schema = testSchema();
+  schema->typeLength[1] = 2000;
+  memset(str, 'x', 2000);
+  str[2000] = '\0';
+
+  TEST_CHECK(initRecordManager(NULL));
+  TEST_CHECK(createTable("test_table_m",schema));
+  TEST_CHECK(openTable(table, "test_table_m"));
+
+  // a fills first page with two long records, growing it moves a to
+  // a new page that two more records then fill up.
+  a = testRecord(schema, 0, "", 0);
+  TEST_CHECK(insertRecord(table, a));
+  for(i = 0; i < 4; i++)
+    {
+      if (i == 2)
+        {
+          r = testRecord(schema, 0, str + 2000 - 1100, 0);
+          r->id = a->id;
+          TEST_CHECK(updateRecord(table, r));
+          freeRecord(r);
+        }
+      r = testRecord(schema, i + 1, str + 2000 - fill[i], i + 1);
+      TEST_CHECK(insertRecord(table, r));
+      freeRecord(r);
+    }
+
+  // only home and moved page can be pinned, no page for a to go to
+  bm = &((RM_TableMgmtData *) table->mgmtData)->bm;
+  for(i = 0; i < numBlockers; i++)
+    TEST_CHECK(pinPage(bm, &blockers[i], 100 + i));
+  r = testRecord(schema, 0, str, 0);
+  r->id = a->id;
+  ASSERT_ERROR(updateRecord(table, r), "no frame for new page");
+  freeRecord(r);
+
+  TEST_CHECK(createRecord(&r, schema));
+  expected = testRecord(schema, 0, str + 2000 - 1100, 0);
+  TEST_CHECK(getRecord(table, a->id, r));
+  ASSERT_EQUALS_RECORDS(expected, r, schema, "old value kept");
+  TEST_CHECK(startScan(table, sc, NULL));
+  count = 0;
+  while((rc = next(sc, r)) == RC_OK)
+    if (*((int *) r->data) == 0)
+      {
+        ASSERT_EQUALS_RECORDS(expected, r, schema, "old value scanned");
+        count++;
+      }
+  ASSERT_EQUALS_INT(1, count, "record still scanned");
+  TEST_CHECK(closeScan(sc));
+  freeRecord(expected);
+  for(i = 0; i < numBlockers; i++)
+    TEST_CHECK(unpinPage(bm, &blockers[i]));
+
+  // retried update moves it, scan sees it once
+  expected = testRecord(schema, 0, str, 0);
+  expected->id = a->id;
+  TEST_CHECK(updateRecord(table, expected));
+  TEST_CHECK(getRecord(table, a->id, r));
+  ASSERT_EQUALS_RECORDS(expected, r, schema, "new value");
+  TEST_CHECK(startScan(table, sc, NULL));
+  count = 0;
+  while((rc = next(sc, r)) == RC_OK)
+    if (*((int *) r->data) == 0)
+      count++;
+  ASSERT_EQUALS_INT(RC_RM_NO_MORE_TUPLES, rc, "scan ended");
+  ASSERT_EQUALS_INT(1, count, "moved record scanned once");
+  TEST_CHECK(closeScan(sc));
+  freeRecord(expected);
+  freeRecord(r);
+  freeRecord(a);
+
+  TEST_CHECK(closeTable(table));
+  TEST_CHECK(deleteTable("test_table_m"));
+  ASSERT_EQUALS_INT(RC_FILE_NOT_FOUND, openTable(table, "test_table_m"),
+                    "open deleted table");
+  TEST_CHECK(shutdownRecordManager());
+
+  free(table);
+  free(sc);
+  freeSchema(schema);
+  TEST_DONE();
+}
+
+// ************************************************************
+// Conditions on int, float and bool attributes are evaluated for a
+// page at once, they must select same records as evalExpr.
+void
+testBatchConditions (void)
+{
+  RM_TableData *table = (RM_TableData *) malloc(sizeof(RM_TableData));
+  RM_ScanHandle *sc = (RM_ScanHandle *) malloc(sizeof(RM_ScanHandle));
+  char *names[] = { "a", "s", "f", "b" };
+  DataType dt[] = { DT_INT, DT_STRING, DT_FLOAT, DT_BOOL };
+  int sizes[] = { 0, 10, 0, 0 };
+  char **cpNames = (char **) malloc(sizeof(char*) * 4);
+  DataType *cpDt = (DataType *) malloc(sizeof(DataType) * 4);
+  int *cpSizes = (int *) malloc(sizeof(int) * 4);
+  int *cpKeys = (int *) malloc(sizeof(int));
+  int numInserts = 5000, numConds = 4, i, count, expected;
+  Expr *conds[4], *l, *r2, *cmp1, *cmp2, *tmp;
+  Record *r;
+  Schema *schema;
+  Value *value, *result;
+  RC rc;
+  testName = "test batch evaluated scan conditions";
+
+  for(i = 0; i < 4; i++)
+    cpNames[i] = strdup(names[i]);
+  memcpy(cpDt, dt, sizeof(DataType) * 4);
+  memcpy(cpSizes, sizes, sizeof(int) * 4);
+  cpKeys[0] = 0;
+  schema = createSchema(4, cpNames, cpDt, cpSizes, 1, cpKeys);
+
+  TEST_CHECK(initRecordManager(NULL));
+  TEST_CHECK(createTable("test_table_v",schema));
+  TEST_CHECK(openTable(table, "test_table_v"));
+
+  TEST_CHECK(createRecord(&r, schema));
+  for(i = 0; i < numInserts; i++)
+    {
+      MAKE_VALUE(value, DT_INT, (i * 7919) % 1000);
+      TEST_CHECK(setAttr(r, schema, 0, value));
+      freeVal(value);
+      MAKE_STRING_VALUE(value, (i % 3) ? "xyz" : "a longer");
+      TEST_CHECK(setAttr(r, schema, 1, value));
+      freeVal(value);
+      MAKE_VALUE(value, DT_FLOAT, (float) (i % 10) / 2);
+      TEST_CHECK(setAttr(r, schema, 2, value));
+      freeVal(value);
+      MAKE_VALUE(value, DT_BOOL, (i % 4) == 0);
+      TEST_CHECK(setAttr(r, schema, 3, value));
+      freeVal(value);
+      TEST_CHECK(insertRecord(table, r));
+    }
+
+  // a < 500
+  MAKE_ATTRREF(l, 0);
+  MAKE_VALUE(value, DT_INT, 500);
+  MAKE_CONS(r2, value);
+  MAKE_BINOP_EXPR(conds[0], l, r2, OP_COMP_SMALLER);
+
+  // 2.5 < f AND NOT (b = true)
+  MAKE_VALUE(value, DT_FLOAT, 2.5);
+  MAKE_CONS(l, value);
+  MAKE_ATTRREF(r2, 2);
+  MAKE_BINOP_EXPR(cmp1, l, r2, OP_COMP_SMALLER);
+  MAKE_ATTRREF(l, 3);
+  MAKE_VALUE(value, DT_BOOL, 1);
+  MAKE_CONS(r2, value);
+  MAKE_BINOP_EXPR(tmp, l, r2, OP_COMP_EQUAL);
+  MAKE_UNOP_EXPR(cmp2, tmp, OP_BOOL_NOT);
+  MAKE_BINOP_EXPR(conds[1], cmp1, cmp2, OP_BOOL_AND);
+
+  // 999 = a OR f = 0.5
+  MAKE_VALUE(value, DT_INT, 999);
+  MAKE_CONS(l, value);
+  MAKE_ATTRREF(r2, 0);
+  MAKE_BINOP_EXPR(cmp1, l, r2, OP_COMP_EQUAL);
+  MAKE_ATTRREF(l, 2);
+  MAKE_VALUE(value, DT_FLOAT, 0.5);
+  MAKE_CONS(r2, value);
+  MAKE_BINOP_EXPR(cmp2, l, r2, OP_COMP_EQUAL);
+  MAKE_BINOP_EXPR(conds[2], cmp1, cmp2, OP_BOOL_OR);
+
+  // s = "xyz" AND a < 100, not batch evaluated
+  MAKE_ATTRREF(l, 1);
+  MAKE_STRING_VALUE(value, "xyz");
+  MAKE_CONS(r2, value);
+  MAKE_BINOP_EXPR(cmp1, l, r2, OP_COMP_EQUAL);
+  MAKE_ATTRREF(l, 0);
+  MAKE_VALUE(value, DT_INT, 100);
+  MAKE_CONS(r2, value);
+  MAKE_BINOP_EXPR(cmp2, l, r2, OP_COMP_SMALLER);
+  MAKE_BINOP_EXPR(conds[3], cmp1, cmp2, OP_BOOL_AND);
+
+  for(i = 0; i < numConds; i++)
+    {
+      // expected count by evaluating condition on every record
+      expected = 0;
+      TEST_CHECK(startScan(table, sc, NULL));
+      while((rc = next(sc, r)) == RC_OK)
+        {
+          TEST_CHECK(evalExpr(r, schema, conds[i], &result));
+          expected += result->v.boolV ? 1 : 0;
+          freeVal(result);
+        }
+      TEST_CHECK(closeScan(sc));
+
+      count = 0;
+      TEST_CHECK(startScan(table, sc, conds[i]));
+      while((rc = next(sc, r)) == RC_OK)
+        {
+          TEST_CHECK(evalExpr(r, schema, conds[i], &result));
+          if (!result->v.boolV)
+            ASSERT_TRUE(FALSE, "scan returns matching record");
+          freeVal(result);
+          count++;
+        }
+      ASSERT_EQUALS_INT(RC_RM_NO_MORE_TUPLES, rc, "scan ended");
+      ASSERT_EQUALS_INT(expected, count, "same records as evalExpr");
+      ASSERT_TRUE(count > 0 && count < numInserts, "condition is selective");
+      TEST_CHECK(closeScan(sc));
+      freeExpr(conds[i]);
+    }
+
+  freeRecord(r);
+  TEST_CHECK(closeTable(table));
+  TEST_CHECK(deleteTable("test_table_v"));
+  TEST_CHECK(shutdownRecordManager());
+
+  free(table);
+  free(sc);
+  freeSchema(schema);
+  TEST_DONE();
+}
+
+// ************************************************************
+// Bulk loaded table has to work like an inserted one. Lower fill
+// factor leaves room in pages, which later inserts use.
+void
+testBulkLoad (void)
+{
+  RM_TableData *table = (RM_TableData *) malloc(sizeof(RM_TableData));
+  RM_ScanHandle *sc = (RM_ScanHandle *) malloc(sizeof(RM_ScanHandle));
+  float fills[] = { 1.0, 0.5 };
+  int numInserts = 10000, lastPage[2], f, i, count;
+  RM_TableLoad *load;
+  Record *r, *expected;
+  RID *rids;
+  Schema *schema;
+  RC rc;
+  testName = "test bulk loading tables";
+  schema = testSchema();
+  rids = (RID *) malloc(sizeof(RID) * numInserts);
+
+  TEST_CHECK(initRecordManager(NULL));
+  for(f = 0; f < 2; f++)
+    {
+      TEST_CHECK(startTableLoad(&load, "test_table_l", schema, fills[f]));
+      for(i = 0; i < numInserts; i++)
+        {
+          r = testRecord(schema, i, (i % 2) ? "abcd" : "ab", i % 7);
+          TEST_CHECK(loadRecord(load, r));
+          rids[i] = r->id;
+          freeRecord(r);
+        }
+      TEST_CHECK(finishTableLoad(load));
+      lastPage[f] = rids[numInserts - 1].page;
+
+      TEST_CHECK(openTable(table, "test_table_l"));
+      ASSERT_EQUALS_INT(numInserts, getNumTuples(table), "number of tuples");
+
+      TEST_CHECK(createRecord(&r, schema));
+      for(i = 0; i < numInserts; i++)
+        {
+          expected = testRecord(schema, i, (i % 2) ? "abcd" : "ab", i % 7);
+          TEST_CHECK(getRecord(table, rids[i], r));
+          if (memcmp(expected->data, r->data, getRecordSize(schema)) != 0)
+            ASSERT_TRUE(FALSE, "compare records");
+          freeRecord(expected);
+        }
+
+      // grow half of records, then insert more
+      for(i = 0; i < numInserts; i += 2)
+        {
+          expected = testRecord(schema, i, "abcd", i % 7);
+          expected->id = rids[i];
+          TEST_CHECK(updateRecord(table, expected));
+          freeRecord(expected);
+        }
+      for(i = 0; i < 100; i++)
+        {
+          expected = testRecord(schema, numInserts + i, "abcd", 0);
+          TEST_CHECK(insertRecord(table, expected));
+          if (f == 1)
+            ASSERT_TRUE(expected->id.page <= lastPage[f], "free space of loaded pages is used");
+          freeRecord(expected);
+        }
+
+      TEST_CHECK(startScan(table, sc, NULL));
+      count = 0;
+      while((rc = next(sc, r)) == RC_OK)
+        count++;
+      ASSERT_EQUALS_INT(RC_RM_NO_MORE_TUPLES, rc, "scan ended");
+      ASSERT_EQUALS_INT(numInserts + 100, count, "scan finds all records");
+      TEST_CHECK(closeScan(sc));
+      freeRecord(r);
+
+      TEST_CHECK(closeTable(table));
+      TEST_CHECK(deleteTable("test_table_l"));
+    }
+  ASSERT_TRUE(lastPage[1] > lastPage[0] * 3 / 2, "half filled pages");
+  TEST_CHECK(shutdownRecordManager());
+
+  free(rids);
+  free(table);
+  free(sc);
+  freeSchema(schema);
+  TEST_DONE();
+}
+
+// ************************************************************
+Schema *
+testSchema (void)
+{
+  Schema *result;
+  char *names[] = { "a", "b", "c" };
+  DataType dt[] = { DT_INT, DT_STRING, DT_INT };
+  int sizes[] = { 0, 4, 0 };
+  int keys[] = {0};
+  int i;
+  char **cpNames = (char **) malloc(sizeof(char*) * 3);
+  DataType *cpDt = (DataType *) malloc(sizeof(DataType) * 3);
+  int *cpSizes = (int *) malloc(sizeof(int) * 3);
+  int *cpKeys = (int *) malloc(sizeof(int));
+
+  for(i = 0; i < 3; i++)
+    {
+      cpNames[i] = (char *) malloc(2);
+      strcpy(cpNames[i], names[i]);
+    }
+  memcpy(cpDt, dt, sizeof(DataType) * 3);
+  memcpy(cpSizes, sizes, sizeof(int) * 3);
+  memcpy(cpKeys, keys, sizeof(int));
+
+  result = createSchema(3, cpNames, cpDt, cpSizes, 1, cpKeys);
+
+  return result;
+}
+
+Record *
+fromTestRecord (Schema *schema, TestRecord in)
+{
+  return testRecord(schema, in.a, in.b, in.c);
+}
+
+Record *
+testRecord(Schema *schema, int a, char *b, int c)
+{
+  Record *result;
+  Value *value;
+
+  TEST_CHECK(createRecord(&result, schema));
+
+  MAKE_VALUE(value, DT_INT, a);
+  TEST_CHECK(setAttr(result, schema, 0, value));
+  freeVal(value);
+
+  MAKE_STRING_VALUE(value, b);
+  TEST_CHECK(setAttr(result, schema, 1, value));
+  freeVal(value);
+
+  MAKE_VALUE(value, DT_INT, c);
+  TEST_CHECK(setAttr(result, schema, 2, value));
+  freeVal(value);
+
+  return result;
+}
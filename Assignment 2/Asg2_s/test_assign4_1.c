@@ -0,0 +1,857 @@
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+#include <limits.h>
+#include <pthread.h>
+
+#include "dberror.h"
+#include "btree_mgr.h"
+#include "expr.h"
+#include "tables.h"
+#include "test_helper.h"
+
+// var to store the current test's name
+char *testName;
+
+// test methods
+static void testInsertAndFind (void);
+static void testDelete (void);
+static void testIndexScan (void);
+static void testRangeScan (void);
+static void testRandomOperations (void);
+static void testBulkLoad (void);
+static void testKeptInnerNodes (void);
+static void testConcurrentOperations (void);
+static void testFailedSplit (void);
+static void *opThread (void *arg);
+
+// helper methods
+static Value **createValues (char **stringVals, int size);
+static void freeValues (Value **vals, int size);
+static int *createPermutation (int size);
+static int scanCount (BTreeHandle *tree, Value *low, Value *high, int *firstPage);
+static int checkNode (BT_TreeMgmtData *t, PageNumber pn, int depth, int low, int high);
+
+// main method
+int
+main (void)
+{
+  testName = "";
+
+  testInsertAndFind();
+  testDelete();
+  testIndexScan();
+  testRangeScan();
+  testRandomOperations();
+  testBulkLoad();
+  testKeptInnerNodes();
+  testConcurrentOperations();
+  testFailedSplit();
+
+  return 0;
+}
+
+// ************************************************************
+void
+testInsertAndFind (void)
+{
+  RID insert[] = {
+    {1,1},
+    {2,3},
+    {1,2},
+    {3,5},
+    {4,4},
+    {3,2},
+  };
+  int numInserts = 6;
+  Value **keys;
+  char *stringKeys[] = {
+    "i1",
+    "i11",
+    "i13",
+    "i17",
+    "i23",
+    "i52"
+  };
+  testName = "test b-tree inserting and search";
+  int i, testint;
+  BTreeHandle *tree = NULL;
+
+  keys = createValues(stringKeys, numInserts);
+
+  TEST_CHECK(initIndexManager(NULL));
+  TEST_CHECK(createBtree("testidx", DT_INT, 2));
+  TEST_CHECK(openBtree(&tree, "testidx"));
+
+  for(i = 0; i < numInserts; i++)
+    TEST_CHECK(insertKey(tree, keys[i], insert[i]));
+  ASSERT_EQUALS_INT(RC_IM_KEY_ALREADY_EXISTS, insertKey(tree, keys[0], insert[0]),
+                    "duplicate key");
+
+  TEST_CHECK(getNumNodes(tree, &testint));
+  ASSERT_EQUALS_INT(testint, 4, "number of nodes in btree");
+  TEST_CHECK(getNumEntries(tree, &testint));
+  ASSERT_EQUALS_INT(testint, numInserts, "number of entries in btree");
+
+  // reopen and search for keys
+  TEST_CHECK(closeBtree(tree));
+  TEST_CHECK(openBtree(&tree, "testidx"));
+  for(i = 0; i < 1000; i++)
+    {
+      int pos = rand() % numInserts;
+      RID rid;
+      Value *key = keys[pos];
+
+      TEST_CHECK(findKey(tree, key, &rid));
+      ASSERT_EQUALS_INT(insert[pos].page, rid.page, "page ids match");
+      ASSERT_EQUALS_INT(insert[pos].slot, rid.slot, "slot ids match");
+    }
+
+  TEST_CHECK(closeBtree(tree));
+  TEST_CHECK(deleteBtree("testidx"));
+  ASSERT_EQUALS_INT(RC_FILE_NOT_FOUND, openBtree(&tree, "testidx"),
+                    "open deleted index");
+  TEST_CHECK(shutdownIndexManager());
+  freeValues(keys, numInserts);
+
+  TEST_DONE();
+}
+
+// ************************************************************
+// Lookups only pin the leaf, inner nodes stay pinned while open.
+void
+testKeptInnerNodes (void)
+{
+  int numKeys = 500, i, height;
+  BTreeHandle *tree = NULL;
+  BM_BufferPool *bm;
+  BM_PoolStats stats;
+  Value key;
+  RID rid;
+  testName = "test b-tree inner nodes kept pinned";
+
+  TEST_CHECK(initIndexManager(NULL));
+  TEST_CHECK(createBtree("testidx", DT_INT, 4));
+  TEST_CHECK(openBtree(&tree, "testidx"));
+  key.dt = DT_INT;
+  for(i = 0; i < numKeys; i++)
+    {
+      key.v.intV = i;
+      rid.page = i;
+      rid.slot = 0;
+      TEST_CHECK(insertKey(tree, &key, rid));
+    }
+  height = ((BT_TreeMgmtData *) tree->mgmtData)->height;
+  ASSERT_TRUE(height > 2, "tree has inner levels");
+
+  bm = &((BT_TreeMgmtData *) tree->mgmtData)->bm;
+  for(i = 0; i < numKeys; i++)
+    {
+      key.v.intV = i;
+      TEST_CHECK(findKey(tree, &key, &rid));
+    }
+  TEST_CHECK(resetPoolStats(bm));
+  for(i = 0; i < numKeys; i++)
+    {
+      key.v.intV = i;
+      TEST_CHECK(findKey(tree, &key, &rid));
+      if (rid.page != i)
+        ASSERT_EQUALS_INT(i, rid.page, "entry found");
+    }
+  TEST_CHECK(getPoolStats(bm, &stats));
+  ASSERT_EQUALS_INT(numKeys, (int) (stats.hits + stats.misses),
+                    "one pin per lookup");
+
+  // kept pins are given back on close
+  TEST_CHECK(closeBtree(tree));
+  TEST_CHECK(openBtree(&tree, "testidx"));
+  key.v.intV = numKeys - 1;
+  TEST_CHECK(findKey(tree, &key, &rid));
+  ASSERT_EQUALS_INT(numKeys - 1, rid.page, "entry after reopen");
+  TEST_CHECK(closeBtree(tree));
+  TEST_CHECK(deleteBtree("testidx"));
+  TEST_CHECK(shutdownIndexManager());
+
+  TEST_DONE();
+}
+
+// ************************************************************
+// Threads insert, delete and look up keys of overlapping ranges.
+// Successful inserts and deletes are counted per key, afterwards the
+// tree must hold exactly the keys counted in, in order, and every
+// node must be filled between its minimum and n.
+#define OP_THREADS 4
+#define OP_KEYS 2000
+#define OP_ROUNDS 5000
+static int keyBalance[OP_KEYS];
+static int opErrors;
+
+typedef struct OpThread {
+  pthread_t thread;
+  BTreeHandle *tree;
+  unsigned int seed;
+  int low;          // Thread uses keys low .. low + OP_KEYS / 2 - 1
+} OpThread;
+
+void
+testConcurrentOperations (void)
+{
+  OpThread threads[OP_THREADS];
+  BTreeHandle *tree = NULL;
+  BT_TreeMgmtData *t;
+  BT_ScanHandle *sc;
+  Value key;
+  RID rid;
+  int i, expected = 0, count = 0, last = -1, testint;
+  RC rc;
+  testName = "test b-tree concurrent inserts, deletes and lookups";
+
+  TEST_CHECK(initIndexManager(NULL));
+  TEST_CHECK(createBtree("testidx", DT_INT, 4));
+  TEST_CHECK(openBtree(&tree, "testidx"));
+
+  // every other key to start with, so deletes merge from the start
+  key.dt = DT_INT;
+  for(i = 0; i < OP_KEYS; i++)
+    {
+      keyBalance[i] = (i % 2 == 0);
+      if (!keyBalance[i])
+        continue;
+      key.v.intV = i;
+      rid.page = i;
+      rid.slot = i % 7;
+      TEST_CHECK(insertKey(tree, &key, rid));
+    }
+
+  opErrors = 0;
+  for(i = 0; i < OP_THREADS; i++)
+    {
+      threads[i].tree = tree;
+      threads[i].seed = i + 1;
+      threads[i].low = i * (OP_KEYS / 2) / (OP_THREADS - 1);
+      pthread_create(&threads[i].thread, NULL, opThread, &threads[i]);
+    }
+  for(i = 0; i < OP_THREADS; i++)
+    pthread_join(threads[i].thread, NULL);
+  ASSERT_EQUALS_INT(0, opErrors, "no unexpected results");
+
+  // lookups find exactly the keys counted in
+  for(i = 0; i < OP_KEYS; i++)
+    {
+      key.v.intV = i;
+      rc = findKey(tree, &key, &rid);
+      if (keyBalance[i] == 1)
+        {
+          expected++;
+          if (rc != RC_OK || rid.page != i || rid.slot != i % 7)
+            ASSERT_TRUE(FALSE, "key counted in is found");
+        }
+      else if (keyBalance[i] != 0 || rc != RC_IM_KEY_NOT_FOUND)
+        ASSERT_TRUE(FALSE, "key counted out is not found");
+    }
+  TEST_CHECK(getNumEntries(tree, &testint));
+  ASSERT_EQUALS_INT(expected, testint, "entries counted");
+
+  // full scan gives the same keys in order
+  TEST_CHECK(openTreeScan(tree, &sc));
+  while((rc = nextEntry(sc, &rid)) == RC_OK)
+    {
+      if (rid.page <= last || keyBalance[rid.page] != 1)
+        ASSERT_TRUE(FALSE, "scan in key order");
+      last = rid.page;
+      count++;
+    }
+  ASSERT_EQUALS_INT(RC_IM_NO_MORE_ENTRIES, rc, "scan ended");
+  TEST_CHECK(closeTreeScan(sc));
+  ASSERT_EQUALS_INT(expected, count, "scan sees all entries");
+
+  t = (BT_TreeMgmtData *) tree->mgmtData;
+  ASSERT_EQUALS_INT(expected, checkNode(t, t->root, 1, INT_MIN, INT_MAX),
+                    "nodes hold all entries");
+
+  TEST_CHECK(closeBtree(tree));
+  TEST_CHECK(deleteBtree("testidx"));
+  TEST_CHECK(shutdownIndexManager());
+
+  TEST_DONE();
+}
+
+void *
+opThread (void *arg)
+{
+  OpThread *op = (OpThread *) arg;
+  Value key;
+  RID rid;
+  int i, k;
+  RC rc;
+
+  key.dt = DT_INT;
+  for(i = 0; i < OP_ROUNDS; i++)
+    {
+      k = op->low + rand_r(&op->seed) % (OP_KEYS / 2);
+      key.v.intV = k;
+      switch (rand_r(&op->seed) % 3)
+        {
+        case 0:
+          rid.page = k;
+          rid.slot = k % 7;
+          rc = insertKey(op->tree, &key, rid);
+          if (rc == RC_OK)
+            __atomic_fetch_add(&keyBalance[k], 1, __ATOMIC_RELAXED);
+          else if (rc != RC_IM_KEY_ALREADY_EXISTS)
+            __atomic_fetch_add(&opErrors, 1, __ATOMIC_RELAXED);
+          break;
+        case 1:
+          rc = deleteKey(op->tree, &key);
+          if (rc == RC_OK)
+            __atomic_fetch_sub(&keyBalance[k], 1, __ATOMIC_RELAXED);
+          else if (rc != RC_IM_KEY_NOT_FOUND)
+            __atomic_fetch_add(&opErrors, 1, __ATOMIC_RELAXED);
+          break;
+        default:
+          rc = findKey(op->tree, &key, &rid);
+          if ((rc == RC_OK && (rid.page != k || rid.slot != k % 7))
+              || (rc != RC_OK && rc != RC_IM_KEY_NOT_FOUND))
+            __atomic_fetch_add(&opErrors, 1, __ATOMIC_RELAXED);
+          break;
+        }
+    }
+  return NULL;
+}
+
+// ************************************************************
+// Split that can not get a frame for its new node leaves the full
+// leaf as it was.
+void
+testFailedSplit (void)
+{
+  BTreeHandle *tree = NULL;
+  BT_TreeMgmtData *t;
+  BM_PageHandle *blockers;
+  Value key;
+  RID rid;
+  int i, numBlockers = 0, testint;
+  testName = "test b-tree split without free frames";
+
+  TEST_CHECK(initIndexManager(NULL));
+  TEST_CHECK(createBtree("testidx", DT_INT, 4));
+  TEST_CHECK(openBtree(&tree, "testidx"));
+  t = (BT_TreeMgmtData *) tree->mgmtData;
+  key.dt = DT_INT;
+  for(i = 0; i < 4; i++)
+    {
+      key.v.intV = i;
+      rid.page = i;
+      rid.slot = 0;
+      TEST_CHECK(insertKey(tree, &key, rid));
+    }
+
+  // one frame left, enough for the leaf but not for a new node
+  blockers = (BM_PageHandle *) malloc(BT_POOL_PAGES * sizeof(BM_PageHandle));
+  while (numBlockers < BT_POOL_PAGES
+         && pinPage(&t->bm, &blockers[numBlockers], 100 + numBlockers) == RC_OK)
+    numBlockers++;
+  TEST_CHECK(unpinPage(&t->bm, &blockers[--numBlockers]));
+
+  key.v.intV = 4;
+  rid.page = 4;
+  testint = insertKey(tree, &key, rid);
+  ASSERT_EQUALS_INT(RC_BUFFER_POOL_FULL, testint, "split fails");
+  for(i = 0; i < numBlockers; i++)
+    TEST_CHECK(unpinPage(&t->bm, &blockers[i]));
+  free(blockers);
+
+  ASSERT_EQUALS_INT(RC_IM_KEY_NOT_FOUND, findKey(tree, &key, &rid), "key not inserted");
+  TEST_CHECK(getNumEntries(tree, &testint));
+  ASSERT_EQUALS_INT(4, testint, "entries unchanged");
+  ASSERT_EQUALS_INT(4, checkNode(t, t->root, 1, INT_MIN, INT_MAX), "leaf unchanged");
+
+  // with frames back split goes through
+  TEST_CHECK(insertKey(tree, &key, rid));
+  TEST_CHECK(findKey(tree, &key, &rid));
+  ASSERT_EQUALS_INT(5, checkNode(t, t->root, 1, INT_MIN, INT_MAX), "split done");
+
+  TEST_CHECK(closeBtree(tree));
+  TEST_CHECK(deleteBtree("testidx"));
+  TEST_CHECK(shutdownIndexManager());
+
+  TEST_DONE();
+}
+
+// ************************************************************
+void
+testDelete (void)
+{
+  RID insert[] = {
+    {1,1},
+    {2,3},
+    {1,2},
+    {3,5},
+    {4,4},
+    {3,2},
+  };
+  int numInserts = 6;
+  Value **keys;
+  char *stringKeys[] = {
+    "i1",
+    "i11",
+    "i13",
+    "i17",
+    "i23",
+    "i52"
+  };
+  testName = "test b-tree delete";
+  int i, iter, testint;
+  BTreeHandle *tree = NULL;
+  bool *deletes = (bool *) malloc(numInserts * sizeof(bool));
+
+  keys = createValues(stringKeys, numInserts);
+  TEST_CHECK(initIndexManager(NULL));
+
+  for(iter = 0; iter < 50; iter++)
+    {
+      // randomly select entries for deletion
+      for(i = 0; i < numInserts; i++)
+        deletes[i] = (rand() % 2) ? TRUE : FALSE;
+
+      TEST_CHECK(createBtree("testidx", DT_INT, 2));
+      TEST_CHECK(openBtree(&tree, "testidx"));
+
+      for(i = 0; i < numInserts; i++)
+        TEST_CHECK(insertKey(tree, keys[i], insert[i]));
+      for(i = 0; i < numInserts; i++)
+        if (deletes[i])
+          TEST_CHECK(deleteKey(tree, keys[i]));
+
+      for(i = 0; i < numInserts; i++)
+        {
+          RID rid;
+          if (deletes[i])
+            {
+              ASSERT_EQUALS_INT(RC_IM_KEY_NOT_FOUND, findKey(tree, keys[i], &rid),
+                                "did find deleted key");
+              ASSERT_EQUALS_INT(RC_IM_KEY_NOT_FOUND, deleteKey(tree, keys[i]),
+                                "deleting deleted key");
+            }
+          else
+            {
+              TEST_CHECK(findKey(tree, keys[i], &rid));
+              ASSERT_EQUALS_INT(insert[i].page, rid.page, "page ids match");
+              ASSERT_EQUALS_INT(insert[i].slot, rid.slot, "slot ids match");
+            }
+        }
+
+      TEST_CHECK(getNumEntries(tree, &testint));
+      for(i = 0; i < numInserts; i++)
+        testint += deletes[i] ? 1 : 0;
+      ASSERT_EQUALS_INT(numInserts, testint, "entries left");
+
+      TEST_CHECK(closeBtree(tree));
+      TEST_CHECK(deleteBtree("testidx"));
+    }
+
+  TEST_CHECK(shutdownIndexManager());
+  freeValues(keys, numInserts);
+  free(deletes);
+
+  TEST_DONE();
+}
+
+// ************************************************************
+void
+testIndexScan (void)
+{
+  RID insert[] = {
+    {1,1},
+    {2,3},
+    {1,2},
+    {3,5},
+    {4,4},
+    {3,2},
+  };
+  int numInserts = 6;
+  Value **keys;
+  char *stringKeys[] = {
+    "i1",
+    "i11",
+    "i13",
+    "i17",
+    "i23",
+    "i52"
+  };
+  testName = "test b-tree index scan";
+  int i, iter;
+  int *permute;
+  BTreeHandle *tree = NULL;
+  BT_ScanHandle *sc;
+  RID rid;
+  RC rc;
+
+  keys = createValues(stringKeys, numInserts);
+  TEST_CHECK(initIndexManager(NULL));
+
+  for(iter = 0; iter < 50; iter++)
+    {
+      permute = createPermutation(numInserts);
+
+      TEST_CHECK(createBtree("testidx", DT_INT, 2));
+      TEST_CHECK(openBtree(&tree, "testidx"));
+
+      for(i = 0; i < numInserts; i++)
+        TEST_CHECK(insertKey(tree, keys[permute[i]], insert[permute[i]]));
+
+      // keys are returned in sorted order
+      TEST_CHECK(openTreeScan(tree, &sc));
+      i = 0;
+      while((rc = nextEntry(sc, &rid)) == RC_OK)
+        {
+          ASSERT_EQUALS_INT(insert[i].page, rid.page, "page id in order");
+          ASSERT_EQUALS_INT(insert[i].slot, rid.slot, "slot id in order");
+          i++;
+        }
+      ASSERT_EQUALS_INT(RC_IM_NO_MORE_ENTRIES, rc, "no error returned by scan");
+      ASSERT_EQUALS_INT(numInserts, i, "have seen all entries");
+      TEST_CHECK(closeTreeScan(sc));
+
+      TEST_CHECK(closeBtree(tree));
+      TEST_CHECK(deleteBtree("testidx"));
+      free(permute);
+    }
+
+  TEST_CHECK(shutdownIndexManager());
+  freeValues(keys, numInserts);
+
+  TEST_DONE();
+}
+
+// ************************************************************
+void
+testRangeScan (void)
+{
+  BTreeHandle *tree = NULL;
+  Value *low, *high;
+  int numKeys = 1000, i, firstPage;
+  RID rid;
+  testName = "test b-tree range scan";
+
+  TEST_CHECK(initIndexManager(NULL));
+  TEST_CHECK(createBtree("testidx", DT_INT, 4));
+  TEST_CHECK(openBtree(&tree, "testidx"));
+
+  // even keys 0 .. 1998, rid page is key
+  for(i = 0; i < numKeys; i++)
+    {
+      MAKE_VALUE(low, DT_INT, 2 * i);
+      rid.page = 2 * i;
+      rid.slot = 0;
+      TEST_CHECK(insertKey(tree, low, rid));
+      freeVal(low);
+    }
+
+  MAKE_VALUE(low, DT_INT, 101);
+  MAKE_VALUE(high, DT_INT, 200);
+  ASSERT_EQUALS_INT(50, scanCount(tree, low, high, &firstPage), "keys in [101,200]");
+  ASSERT_EQUALS_INT(102, firstPage, "first key >= 101");
+  ASSERT_EQUALS_INT(1000, scanCount(tree, NULL, NULL, &firstPage), "open range");
+  ASSERT_EQUALS_INT(0, firstPage, "first key of open range");
+  ASSERT_EQUALS_INT(51, scanCount(tree, NULL, low, &firstPage), "keys <= 101");
+  ASSERT_EQUALS_INT(900, scanCount(tree, high, NULL, &firstPage), "keys >= 200");
+  ASSERT_EQUALS_INT(0, scanCount(tree, high, low, &firstPage), "empty range");
+  freeVal(low);
+  freeVal(high);
+
+  TEST_CHECK(closeBtree(tree));
+  TEST_CHECK(deleteBtree("testidx"));
+  TEST_CHECK(shutdownIndexManager());
+
+  TEST_DONE();
+}
+
+// ************************************************************
+// Many inserts and deletes in random order for several fanouts,
+// tree has to stay consistent through splits, borrows and merges.
+void
+testRandomOperations (void)
+{
+  int fanouts[] = { 2, 3, 4, 7, BT_MAX_N };
+  int numKeys = 5000, f, i, testint, firstPage;
+  int *permute;
+  bool *present;
+  BTreeHandle *tree = NULL;
+  Value *key;
+  RID rid;
+  testName = "test b-tree random inserts and deletes";
+
+  TEST_CHECK(initIndexManager(NULL));
+  present = (bool *) malloc(numKeys * sizeof(bool));
+
+  for(f = 0; f < 5; f++)
+    {
+      TEST_CHECK(createBtree("testidx", DT_INT, fanouts[f]));
+      TEST_CHECK(openBtree(&tree, "testidx"));
+
+      permute = createPermutation(numKeys);
+      for(i = 0; i < numKeys; i++)
+        {
+          MAKE_VALUE(key, DT_INT, permute[i]);
+          rid.page = permute[i];
+          rid.slot = permute[i] % 7;
+          TEST_CHECK(insertKey(tree, key, rid));
+          freeVal(key);
+          present[i] = TRUE;
+        }
+      free(permute);
+
+      // delete 3/4 of keys in other order
+      permute = createPermutation(numKeys);
+      for(i = 0; i < numKeys * 3 / 4; i++)
+        {
+          MAKE_VALUE(key, DT_INT, permute[i]);
+          TEST_CHECK(deleteKey(tree, key));
+          freeVal(key);
+          present[permute[i]] = FALSE;
+        }
+      free(permute);
+
+      TEST_CHECK(closeBtree(tree));
+      TEST_CHECK(openBtree(&tree, "testidx"));
+
+      for(i = 0; i < numKeys; i++)
+        {
+          MAKE_VALUE(key, DT_INT, i);
+          if (present[i])
+            {
+              TEST_CHECK(findKey(tree, key, &rid));
+              if (rid.page != i || rid.slot != i % 7)
+                ASSERT_TRUE(FALSE, "rid of key");
+            }
+          else if (findKey(tree, key, &rid) != RC_IM_KEY_NOT_FOUND)
+            ASSERT_TRUE(FALSE, "deleted key not found");
+          freeVal(key);
+        }
+      TEST_CHECK(getNumEntries(tree, &testint));
+      ASSERT_EQUALS_INT(numKeys - numKeys * 3 / 4, testint, "entries left");
+      ASSERT_EQUALS_INT(testint, scanCount(tree, NULL, NULL, &firstPage), "scan sees all entries");
+
+      // delete rest, tree shrinks to an empty root leaf
+      for(i = 0; i < numKeys; i++)
+        if (present[i])
+          {
+            MAKE_VALUE(key, DT_INT, i);
+            TEST_CHECK(deleteKey(tree, key));
+            freeVal(key);
+          }
+      TEST_CHECK(getNumNodes(tree, &testint));
+      ASSERT_EQUALS_INT(1, testint, "only root left");
+      ASSERT_EQUALS_INT(0, scanCount(tree, NULL, NULL, &firstPage), "empty tree");
+
+      TEST_CHECK(closeBtree(tree));
+      TEST_CHECK(deleteBtree("testidx"));
+    }
+
+  free(present);
+  TEST_CHECK(shutdownIndexManager());
+
+  TEST_DONE();
+}
+
+// ************************************************************
+// Bulk loaded tree has to answer like an inserted one, and stay
+// consistent through later inserts and deletes. Enough keys for
+// several sorted runs.
+void
+testBulkLoad (void)
+{
+  int fanouts[] = { 3, BT_MAX_N };
+  float fills[] = { 1.0, 0.7 };
+  int numKeys = 2 * BT_LOAD_RUN_ENTRIES + 1000, f, i, testint, firstPage;
+  int *permute;
+  BT_BulkLoad *load;
+  BTreeHandle *tree = NULL;
+  Value *key;
+  RID rid;
+  testName = "test b-tree bulk load";
+
+  TEST_CHECK(initIndexManager(NULL));
+
+  for(f = 0; f < 2; f++)
+    {
+      TEST_CHECK(startBtreeLoad(&load, "testidx", DT_INT, fanouts[f], fills[f]));
+      permute = createPermutation(numKeys);
+      for(i = 0; i < numKeys; i++)
+        {
+          MAKE_VALUE(key, DT_INT, permute[i]);
+          rid.page = permute[i];
+          rid.slot = permute[i] % 7;
+          TEST_CHECK(loadKey(load, key, rid));
+          freeVal(key);
+        }
+      free(permute);
+      TEST_CHECK(finishBtreeLoad(load));
+
+      TEST_CHECK(openBtree(&tree, "testidx"));
+      TEST_CHECK(getNumEntries(tree, &testint));
+      ASSERT_EQUALS_INT(numKeys, testint, "entries loaded");
+      ASSERT_EQUALS_INT(numKeys, scanCount(tree, NULL, NULL, &firstPage), "scan sees all entries");
+      ASSERT_EQUALS_INT(0, firstPage, "scan starts at smallest key");
+      for(i = 0; i < numKeys; i++)
+        {
+          MAKE_VALUE(key, DT_INT, i);
+          TEST_CHECK(findKey(tree, key, &rid));
+          if (rid.page != i || rid.slot != i % 7)
+            ASSERT_TRUE(FALSE, "rid of key");
+          freeVal(key);
+        }
+
+      // delete every other key, then insert keys past the end
+      for(i = 0; i < numKeys; i += 2)
+        {
+          MAKE_VALUE(key, DT_INT, i);
+          TEST_CHECK(deleteKey(tree, key));
+          freeVal(key);
+        }
+      for(i = numKeys; i < numKeys + 1000; i++)
+        {
+          MAKE_VALUE(key, DT_INT, i);
+          rid.page = i;
+          rid.slot = 0;
+          TEST_CHECK(insertKey(tree, key, rid));
+          freeVal(key);
+        }
+      ASSERT_EQUALS_INT(numKeys / 2 + 1000, scanCount(tree, NULL, NULL, &firstPage), "entries after changes");
+      ASSERT_EQUALS_INT(1, firstPage, "smallest key left");
+
+      TEST_CHECK(closeBtree(tree));
+      TEST_CHECK(deleteBtree("testidx"));
+    }
+
+  // empty load gives an empty root leaf
+  TEST_CHECK(startBtreeLoad(&load, "testidx", DT_INT, 4, 1.0));
+  TEST_CHECK(finishBtreeLoad(load));
+  TEST_CHECK(openBtree(&tree, "testidx"));
+  TEST_CHECK(getNumNodes(tree, &testint));
+  ASSERT_EQUALS_INT(1, testint, "only root");
+  ASSERT_EQUALS_INT(0, scanCount(tree, NULL, NULL, &firstPage), "empty tree");
+  TEST_CHECK(closeBtree(tree));
+  TEST_CHECK(deleteBtree("testidx"));
+
+  // duplicate keys are found when entries are sorted
+  TEST_CHECK(startBtreeLoad(&load, "testidx", DT_INT, 4, 1.0));
+  rid.page = rid.slot = 0;
+  for(i = 0; i < 10; i++)
+    {
+      MAKE_VALUE(key, DT_INT, i % 9);
+      TEST_CHECK(loadKey(load, key, rid));
+      freeVal(key);
+    }
+  testint = finishBtreeLoad(load);
+  ASSERT_EQUALS_INT(RC_IM_KEY_ALREADY_EXISTS, testint, "duplicate key");
+
+  TEST_CHECK(shutdownIndexManager());
+
+  TEST_DONE();
+}
+
+// ************************************************************
+int *
+createPermutation (int size)
+{
+  int *result = (int *) malloc(size * sizeof(int));
+  int i;
+
+  for(i = 0; i < size; i++)
+    result[i] = i;
+
+  for(i = 0; i < size; i++)
+    {
+      int r = rand() % size;
+      int temp = result[i];
+      result[i] = result[r];
+      result[r] = temp;
+    }
+
+  return result;
+}
+
+Value **
+createValues (char **stringVals, int size)
+{
+  Value **result = (Value **) malloc(sizeof(Value *) * size);
+  int i;
+
+  for(i = 0; i < size; i++)
+    result[i] = stringToValue(stringVals[i]);
+
+  return result;
+}
+
+void
+freeValues (Value **vals, int size)
+{
+  while(--size >= 0)
+    freeVal(vals[size]);
+  free(vals);
+}
+
+// Entries below node pn, whose keys must lie in [low, high). Keys are
+// ordered, nodes other than root hold at least their minimum and all
+// leaves are at the depth of the tree height.
+int
+checkNode (BT_TreeMgmtData *t, PageNumber pn, int depth, int low, int high)
+{
+  BM_PageHandle ph;
+  BT_NodeHeader *hdr;
+  BT_Key *keys;
+  int i, min, count = 0;
+
+  TEST_CHECK(pinPage(&t->bm, &ph, pn));
+  hdr = BT_HEADER(ph.data);
+  keys = BT_KEYS(ph.data);
+  min = hdr->isLeaf ? (t->n + 1) / 2 : t->n / 2;
+  if (depth == 1)
+    min = hdr->isLeaf ? 0 : 1;
+  if (hdr->numKeys < min || hdr->numKeys > t->n)
+    ASSERT_TRUE(FALSE, "node fill");
+  for(i = 0; i < hdr->numKeys; i++)
+    if (keys[i].intV < low || keys[i].intV >= high
+        || (i > 0 && keys[i - 1].intV >= keys[i].intV))
+      ASSERT_TRUE(FALSE, "node keys ordered and in range");
+
+  if (hdr->isLeaf)
+    {
+      if (depth != t->height)
+        ASSERT_EQUALS_INT(t->height, depth, "leaf depth");
+      count = hdr->numKeys;
+    }
+  else
+    for(i = 0; i <= hdr->numKeys; i++)
+      count += checkNode(t, BT_CHILDREN(ph.data, t->n)[i], depth + 1,
+                         i > 0 ? keys[i - 1].intV : low,
+                         i < hdr->numKeys ? keys[i].intV : high);
+
+  TEST_CHECK(unpinPage(&t->bm, &ph));
+  return count;
+}
+
+// Number of entries of range scan, firstPage gets rid page of first one.
+int
+scanCount (BTreeHandle *tree, Value *low, Value *high, int *firstPage)
+{
+  BT_ScanHandle *sc;
+  RID rid;
+  int count = 0;
+  RC rc;
+
+  TEST_CHECK(openTreeRangeScan(tree, low, high, &sc));
+  *firstPage = -1;
+  while((rc = nextEntry(sc, &rid)) == RC_OK)
+    {
+      if (count == 0)
+        *firstPage = rid.page;
+      count++;
+    }
+  ASSERT_EQUALS_INT(RC_IM_NO_MORE_ENTRIES, rc, "scan ended");
+  TEST_CHECK(closeTreeScan(sc));
+
+  return count;
+}
@@ -0,0 +1,351 @@
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+
+#include "dberror.h"
+#include "hash_mgr.h"
+#include "expr.h"
+#include "tables.h"
+#include "test_helper.h"
+
+// var to store the current test's name
+char *testName;
+
+// test methods
+static void testInsertAndFind (void);
+static void testGrowth (void);
+static void testDelete (void);
+static void testFloatKeys (void);
+static void testFailedSplit (void);
+
+// helper methods
+static int *createPermutation (int size);
+static void checkKeys (HashHandle *hash, int numKeys);
+
+// main method
+int
+main (void)
+{
+  testName = "";
+
+  initStorageManager();
+  testInsertAndFind();
+  testGrowth();
+  testDelete();
+  testFloatKeys();
+  testFailedSplit();
+
+  return 0;
+}
+
+// ************************************************************
+void
+testInsertAndFind (void)
+{
+  HashHandle *hash = NULL;
+  Value *key;
+  RID rid;
+  int i, testint;
+  testName = "test hash index inserting and search";
+
+  TEST_CHECK(createHash("testhash", DT_INT));
+  TEST_CHECK(openHash(&hash, "testhash"));
+
+  for(i = 0; i < 10; i++)
+    {
+      MAKE_VALUE(key, DT_INT, i * 11);
+      rid.page = i;
+      rid.slot = i % 3;
+      TEST_CHECK(insertHashKey(hash, key, rid));
+      freeVal(key);
+    }
+  MAKE_VALUE(key, DT_INT, 33);
+  testint = insertHashKey(hash, key, rid);
+  ASSERT_EQUALS_INT(RC_IM_KEY_ALREADY_EXISTS, testint, "duplicate key");
+  TEST_CHECK(findHashKey(hash, key, &rid));
+  ASSERT_EQUALS_INT(3, rid.page, "rid page of key 33");
+  ASSERT_EQUALS_INT(0, rid.slot, "rid slot of key 33");
+  freeVal(key);
+
+  MAKE_VALUE(key, DT_INT, 34);
+  testint = findHashKey(hash, key, &rid);
+  ASSERT_EQUALS_INT(RC_IM_KEY_NOT_FOUND, testint, "missing key");
+  freeVal(key);
+
+  TEST_CHECK(getHashNumEntries(hash, &testint));
+  ASSERT_EQUALS_INT(10, testint, "number of entries");
+  TEST_CHECK(getHashNumBuckets(hash, &testint));
+  ASSERT_EQUALS_INT(HS_INITIAL_BUCKETS, testint, "no split yet");
+
+  TEST_CHECK(closeHash(hash));
+  TEST_CHECK(deleteHash("testhash"));
+  ASSERT_EQUALS_INT(RC_FILE_NOT_FOUND, openHash(&hash, "testhash"),
+                    "open deleted index");
+
+  TEST_DONE();
+}
+
+// ************************************************************
+// Buckets are split one at a time as entries come, chains must stay
+// short and every key must stay findable across reopen.
+void
+testGrowth (void)
+{
+  HashHandle *hash = NULL;
+  int numKeys = 100000, i, buckets, overflow, testint;
+  int *permute;
+  Value *key;
+  RID rid;
+  testName = "test hash index growth by splits";
+
+  TEST_CHECK(createHash("testhash", DT_INT));
+  TEST_CHECK(openHash(&hash, "testhash"));
+
+  permute = createPermutation(numKeys);
+  for(i = 0; i < numKeys; i++)
+    {
+      MAKE_VALUE(key, DT_INT, permute[i]);
+      rid.page = permute[i];
+      rid.slot = permute[i] % 5;
+      TEST_CHECK(insertHashKey(hash, key, rid));
+      freeVal(key);
+    }
+  free(permute);
+
+  TEST_CHECK(getHashNumBuckets(hash, &buckets));
+  TEST_CHECK(getHashNumOverflowPages(hash, &overflow));
+  ASSERT_TRUE(buckets >= numKeys / HS_ENTRIES_PER_PAGE, "buckets grew with entries");
+  // buckets not yet split this round hold about twice the average
+  ASSERT_TRUE(overflow <= buckets / 2, "few overflow pages");
+
+  TEST_CHECK(closeHash(hash));
+  TEST_CHECK(openHash(&hash, "testhash"));
+
+  TEST_CHECK(getHashNumBuckets(hash, &testint));
+  ASSERT_EQUALS_INT(buckets, testint, "buckets after reopen");
+  TEST_CHECK(getHashNumEntries(hash, &testint));
+  ASSERT_EQUALS_INT(numKeys, testint, "entries after reopen");
+  for(i = 0; i < numKeys; i++)
+    {
+      MAKE_VALUE(key, DT_INT, i);
+      TEST_CHECK(findHashKey(hash, key, &rid));
+      if (rid.page != i || rid.slot != i % 5)
+        ASSERT_TRUE(FALSE, "rid of key");
+      freeVal(key);
+    }
+
+  TEST_CHECK(closeHash(hash));
+  TEST_CHECK(deleteHash("testhash"));
+
+  TEST_DONE();
+}
+
+// ************************************************************
+// Split that runs out of frames leaves every entry in place.
+void
+testFailedSplit (void)
+{
+  HashHandle *hash = NULL;
+  BM_BufferPool *bm;
+  BM_PageHandle blockers[HS_POOL_PAGES - 1];
+  int limit = (int) (HS_SPLIT_LOAD * HS_INITIAL_BUCKETS * HS_ENTRIES_PER_PAGE);
+  int i, testint;
+  Value *key;
+  RID rid;
+  testName = "test hash index split without frames";
+
+  TEST_CHECK(createHash("testhash", DT_INT));
+  TEST_CHECK(openHash(&hash, "testhash"));
+  for(i = 0; i < limit; i++)
+    {
+      MAKE_VALUE(key, DT_INT, i);
+      rid.page = i;
+      rid.slot = i % 5;
+      TEST_CHECK(insertHashKey(hash, key, rid));
+      freeVal(key);
+    }
+  TEST_CHECK(getHashNumBuckets(hash, &testint));
+  ASSERT_EQUALS_INT(HS_INITIAL_BUCKETS, testint, "no split yet");
+
+  // one frame left, enough to insert but not to split
+  bm = &((HS_IndexMgmtData *) hash->mgmtData)->bm;
+  for(i = 0; i < HS_POOL_PAGES - 1; i++)
+    TEST_CHECK(pinPage(bm, &blockers[i], 1000 + i));
+  MAKE_VALUE(key, DT_INT, limit);
+  rid.page = limit;
+  rid.slot = limit % 5;
+  ASSERT_ERROR(insertHashKey(hash, key, rid), "split fails");
+  freeVal(key);
+  TEST_CHECK(getHashNumEntries(hash, &testint));
+  ASSERT_EQUALS_INT(limit + 1, testint, "key inserted before split");
+  TEST_CHECK(getHashNumBuckets(hash, &testint));
+  ASSERT_EQUALS_INT(HS_INITIAL_BUCKETS, testint, "no bucket added");
+  checkKeys(hash, limit + 1);
+
+  // next insert splits
+  for(i = 0; i < HS_POOL_PAGES - 1; i++)
+    TEST_CHECK(unpinPage(bm, &blockers[i]));
+  MAKE_VALUE(key, DT_INT, limit + 1);
+  rid.page = limit + 1;
+  rid.slot = (limit + 1) % 5;
+  TEST_CHECK(insertHashKey(hash, key, rid));
+  freeVal(key);
+  TEST_CHECK(getHashNumBuckets(hash, &testint));
+  ASSERT_EQUALS_INT(HS_INITIAL_BUCKETS + 1, testint, "bucket added");
+  checkKeys(hash, limit + 2);
+
+  TEST_CHECK(closeHash(hash));
+  TEST_CHECK(deleteHash("testhash"));
+
+  TEST_DONE();
+}
+
+// ************************************************************
+void
+testDelete (void)
+{
+  HashHandle *hash = NULL;
+  int numKeys = 20000, i, testint;
+  int *permute;
+  Value *key;
+  RID rid;
+  testName = "test hash index delete";
+
+  TEST_CHECK(createHash("testhash", DT_INT));
+  TEST_CHECK(openHash(&hash, "testhash"));
+
+  for(i = 0; i < numKeys; i++)
+    {
+      MAKE_VALUE(key, DT_INT, i);
+      rid.page = i;
+      rid.slot = 0;
+      TEST_CHECK(insertHashKey(hash, key, rid));
+      freeVal(key);
+    }
+
+  // delete odd keys in random order
+  permute = createPermutation(numKeys);
+  for(i = 0; i < numKeys; i++)
+    if (permute[i] % 2)
+      {
+        MAKE_VALUE(key, DT_INT, permute[i]);
+        TEST_CHECK(deleteHashKey(hash, key));
+        testint = deleteHashKey(hash, key);
+        if (testint != RC_IM_KEY_NOT_FOUND)
+          ASSERT_TRUE(FALSE, "key deleted twice");
+        freeVal(key);
+      }
+  free(permute);
+
+  TEST_CHECK(getHashNumEntries(hash, &testint));
+  ASSERT_EQUALS_INT(numKeys / 2, testint, "entries left");
+  for(i = 0; i < numKeys; i++)
+    {
+      MAKE_VALUE(key, DT_INT, i);
+      testint = findHashKey(hash, key, &rid);
+      if ((i % 2) ? testint != RC_IM_KEY_NOT_FOUND
+                  : (testint != RC_OK || rid.page != i))
+        ASSERT_TRUE(FALSE, "find after delete");
+      freeVal(key);
+    }
+
+  // deleted keys can be inserted again
+  for(i = 1; i < numKeys; i += 2)
+    {
+      MAKE_VALUE(key, DT_INT, i);
+      rid.page = i;
+      TEST_CHECK(insertHashKey(hash, key, rid));
+      freeVal(key);
+    }
+  TEST_CHECK(getHashNumEntries(hash, &testint));
+  ASSERT_EQUALS_INT(numKeys, testint, "entries after reinsert");
+
+  TEST_CHECK(closeHash(hash));
+  TEST_CHECK(deleteHash("testhash"));
+
+  TEST_DONE();
+}
+
+// ************************************************************
+void
+testFloatKeys (void)
+{
+  HashHandle *hash = NULL;
+  Value *key;
+  RID rid;
+  int i, testint;
+  testName = "test hash index float keys";
+
+  TEST_CHECK(createHash("testhash", DT_FLOAT));
+  TEST_CHECK(openHash(&hash, "testhash"));
+
+  for(i = 0; i < 1000; i++)
+    {
+      MAKE_VALUE(key, DT_FLOAT, i * 0.25f);
+      rid.page = i;
+      rid.slot = 0;
+      TEST_CHECK(insertHashKey(hash, key, rid));
+      freeVal(key);
+    }
+
+  MAKE_VALUE(key, DT_FLOAT, 12.5f);
+  TEST_CHECK(findHashKey(hash, key, &rid));
+  ASSERT_EQUALS_INT(50, rid.page, "rid of 12.5");
+  freeVal(key);
+
+  // -0.0 equals 0.0
+  MAKE_VALUE(key, DT_FLOAT, -0.0f);
+  TEST_CHECK(findHashKey(hash, key, &rid));
+  ASSERT_EQUALS_INT(0, rid.page, "rid of -0.0");
+  freeVal(key);
+
+  MAKE_VALUE(key, DT_INT, 1);
+  testint = findHashKey(hash, key, &rid);
+  ASSERT_EQUALS_INT(RC_RM_COMPARE_VALUE_OF_DIFFERENT_DATATYPE, testint, "wrong key type");
+  freeVal(key);
+
+  TEST_CHECK(closeHash(hash));
+  TEST_CHECK(deleteHash("testhash"));
+
+  TEST_DONE();
+}
+
+// ************************************************************
+int *
+createPermutation (int size)
+{
+  int *result = (int *) malloc(size * sizeof(int));
+  int i;
+
+  for(i = 0; i < size; i++)
+    result[i] = i;
+
+  for(i = 0; i < size; i++)
+    {
+      int r = rand() % size;
+      int temp = result[i];
+      result[i] = result[r];
+      result[r] = temp;
+    }
+
+  return result;
+}
+
+// Keys 0 .. numKeys-1 are found with rid {key, key % 5}
+void
+checkKeys (HashHandle *hash, int numKeys)
+{
+  Value *key;
+  RID rid;
+  int i;
+
+  for(i = 0; i < numKeys; i++)
+    {
+      MAKE_VALUE(key, DT_INT, i);
+      TEST_CHECK(findHashKey(hash, key, &rid));
+      if (rid.page != i || rid.slot != i % 5)
+        ASSERT_TRUE(FALSE, "rid of key");
+      freeVal(key);
+    }
+  ASSERT_TRUE(TRUE, "all keys found");
+}
@@ -0,0 +1,329 @@
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+#include <unistd.h>
+
+#include "dberror.h"
+#include "storage_mgr.h"
+#include "buffer_mgr.h"
+#include "sort_mgr.h"
+#include "test_helper.h"
+
+// var to store the current test's name
+char *testName;
+
+// record with payload, larger than a key
+typedef struct WideRecord {
+  int key;
+  int check;
+  char pad[92];
+} WideRecord;
+
+// test methods
+static void testInMemorySort (void);
+static void testReplacementSelection (void);
+static void testPresortedInput (void);
+static void testWideRecords (void);
+static void testSortErrors (void);
+
+// helper methods
+static int *createPermutation (int size);
+static int intCmp (const void *a, const void *b, void *ctx);
+static int wideCmp (const void *a, const void *b, void *ctx);
+static bool runFilesLeft (char *prefix, int upTo);
+
+// main method
+int
+main (void)
+{
+  testName = "";
+
+  initStorageManager();
+  testInMemorySort();
+  testReplacementSelection();
+  testPresortedInput();
+  testWideRecords();
+  testSortErrors();
+
+  return 0;
+}
+
+// ************************************************************
+void
+testInMemorySort (void)
+{
+  ES_SortHandle *sort;
+  int numRecords = 1000, i, v, testint;
+  int *permute;
+  testName = "test sort fitting in workspace";
+
+  TEST_CHECK(openSort(&sort, NULL, ES_MIN_FRAMES, sizeof(int), intCmp, NULL,
+                      "testsort"));
+  permute = createPermutation(numRecords);
+  for(i = 0; i < numRecords; i++)
+    TEST_CHECK(putSortRecord(sort, &permute[i]));
+  free(permute);
+
+  TEST_CHECK(finishSortInput(sort));
+  TEST_CHECK(getSortNumRuns(sort, &testint));
+  ASSERT_EQUALS_INT(0, testint, "no run written");
+  for(i = 0; i < numRecords; i++)
+    {
+      TEST_CHECK(getSortRecord(sort, &v));
+      if (v != i)
+        ASSERT_EQUALS_INT(i, v, "records in order");
+    }
+  testint = getSortRecord(sort, &v);
+  ASSERT_EQUALS_INT(RC_ES_NO_MORE_RECORDS, testint, "end of sort");
+  TEST_CHECK(closeSort(sort));
+
+  // empty input
+  TEST_CHECK(openSort(&sort, NULL, ES_MIN_FRAMES, sizeof(int), intCmp, NULL,
+                      "testsort"));
+  testint = getSortRecord(sort, &v);
+  ASSERT_EQUALS_INT(RC_ES_NO_MORE_RECORDS, testint, "empty sort");
+  TEST_CHECK(closeSort(sort));
+
+  TEST_DONE();
+}
+
+// ************************************************************
+// Workspace frames come from a buffer pool, runs outnumber what can
+// be merged at once so merges write new runs.
+void
+testReplacementSelection (void)
+{
+  BM_BufferPool *bm = MAKE_POOL();
+  BM_PageHandle *h = MAKE_PAGE_HANDLE();
+  ES_SortHandle *sort;
+  int numFrames = 9, numRecords = 200000, i, v, testint, capacity;
+  int *permute, *fixCounts;
+  testName = "test sort with replacement selection and merges";
+
+  CHECK(createPageFile("testsort.bin"));
+  CHECK(initBufferPool(bm, "testsort.bin", 16, RS_LRU, NULL));
+  TEST_CHECK(pinPage(bm, h, 3));
+  TEST_CHECK(unpinPage(bm, h));
+
+  TEST_CHECK(openSort(&sort, bm, numFrames, sizeof(int), intCmp, NULL,
+                      "testsort"));
+  fixCounts = getFixCounts(bm);
+  testint = 0;
+  for(i = 0; i < 16; i++)
+    testint += fixCounts[i];
+  free(fixCounts);
+  ASSERT_EQUALS_INT(numFrames, testint, "frames reserved from pool");
+
+  // rest of pool is still usable
+  TEST_CHECK(pinPage(bm, h, 5));
+  TEST_CHECK(unpinPage(bm, h));
+
+  permute = createPermutation(numRecords);
+  for(i = 0; i < numRecords; i++)
+    TEST_CHECK(putSortRecord(sort, &permute[i]));
+  free(permute);
+  TEST_CHECK(finishSortInput(sort));
+
+  // random input gives runs of about twice the workspace
+  capacity = (numFrames - 1) * (PAGE_SIZE / sizeof(int));
+  TEST_CHECK(getSortNumRuns(sort, &testint));
+  ASSERT_TRUE(testint > (numFrames - 1) / 2, "more runs than one merge takes");
+  ASSERT_TRUE(testint <= numRecords / capacity, "runs longer than workspace");
+  TEST_CHECK(getSortNumMerges(sort, &testint));
+  ASSERT_TRUE(testint > 0, "runs were merged before last merge");
+  TEST_CHECK(getSortNumRecords(sort, &testint));
+  ASSERT_EQUALS_INT(numRecords, testint, "number of records");
+
+  for(i = 0; i < numRecords; i++)
+    {
+      TEST_CHECK(getSortRecord(sort, &v));
+      if (v != i)
+        ASSERT_EQUALS_INT(i, v, "records in order");
+    }
+  testint = getSortRecord(sort, &v);
+  ASSERT_EQUALS_INT(RC_ES_NO_MORE_RECORDS, testint, "end of sort");
+  TEST_CHECK(closeSort(sort));
+  ASSERT_TRUE(!runFilesLeft("testsort", 200), "run files removed");
+
+  // frames went back to the pool
+  TEST_CHECK(shutdownBufferPool(bm));
+  TEST_CHECK(destroyPageFile("testsort.bin"));
+  free(bm);
+  free(h);
+
+  TEST_DONE();
+}
+
+// ************************************************************
+void
+testPresortedInput (void)
+{
+  ES_SortHandle *sort;
+  int numFrames = 9, numRecords = 50000, i, v, testint, capacity;
+  testName = "test sort of sorted and reverse sorted input";
+
+  capacity = (numFrames - 1) * (PAGE_SIZE / sizeof(int));
+
+  // sorted input is one run
+  TEST_CHECK(openSort(&sort, NULL, numFrames, sizeof(int), intCmp, NULL,
+                      "testsort"));
+  for(i = 0; i < numRecords; i++)
+    TEST_CHECK(putSortRecord(sort, &i));
+  TEST_CHECK(finishSortInput(sort));
+  TEST_CHECK(getSortNumRuns(sort, &testint));
+  ASSERT_EQUALS_INT(1, testint, "one run for sorted input");
+  for(i = 0; i < numRecords; i++)
+    {
+      TEST_CHECK(getSortRecord(sort, &v));
+      if (v != i)
+        ASSERT_EQUALS_INT(i, v, "records in order");
+    }
+  TEST_CHECK(closeSort(sort));
+
+  // reverse sorted input makes runs of workspace size
+  TEST_CHECK(openSort(&sort, NULL, numFrames, sizeof(int), intCmp, NULL,
+                      "testsort"));
+  for(i = numRecords - 1; i >= 0; i--)
+    TEST_CHECK(putSortRecord(sort, &i));
+  TEST_CHECK(finishSortInput(sort));
+  TEST_CHECK(getSortNumRuns(sort, &testint));
+  ASSERT_EQUALS_INT((numRecords + capacity - 1) / capacity, testint,
+                    "runs of workspace size");
+  for(i = 0; i < numRecords; i++)
+    {
+      TEST_CHECK(getSortRecord(sort, &v));
+      if (v != i)
+        ASSERT_EQUALS_INT(i, v, "records in order");
+    }
+  TEST_CHECK(closeSort(sort));
+
+  TEST_DONE();
+}
+
+// ************************************************************
+void
+testWideRecords (void)
+{
+  ES_SortHandle *sort;
+  WideRecord r;
+  int numRecords = 30000, i, prev = -1, testint;
+  testName = "test sort of wide records with duplicate keys";
+
+  TEST_CHECK(openSort(&sort, NULL, 7, sizeof(WideRecord), wideCmp, NULL,
+                      "testsort"));
+  memset(&r, 0, sizeof(WideRecord));
+  for(i = 0; i < numRecords; i++)
+    {
+      r.key = rand() % 1000;
+      r.check = r.key * 7;
+      TEST_CHECK(putSortRecord(sort, &r));
+    }
+
+  for(i = 0; i < numRecords; i++)
+    {
+      TEST_CHECK(getSortRecord(sort, &r));
+      if (r.key < prev || r.check != r.key * 7)
+        ASSERT_TRUE(FALSE, "wide records in order and intact");
+      prev = r.key;
+    }
+  testint = getSortRecord(sort, &r);
+  ASSERT_EQUALS_INT(RC_ES_NO_MORE_RECORDS, testint, "end of sort");
+
+  // putting records after input ended fails
+  testint = putSortRecord(sort, &r);
+  ASSERT_EQUALS_INT(RC_ES_NO_MORE_RECORDS, testint, "input ended");
+  TEST_CHECK(closeSort(sort));
+
+  TEST_DONE();
+}
+
+// ************************************************************
+void
+testSortErrors (void)
+{
+  BM_BufferPool *bm = MAKE_POOL();
+  ES_SortHandle *sort;
+  int i, testint;
+  testName = "test sort errors and early close";
+
+  testint = openSort(&sort, NULL, ES_MIN_FRAMES - 1, sizeof(int), intCmp,
+                     NULL, "testsort");
+  ASSERT_EQUALS_INT(RC_ES_TOO_FEW_FRAMES, testint, "too few frames");
+  testint = openSort(&sort, NULL, ES_MIN_FRAMES, PAGE_SIZE + 1, intCmp,
+                     NULL, "testsort");
+  ASSERT_EQUALS_INT(RC_ES_RECORD_TOO_BIG, testint, "record too big");
+
+  // pool smaller than workspace, nothing stays reserved
+  CHECK(createPageFile("testsort.bin"));
+  CHECK(initBufferPool(bm, "testsort.bin", 6, RS_FIFO, NULL));
+  testint = openSort(&sort, bm, 8, sizeof(int), intCmp, NULL, "testsort");
+  ASSERT_EQUALS_INT(RC_BUFFER_POOL_FULL, testint, "pool too small");
+
+  // close while records of runs are still unread
+  TEST_CHECK(openSort(&sort, bm, 6, sizeof(int), intCmp, NULL, "testsort"));
+  for(i = 0; i < 50000; i++)
+    {
+      testint = (i * 7919) % 50000;
+      TEST_CHECK(putSortRecord(sort, &testint));
+    }
+  TEST_CHECK(getSortRecord(sort, &testint));
+  ASSERT_EQUALS_INT(0, testint, "smallest record");
+  TEST_CHECK(closeSort(sort));
+  ASSERT_TRUE(!runFilesLeft("testsort", 200), "run files removed");
+
+  TEST_CHECK(shutdownBufferPool(bm));
+  TEST_CHECK(destroyPageFile("testsort.bin"));
+  free(bm);
+
+  TEST_DONE();
+}
+
+// ************************************************************
+int *
+createPermutation (int size)
+{
+  int *result = (int *) malloc(size * sizeof(int));
+  int i;
+
+  for(i = 0; i < size; i++)
+    result[i] = i;
+
+  for(i = 0; i < size; i++)
+    {
+      int r = rand() % size;
+      int temp = result[i];
+      result[i] = result[r];
+      result[r] = temp;
+    }
+
+  return result;
+}
+
+int
+intCmp (const void *a, const void *b, void *ctx)
+{
+  int x = *(const int *) a, y = *(const int *) b;
+  return x < y ? -1 : (x > y ? 1 : 0);
+}
+
+int
+wideCmp (const void *a, const void *b, void *ctx)
+{
+  return intCmp(&((const WideRecord *) a)->key,
+                &((const WideRecord *) b)->key, ctx);
+}
+
+bool
+runFilesLeft (char *prefix, int upTo)
+{
+  char name[64];
+  int i;
+
+  for(i = 0; i < upTo; i++)
+    {
+      sprintf(name, "%s.sort%d", prefix, i);
+      if (access(name, F_OK) == 0)
+        return TRUE;
+    }
+  return FALSE;
+}
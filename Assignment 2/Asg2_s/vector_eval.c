@@ -0,0 +1,418 @@
+#include "vector_eval.h"
+#include <string.h>
+#include <stdlib.h>
+
+/*
+ * Every node of the condition produces a byte mask over the batch,
+ * 1 for rows where it holds, 0 otherwise.
+ *
+ * Comparisons run a kernel over the column array. On x86_64 SSE2
+ * kernels are always available, AVX2 ones are picked at runtime
+ * when the CPU has it. Elsewhere the scalar kernels are used.
+ * AND, OR and NOT combine masks 8 rows at a time in a 64 bit word.
+ * At last mask is turned into a selection vector without branches.
+ */
+
+#if defined(__GNUC__) && defined(__x86_64__)
+#define VE_X86 1
+#include <immintrin.h>
+#endif
+
+typedef void (*VE_IntKernel) (const int *col, int n, VE_CmpOp op, int c,
+                              unsigned char *mask);
+typedef void (*VE_FloatKernel) (const float *col, int n, VE_CmpOp op,
+                                float c, unsigned char *mask);
+
+#define MASK_WORD_ONES 0x0101010101010101ULL
+
+// Not a interface
+static VE_Node *compileNode(Schema *schema, Expr *expr, VE_Column *cols);
+static void freeNode(VE_Node *node);
+static void selectKernels(void);
+static void evalNode(VE_Predicate *pred, VE_Node *node, int n,
+                     unsigned char *mask);
+static void cmpIntScalar(const int *col, int n, VE_CmpOp op, int c,
+                         unsigned char *mask);
+static void cmpFloatScalar(const float *col, int n, VE_CmpOp op, float c,
+                           unsigned char *mask);
+
+static VE_IntKernel cmpInt= NULL;
+static VE_FloatKernel cmpFloat= NULL;
+
+/**************************************************
+ * Scalar kernels, also handle tails of SIMD kernels.
+ */
+static void cmpIntScalar(const int *col, int n, VE_CmpOp op, int c,
+                         unsigned char *mask)
+{
+  int i;
+  switch (op)
+  {
+    case VE_CMP_EQ:
+      for (i=0; i < n; i++)
+        mask[i]= (col[i] == c);
+      break;
+    case VE_CMP_LT:
+      for (i=0; i < n; i++)
+        mask[i]= (col[i] < c);
+      break;
+    case VE_CMP_GT:
+      for (i=0; i < n; i++)
+        mask[i]= (col[i] > c);
+      break;
+  }
+}
+
+static void cmpFloatScalar(const float *col, int n, VE_CmpOp op, float c,
+                           unsigned char *mask)
+{
+  int i;
+  switch (op)
+  {
+    case VE_CMP_EQ:
+      for (i=0; i < n; i++)
+        mask[i]= (col[i] == c);
+      break;
+    case VE_CMP_LT:
+      for (i=0; i < n; i++)
+        mask[i]= (col[i] < c);
+      break;
+    case VE_CMP_GT:
+      for (i=0; i < n; i++)
+        mask[i]= (col[i] > c);
+      break;
+  }
+}
+
+#ifdef VE_X86
+// Mask bytes of 4 lanes, indexed by movemask bits (little endian).
+static const unsigned int laneBytes[16]= {
+  0x00000000, 0x00000001, 0x00000100, 0x00000101,
+  0x00010000, 0x00010001, 0x00010100, 0x00010101,
+  0x01000000, 0x01000001, 0x01000100, 0x01000101,
+  0x01010000, 0x01010001, 0x01010100, 0x01010101
+};
+
+static void cmpIntSSE2(const int *col, int n, VE_CmpOp op, int c,
+                       unsigned char *mask)
+{
+  __m128i vc= _mm_set1_epi32(c);
+  __m128i v, r;
+  int i;
+
+  for (i=0; i + 4 <= n; i+= 4)
+  {
+    v= _mm_loadu_si128((const __m128i*) &col[i]);
+    if (op == VE_CMP_EQ)
+      r= _mm_cmpeq_epi32(v, vc);
+    else if (op == VE_CMP_LT)
+      r= _mm_cmplt_epi32(v, vc);
+    else
+      r= _mm_cmpgt_epi32(v, vc);
+    memcpy(&mask[i], &laneBytes[_mm_movemask_ps(_mm_castsi128_ps(r))], 4);
+  }
+  cmpIntScalar(&col[i], n - i, op, c, &mask[i]);
+}
+
+static void cmpFloatSSE2(const float *col, int n, VE_CmpOp op, float c,
+                         unsigned char *mask)
+{
+  __m128 vc= _mm_set1_ps(c);
+  __m128 v, r;
+  int i;
+
+  for (i=0; i + 4 <= n; i+= 4)
+  {
+    v= _mm_loadu_ps(&col[i]);
+    if (op == VE_CMP_EQ)
+      r= _mm_cmpeq_ps(v, vc);
+    else if (op == VE_CMP_LT)
+      r= _mm_cmplt_ps(v, vc);
+    else
+      r= _mm_cmpgt_ps(v, vc);
+    memcpy(&mask[i], &laneBytes[_mm_movemask_ps(r)], 4);
+  }
+  cmpFloatScalar(&col[i], n - i, op, c, &mask[i]);
+}
+
+__attribute__((target("avx2")))
+static void cmpIntAVX2(const int *col, int n, VE_CmpOp op, int c,
+                       unsigned char *mask)
+{
+  __m256i vc= _mm256_set1_epi32(c);
+  __m256i v, r;
+  int i, bits;
+
+  for (i=0; i + 8 <= n; i+= 8)
+  {
+    v= _mm256_loadu_si256((const __m256i*) &col[i]);
+    if (op == VE_CMP_EQ)
+      r= _mm256_cmpeq_epi32(v, vc);
+    else if (op == VE_CMP_LT)
+      r= _mm256_cmpgt_epi32(vc, v);
+    else
+      r= _mm256_cmpgt_epi32(v, vc);
+    bits= _mm256_movemask_ps(_mm256_castsi256_ps(r));
+    memcpy(&mask[i], &laneBytes[bits & 0xF], 4);
+    memcpy(&mask[i+4], &laneBytes[bits >> 4], 4);
+  }
+  cmpIntScalar(&col[i], n - i, op, c, &mask[i]);
+}
+
+__attribute__((target("avx2")))
+static void cmpFloatAVX2(const float *col, int n, VE_CmpOp op, float c,
+                         unsigned char *mask)
+{
+  __m256 vc= _mm256_set1_ps(c);
+  __m256 v, r;
+  int i, bits;
+
+  for (i=0; i + 8 <= n; i+= 8)
+  {
+    v= _mm256_loadu_ps(&col[i]);
+    // Ordered compares, false for NaN like C operators
+    if (op == VE_CMP_EQ)
+      r= _mm256_cmp_ps(v, vc, _CMP_EQ_OQ);
+    else if (op == VE_CMP_LT)
+      r= _mm256_cmp_ps(v, vc, _CMP_LT_OQ);
+    else
+      r= _mm256_cmp_ps(v, vc, _CMP_GT_OQ);
+    bits= _mm256_movemask_ps(r);
+    memcpy(&mask[i], &laneBytes[bits & 0xF], 4);
+    memcpy(&mask[i+4], &laneBytes[bits >> 4], 4);
+  }
+  cmpFloatScalar(&col[i], n - i, op, c, &mask[i]);
+}
+#endif // VE_X86
+
+// Kernels only depend on CPU, racing callers pick the same ones.
+static void selectKernels(void)
+{
+  if (cmpInt != NULL)
+    return;
+
+#ifdef VE_X86
+  if (__builtin_cpu_supports("avx2"))
+  {
+    cmpFloat= cmpFloatAVX2;
+    cmpInt= cmpIntAVX2;
+    return;
+  }
+  cmpFloat= cmpFloatSSE2;
+  cmpInt= cmpIntSSE2;
+#else
+  cmpFloat= cmpFloatScalar;
+  cmpInt= cmpIntScalar;
+#endif
+}
+
+/**************************************************
+ * Compiling conditions
+ */
+static void freeNode(VE_Node *node)
+{
+  if (node == NULL)
+    return;
+  freeNode(node->left);
+  freeNode(node->right);
+  free(node);
+}
+
+static VE_Node *compileNode(Schema *schema, Expr *expr, VE_Column *cols)
+{
+  VE_Node *node;
+  Operator *op;
+  Expr *attr, *cons;
+  Value *val;
+
+  if (expr == NULL || expr->type != EXPR_OP)
+    return NULL;
+  op= expr->expr.op;
+
+  node= (VE_Node*) calloc(1, sizeof(VE_Node));
+  switch (op->type)
+  {
+    case OP_BOOL_NOT:
+      node->type= VE_NODE_NOT;
+      node->left= compileNode(schema, op->args[0], cols);
+      if (node->left == NULL)
+        break;
+      return node;
+
+    case OP_BOOL_AND:
+    case OP_BOOL_OR:
+      node->type= (op->type == OP_BOOL_AND) ? VE_NODE_AND : VE_NODE_OR;
+      node->left= compileNode(schema, op->args[0], cols);
+      node->right= compileNode(schema, op->args[1], cols);
+      if (node->left == NULL || node->right == NULL)
+        break;
+      return node;
+
+    case OP_COMP_EQUAL:
+    case OP_COMP_SMALLER:
+      node->type= VE_NODE_CMP;
+      node->op= (op->type == OP_COMP_EQUAL) ? VE_CMP_EQ : VE_CMP_LT;
+
+      // Constant on the left flips "smaller" around
+      attr= op->args[0];
+      cons= op->args[1];
+      if (attr->type == EXPR_CONST && cons->type == EXPR_ATTRREF)
+      {
+        attr= op->args[1];
+        cons= op->args[0];
+        if (node->op == VE_CMP_LT)
+          node->op= VE_CMP_GT;
+      }
+      if (attr->type != EXPR_ATTRREF || cons->type != EXPR_CONST)
+        break;
+
+      node->attrNum= attr->expr.attrRef;
+      val= cons->expr.cons;
+      if (node->attrNum < 0 || node->attrNum >= schema->numAttr
+          || schema->dataTypes[node->attrNum] != val->dt)
+        break;
+
+      if (val->dt == DT_INT)
+        node->cons.intV= val->v.intV;
+      else if (val->dt == DT_BOOL)
+        node->cons.intV= val->v.boolV;
+      else if (val->dt == DT_FLOAT)
+        node->cons.floatV= val->v.floatV;
+      else
+        break;
+
+      cols[node->attrNum].used= TRUE;
+      cols[node->attrNum].dt= val->dt;
+      return node;
+  }
+
+  freeNode(node);
+  return NULL;
+}
+
+VE_Predicate *vePrepare (Schema *schema, Expr *cond)
+{
+  VE_Predicate *pred;
+  VE_Column *cols;
+  VE_Node *root;
+  int i;
+
+  cols= (VE_Column*) calloc(schema->numAttr, sizeof(VE_Column));
+  root= compileNode(schema, cond, cols);
+  if (root == NULL)
+  {
+    free(cols);
+    return NULL;
+  }
+
+  for (i=0; i < schema->numAttr; i++)
+  {
+    if (!cols[i].used)
+      continue;
+    if (cols[i].dt == DT_FLOAT)
+      cols[i].v.floatV= (float*) malloc(VE_BATCH_SIZE * sizeof(float));
+    else
+      cols[i].v.intV= (int*) malloc(VE_BATCH_SIZE * sizeof(int));
+  }
+
+  selectKernels();
+  pred= (VE_Predicate*) malloc(sizeof(VE_Predicate));
+  pred->root= root;
+  pred->numAttr= schema->numAttr;
+  pred->cols= cols;
+  return pred;
+}
+
+void veFree (VE_Predicate *pred)
+{
+  int i;
+
+  if (pred == NULL)
+    return;
+  for (i=0; i < pred->numAttr; i++)
+  {
+    if (pred->cols[i].dt == DT_FLOAT)
+      free(pred->cols[i].v.floatV);
+    else
+      free(pred->cols[i].v.intV);
+  }
+  freeNode(pred->root);
+  free(pred->cols);
+  free(pred);
+}
+
+int *veIntColumn (VE_Predicate *pred, int attrNum)
+{
+  VE_Column *col= &pred->cols[attrNum];
+  return (col->used && col->dt != DT_FLOAT) ? col->v.intV : NULL;
+}
+
+float *veFloatColumn (VE_Predicate *pred, int attrNum)
+{
+  VE_Column *col= &pred->cols[attrNum];
+  return (col->used && col->dt == DT_FLOAT) ? col->v.floatV : NULL;
+}
+
+/**************************************************
+ * Evaluation
+ */
+static void evalNode(VE_Predicate *pred, VE_Node *node, int n,
+                     unsigned char *mask)
+{
+  unsigned char other[VE_BATCH_SIZE];
+  unsigned long long a, b;
+  VE_Column *col;
+  int i;
+
+  switch (node->type)
+  {
+    case VE_NODE_CMP:
+      col= &pred->cols[node->attrNum];
+      if (col->dt == DT_FLOAT)
+        cmpFloat(col->v.floatV, n, node->op, node->cons.floatV, mask);
+      else
+        cmpInt(col->v.intV, n, node->op, node->cons.intV, mask);
+      return;
+
+    case VE_NODE_NOT:
+      evalNode(pred, node->left, n, mask);
+      for (i=0; i < n; i+= 8)
+      {
+        memcpy(&a, &mask[i], 8);
+        a^= MASK_WORD_ONES;
+        memcpy(&mask[i], &a, 8);
+      }
+      return;
+
+    case VE_NODE_AND:
+    case VE_NODE_OR:
+      evalNode(pred, node->left, n, mask);
+      evalNode(pred, node->right, n, other);
+      // Bytes past n are garbage, but stay inside the buffers.
+      for (i=0; i < n; i+= 8)
+      {
+        memcpy(&a, &mask[i], 8);
+        memcpy(&b, &other[i], 8);
+        a= (node->type == VE_NODE_AND) ? (a & b) : (a | b);
+        memcpy(&mask[i], &a, 8);
+      }
+      return;
+  }
+}
+
+int veSelect (VE_Predicate *pred, int numRows, unsigned short *sel)
+{
+  unsigned char mask[VE_BATCH_SIZE];
+  int i, numSel= 0;
+
+  if (numRows <= 0)
+    return 0;
+
+  evalNode(pred, pred->root, numRows, mask);
+  for (i=0; i < numRows; i++)
+  {
+    sel[numSel]= i;
+    numSel+= mask[i];
+  }
+  return numSel;
+}
@@ -0,0 +1,81 @@
+#ifndef VECTOR_EVAL_H
+#define VECTOR_EVAL_H
+
+#include "dberror.h"
+#include "expr.h"
+#include "tables.h"
+
+/*
+ * Batch evaluation of scan conditions
+ *
+ * Condition is compiled once per scan. Caller extracts the
+ * attributes it needs from a batch of tuples into column arrays,
+ * then veSelect compares whole columns and returns the rows
+ * matching the condition as a selection vector.
+ *
+ * Only comparisons of DT_INT, DT_FLOAT or DT_BOOL attributes with
+ * constants, combined by AND, OR and NOT, are compiled. For other
+ * conditions vePrepare returns NULL and caller uses evalExpr.
+ */
+
+// Rows in a batch. Every tuple takes at least 14 bytes of a page,
+// so a page never has more live tuples than this.
+#define VE_BATCH_SIZE 512
+
+typedef enum VE_CmpOp {
+  VE_CMP_EQ,
+  VE_CMP_LT,
+  VE_CMP_GT
+} VE_CmpOp;
+
+typedef enum VE_NodeType {
+  VE_NODE_CMP,
+  VE_NODE_AND,
+  VE_NODE_OR,
+  VE_NODE_NOT
+} VE_NodeType;
+
+typedef struct VE_Node {
+  VE_NodeType type;
+
+  // VE_NODE_CMP: attribute <op> constant
+  int attrNum;
+  VE_CmpOp op;
+  union {
+    int intV;     // DT_INT and DT_BOOL
+    float floatV; // DT_FLOAT
+  } cons;
+
+  struct VE_Node *left;   // Operands of AND, OR and NOT
+  struct VE_Node *right;
+} VE_Node;
+
+// Column of an attribute, DT_BOOL values are widened to int.
+typedef struct VE_Column {
+  bool used;
+  DataType dt;
+  union {
+    int *intV;
+    float *floatV;
+  } v;
+} VE_Column;
+
+typedef struct VE_Predicate {
+  VE_Node *root;
+  int numAttr;
+  VE_Column *cols;  // Indexed by attribute number
+} VE_Predicate;
+
+// Compile condition, NULL if it can not be evaluated in batches.
+VE_Predicate *vePrepare (Schema *schema, Expr *cond);
+void veFree (VE_Predicate *pred);
+
+// Column arrays to fill, NULL if condition does not use the attribute.
+int *veIntColumn (VE_Predicate *pred, int attrNum);
+float *veFloatColumn (VE_Predicate *pred, int attrNum);
+
+// Evaluate over first numRows rows of the columns. Writes indexes of
+// matching rows in ascending order to sel, returns their number.
+int veSelect (VE_Predicate *pred, int numRows, unsigned short *sel);
+
+#endif // VECTOR_EVAL_H